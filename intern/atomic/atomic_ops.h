@@ -0,0 +1,138 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file atomic/atomic_ops.h
+ *  \ingroup Atomic
+ *
+ * Header only atomic operations on integers, for counters and simple locks
+ * shared between threads without a mutex. All operations are full barriers.
+ */
+
+#ifndef __ATOMIC_OPS_H__
+#define __ATOMIC_OPS_H__
+
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#  include <windows.h>
+#  include <intrin.h>
+#  define ATOMIC_INLINE static __forceinline
+#else
+#  define ATOMIC_INLINE static inline
+#endif
+
+/* 32 bit */
+
+ATOMIC_INLINE unsigned int atomic_add_uint32(volatile unsigned int *p, unsigned int x)
+{
+#if defined(_MSC_VER)
+	return (unsigned int)InterlockedExchangeAdd((volatile long *)p, (long)x) + x;
+#else
+	return __sync_add_and_fetch(p, x);
+#endif
+}
+
+ATOMIC_INLINE unsigned int atomic_sub_uint32(volatile unsigned int *p, unsigned int x)
+{
+#if defined(_MSC_VER)
+	return (unsigned int)InterlockedExchangeAdd((volatile long *)p, -(long)x) - x;
+#else
+	return __sync_sub_and_fetch(p, x);
+#endif
+}
+
+/* returns the previous value, the swap happened when it equals 'old' */
+ATOMIC_INLINE unsigned int atomic_cas_uint32(volatile unsigned int *p, unsigned int old, unsigned int _new)
+{
+#if defined(_MSC_VER)
+	return (unsigned int)InterlockedCompareExchange((volatile long *)p, (long)_new, (long)old);
+#else
+	return __sync_val_compare_and_swap(p, old, _new);
+#endif
+}
+
+/* size_t */
+
+ATOMIC_INLINE size_t atomic_add_z(volatile size_t *p, size_t x)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	return (size_t)InterlockedExchangeAdd64((volatile __int64 *)p, (__int64)x) + x;
+#elif defined(_MSC_VER)
+	return (size_t)InterlockedExchangeAdd((volatile long *)p, (long)x) + x;
+#else
+	return __sync_add_and_fetch(p, x);
+#endif
+}
+
+ATOMIC_INLINE size_t atomic_sub_z(volatile size_t *p, size_t x)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	return (size_t)InterlockedExchangeAdd64((volatile __int64 *)p, -(__int64)x) - x;
+#elif defined(_MSC_VER)
+	return (size_t)InterlockedExchangeAdd((volatile long *)p, -(long)x) - x;
+#else
+	return __sync_sub_and_fetch(p, x);
+#endif
+}
+
+/* returns the previous value, the swap happened when it equals 'old' */
+ATOMIC_INLINE size_t atomic_cas_z(volatile size_t *p, size_t old, size_t _new)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	return (size_t)InterlockedCompareExchange64((volatile __int64 *)p, (__int64)_new, (__int64)old);
+#elif defined(_MSC_VER)
+	return (size_t)InterlockedCompareExchange((volatile long *)p, (long)_new, (long)old);
+#else
+	return __sync_val_compare_and_swap(p, old, _new);
+#endif
+}
+
+/* Full memory barrier, for ordering plain loads and stores of data that
+ * is published to other threads without a lock. */
+
+ATOMIC_INLINE void atomic_barrier(void)
+{
+#if defined(_MSC_VER)
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+/* Spin lock on an unsigned int which is zero when unlocked,
+ * only for very short sections with little contention. */
+
+ATOMIC_INLINE void atomic_spin_lock(volatile unsigned int *lock)
+{
+	while (atomic_cas_uint32(lock, 0, 1) != 0) {
+		while (*lock) {
+			/* wait for the owner without hammering the cache line */
+		}
+	}
+}
+
+ATOMIC_INLINE void atomic_spin_unlock(volatile unsigned int *lock)
+{
+	atomic_cas_uint32(lock, 1, 0);
+}
+
+#endif /* __ATOMIC_OPS_H__ */
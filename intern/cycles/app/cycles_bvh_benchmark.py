@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+#
+# Copyright 2013, Blender Foundation.
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software Foundation,
+# Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+
+# Compares ray intersection speed of the regular BVH and the QBVH, by
+# rendering XML scenes with cycles_test on the CPU device, for example:
+#
+#   cycles_bvh_benchmark.py --cycles ./bin/cycles_test --samples 50 scene1.xml scene2.xml
+
+import argparse
+import re
+import subprocess
+import sys
+
+RE_RENDER_TIME = re.compile(r"Render time: ([0-9.]+)s, ([0-9.]+) M camera rays/s")
+
+
+def render(cycles_test, filepath, samples, threads, use_qbvh):
+    args = [cycles_test, "--background", "--quiet", "--device", "cpu",
+            "--samples", str(samples)]
+
+    if threads:
+        args += ["--threads", str(threads)]
+    if use_qbvh:
+        args.append("--qbvh")
+
+    args.append(filepath)
+
+    output = subprocess.check_output(args, universal_newlines=True)
+    match = RE_RENDER_TIME.search(output)
+
+    if not match:
+        raise RuntimeError("no render time in output of %r" % filepath)
+
+    return float(match.group(1)), float(match.group(2))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Cycles BVH traversal benchmark")
+    parser.add_argument("--cycles", default="cycles_test", help="Path to the cycles_test executable")
+    parser.add_argument("--samples", type=int, default=20, help="Number of samples to render")
+    parser.add_argument("--threads", type=int, default=0, help="Number of render threads, 0 for automatic")
+    parser.add_argument("--runs", type=int, default=3, help="Number of renders, the fastest one is used")
+    parser.add_argument("scenes", nargs="+", help="XML scene files")
+    args = parser.parse_args()
+
+    print("%-32s %12s %12s %8s" % ("scene", "regular", "qbvh", "speedup"))
+
+    for filepath in args.scenes:
+        result = {}
+
+        for use_qbvh in (False, True):
+            runs = [render(args.cycles, filepath, args.samples, args.threads, use_qbvh)
+                    for i in range(args.runs)]
+            result[use_qbvh] = max(rays for time, rays in runs)
+
+        print("%-32s %8.3f M/s %8.3f M/s %7.2fx" % (filepath[-32:], result[False], result[True],
+                                                     result[True] / result[False]))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -123,7 +123,13 @@ static void scene_init(int width, int height)
 
 static void session_exit()
 {
+	string profiling_report;
+
 	if(options.session) {
+		/* needs the scene shader names, before it is freed */
+		if(options.session_params.profiling)
+			profiling_report = options.session->profiling_report();
+
 		delete options.session;
 		options.session = NULL;
 	}
@@ -136,6 +142,9 @@ static void session_exit()
 		session_print("Finished Rendering.");
 		printf("\n");
 	}
+
+	if(profiling_report != "")
+		printf("%s", profiling_report.c_str());
 }
 
 static void display_info(Progress& progress)
@@ -222,6 +231,7 @@ static void options_parse(int argc, const char **argv)
 	/* shading system */
 	string ssname = "svm";
 	string shadingsystems = "Shading system to use: svm";
+	bool use_qbvh = false;
 
 #ifdef WITH_OSL
 	shadingsystems += ", osl"; 
@@ -240,6 +250,8 @@ static void options_parse(int argc, const char **argv)
 		"--samples %d", &options.session_params.samples, "Number of samples to render",
 		"--output %s", &options.session_params.output_path, "File path to write output image",
 		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
+		"--qbvh", &use_qbvh, "Use the QBVH when the device supports it",
+		"--profile", &options.session_params.profiling, "Count rays, BVH nodes, shader nodes and image lookups, and print them when done (CPU only)",
 		"--width  %d", &options.width, "Window width in pixel",
 		"--height %d", &options.height, "Window height in pixel",
 		"--list-devices", &list, "List information about all available devices",
@@ -273,6 +285,8 @@ static void options_parse(int argc, const char **argv)
 	else if(ssname == "svm")
 		options.scene_params.shadingsystem = SceneParams::SVM;
 		
+	options.scene_params.use_qbvh = use_qbvh;
+
 	/* Progressive rendering */
 	options.session_params.progressive = true;
 
@@ -331,8 +345,18 @@ int main(int argc, const char **argv)
 	options_parse(argc, argv);
 
 	if(options.session_params.background) {
+		double start_time = time_dt();
+
 		session_init();
 		options.session->wait();
+
+		/* one camera ray per pixel and sample, for comparing render speed */
+		double render_time = time_dt() - start_time;
+		double num_rays = (double)options.width * options.height * options.session->params.samples;
+
+		printf("Render time: %.2fs, %.3f M camera rays/s, %s BVH\n", render_time,
+			num_rays / render_time * 1e-6, (options.session->scene->params.use_qbvh)? "QBVH": "regular");
+
 		session_exit();
 	}
 	else {
@@ -58,6 +58,20 @@ class CyclesRender(bpy.types.RenderEngine):
     def render(self, scene):
         engine.render(self)
 
+        if self.session and scene.cycles.use_profiling:
+            report = engine.profiling_report(self)
+            if report:
+                print(report)
+
+    def bake(self, scene, obj, pass_type, pixel_array, num_pixels, depth, result):
+        device_type = bpy.context.user_preferences.system.compute_device_type
+
+        if device_type != 'NONE' and scene.cycles.device != 'CPU':
+            self.report({'ERROR'}, "Baking is only supported on the CPU")
+            return
+
+        engine.bake(self, obj, pass_type, pixel_array, num_pixels, depth, result)
+
     # preview render
     # def preview_update(self, context, id):
     #    pass
@@ -61,6 +61,23 @@ def render(engine):
         _cycles.render(engine.session)
 
 
+def bake(engine, obj, pass_type, pixel_array, num_pixels, depth, result):
+    import _cycles
+    session = getattr(engine, "session", None)
+    if session is not None:
+        _cycles.bake(engine.session, obj.as_pointer(), pass_type, pixel_array.as_pointer(), num_pixels, depth, result.as_pointer())
+
+
+def profiling_stats(engine):
+    import _cycles
+    return _cycles.profiling_stats(engine.session)
+
+
+def profiling_report(engine):
+    import _cycles
+    return _cycles.profiling_report(engine.session)
+
+
 def reset(engine, data, scene):
     import _cycles
     data = data.as_pointer()
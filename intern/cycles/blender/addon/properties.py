@@ -23,7 +23,8 @@ from bpy.props import (BoolProperty,
                        EnumProperty,
                        FloatProperty,
                        IntProperty,
-                       PointerProperty)
+                       PointerProperty,
+                       StringProperty)
 
 import math
 
@@ -75,6 +76,25 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0, max=2147483647,
                 default=10,
                 )
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Stop sampling tiles once their noise is below the threshold, "
+                            "samples is the maximum (CPU final renders only)",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Adaptive Threshold",
+                description="Noise level below which tiles stop sampling, lower values give less noise",
+                min=0.0001, max=1.0,
+                default=0.01,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Adaptive Min Samples",
+                description="Number of samples to render before checking the noise of a tile",
+                min=2, max=10000,
+                default=16,
+                )
         cls.preview_pause = BoolProperty(
                 name="Pause Preview",
                 description="Pause all viewport preview renders",
@@ -283,11 +303,50 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 description="Use BVH spatial splits: longer builder time, faster render",
                 default=False,
                 )
+        cls.debug_use_qbvh = BoolProperty(
+                name="Use QBVH",
+                description="Use a BVH with 4 children per node, traversed with SSE (CPU only)",
+                default=False,
+                )
+        cls.debug_bvh_refit_threshold = FloatProperty(
+                name="Refit Threshold",
+                description="When geometry moved, refit the BVH instead of rebuilding it, unless it became "
+                            "this many times slower to trace than when it was built (0 to always refit)",
+                min=0.0, max=10.0,
+                default=1.5,
+                )
         cls.use_cache = BoolProperty(
                 name="Cache BVH",
                 description="Cache last built BVH to disk for faster re-render if no geometry changed",
                 default=False,
                 )
+        cls.texture_cache_size = IntProperty(
+                name="Texture Cache",
+                description="Memory limit in megabytes for image textures, which are then loaded in tiles "
+                            "and mipmap levels as rendering needs them (CPU only, 0 to load whole images)",
+                min=0, max=65536,
+                default=0,
+                )
+        cls.use_profiling = BoolProperty(
+                name="Profiling",
+                description="Count rays, BVH nodes, shader nodes and image lookups during final renders, "
+                            "and print them with the cost per shader when done (CPU only)",
+                default=False,
+                )
+        cls.checkpoint_directory = StringProperty(
+                name="Checkpoints",
+                description="Directory to save finished tiles of command line renders in, "
+                            "so an interrupted render continues where it stopped when started again "
+                            "(leave empty to disable)",
+                subtype='DIR_PATH',
+                default="",
+                )
+        cls.checkpoint_interval = IntProperty(
+                name="Checkpoint Interval",
+                description="Seconds between writes of finished tiles to the checkpoint",
+                min=1, max=3600,
+                default=60,
+                )
         cls.use_progressive_refine = BoolProperty(
                 name="Progressive Refine",
                 description="Instead of rendering each tile until it is finished, "
@@ -540,6 +599,34 @@ class CyclesMeshSettings(bpy.types.PropertyGroup):
         del bpy.types.MetaBall.cycles
 
 
+class CyclesCurveSettings(bpy.types.PropertyGroup):
+    @classmethod
+    def register(cls):
+        bpy.types.ParticleSettings.cycles = PointerProperty(
+                name="Cycles Hair Settings",
+                description="Cycles hair settings",
+                type=cls,
+                )
+        cls.root_radius = FloatProperty(
+                name="Root Radius",
+                description="Radius of hair strands at the root",
+                min=0.0, max=1000.0,
+                default=0.01,
+                precision=4,
+                )
+        cls.tip_radius = FloatProperty(
+                name="Tip Radius",
+                description="Radius of hair strands at the tip",
+                min=0.0, max=1000.0,
+                default=0.005,
+                precision=4,
+                )
+
+    @classmethod
+    def unregister(cls):
+        del bpy.types.ParticleSettings.cycles
+
+
 def register():
     bpy.utils.register_class(CyclesRenderSettings)
     bpy.utils.register_class(CyclesCameraSettings)
@@ -548,6 +635,7 @@ def register():
     bpy.utils.register_class(CyclesWorldSettings)
     bpy.utils.register_class(CyclesVisibilitySettings)
     bpy.utils.register_class(CyclesMeshSettings)
+    bpy.utils.register_class(CyclesCurveSettings)
 
 
 def unregister():
@@ -558,3 +646,4 @@ def unregister():
     bpy.utils.unregister_class(CyclesWorldSettings)
     bpy.utils.unregister_class(CyclesMeshSettings)
     bpy.utils.unregister_class(CyclesVisibilitySettings)
+    bpy.utils.unregister_class(CyclesCurveSettings)
@@ -86,6 +86,13 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
             sub.prop(cscene, "ao_samples", text="AO")
             sub.prop(cscene, "mesh_light_samples", text="Mesh Light")
 
+        layout.prop(cscene, "use_adaptive_sampling")
+
+        split = layout.split()
+        split.active = cscene.use_adaptive_sampling
+        split.prop(cscene, "adaptive_threshold", text="Threshold")
+        split.prop(cscene, "adaptive_min_samples", text="Min Samples")
+
 
 class CyclesRender_PT_light_paths(CyclesButtonsPanel, Panel):
     bl_label = "Light Paths"
@@ -210,6 +217,8 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         sub.label(text="Acceleration structure:")
         sub.prop(cscene, "debug_bvh_type", text="")
         sub.prop(cscene, "debug_use_spatial_splits")
+        sub.prop(cscene, "debug_use_qbvh")
+        sub.prop(cscene, "debug_bvh_refit_threshold")
         sub.prop(cscene, "use_cache")
 
         sub = col.column(align=True)
@@ -218,7 +227,14 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
 
         sub = col.column(align=True)
         sub.label(text="Final Render:")
-        sub.prop(rd, "use_persistent_data", text="Persistent Images")
+        sub.prop(rd, "use_persistent_data", text="Persistent Data")
+        sub.prop(cscene, "use_profiling")
+        sub.prop(cscene, "checkpoint_directory")
+        sub.prop(cscene, "checkpoint_interval")
+
+        sub = col.column(align=True)
+        sub.label(text="Memory:")
+        sub.prop(cscene, "texture_cache_size")
 
 
 class CyclesRender_PT_layers(CyclesButtonsPanel, Panel):
@@ -487,6 +503,25 @@ class CyclesObject_PT_ray_visibility(CyclesButtonsPanel, Panel):
         flow.prop(visibility, "shadow")
 
 
+class CyclesParticle_PT_hair(CyclesButtonsPanel, Panel):
+    bl_label = "Hair Rendering"
+    bl_context = "particle"
+
+    @classmethod
+    def poll(cls, context):
+        psys = context.particle_system
+        return CyclesButtonsPanel.poll(context) and psys and psys.settings.type == 'HAIR'
+
+    def draw(self, context):
+        layout = self.layout
+
+        cpart = context.particle_system.settings.cycles
+
+        row = layout.row(align=True)
+        row.prop(cpart, "root_radius", text="Root")
+        row.prop(cpart, "tip_radius", text="Tip")
+
+
 def find_node(material, nodetype):
     if material and material.node_tree:
         ntree = material.node_tree
@@ -29,6 +29,7 @@
 #include "subd_split.h"
 
 #include "util_foreach.h"
+#include "util_hash.h"
 
 #include "mikktspace.h"
 
@@ -374,13 +375,64 @@ static void create_subd_mesh(Mesh *mesh, BL::Mesh b_mesh, PointerRNA *cmesh, con
 	sdmesh.tessellate(&dsplit, false, mesh, used_shaders[0], true);
 }
 
+/* Content Hash
+ *
+ * With persistent data there are no recalc flags between frames, meshes are
+ * recreated and compared against a hash of the previous data instead, to
+ * keep the BVH of meshes that did not change. */
+
+template<typename T>
+static uint hash_vector(const vector<T>& data, uint hash)
+{
+	return (data.size())? hash_data(&data[0], sizeof(T)*data.size(), hash): hash;
+}
+
+static uint mesh_content_hash(Mesh *mesh)
+{
+	uint hash = hash_int(mesh->displacement_method);
+
+	hash = hash_vector(mesh->verts, hash);
+	hash = hash_vector(mesh->triangles, hash);
+	hash = hash_vector(mesh->shader, hash);
+	hash = hash_vector(mesh->used_shaders, hash);
+	hash = hash_vector(mesh->curve_keys, hash);
+	hash = hash_vector(mesh->curves, hash);
+
+	for(size_t i = 0; i < mesh->smooth.size(); i++)
+		hash = hash_int_2d(hash, mesh->smooth[i]);
+
+	foreach(Attribute& attr, mesh->attributes.attributes) {
+		hash = hash_int_2d(hash, hash_string(attr.name.c_str()));
+		hash = hash_int_2d(hash, attr.std);
+		hash = hash_vector(attr.buffer, hash);
+	}
+
+	return hash;
+}
+
+void BlenderSync::prune_mesh_hash()
+{
+	/* remove hashes of meshes that were deleted */
+	set<Mesh*> meshes(scene->meshes.begin(), scene->meshes.end());
+	map<Mesh*, MeshHash>::iterator it = mesh_hash.begin();
+
+	while(it != mesh_hash.end()) {
+		if(meshes.find(it->first) == meshes.end())
+			mesh_hash.erase(it++);
+		else
+			++it;
+	}
+}
+
 /* Sync */
 
-Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated)
+Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated, const Transform& tfm)
 {
-	/* test if we can instance or if the object is modified */
+	/* test if we can instance or if the object is modified. hair is exported
+	 * from the particle systems of the object, so it can't be shared either */
 	BL::ID b_ob_data = b_ob.data();
-	BL::ID key = (BKE_object_is_modified(b_ob))? b_ob: b_ob_data;
+	bool hair = scene->params.use_hair && object_has_hair(b_ob);
+	BL::ID key = (BKE_object_is_modified(b_ob) || hair)? b_ob: b_ob_data;
 	BL::Material material_override = render_layer.material_override;
 
 	/* find shader indices */
@@ -403,8 +455,9 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated)
 	
 	/* test if we need to sync */
 	Mesh *mesh;
+	bool mesh_recalc = mesh_map.sync(&mesh, key);
 
-	if(!mesh_map.sync(&mesh, key)) {
+	if(!mesh_recalc && !verify_all) {
 		/* if transform was applied to mesh, need full update */
 		if(object_updated && mesh->transform_applied);
 		/* test if shaders changed, these can be object level so mesh
@@ -435,6 +488,22 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated)
 	PointerRNA cmesh = RNA_pointer_get(&b_ob_data.ptr, "cycles");
 
 	vector<Mesh::Triangle> oldtriangle = mesh->triangles;
+	size_t oldcurve_keys_size = mesh->curve_keys.size();
+	bool old_transform_applied = mesh->transform_applied;
+	bool old_transform_negative_scaled = mesh->transform_negative_scaled;
+
+	/* background renders with persistent data apply the object transform to
+	 * single user meshes, keep the transformed data to put it back when
+	 * neither the mesh nor the transform changed */
+	vector<float3> oldverts;
+	vector<float4> oldcurve_keys;
+	list<Attribute> oldattributes;
+
+	if(scene->params.persistent_data && old_transform_applied) {
+		oldverts.swap(mesh->verts);
+		oldcurve_keys.swap(mesh->curve_keys);
+		oldattributes.swap(mesh->attributes.attributes);
+	}
 
 	mesh->clear();
 	mesh->used_shaders = used_shaders;
@@ -450,6 +519,10 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated)
 		b_data.meshes.remove(b_mesh);
 	}
 
+	/* hair strands */
+	if(hair)
+		sync_curves(mesh, b_ob, used_shaders);
+
 	/* displacement method */
 	if(cmesh.data) {
 		int method = RNA_enum_get(&cmesh, "displacement_method");
@@ -462,6 +535,41 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated)
 			mesh->displacement_method = Mesh::DISPLACE_BOTH;
 	}
 
+	/* compare with the previous data for persistent data */
+	if(scene->params.persistent_data) {
+		uint hash = mesh_content_hash(mesh);
+		map<Mesh*, MeshHash>::iterator it = mesh_hash.find(mesh);
+		bool unchanged = (!mesh_recalc && it != mesh_hash.end() && it->second.content == hash);
+
+		if(unchanged && old_transform_applied) {
+			/* the hash is of the data before the transform was applied, the
+			 * old data is still valid if the transform is the same too */
+			if(it->second.tfm == tfm) {
+				mesh->verts.swap(oldverts);
+				mesh->curve_keys.swap(oldcurve_keys);
+				mesh->attributes.attributes.swap(oldattributes);
+				mesh->transform_applied = true;
+				mesh->transform_negative_scaled = old_transform_negative_scaled;
+
+				return mesh;
+			}
+		}
+
+		MeshHash& mesh_data_hash = mesh_hash[mesh];
+		mesh_data_hash.content = hash;
+		mesh_data_hash.tfm = tfm;
+
+		/* nothing to update, unless displacement was applied to the old data
+		 * and needs to be applied again. normals are only added by the mesh
+		 * manager on update, so restore them here */
+		if(unchanged && !old_transform_applied && mesh->displacement_method == Mesh::DISPLACE_BUMP) {
+			mesh->add_face_normals();
+			mesh->add_vertex_normals();
+
+			return mesh;
+		}
+	}
+
 	/* tag update */
 	bool rebuild = false;
 
@@ -471,6 +579,9 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated)
 		if(memcmp(&oldtriangle[0], &mesh->triangles[0], sizeof(Mesh::Triangle)*oldtriangle.size()) != 0)
 			rebuild = true;
 	}
+
+	if(oldcurve_keys_size != mesh->curve_keys.size())
+		rebuild = true;
 	
 	mesh->tag_update(scene, rebuild);
 
@@ -479,7 +590,7 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated)
 
 void BlenderSync::sync_mesh_motion(BL::Object b_ob, Mesh *mesh, int motion)
 {
-	/* todo: displacement, subdivision */
+	/* todo: displacement, subdivision, hair */
 	size_t size = mesh->verts.size();
 
 	/* skip objects without deforming modifiers. this is not a totally reliable,
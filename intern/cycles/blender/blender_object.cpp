@@ -92,7 +92,7 @@ void BlenderSync::sync_light(BL::Object b_parent, int persistent_id[OBJECT_PERSI
 	Light *light;
 	ObjectKey key(b_parent, persistent_id, b_ob);
 
-	if(!light_map.sync(&light, b_ob, b_parent, key))
+	if(!light_map.sync(&light, b_ob, b_parent, key) && !verify_all)
 		return;
 	
 	BL::Lamp b_lamp(b_ob.data());
@@ -176,7 +176,7 @@ void BlenderSync::sync_background_light()
 			ObjectKey key(b_world, 0, b_world);
 
 			if(light_map.sync(&light, b_world, b_world, key) ||
-			   world_recalc ||
+			   world_recalc || verify_all ||
 			   b_world.ptr.data != world_map)
 			{
 				light->type = LIGHT_BACKGROUND;
@@ -196,6 +196,13 @@ void BlenderSync::sync_background_light()
 
 /* Object */
 
+Object *BlenderSync::find_object(BL::Object b_ob)
+{
+	/* same key as sync_objects() uses for objects that are not duplis */
+	ObjectKey key(b_ob, NULL, b_ob);
+	return object_map.find(key);
+}
+
 Object *BlenderSync::sync_object(BL::Object b_parent, int persistent_id[OBJECT_PERSISTENT_ID_SIZE], BL::DupliObject b_dupli_ob, Transform& tfm, uint layer_flag, int motion)
 {
 	BL::Object b_ob = (b_dupli_ob ? b_dupli_ob.object() : b_parent);
@@ -228,6 +235,10 @@ Object *BlenderSync::sync_object(BL::Object b_parent, int persistent_id[OBJECT_P
 					object->motion.post = tfm;
 
 				object->use_motion = true;
+
+				/* without recalc flags the object may not be tagged yet */
+				if(verify_all)
+					object->tag_update(scene);
 			}
 
 			/* mesh deformation blur not supported yet */
@@ -247,7 +258,7 @@ Object *BlenderSync::sync_object(BL::Object b_parent, int persistent_id[OBJECT_P
 	bool use_holdout = (layer_flag & render_layer.holdout_layer) != 0;
 	
 	/* mesh sync */
-	object->mesh = sync_mesh(b_ob, object_updated);
+	object->mesh = sync_mesh(b_ob, object_updated, tfm);
 
 	/* sspecial case not tracked by object update flags */
 	if(use_holdout != object->use_holdout) {
@@ -259,7 +270,20 @@ Object *BlenderSync::sync_object(BL::Object b_parent, int persistent_id[OBJECT_P
 	/* object sync
 	 * transform comparison should not be needed, but duplis don't work perfect
 	 * in the depsgraph and may not signal changes, so this is a workaround */
-	if(object_updated || (object->mesh && object->mesh->need_update) || tfm != object->tfm) {
+	if(tfm != object->tfm)
+		object_updated = true;
+	if(object->mesh && object->mesh->need_update)
+		object_updated = true;
+
+	if(object_updated || verify_all) {
+		/* without recalc flags, compare settings to find changes */
+		uint prev_visibility = object->visibility;
+		uint prev_random_id = object->random_id;
+		int prev_pass_id = object->pass_id;
+		float3 prev_dupli_generated = object->dupli_generated;
+		float2 prev_dupli_uv = object->dupli_uv;
+		bool prev_use_motion = object->use_motion;
+
 		object->name = b_ob.name().c_str();
 		object->pass_id = b_ob.pass_index();
 		object->tfm = tfm;
@@ -304,7 +328,18 @@ Object *BlenderSync::sync_object(BL::Object b_parent, int persistent_id[OBJECT_P
 			object->dupli_uv = make_float2(0.0f, 0.0f);
 		}
 
-		object->tag_update(scene);
+		if(object->visibility != prev_visibility ||
+		   object->random_id != prev_random_id ||
+		   object->pass_id != prev_pass_id ||
+		   object->dupli_generated != prev_dupli_generated ||
+		   object->dupli_uv != prev_dupli_uv ||
+		   prev_use_motion)
+		{
+			object_updated = true;
+		}
+
+		if(object_updated)
+			object->tag_update(scene);
 	}
 
 	return object;
@@ -424,6 +459,8 @@ void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, int motion)
 			scene->light_manager->tag_update(scene);
 		if(mesh_map.post_sync())
 			scene->mesh_manager->tag_update(scene);
+		if(mesh_hash.size() > scene->meshes.size())
+			prune_mesh_hash();
 		if(object_map.post_sync())
 			scene->object_manager->tag_update(scene);
 		if(particle_system_map.post_sync())
@@ -54,7 +54,7 @@ bool BlenderSync::sync_dupli_particle(BL::Object b_ob, BL::DupliObject b_dup, Ob
 	bool need_update = particle_system_map.sync(&psys, b_ob, b_dup.object(), key);
 
 	/* no update needed? */
-	if(!need_update && !object->mesh->need_update && !scene->object_manager->need_update)
+	if(!need_update && !object->mesh->need_update && !scene->object_manager->need_update && !verify_all)
 		return true;
 
 	/* first time used in this sync loop? clear and tag update */
@@ -82,4 +82,52 @@ bool BlenderSync::sync_dupli_particle(BL::Object b_ob, BL::DupliObject b_dup, Ob
 	return true;
 }
 
+/* Hair Curves */
+
+void BlenderSync::sync_curves(Mesh *mesh, BL::Object b_ob, const vector<uint>& used_shaders)
+{
+	/* export the parent strands of hair particle systems as curves in object
+	 * space. child strands are generated on the fly by the particle system
+	 * when drawing and are not available here */
+	BL::Object::particle_systems_iterator b_psys;
+
+	for(b_ob.particle_systems.begin(b_psys); b_psys != b_ob.particle_systems.end(); ++b_psys) {
+		BL::ParticleSettings b_part = b_psys->settings();
+
+		if(b_part.type() != BL::ParticleSettings::type_HAIR)
+			continue;
+		if(b_part.render_type() != BL::ParticleSettings::render_type_PATH)
+			continue;
+
+		PointerRNA cpart = RNA_pointer_get(&b_part.ptr, "cycles");
+		float root_radius = get_float(cpart, "root_radius");
+		float tip_radius = get_float(cpart, "tip_radius");
+
+		int mi = clamp(b_part.material() - 1, 0, (int)used_shaders.size() - 1);
+		int shader = used_shaders[mi];
+
+		BL::ParticleSystem::particles_iterator b_pa;
+
+		for(b_psys->particles.begin(b_pa); b_pa != b_psys->particles.end(); ++b_pa) {
+			int num_keys = b_pa->hair_keys.length();
+
+			if(num_keys < 2)
+				continue;
+
+			/* radius is interpolated from root to tip */
+			int first_key = mesh->curve_keys.size();
+			int k = 0;
+
+			BL::Particle::hair_keys_iterator b_key;
+
+			for(b_pa->hair_keys.begin(b_key); b_key != b_pa->hair_keys.end(); ++b_key, ++k) {
+				float t = (float)k/(float)(num_keys - 1);
+				mesh->add_curve_key(get_float3(b_key->co()), lerp(root_radius, tip_radius, t));
+			}
+
+			mesh->add_curve(first_key, num_keys, shader);
+		}
+	}
+}
+
 CCL_NAMESPACE_END
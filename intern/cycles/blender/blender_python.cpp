@@ -23,6 +23,8 @@
 #include "blender_sync.h"
 #include "blender_session.h"
 
+#include "shader.h"
+
 #include "util_foreach.h"
 #include "util_md5.h"
 #include "util_opengl.h"
@@ -126,6 +128,91 @@ static PyObject *render_func(PyObject *self, PyObject *value)
 	Py_RETURN_NONE;
 }
 
+static PyObject *bake_func(PyObject *self, PyObject *args)
+{
+	PyObject *pysession, *pyobject;
+	PyObject *pypixel_array, *pyresult;
+	const char *pass_type;
+	int num_pixels, depth;
+
+	if(!PyArg_ParseTuple(args, "OOsOiiO", &pysession, &pyobject, &pass_type, &pypixel_array, &num_pixels, &depth, &pyresult))
+		return NULL;
+
+	BlenderSession *session = (BlenderSession*)PyLong_AsVoidPtr(pysession);
+
+	PointerRNA objectptr;
+	RNA_id_pointer_create((ID*)PyLong_AsVoidPtr(pyobject), &objectptr);
+	BL::Object b_object(objectptr);
+
+	void *b_result = PyLong_AsVoidPtr(pyresult);
+
+	PointerRNA bakepixelptr;
+	RNA_pointer_create(NULL, &RNA_BakePixel, PyLong_AsVoidPtr(pypixel_array), &bakepixelptr);
+	BL::BakePixel b_bake_pixel(bakepixelptr);
+
+	Py_BEGIN_ALLOW_THREADS
+
+	session->bake(b_object, pass_type, b_bake_pixel, num_pixels, depth, (float *)b_result);
+
+	Py_END_ALLOW_THREADS
+
+	Py_RETURN_NONE;
+}
+
+static PyObject *profiling_stats_func(PyObject *self, PyObject *value)
+{
+	BlenderSession *session = (BlenderSession*)PyLong_AsVoidPtr(value);
+	Scene *scene = session->session->scene;
+
+	ProfilingStats stats;
+	session->session->progress.get_profiling_stats(stats);
+
+	PyObject *ret = PyDict_New();
+	PyObject *item;
+
+#define PROFILING_SET_ITEM(name, value) \
+	item = PyLong_FromUnsignedLongLong(value); \
+	PyDict_SetItemString(ret, name, item); \
+	Py_DECREF(item);
+
+	PROFILING_SET_ITEM("camera_rays", stats.rays[PROFILING_RAY_CAMERA]);
+	PROFILING_SET_ITEM("reflection_rays", stats.rays[PROFILING_RAY_REFLECT]);
+	PROFILING_SET_ITEM("transmission_rays", stats.rays[PROFILING_RAY_TRANSMIT]);
+	PROFILING_SET_ITEM("shadow_rays", stats.rays[PROFILING_RAY_SHADOW]);
+	PROFILING_SET_ITEM("bvh_nodes", stats.bvh_nodes);
+	PROFILING_SET_ITEM("bvh_primitives", stats.bvh_primitives);
+	PROFILING_SET_ITEM("light_samples", stats.light_samples);
+	PROFILING_SET_ITEM("image_lookups", stats.image_lookups);
+
+#undef PROFILING_SET_ITEM
+
+	/* shader name -> (evaluations, nodes executed) */
+	PyObject *shaders = PyDict_New();
+
+	for(size_t i = 0; i < stats.shader_evals.size() && i < scene->shaders.size(); i++) {
+		if(stats.shader_evals[i] == 0)
+			continue;
+
+		item = Py_BuildValue("(KK)",
+			(unsigned long long)stats.shader_evals[i], (unsigned long long)stats.shader_nodes[i]);
+		PyDict_SetItemString(shaders, scene->shaders[i]->name.c_str(), item);
+		Py_DECREF(item);
+	}
+
+	PyDict_SetItemString(ret, "shaders", shaders);
+	Py_DECREF(shaders);
+
+	return ret;
+}
+
+static PyObject *profiling_report_func(PyObject *self, PyObject *value)
+{
+	BlenderSession *session = (BlenderSession*)PyLong_AsVoidPtr(value);
+	string report = session->session->profiling_report();
+
+	return PyUnicode_FromString(report.c_str());
+}
+
 static PyObject *draw_func(PyObject *self, PyObject *args)
 {
 	PyObject *pysession, *pyv3d, *pyrv3d;
@@ -378,6 +465,9 @@ static PyMethodDef methods[] = {
 	{"create", create_func, METH_VARARGS, ""},
 	{"free", free_func, METH_O, ""},
 	{"render", render_func, METH_O, ""},
+	{"bake", bake_func, METH_VARARGS, ""},
+	{"profiling_stats", profiling_stats_func, METH_O, ""},
+	{"profiling_report", profiling_report_func, METH_O, ""},
 	{"draw", draw_func, METH_VARARGS, ""},
 	{"sync", sync_func, METH_O, ""},
 	{"reset", reset_func, METH_VARARGS, ""},
@@ -17,12 +17,14 @@
  */
 
 #include "background.h"
+#include "bake.h"
 #include "buffers.h"
 #include "camera.h"
 #include "device.h"
 #include "integrator.h"
 #include "film.h"
 #include "light.h"
+#include "object.h"
 #include "scene.h"
 #include "session.h"
 #include "shader.h"
@@ -116,6 +118,7 @@ void BlenderSession::reset_session(BL::BlendData b_data_, BL::Scene b_scene_)
 
 	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background);
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
+	scene_params.limit_to_device(session_params.device);
 
 	width = b_engine.resolution_x();
 	height = b_engine.resolution_y();
@@ -127,7 +130,7 @@ void BlenderSession::reset_session(BL::BlendData b_data_, BL::Scene b_scene_)
 		 * them rather than trying to distinguish which settings need to be updated
 		 */
 
-		delete session;
+		free_session();
 
 		create_session();
 
@@ -142,8 +145,16 @@ void BlenderSession::reset_session(BL::BlendData b_data_, BL::Scene b_scene_)
 	 */
 	session->stats.mem_peak = session->stats.mem_used;
 
-	/* sync object should be re-created */
-	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+	if(sync) {
+		/* with persistent data the scene was kept from the previous render,
+		 * the sync object then only updates what changed */
+		sync->reset(b_data, b_scene);
+	}
+	else {
+		/* sync object should be re-created */
+		sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+	}
+
 	sync->sync_data(b_v3d, b_engine.camera_override());
 	sync->sync_camera(b_engine.camera_override(), width, height);
 
@@ -272,6 +283,27 @@ void BlenderSession::update_render_tile(RenderTile& rtile)
 	do_write_update_render_tile(rtile, true);
 }
 
+string BlenderSession::checkpoint_filepath()
+{
+	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+	string dirpath = get_string(cscene, "checkpoint_directory");
+
+	/* only final renders from the command line can be resumed */
+	if(!background || dirpath == "")
+		return "";
+
+	dirpath = blender_absolute_path(b_data, b_scene, dirpath);
+
+	string blendname = path_filename(b_data.filepath());
+	if(blendname == "")
+		blendname = "untitled";
+
+	string filename = string_printf("%s_%s_%s_%04d.ckpt", blendname.c_str(),
+		b_scene.name().c_str(), b_rlay_name.c_str(), b_scene.frame_current());
+
+	return path_join(dirpath, filename);
+}
+
 void BlenderSession::render()
 {
 	/* set callback to write out render results */
@@ -282,6 +314,10 @@ void BlenderSession::render()
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
 	BufferParams buffer_params = BlenderSync::get_buffer_params(b_scene, b_v3d, b_rv3d, scene->camera, width, height);
 
+	/* profiling counts all layers, but only this frame with persistent data */
+	if(session->params.profiling)
+		session->device->reset_profiling_stats();
+
 	/* render each layer */
 	BL::RenderSettings r = b_scene.render();
 	BL::RenderSettings::layers_iterator b_iter;
@@ -322,6 +358,10 @@ void BlenderSession::render()
 			}
 		}
 
+		/* error estimate for adaptive sampling, not written to the render result */
+		if(session_params.adaptive_threshold > 0.0f)
+			Pass::add(PASS_ADAPTIVE_AUX, passes);
+
 		/* free result without merging */
 		end_render_result(b_engine, b_rr, true);
 
@@ -336,6 +376,7 @@ void BlenderSession::render()
 		/* update session */
 		int samples = sync->get_layer_samples();
 		session->reset(buffer_params, (samples == 0)? session_params.samples: samples);
+		session->checkpoint_path = checkpoint_filepath();
 
 		/* render */
 		session->start();
@@ -348,15 +389,81 @@ void BlenderSession::render()
 	/* clear callback */
 	session->write_render_tile_cb = NULL;
 	session->update_render_tile_cb = NULL;
+	session->checkpoint_path = "";
 
 	/* free all memory used (host and device), so we wouldn't leave render
-	 * engine with extra memory allocated
+	 * engine with extra memory allocated, unless it is kept for the next
+	 * render with persistent data
 	 */
+	if(!scene->params.persistent_data) {
+		session->device_free();
+
+		delete sync;
+		sync = NULL;
+	}
+}
+
+static ShaderEvalType get_shader_type(const string& pass_type)
+{
+	const char *shader_type = pass_type.c_str();
+
+	/* same as blender's bake pass types */
+	if(strcmp(shader_type, "AO") == 0)
+		return SHADER_EVAL_BAKE_AO;
+	else if(strcmp(shader_type, "NORMAL") == 0)
+		return SHADER_EVAL_BAKE_NORMAL;
+	else if(strcmp(shader_type, "DIFFUSE_DIRECT") == 0)
+		return SHADER_EVAL_BAKE_DIFFUSE_DIRECT;
+	else if(strcmp(shader_type, "DIFFUSE_INDIRECT") == 0)
+		return SHADER_EVAL_BAKE_DIFFUSE_INDIRECT;
+	else if(strcmp(shader_type, "GLOSSY_DIRECT") == 0)
+		return SHADER_EVAL_BAKE_GLOSSY_DIRECT;
+	else if(strcmp(shader_type, "GLOSSY_INDIRECT") == 0)
+		return SHADER_EVAL_BAKE_GLOSSY_INDIRECT;
+	else
+		return SHADER_EVAL_BAKE_COMBINED;
+}
+
+void BlenderSession::bake(BL::Object b_object, const string& pass_type, BL::BakePixel pixel_array, int num_pixels, int depth, float result[])
+{
+	/* only the CPU kernel is compiled with baking */
+	if(session->params.device.type != DEVICE_CPU)
+		return;
 
-	session->device_free();
+	ShaderEvalType shader_type = get_shader_type(pass_type);
+
+	/* find the synced object, it is missing if not visible for rendering */
+	Object *object = (sync)? sync->find_object(b_object): NULL;
+	int object_index = -1;
+
+	for(size_t i = 0; object && i < scene->objects.size(); i++) {
+		if(scene->objects[i] == object) {
+			object_index = i;
+			break;
+		}
+	}
 
-	delete sync;
-	sync = NULL;
+	if(object_index == -1)
+		return;
+
+	/* pixels to bake, triangle and barycentric coordinates */
+	BakeData bake_data(object_index, num_pixels);
+	BL::BakePixel bp = pixel_array;
+
+	for(int i = 0; i < num_pixels; i++) {
+		int prim = bp.primitive_id();
+
+		if(prim != -1) {
+			float2 uv = get_float2(bp.uv());
+			bake_data.set(i, prim, uv.x, uv.y);
+		}
+
+		bp = bp.next();
+	}
+
+	session->bake(shader_type, &bake_data, result, depth);
+
+	update_status_progress();
 }
 
 void BlenderSession::do_write_update_render_result(BL::RenderResult b_rr, BL::RenderLayer b_rlay, RenderTile& rtile, bool do_update_only)
@@ -412,6 +519,7 @@ void BlenderSession::synchronize()
 	/* on session/scene parameter changes, we recreate session entirely */
 	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background);
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
+	scene_params.limit_to_device(session_params.device);
 
 	if(session->params.modified(session_params) ||
 	   scene->params.modified(scene_params))
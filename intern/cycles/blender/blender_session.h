@@ -50,6 +50,10 @@ public:
 
 	/* offline render */
 	void render();
+	string checkpoint_filepath();
+
+	/* texture baking */
+	void bake(BL::Object b_object, const string& pass_type, BL::BakePixel pixel_array, int num_pixels, int depth, float result[]);
 
 	void write_render_result(BL::RenderResult b_rr, BL::RenderLayer b_rlay, RenderTile& rtile);
 	void write_render_tile(RenderTile& rtile);
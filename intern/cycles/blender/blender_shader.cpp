@@ -985,11 +985,14 @@ void BlenderSync::sync_shaders()
 		auto_refresh_update = image_manager->set_animation_frame_update(frame);
 	}
 
+	/* without recalc flags for persistent data, all shaders are updated */
+	bool update_all = auto_refresh_update || verify_all;
+
 	shader_map.pre_sync();
 
-	sync_world(auto_refresh_update);
-	sync_lamps(auto_refresh_update);
-	sync_materials(auto_refresh_update);
+	sync_world(update_all);
+	sync_lamps(update_all);
+	sync_materials(update_all);
 
 	/* false = don't delete unused shaders, not supported */
 	shader_map.post_sync(false);
@@ -51,6 +51,7 @@ BlenderSync::BlenderSync(BL::RenderEngine b_engine_, BL::BlendData b_data_, BL::
   particle_system_map(&scene_->particle_systems),
   world_map(NULL),
   world_recalc(false),
+  verify_all(false),
   experimental(false),
   progress(progress_)
 {
@@ -62,6 +63,19 @@ BlenderSync::~BlenderSync()
 {
 }
 
+/* Persistent Data */
+
+void BlenderSync::reset(BL::BlendData b_data_, BL::Scene b_scene_)
+{
+	/* the scene data from the previous render is reused. recalc flags are
+	 * already cleared by the frame change at this point, so the next sync
+	 * compares the data with what is in the scene to find changes */
+	b_data = b_data_;
+	b_scene = b_scene_;
+
+	verify_all = true;
+}
+
 /* Sync */
 
 bool BlenderSync::sync_recalc()
@@ -143,6 +157,8 @@ void BlenderSync::sync_data(BL::SpaceView3D b_v3d, BL::Object b_override, const
 	sync_shaders();
 	sync_objects(b_v3d);
 	sync_motion(b_v3d, b_override);
+
+	verify_all = false;
 }
 
 /* Integrator */
@@ -302,9 +318,13 @@ SceneParams BlenderSync::get_scene_params(BL::Scene b_scene, bool background)
 		params.bvh_type = (SceneParams::BVHType)RNA_enum_get(&cscene, "debug_bvh_type");
 
 	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
+	params.use_qbvh = RNA_boolean_get(&cscene, "debug_use_qbvh");
+	params.bvh_refit_threshold = RNA_float_get(&cscene, "debug_bvh_refit_threshold");
 	params.use_bvh_cache = (background)? RNA_boolean_get(&cscene, "use_cache"): false;
 
-	params.persistent_images = (background)? r.use_persistent_data(): false;
+	params.persistent_data = (background)? r.use_persistent_data(): false;
+
+	params.texture_cache_size = (size_t)RNA_int_get(&cscene, "texture_cache_size")*1024*1024;
 
 	return params;
 }
@@ -413,6 +433,22 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine b_engine, BL::Use
 	else
 		params.progressive = true;
 
+	/* adaptive sampling, needs the samples of a tile rendered at once
+	 * and the buffers on the host */
+	if(get_boolean(cscene, "use_adaptive_sampling") &&
+	   background && !params.progressive_refine && params.device.type == DEVICE_CPU)
+	{
+		params.adaptive_threshold = get_float(cscene, "adaptive_threshold");
+		params.adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+	}
+
+	/* profiling counters, only collected by the CPU kernel */
+	if(background && params.device.type == DEVICE_CPU)
+		params.profiling = get_boolean(cscene, "use_profiling");
+
+	/* checkpoints, the file path is set per render layer by the session */
+	params.checkpoint_interval = (double)get_int(cscene, "checkpoint_interval");
+
 	/* shading system - scene level needs full refresh */
 	int shadingsystem = RNA_enum_get(&cscene, "shading_system");
 
@@ -53,6 +53,9 @@ public:
 	BlenderSync(BL::RenderEngine b_engine_, BL::BlendData b_data, BL::Scene b_scene, Scene *scene_, bool preview_, Progress &progress_);
 	~BlenderSync();
 
+	/* persistent data */
+	void reset(BL::BlendData b_data, BL::Scene b_scene);
+
 	/* sync */
 	bool sync_recalc();
 	void sync_data(BL::SpaceView3D b_v3d, BL::Object b_override, const char *layer = 0);
@@ -60,6 +63,9 @@ public:
 	void sync_view(BL::SpaceView3D b_v3d, BL::RegionView3D b_rv3d, int width, int height);
 	int get_layer_samples() { return render_layer.samples; }
 
+	/* synced object for a blender object itself, not its duplis */
+	Object *find_object(BL::Object b_ob);
+
 	/* get parameters */
 	static SceneParams get_scene_params(BL::Scene b_scene, bool background);
 	static SessionParams get_session_params(BL::RenderEngine b_engine, BL::UserPreferences b_userpref, BL::Scene b_scene, bool background);
@@ -80,7 +86,8 @@ private:
 	void sync_shaders();
 
 	void sync_nodes(Shader *shader, BL::ShaderNodeTree b_ntree);
-	Mesh *sync_mesh(BL::Object b_ob, bool object_updated);
+	Mesh *sync_mesh(BL::Object b_ob, bool object_updated, const Transform& tfm);
+	void prune_mesh_hash();
 	Object *sync_object(BL::Object b_parent, int persistent_id[OBJECT_PERSISTENT_ID_SIZE], BL::DupliObject b_dupli_object, Transform& tfm, uint layer_flag, int motion);
 	void sync_light(BL::Object b_parent, int persistent_id[OBJECT_PERSISTENT_ID_SIZE], BL::Object b_ob, Transform& tfm);
 	void sync_background_light();
@@ -89,6 +96,7 @@ private:
 
 	/* particles */
 	bool sync_dupli_particle(BL::Object b_ob, BL::DupliObject b_dup, Object *object);
+	void sync_curves(Mesh *mesh, BL::Object b_ob, const vector<uint>& used_shaders);
 
 	/* util */
 	void find_shader(BL::ID id, vector<uint>& used_shaders, int default_shader);
@@ -107,8 +115,16 @@ private:
 	id_map<ObjectKey, Light> light_map;
 	id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
 	set<Mesh*> mesh_synced;
+	/* content hash of mesh data before the object transform was applied to
+	 * it, and that transform */
+	struct MeshHash {
+		uint content;
+		Transform tfm;
+	};
+	map<Mesh*, MeshHash> mesh_hash;
 	void *world_map;
 	bool world_recalc;
+	bool verify_all;
 
 	Scene *scene;
 	bool preview;
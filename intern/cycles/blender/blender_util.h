@@ -19,6 +19,8 @@
 #ifndef __BLENDER_UTIL_H__
 #define __BLENDER_UTIL_H__
 
+#include "MEM_guardedalloc.h"
+
 #include "util_map.h"
 #include "util_path.h"
 #include "util_set.h"
@@ -62,6 +64,21 @@ static inline bool BKE_object_is_deform_modified(BL::Object self, BL::Scene scen
 	return self.is_deform_modified(scene, (preview)? (1<<0): (1<<1))? true: false;
 }
 
+static inline bool object_has_hair(BL::Object self)
+{
+	BL::Object::particle_systems_iterator b_psys;
+
+	for(self.particle_systems.begin(b_psys); b_psys != self.particle_systems.end(); ++b_psys) {
+		BL::ParticleSettings b_part = b_psys->settings();
+
+		if(b_part.type() == BL::ParticleSettings::type_HAIR &&
+		   b_part.render_type() == BL::ParticleSettings::render_type_PATH)
+			return true;
+	}
+
+	return false;
+}
+
 static inline string image_user_file_path(BL::ImageUser iuser, BL::Image ima, int cfra)
 {
 	char filepath[1024];
@@ -183,6 +200,18 @@ static inline int get_enum(PointerRNA& ptr, const char *name)
 	return RNA_enum_get(&ptr, name);
 }
 
+static inline string get_string(PointerRNA& ptr, const char *name)
+{
+	char cstrbuf[1024];
+	char *cstr = RNA_string_get_alloc(&ptr, name, cstrbuf, sizeof(cstrbuf));
+	string str(cstr);
+
+	if(cstr != cstrbuf)
+		MEM_freeN(cstr);
+
+	return str;
+}
+
 static inline string get_enum_identifier(PointerRNA& ptr, const char *name)
 {
 	PropertyRNA *prop = RNA_struct_find_property(&ptr, name);
@@ -56,6 +56,9 @@ struct BVHStackEntry
 BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
 : params(params_), objects(objects_)
 {
+	build_SAH = 0.0f;
+	refit_SAH = 0.0f;
+	top_level_prims = 0;
 }
 
 BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
@@ -75,6 +78,8 @@ bool BVH::cache_read(CacheData& key)
 	foreach(Object *ob, objects) {
 		key.add(ob->mesh->verts);
 		key.add(ob->mesh->triangles);
+		key.add(ob->mesh->curve_keys);
+		key.add(ob->mesh->curves);
 		key.add(&ob->bounds, sizeof(ob->bounds));
 		key.add(&ob->visibility, sizeof(ob->visibility));
 		key.add(&ob->mesh->transform_applied, sizeof(bool));
@@ -94,6 +99,7 @@ bool BVH::cache_read(CacheData& key)
 		value.read(pack.prim_visibility);
 		value.read(pack.prim_index);
 		value.read(pack.prim_object);
+		value.read(pack.prim_segment);
 		value.read(pack.is_leaf);
 
 		return true;
@@ -115,6 +121,7 @@ void BVH::cache_write(CacheData& key)
 	value.add(pack.prim_visibility);
 	value.add(pack.prim_index);
 	value.add(pack.prim_object);
+	value.add(pack.prim_segment);
 	value.add(pack.is_leaf);
 
 	Cache::global.insert(key, value);
@@ -159,8 +166,9 @@ void BVH::build(Progress& progress)
 	/* build nodes */
 	vector<int> prim_index;
 	vector<int> prim_object;
+	vector<uint> prim_segment;
 
-	BVHBuild bvh_build(objects, prim_index, prim_object, params, progress);
+	BVHBuild bvh_build(objects, prim_index, prim_object, prim_segment, params, progress);
 	BVHNode *root = bvh_build.run();
 
 	if(progress.get_cancel()) {
@@ -171,6 +179,7 @@ void BVH::build(Progress& progress)
 	/* todo: get rid of this copy */
 	pack.prim_index = prim_index;
 	pack.prim_object = prim_object;
+	pack.prim_segment = prim_segment;
 
 	/* compute SAH */
 	if(!params.top_level)
@@ -215,13 +224,29 @@ void BVH::build(Progress& progress)
 
 void BVH::refit(Progress& progress)
 {
+	if(params.top_level) {
+		/* remove the merged instances, they are merged again after refitting
+		 * since their own BVH may have changed */
+		size_t nsize = (params.use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+
+		pack.nodes.resize(pack.is_leaf.size()*nsize);
+		pack.prim_index.resize(top_level_prims);
+		pack.prim_object.resize(top_level_prims);
+		pack.prim_segment.resize(top_level_prims);
+
+		for(size_t i = 0; i < pack.prim_index.size(); i++)
+			if(pack.prim_index[i] != -1)
+				pack.prim_index[i] -= prim_offset(i);
+	}
+
 	progress.set_substatus("Packing BVH triangles");
 	pack_triangles();
 
-	if(progress.get_cancel()) return;
-
 	progress.set_substatus("Refitting BVH nodes");
 	refit_nodes();
+
+	if(params.top_level)
+		pack_instances(pack.nodes.size());
 }
 
 /* Triangles */
@@ -277,7 +302,12 @@ void BVH::pack_triangles()
 		if(pack.prim_index[i] != -1) {
 			float4 woop[3];
 
-			pack_triangle(i, woop);
+			/* curves are intersected using their keys */
+			if(pack.prim_segment[i] != ~0)
+				memset(woop, 0, sizeof(woop));
+			else
+				pack_triangle(i, woop);
+
 			memcpy(&pack.tri_woop[i * nsize], woop, sizeof(float4)*3);
 
 			int tob = pack.prim_object[i];
@@ -287,6 +317,14 @@ void BVH::pack_triangles()
 	}
 }
 
+/* offset of the mesh primitives in the global triangle or curve arrays */
+
+size_t BVH::prim_offset(size_t idx)
+{
+	const Mesh *mesh = objects[pack.prim_object[idx]]->mesh;
+	return (pack.prim_segment[idx] != ~0)? mesh->curve_offset: mesh->tri_offset;
+}
+
 /* Pack Instances */
 
 void BVH::pack_instances(size_t nodes_size)
@@ -297,11 +335,13 @@ void BVH::pack_instances(size_t nodes_size)
 	bool use_qbvh = params.use_qbvh;
 	size_t nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
 
+	top_level_prims = pack.prim_index.size();
+
 	/* adjust primitive index to point to the triangle in the global array, for
 	 * meshes with transform applied and already in the top level BVH */
 	for(size_t i = 0; i < pack.prim_index.size(); i++)
 		if(pack.prim_index[i] != -1)
-			pack.prim_index[i] += objects[pack.prim_object[i]]->mesh->tri_offset;
+			pack.prim_index[i] += prim_offset(i);
 
 	/* track offsets of instanced BVH data in global array */
 	size_t tri_offset = pack.prim_index.size();
@@ -329,7 +369,7 @@ void BVH::pack_instances(size_t nodes_size)
 			if(mesh_map.find(mesh) == mesh_map.end()) {
 				prim_index_size += bvh->pack.prim_index.size();
 				tri_woop_size += bvh->pack.tri_woop.size();
-				nodes_size += bvh->pack.nodes.size()*nsize;
+				nodes_size += bvh->pack.nodes.size();
 
 				mesh_map[mesh] = 1;
 			}
@@ -340,6 +380,7 @@ void BVH::pack_instances(size_t nodes_size)
 
 	pack.prim_index.resize(prim_index_size);
 	pack.prim_object.resize(prim_index_size);
+	pack.prim_segment.resize(prim_index_size);
 	pack.prim_visibility.resize(prim_index_size);
 	pack.tri_woop.resize(tri_woop_size);
 	pack.nodes.resize(nodes_size);
@@ -347,6 +388,7 @@ void BVH::pack_instances(size_t nodes_size)
 
 	int *pack_prim_index = (pack.prim_index.size())? &pack.prim_index[0]: NULL;
 	int *pack_prim_object = (pack.prim_object.size())? &pack.prim_object[0]: NULL;
+	uint *pack_prim_segment = (pack.prim_segment.size())? &pack.prim_segment[0]: NULL;
 	uint *pack_prim_visibility = (pack.prim_visibility.size())? &pack.prim_visibility[0]: NULL;
 	float4 *pack_tri_woop = (pack.tri_woop.size())? &pack.tri_woop[0]: NULL;
 	int4 *pack_nodes = (pack.nodes.size())? &pack.nodes[0]: NULL;
@@ -376,6 +418,7 @@ void BVH::pack_instances(size_t nodes_size)
 
 		int noffset = nodes_offset/nsize;
 		int mesh_tri_offset = mesh->tri_offset;
+		int mesh_curve_offset = mesh->curve_offset;
 
 		/* fill in node indexes for instances */
 		if((bvh->pack.is_leaf.size() != 0) && bvh->pack.is_leaf[0])
@@ -389,10 +432,16 @@ void BVH::pack_instances(size_t nodes_size)
 		if(bvh->pack.prim_index.size()) {
 			size_t bvh_prim_index_size = bvh->pack.prim_index.size();
 			int *bvh_prim_index = &bvh->pack.prim_index[0];
+			uint *bvh_prim_segment = &bvh->pack.prim_segment[0];
 			uint *bvh_prim_visibility = &bvh->pack.prim_visibility[0];
 
 			for(size_t i = 0; i < bvh_prim_index_size; i++) {
-				pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + mesh_tri_offset;
+				if(bvh_prim_segment[i] != ~0)
+					pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + mesh_curve_offset;
+				else
+					pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + mesh_tri_offset;
+
+				pack_prim_segment[pack_prim_index_offset] = bvh_prim_segment[i];
 				pack_prim_visibility[pack_prim_index_offset] = bvh_prim_visibility[i];
 				pack_prim_object[pack_prim_index_offset] = 0;  // unused for instances
 				pack_prim_index_offset++;
@@ -502,6 +551,8 @@ void RegularBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
 	vector<BVHStackEntry> stack;
 	stack.push_back(BVHStackEntry(root, nextNodeIdx++));
 
+	float SAH = 0.0f;
+
 	while(stack.size()) {
 		BVHStackEntry e = stack.back();
 		stack.pop_back();
@@ -512,6 +563,8 @@ void RegularBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
 			/* leaf node */
 			const LeafNode* leaf = reinterpret_cast<const LeafNode*>(e.node);
 			pack_leaf(e, leaf);
+
+			SAH += leaf->m_bounds.safe_area() * params.triangle_cost(leaf->num_triangles());
 		}
 		else {
 			/* innner node */
@@ -519,23 +572,31 @@ void RegularBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
 			stack.push_back(BVHStackEntry(e.node->get_child(1), nextNodeIdx++));
 
 			pack_inner(e, stack[stack.size()-2], stack[stack.size()-1]);
+
+			SAH += e.node->m_bounds.safe_area() * params.node_cost(2);
 		}
 	}
 
 	/* root index to start traversal at, to handle case of single leaf node */
 	pack.root_index = (pack.is_leaf[0])? -1: 0;
+
+	/* same cost as computed when refitting, relative to the root area */
+	build_SAH = SAH / max(root->m_bounds.safe_area(), FLT_MIN);
+	refit_SAH = build_SAH;
 }
 
 void RegularBVH::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
-	refit_node(0, (pack.is_leaf[0])? true: false, bbox, visibility);
+	float SAH = 0.0f;
+
+	refit_node(0, (pack.is_leaf[0])? true: false, bbox, visibility, SAH);
+
+	refit_SAH = SAH / max(bbox.safe_area(), FLT_MIN);
 }
 
-void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
+void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility, float& SAH)
 {
 	int4 *data = &pack.nodes[idx*4];
 
@@ -543,29 +604,48 @@ void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility
 	int c1 = data[3].y;
 
 	if(leaf) {
-		/* refit leaf node */
-		for(int tri = c0; tri < c1; tri++) {
-			int tidx = pack.prim_index[tri];
-			int tob = pack.prim_object[tri];
-			Object *ob = objects[tob];
+		if(c0 < 0) {
+			/* refit object leaf node, in top level BVH */
+			Object *ob = objects[pack.prim_object[~c0]];
 
-			if(tidx == -1) {
-				/* object instance */
-				bbox.grow(ob->bounds);
-			}
-			else {
-				/* triangles */
-				const Mesh *mesh = ob->mesh;
-				int tri_offset = (params.top_level)? mesh->tri_offset: 0;
-				const int *vidx = mesh->triangles[tidx - tri_offset].v;
-				const float3 *vpos = &mesh->verts[0];
-
-				bbox.grow(vpos[vidx[0]]);
-				bbox.grow(vpos[vidx[1]]);
-				bbox.grow(vpos[vidx[2]]);
+			bbox.grow(ob->bounds);
+			visibility |= ob->visibility;
+
+			SAH += bbox.safe_area() * params.triangle_cost(1);
+		}
+		else {
+			/* refit leaf node */
+			for(int tri = c0; tri < c1; tri++) {
+				int tidx = pack.prim_index[tri];
+				int tob = pack.prim_object[tri];
+				Object *ob = objects[tob];
+
+				if(tidx == -1) {
+					/* object instance */
+					bbox.grow(ob->bounds);
+				}
+				else if(pack.prim_segment[tri] != ~0) {
+					/* curve segments */
+					const Mesh *mesh = ob->mesh;
+					const Mesh::Curve& curve = mesh->curves[tidx];
+
+					curve.bounds_grow(pack.prim_segment[tri], &mesh->curve_keys[0], bbox);
+				}
+				else {
+					/* triangles */
+					const Mesh *mesh = ob->mesh;
+					const int *vidx = mesh->triangles[tidx].v;
+					const float3 *vpos = &mesh->verts[0];
+
+					bbox.grow(vpos[vidx[0]]);
+					bbox.grow(vpos[vidx[1]]);
+					bbox.grow(vpos[vidx[2]]);
+				}
+
+				visibility |= ob->visibility;
 			}
 
-			visibility |= ob->visibility;
+			SAH += bbox.safe_area() * params.triangle_cost(c1 - c0);
 		}
 
 		pack_node(idx, bbox, bbox, c0, c1, visibility, visibility);
@@ -575,14 +655,16 @@ void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility
 		BoundBox bbox0 = BoundBox::empty, bbox1 = BoundBox::empty;
 		uint visibility0 = 0, visibility1 = 0;
 
-		refit_node((c0 < 0)? -c0-1: c0, (c0 < 0), bbox0, visibility0);
-		refit_node((c1 < 0)? -c1-1: c1, (c1 < 0), bbox1, visibility1);
+		refit_node((c0 < 0)? -c0-1: c0, (c0 < 0), bbox0, visibility0, SAH);
+		refit_node((c1 < 0)? -c1-1: c1, (c1 < 0), bbox1, visibility1, SAH);
 
 		pack_node(idx, bbox0, bbox1, c0, c1, visibility0, visibility1);
 
 		bbox.grow(bbox0);
 		bbox.grow(bbox1);
 		visibility = visibility0|visibility1;
+
+		SAH += bbox.safe_area() * params.node_cost(2);
 	}
 }
 
@@ -592,8 +674,6 @@ QBVH::QBVH(const BVHParams& params_, const vector<Object*>& objects_)
 : BVH(params_, objects_)
 {
 	params.use_qbvh = true;
-
-	/* todo: use visibility */
 }
 
 void QBVH::pack_leaf(const BVHStackEntry& e, const LeafNode *leaf)
@@ -632,20 +712,22 @@ void QBVH::pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num)
 		data[5][i] = bb_max.z;
 
 		data[6][i] = __int_as_float(en[i].encodeIdx());
-		data[7][i] = 0.0f;
+		data[7][i] = __uint_as_float(en[i].node->m_visibility);
 	}
 
 	for(int i = num; i < 4; i++) {
-		data[0][i] = 0.0f;
-		data[1][i] = 0.0f;
-		data[2][i] = 0.0f;
+		/* empty bounds that no ray intersects, with zero as child index which
+		 * is the root and never a child */
+		data[0][i] = FLT_MAX;
+		data[1][i] = -FLT_MAX;
+		data[2][i] = FLT_MAX;
 
-		data[3][i] = 0.0f;
-		data[4][i] = 0.0f;
-		data[5][i] = 0.0f;
+		data[3][i] = -FLT_MAX;
+		data[4][i] = FLT_MAX;
+		data[5][i] = -FLT_MAX;
 
 		data[6][i] = __int_as_float(0);
-		data[7][i] = 0.0f;
+		data[7][i] = __uint_as_float(0);
 	}
 
 	memcpy(&pack.nodes[e.idx * BVH_QNODE_SIZE], data, sizeof(float4)*BVH_QNODE_SIZE);
@@ -673,6 +755,8 @@ void QBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
 	vector<BVHStackEntry> stack;
 	stack.push_back(BVHStackEntry(root, nextNodeIdx++));
 
+	float SAH = 0.0f;
+
 	while(stack.size()) {
 		BVHStackEntry e = stack.back();
 		stack.pop_back();
@@ -683,6 +767,8 @@ void QBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
 			/* leaf node */
 			const LeafNode* leaf = reinterpret_cast<const LeafNode*>(e.node);
 			pack_leaf(e, leaf);
+
+			SAH += leaf->m_bounds.safe_area() * params.triangle_cost(leaf->num_triangles());
 		}
 		else {
 			/* inner node */
@@ -716,16 +802,113 @@ void QBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
 
 			/* set node */
 			pack_inner(e, &stack[stack.size()-numnodes], numnodes);
+
+			SAH += node->m_bounds.safe_area() * params.node_cost(numnodes);
 		}
 	}
 
 	/* root index to start traversal at, to handle case of single leaf node */
 	pack.root_index = (pack.is_leaf[0])? -1: 0;
+
+	/* same cost as computed when refitting, relative to the root area */
+	build_SAH = SAH / max(root->m_bounds.safe_area(), FLT_MIN);
+	refit_SAH = build_SAH;
 }
 
 void QBVH::refit_nodes()
 {
-	assert(0); /* todo */
+	BoundBox bbox = BoundBox::empty;
+	uint visibility = 0;
+	float SAH = 0.0f;
+
+	refit_node(0, (pack.is_leaf[0])? true: false, bbox, visibility, SAH);
+
+	refit_SAH = SAH / max(bbox.safe_area(), FLT_MIN);
+}
+
+void QBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility, float& SAH)
+{
+	float4 *data = (float4*)&pack.nodes[idx*BVH_QNODE_SIZE];
+
+	if(leaf) {
+		int c0 = __float_as_int(data[6].x);
+		int c1 = __float_as_int(data[6].y);
+
+		if(c0 < 0) {
+			/* refit object leaf node, in top level BVH */
+			Object *ob = objects[pack.prim_object[~c0]];
+
+			bbox.grow(ob->bounds);
+			visibility |= ob->visibility;
+
+			SAH += bbox.safe_area() * params.triangle_cost(1);
+		}
+		else {
+			/* refit leaf node */
+			for(int tri = c0; tri < c1; tri++) {
+				int tidx = pack.prim_index[tri];
+				int tob = pack.prim_object[tri];
+				Object *ob = objects[tob];
+
+				if(tidx == -1) {
+					/* object instance */
+					bbox.grow(ob->bounds);
+				}
+				else if(pack.prim_segment[tri] != ~0) {
+					/* curve segments */
+					const Mesh *mesh = ob->mesh;
+					const Mesh::Curve& curve = mesh->curves[tidx];
+
+					curve.bounds_grow(pack.prim_segment[tri], &mesh->curve_keys[0], bbox);
+				}
+				else {
+					/* triangles */
+					const Mesh *mesh = ob->mesh;
+					const int *vidx = mesh->triangles[tidx].v;
+					const float3 *vpos = &mesh->verts[0];
+
+					bbox.grow(vpos[vidx[0]]);
+					bbox.grow(vpos[vidx[1]]);
+					bbox.grow(vpos[vidx[2]]);
+				}
+
+				visibility |= ob->visibility;
+			}
+
+			SAH += bbox.safe_area() * params.triangle_cost(c1 - c0);
+		}
+	}
+	else {
+		/* refit inner node, set bboxes from children, empty slots have
+		 * zero as child index and are left as they are */
+		int num = 0;
+
+		for(int i = 0; i < 4; i++) {
+			int c = __float_as_int(data[6][i]);
+
+			if(c == 0)
+				continue;
+
+			BoundBox cbox = BoundBox::empty;
+			uint cvisibility = 0;
+
+			refit_node((c < 0)? -c-1: c, (c < 0), cbox, cvisibility, SAH);
+
+			data[0][i] = cbox.min.x;
+			data[1][i] = cbox.max.x;
+			data[2][i] = cbox.min.y;
+			data[3][i] = cbox.max.y;
+			data[4][i] = cbox.min.z;
+			data[5][i] = cbox.max.z;
+			data[7][i] = __uint_as_float(cvisibility);
+
+			bbox.grow(cbox);
+			visibility |= cvisibility;
+			num++;
+		}
+
+		SAH += bbox.safe_area() * params.node_cost(num);
+	}
 }
 
 CCL_NAMESPACE_END
@@ -46,7 +46,9 @@ class Progress;
 
 struct PackedBVH {
 	/* BVH nodes storage, one node is 4x int4, and contains two bounding boxes,
-	 * and child, triangle or object indexes dependening on the node type */
+	 * and child, triangle or object indexes dependening on the node type. QBVH
+	 * nodes are 8x int4, with the bounds of four children stored per axis and
+	 * their child indexes and visibility, for intersecting them at once */
 	array<int4> nodes; 
 	/* object index to BVH node index mapping for instances */
 	array<int> object_node; 
@@ -59,6 +61,9 @@ struct PackedBVH {
 	array<int> prim_index;
 	/* mapping from BVH primitive index, to the object id of that primitive. */
 	array<int> prim_object;
+	/* mapping from BVH primitive index to the curve segment, in which case
+	 * prim_index is the curve. ~0 for triangles and instances. */
+	array<uint> prim_segment;
 	/* quick array to lookup if a node is a leaf, not used for traversal, only
 	 * for instance BVH merging  */
 	array<int> is_leaf;
@@ -86,17 +91,30 @@ public:
 	vector<Object*> objects;
 	string cache_filename;
 
+	/* SAH cost of the nodes after building and after the last refit. refitting
+	 * keeps the tree topology, so the cost goes up as primitives move apart */
+	float build_SAH;
+	float refit_SAH;
+
 	static BVH *create(const BVHParams& params, const vector<Object*>& objects);
 	virtual ~BVH() {}
 
 	void build(Progress& progress);
 	void refit(Progress& progress);
 
+	/* increase of SAH cost by refitting, compared to the built tree */
+	float refit_degradation() const
+	{ return (build_SAH > 0.0f)? refit_SAH/build_SAH: 1.0f; }
+
 	void clear_cache_except();
 
 protected:
 	BVH(const BVHParams& params, const vector<Object*>& objects);
 
+	/* number of top level primitives, primitives of instances are merged in
+	 * after them */
+	size_t top_level_prims;
+
 	/* cache */
 	bool cache_read(CacheData& key);
 	void cache_write(CacheData& key);
@@ -104,6 +122,7 @@ protected:
 	/* triangles */
 	void pack_triangles();
 	void pack_triangle(int idx, float4 woop[3]);
+	size_t prim_offset(size_t idx);
 
 	/* merge instance BVH's */
 	void pack_instances(size_t nodes_size);
@@ -131,7 +150,7 @@ protected:
 
 	/* refit */
 	void refit_nodes();
-	void refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility);
+	void refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility, float& SAH);
 };
 
 /* QBVH
@@ -151,6 +170,7 @@ protected:
 
 	/* refit */
 	void refit_nodes();
+	void refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility, float& SAH);
 };
 
 CCL_NAMESPACE_END
@@ -45,14 +45,36 @@ public:
 	BVHObjectBinning range;
 };
 
+/* Spatial Split Build Task
+ *
+ * The subtree gets its own copy of the references and split storage, so
+ * duplicates can be inserted without affecting other threads. */
+
+class BVHSpatialSplitBuildTask : public Task {
+public:
+	BVHSpatialSplitBuildTask(BVHBuild *build, InnerNode *node, int child, const BVHRange& range_,
+		const vector<BVHReference>& refs_, int level)
+	: range(range_.bounds(), 0, range_.size()),
+	  refs(refs_.begin() + range_.start(), refs_.begin() + range_.end())
+	{
+		storage.right_bounds.resize(max(range.size(), (int)BVHParams::NUM_SPATIAL_BINS) - 1);
+		run = function_bind(&BVHBuild::thread_build_spatial_split_node, build, node, child, &range, &refs, &storage, level);
+	}
+
+	BVHRange range;
+	vector<BVHReference> refs;
+	BVHSpatialStorage storage;
+};
+
 /* Constructor / Destructor */
 
 BVHBuild::BVHBuild(const vector<Object*>& objects_,
-	vector<int>& prim_index_, vector<int>& prim_object_,
+	vector<int>& prim_index_, vector<int>& prim_object_, vector<uint>& prim_segment_,
 	const BVHParams& params_, Progress& progress_)
 : objects(objects_),
   prim_index(prim_index_),
   prim_object(prim_object_),
+  prim_segment(prim_segment_),
   params(params_),
   progress(progress_),
   progress_start_time(0.0)
@@ -83,6 +105,26 @@ void BVHBuild::add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh,
 			center.grow(bounds.center2());
 		}
 	}
+
+	/* one reference per curve segment, Mesh::add_curve() splits curves with
+	 * more segments than a reference can store */
+	const float4 *curve_keys = (mesh->curve_keys.size())? &mesh->curve_keys[0]: NULL;
+
+	for(uint j = 0; j < mesh->curves.size(); j++) {
+		const Mesh::Curve& curve = mesh->curves[j];
+		int num_segments = curve.num_segments();
+
+		for(int k = 0; k < num_segments; k++) {
+			BoundBox bounds = BoundBox::empty;
+			curve.bounds_grow(k, curve_keys, bounds);
+
+			if(bounds.valid()) {
+				references.push_back(BVHReference(bounds, j, i, k));
+				root.grow(bounds);
+				center.grow(bounds.center2());
+			}
+		}
+	}
 }
 
 void BVHBuild::add_reference_object(BoundBox& root, BoundBox& center, Object *ob, int i)
@@ -94,18 +136,26 @@ void BVHBuild::add_reference_object(BoundBox& root, BoundBox& center, Object *ob
 
 void BVHBuild::add_references(BVHRange& root)
 {
+	/* the object index shares its bits with the curve segment */
+	if(objects.size() > BVH_MAX_OBJECTS) {
+		string message = string_printf("Too many objects for the BVH, %d is the maximum", BVH_MAX_OBJECTS);
+		fprintf(stderr, "%s\n", message.c_str());
+		progress.set_cancel(message);
+		return;
+	}
+
 	/* reserve space for references */
 	size_t num_alloc_references = 0;
 
 	foreach(Object *ob, objects) {
 		if(params.top_level) {
 			if(ob->mesh->transform_applied)
-				num_alloc_references += ob->mesh->triangles.size();
+				num_alloc_references += ob->mesh->triangles.size() + ob->mesh->num_curve_segments();
 			else
 				num_alloc_references++;
 		}
 		else
-			num_alloc_references += ob->mesh->triangles.size();
+			num_alloc_references += ob->mesh->triangles.size() + ob->mesh->num_curve_segments();
 	}
 
 	references.reserve(num_alloc_references);
@@ -153,8 +203,8 @@ BVHNode* BVHBuild::run()
 		params.use_spatial_split = false;
 
 	spatial_min_overlap = root.bounds().safe_area() * params.spatial_split_alpha;
-	spatial_right_bounds.clear();
-	spatial_right_bounds.resize(max(root.size(), (int)BVHParams::NUM_SPATIAL_BINS) - 1);
+	spatial_storage.right_bounds.clear();
+	spatial_storage.right_bounds.resize(max(root.size(), (int)BVHParams::NUM_SPATIAL_BINS) - 1);
 
 	/* init progress updates */
 	progress_start_time = time_dt();
@@ -162,18 +212,27 @@ BVHNode* BVHBuild::run()
 	progress_total = references.size();
 	progress_original_total = progress_total;
 
-	prim_index.resize(references.size());
-	prim_object.resize(references.size());
-
 	/* build recursively */
 	BVHNode *rootnode;
 
 	if(params.use_spatial_split) {
-		/* singlethreaded spatial split build */
-		rootnode = build_node(root, 0);
+		/* multithreaded spatial split build, leaves append their primitives */
+		prim_index.clear();
+		prim_object.clear();
+		prim_segment.clear();
+		prim_index.reserve(references.size());
+		prim_object.reserve(references.size());
+		prim_segment.reserve(references.size());
+
+		rootnode = build_node(root, references, &spatial_storage, 0);
+		task_pool.wait_work();
 	}
 	else {
 		/* multithreaded binning build */
+		prim_index.resize(references.size());
+		prim_object.resize(references.size());
+		prim_segment.resize(references.size());
+
 		BVHObjectBinning rootbin(root, (references.size())? &references[0]: NULL);
 		rootnode = build_node(rootbin, 0);
 		task_pool.wait_work();
@@ -185,7 +244,7 @@ BVHNode* BVHBuild::run()
 			rootnode->deleteSubtree();
 			rootnode = NULL;
 		}
-		else if(!params.use_spatial_split) {
+		else {
 			/*rotate(rootnode, 4, 5);*/
 			rootnode->update_visibility();
 		}
@@ -231,6 +290,19 @@ void BVHBuild::thread_build_node(InnerNode *inner, int child, BVHObjectBinning *
 	}
 }
 
+void BVHBuild::thread_build_spatial_split_node(InnerNode *inner, int child, BVHRange *range,
+	vector<BVHReference> *refs, BVHSpatialStorage *storage, int level)
+{
+	if(progress.get_cancel())
+		return;
+
+	/* build nodes */
+	BVHNode *node = build_node(*range, *refs, storage, level);
+
+	/* set child in inner node */
+	inner->children[child] = node;
+}
+
 /* multithreaded binning builder */
 BVHNode* BVHBuild::build_node(const BVHObjectBinning& range, int level)
 {
@@ -240,7 +312,7 @@ BVHNode* BVHBuild::build_node(const BVHObjectBinning& range, int level)
 
 	/* make leaf node when threshold reached or SAH tells us */
 	if(params.small_enough_for_leaf(size, level) || (size <= params.max_leaf_size && leafSAH < splitSAH))
-		return create_leaf_node(range);
+		return create_leaf_node(range, references);
 
 	/* perform split */
 	BVHObjectBinning left, right;
@@ -267,44 +339,56 @@ BVHNode* BVHBuild::build_node(const BVHObjectBinning& range, int level)
 	return inner;
 }
 
-/* single threaded spatial split builder */
-BVHNode* BVHBuild::build_node(const BVHRange& range, int level)
+/* multithreaded spatial split builder */
+BVHNode* BVHBuild::build_node(const BVHRange& range, vector<BVHReference>& refs, BVHSpatialStorage *storage, int level)
 {
-	/* progress update */
-	progress_update();
 	if(progress.get_cancel())
 		return NULL;
 
 	/* small enough or too deep => create leaf. */
-	if(params.small_enough_for_leaf(range.size(), level)) {
-		progress_count += range.size();
-		return create_leaf_node(range);
-	}
+	if(params.small_enough_for_leaf(range.size(), level))
+		return create_leaf_node(range, refs);
 
 	/* splitting test */
-	BVHMixedSplit split(this, range, level);
+	BVHMixedSplit split(this, storage, range, refs, level);
 
-	if(split.no_split) {
-		progress_count += range.size();
-		return create_leaf_node(range);
-	}
+	if(split.no_split)
+		return create_leaf_node(range, refs);
 	
 	/* do split */
 	BVHRange left, right;
-	split.split(this, left, right, range);
+	split.split(this, left, right, range, refs);
 
-	progress_total += left.size() + right.size() - range.size();
-	size_t total = progress_total;
+	int num_duplicates = left.size() + right.size() - range.size();
 
-	/* leaft node */
-	BVHNode *leftnode = build_node(left, level + 1);
+	if(num_duplicates) {
+		thread_scoped_lock lock(build_mutex);
+		progress_total += num_duplicates;
+	}
+
+	/* create inner node. */
+	InnerNode *inner;
+
+	if(range.size() < THREAD_TASK_SIZE) {
+		/* local build */
+		size_t num_refs = refs.size();
+		BVHNode *leftnode = build_node(left, refs, storage, level + 1);
+
+		/* duplicates from the left subtree were inserted before the right range */
+		right.set_start(right.start() + refs.size() - num_refs);
+		BVHNode *rightnode = build_node(right, refs, storage, level + 1);
+
+		inner = new InnerNode(range.bounds(), leftnode, rightnode);
+	}
+	else {
+		/* threaded build */
+		inner = new InnerNode(range.bounds());
 
-	/* right node (modify start for splits) */
-	right.set_start(right.start() + progress_total - total);
-	BVHNode *rightnode = build_node(right, level + 1);
+		task_pool.push(new BVHSpatialSplitBuildTask(this, inner, 0, left, refs, level + 1), true);
+		task_pool.push(new BVHSpatialSplitBuildTask(this, inner, 1, right, refs, level + 1), true);
+	}
 
-	/* inner node */
-	return new InnerNode(range.bounds(), leftnode, rightnode);
+	return inner;
 }
 
 /* Create Nodes */
@@ -316,16 +400,9 @@ BVHNode *BVHBuild::create_object_leaf_nodes(const BVHReference *ref, int start,
 		return new LeafNode(bounds, 0, 0, 0);
 	}
 	else if(num == 1) {
-		if(start == prim_index.size()) {
-			assert(params.use_spatial_split);
-
-			prim_index.push_back(ref->prim_index());
-			prim_object.push_back(ref->prim_object());
-		}
-		else {
-			prim_index[start] = ref->prim_index();
-			prim_object[start] = ref->prim_object();
-		}
+		prim_index[start] = ref->prim_index();
+		prim_object[start] = ref->prim_object();
+		prim_segment[start] = ref->prim_segment();
 
 		uint visibility = objects[ref->prim_object()]->visibility;
 		return new LeafNode(ref->bounds(), visibility, start, start+1);
@@ -343,28 +420,41 @@ BVHNode *BVHBuild::create_object_leaf_nodes(const BVHReference *ref, int start,
 	}
 }
 
-BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
+BVHNode* BVHBuild::create_leaf_node(const BVHRange& range, vector<BVHReference>& refs)
+{
+	if(params.use_spatial_split) {
+		/* duplicates make the output larger than the number of references, and
+		 * subtrees are built in parallel, so primitives are appended instead of
+		 * stored at the start of the range */
+		thread_scoped_lock lock(build_mutex);
+		int start = prim_index.size();
+
+		prim_index.resize(start + range.size());
+		prim_object.resize(start + range.size());
+		prim_segment.resize(start + range.size());
+
+		progress_count += range.size();
+		progress_update();
+
+		return create_leaf_node(range, refs, start);
+	}
+
+	return create_leaf_node(range, refs, range.start());
+}
+
+BVHNode* BVHBuild::create_leaf_node(const BVHRange& range, vector<BVHReference>& refs, int start)
 {
-	vector<int>& p_index = prim_index;
-	vector<int>& p_object = prim_object;
 	BoundBox bounds = BoundBox::empty;
 	int num = 0, ob_num = 0;
 	uint visibility = 0;
 
 	for(int i = 0; i < range.size(); i++) {
-		BVHReference& ref = references[range.start() + i];
+		BVHReference& ref = refs[range.start() + i];
 
 		if(ref.prim_index() != -1) {
-			if(range.start() + num == prim_index.size()) {
-				assert(params.use_spatial_split);
-
-				p_index.push_back(ref.prim_index());
-				p_object.push_back(ref.prim_object());
-			}
-			else {
-				p_index[range.start() + num] = ref.prim_index();
-				p_object[range.start() + num] = ref.prim_object();
-			}
+			prim_index[start + num] = ref.prim_index();
+			prim_object[start + num] = ref.prim_object();
+			prim_segment[start + num] = ref.prim_segment();
 
 			bounds.grow(ref.bounds());
 			visibility |= objects[ref.prim_object()]->visibility;
@@ -372,7 +462,7 @@ BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
 		}
 		else {
 			if(ob_num < i)
-				references[range.start() + ob_num] = ref;
+				refs[range.start() + ob_num] = ref;
 			ob_num++;
 		}
 	}
@@ -380,7 +470,7 @@ BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
 	BVHNode *leaf = NULL;
 	
 	if(num > 0) {
-		leaf = new LeafNode(bounds, visibility, range.start(), range.start() + num);
+		leaf = new LeafNode(bounds, visibility, start, start + num);
 
 		if(num == range.size())
 			return leaf;
@@ -388,8 +478,8 @@ BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
 
 	/* while there may be multiple triangles in a leaf, for object primitives
 	 * we want there to be the only one, so we keep splitting */
-	const BVHReference *ref = (ob_num)? &references[range.start()]: NULL;
-	BVHNode *oleaf = create_object_leaf_nodes(ref, range.start() + num, ob_num);
+	const BVHReference *ref = (ob_num)? &refs[range.start()]: NULL;
+	BVHNode *oleaf = create_object_leaf_nodes(ref, start + num, ob_num);
 	
 	if(leaf)
 		return new InnerNode(range.bounds(), leaf, oleaf);
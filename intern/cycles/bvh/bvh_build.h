@@ -30,6 +30,7 @@
 CCL_NAMESPACE_BEGIN
 
 class BVHBuildTask;
+class BVHSpatialSplitBuildTask;
 class BVHParams;
 class InnerNode;
 class Mesh;
@@ -46,6 +47,7 @@ public:
 		const vector<Object*>& objects,
 		vector<int>& prim_index,
 		vector<int>& prim_object,
+		vector<uint>& prim_segment,
 		const BVHParams& params,
 		Progress& progress);
 	~BVHBuild();
@@ -57,6 +59,7 @@ protected:
 	friend class BVHObjectSplit;
 	friend class BVHSpatialSplit;
 	friend class BVHBuildTask;
+	friend class BVHSpatialSplitBuildTask;
 
 	/* adding references */
 	void add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
@@ -64,14 +67,17 @@ protected:
 	void add_references(BVHRange& root);
 
 	/* building */
-	BVHNode *build_node(const BVHRange& range, int level);
+	BVHNode *build_node(const BVHRange& range, vector<BVHReference>& refs, BVHSpatialStorage *storage, int level);
 	BVHNode *build_node(const BVHObjectBinning& range, int level);
-	BVHNode *create_leaf_node(const BVHRange& range);
+	BVHNode *create_leaf_node(const BVHRange& range, vector<BVHReference>& refs);
+	BVHNode *create_leaf_node(const BVHRange& range, vector<BVHReference>& refs, int start);
 	BVHNode *create_object_leaf_nodes(const BVHReference *ref, int start, int num);
 
 	/* threads */
 	enum { THREAD_TASK_SIZE = 4096 };
 	void thread_build_node(InnerNode *node, int child, BVHObjectBinning *range, int level);
+	void thread_build_spatial_split_node(InnerNode *node, int child, BVHRange *range,
+		vector<BVHReference> *refs, BVHSpatialStorage *storage, int level);
 	thread_mutex build_mutex;
 
 	/* progress */
@@ -89,6 +95,7 @@ protected:
 	/* output primitive indexes and objects */
 	vector<int>& prim_index;
 	vector<int>& prim_object;
+	vector<uint>& prim_segment;
 
 	/* build parameters */
 	BVHParams params;
@@ -100,10 +107,9 @@ protected:
 	size_t progress_total;
 	size_t progress_original_total;
 
-	/* spatial splitting */
+	/* spatial splitting, storage for the root, subtree tasks have their own */
 	float spatial_min_overlap;
-	vector<BoundBox> spatial_right_bounds;
-	BVHSpatialBin spatial_bins[3][BVHParams::NUM_SPATIAL_BINS];
+	BVHSpatialStorage spatial_storage;
 
 	/* threads */
 	TaskPool task_pool;
@@ -19,6 +19,8 @@
 #define __BVH_PARAMS_H__
 
 #include "util_boundbox.h"
+#include "util_debug.h"
+#include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -91,23 +93,35 @@ public:
 /* BVH Reference
  *
  * Reference to a primitive. Primitive index and object are sneakily packed
- * into BoundBox to reduce memory usage and align nicely */
+ * into BoundBox to reduce memory usage and align nicely. For curves the
+ * primitive index is the curve and segment the segment within it, for
+ * triangles segment is ~0. The segment is stored plus one in the high bits
+ * of the object, so triangles store zero there. BVHBuild refuses scenes with
+ * more objects than fit, Mesh::add_curve() splits longer curves */
+
+#define BVH_REFERENCE_SEGMENT_SHIFT 22
+#define BVH_MAX_OBJECTS (1 << BVH_REFERENCE_SEGMENT_SHIFT)
+#define BVH_MAX_CURVE_SEGMENTS ((1 << (32 - BVH_REFERENCE_SEGMENT_SHIFT)) - 1)
 
 class BVHReference
 {
 public:
 	__forceinline BVHReference() {}
 
-	__forceinline BVHReference(const BoundBox& bounds_, int prim_index_, int prim_object_)
+	__forceinline BVHReference(const BoundBox& bounds_, int prim_index_, int prim_object_, uint prim_segment_ = ~0)
 	: rbounds(bounds_)
 	{
+		assert(prim_object_ >= 0 && prim_object_ < BVH_MAX_OBJECTS);
+		assert(prim_segment_ == ~0 || prim_segment_ < BVH_MAX_CURVE_SEGMENTS);
+
 		rbounds.min.w = __int_as_float(prim_index_);
-		rbounds.max.w = __int_as_float(prim_object_);
+		rbounds.max.w = __int_as_float(prim_object_ | ((prim_segment_ + 1) << BVH_REFERENCE_SEGMENT_SHIFT));
 	}
 
 	__forceinline const BoundBox& bounds() const { return rbounds; }
 	__forceinline int prim_index() const { return __float_as_int(rbounds.min.w); }
-	__forceinline int prim_object() const { return __float_as_int(rbounds.max.w); }
+	__forceinline int prim_object() const { return __float_as_int(rbounds.max.w) & (BVH_MAX_OBJECTS - 1); }
+	__forceinline uint prim_segment() const { return ((uint)__float_as_int(rbounds.max.w) >> BVH_REFERENCE_SEGMENT_SHIFT) - 1; }
 
 protected:
 	BoundBox rbounds;
@@ -168,6 +182,20 @@ struct BVHSpatialBin
 	}
 };
 
+/* BVH Spatial Storage
+ *
+ * Scratch memory for finding splits in the spatial split builder. Subtrees
+ * are built in parallel, each with its own storage. */
+
+struct BVHSpatialStorage
+{
+	/* bounds of sweeps from right to left */
+	vector<BoundBox> right_bounds;
+
+	/* bins of spatial splits along each axis */
+	BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS];
+};
+
 CCL_NAMESPACE_END
 
 #endif /* __BVH_PARAMS_H__ */
@@ -43,6 +43,8 @@ public:
 		else if(ra.prim_object() > rb.prim_object()) return false;
 		else if(ra.prim_index() < rb.prim_index()) return true;
 		else if(ra.prim_index() > rb.prim_index()) return false;
+		else if(ra.prim_segment() < rb.prim_segment()) return true;
+		else if(ra.prim_segment() > rb.prim_segment()) return false;
 
 		return false;
 	}
@@ -37,9 +37,11 @@ public:
 	BoundBox right_bounds;
 
 	BVHObjectSplit() {}
-	BVHObjectSplit(BVHBuild *builder, const BVHRange& range, float nodeSAH);
+	BVHObjectSplit(BVHBuild *builder, BVHSpatialStorage *storage, const BVHRange& range,
+		vector<BVHReference>& refs, float nodeSAH);
 
-	void split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range);
+	void split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range,
+		vector<BVHReference>& refs);
 };
 
 /* Spatial Split */
@@ -52,9 +54,11 @@ public:
 	float pos;
 
 	BVHSpatialSplit() : sah(FLT_MAX), dim(0), pos(0.0f) {}
-	BVHSpatialSplit(BVHBuild *builder, const BVHRange& range, float nodeSAH);
+	BVHSpatialSplit(BVHBuild *builder, BVHSpatialStorage *storage, const BVHRange& range,
+		vector<BVHReference>& refs, float nodeSAH);
 
-	void split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range);
+	void split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range,
+		vector<BVHReference>& refs);
 	void split_reference(BVHBuild *builder, BVHReference& left, BVHReference& right, const BVHReference& ref, int dim, float pos);
 };
 
@@ -72,7 +76,8 @@ public:
 
 	bool no_split;
 
-	__forceinline BVHMixedSplit(BVHBuild *builder, const BVHRange& range, int level)
+	__forceinline BVHMixedSplit(BVHBuild *builder, BVHSpatialStorage *storage, const BVHRange& range,
+		vector<BVHReference>& refs, int level)
 	{
 		/* find split candidates. */
 		float area = range.bounds().safe_area();
@@ -80,14 +85,14 @@ public:
 		leafSAH = area * builder->params.triangle_cost(range.size());
 		nodeSAH = area * builder->params.node_cost(2);
 
-		object = BVHObjectSplit(builder, range, nodeSAH);
+		object = BVHObjectSplit(builder, storage, range, refs, nodeSAH);
 
 		if(builder->params.use_spatial_split && level < BVHParams::MAX_SPATIAL_DEPTH) {
 			BoundBox overlap = object.left_bounds;
 			overlap.intersect(object.right_bounds);
 
 			if(overlap.safe_area() >= builder->spatial_min_overlap)
-				spatial = BVHSpatialSplit(builder, range, nodeSAH);
+				spatial = BVHSpatialSplit(builder, storage, range, refs, nodeSAH);
 		}
 
 		/* leaf SAH is the lowest => create leaf. */
@@ -95,12 +100,13 @@ public:
 		no_split = (minSAH == leafSAH && range.size() <= builder->params.max_leaf_size);
 	}
 
-	__forceinline void split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range)
+	__forceinline void split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range,
+		vector<BVHReference>& refs)
 	{
 		if(builder->params.use_spatial_split && minSAH == spatial.sah)
-			spatial.split(builder, left, right, range);
+			spatial.split(builder, left, right, range, refs);
 		if(!left.size() || !right.size())
-			object.split(builder, left, right, range);
+			object.split(builder, left, right, range, refs);
 	}
 };
 
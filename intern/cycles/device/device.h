@@ -35,6 +35,7 @@ CCL_NAMESPACE_BEGIN
 
 class Progress;
 class RenderTile;
+class TextureCache;
 
 /* Device Types */
 
@@ -56,6 +57,8 @@ public:
 	bool display_device;
 	bool advanced_shading;
 	bool pack_images;
+	bool use_qbvh;
+	bool use_hair;
 	vector<DeviceInfo> multi_devices;
 
 	DeviceInfo()
@@ -66,6 +69,8 @@ public:
 		display_device = false;
 		advanced_shading = true;
 		pack_images = false;
+		use_qbvh = false;
+		use_hair = false;
 	}
 };
 
@@ -112,6 +117,13 @@ public:
 	/* open shading language, only for CPU device */
 	virtual void *osl_memory() { return NULL; }
 
+	/* image tiles loaded on demand, only for CPU device */
+	virtual void set_texture_cache(TextureCache *cache) {}
+
+	/* render time counters of tasks with profiling, only for CPU device */
+	virtual bool get_profiling_stats(ProfilingStats& stats) { return false; }
+	virtual void reset_profiling_stats() {}
+
 	/* load/compile kernels, must be called before adding tasks */ 
 	virtual bool load_kernels(bool experimental) { return true; }
 
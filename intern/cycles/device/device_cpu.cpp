@@ -44,6 +44,10 @@ class CPUDevice : public Device
 public:
 	TaskPool task_pool;
 	KernelGlobals *kg;
+
+	/* counters of finished profiling tasks, added by each thread */
+	ProfilingStats profiling_stats;
+	thread_mutex profiling_mutex;
 	
 	CPUDevice(Stats &stats) : Device(stats)
 	{
@@ -113,6 +117,24 @@ public:
 		stats.mem_free(mem.memory_size());
 	}
 
+	void set_texture_cache(TextureCache *cache)
+	{
+		kernel_texture_cache_set(kg, cache);
+	}
+
+	bool get_profiling_stats(ProfilingStats& stats)
+	{
+		thread_scoped_lock profiling_lock(profiling_mutex);
+		stats = profiling_stats;
+		return true;
+	}
+
+	void reset_profiling_stats()
+	{
+		thread_scoped_lock profiling_lock(profiling_mutex);
+		profiling_stats.reset();
+	}
+
 	void *osl_memory()
 	{
 #ifdef WITH_OSL
@@ -141,6 +163,47 @@ public:
 		}
 	};
 
+	/* Adaptive sampling: from the minimum number of samples on, the error of
+	 * the tile is checked every few samples and the tile is released once it
+	 * is converged. The thread then continues with the next tile, so the time
+	 * saved goes to the tiles that still need it. */
+	bool adaptive_converged(DeviceTask& task, RenderTile& tile)
+	{
+		const int step = 8;
+		int min_samples = max(task.adaptive_min_samples & ~1, 2);
+
+		if(tile.sample < min_samples || (tile.sample - min_samples) % step != 0)
+			return false;
+
+		float *render_buffer = (float*)tile.buffer;
+		float error_sum = 0.0f, error_max = 0.0f;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				float error;
+
+#ifdef WITH_OPTIMIZED_KERNEL
+				if(system_cpu_support_optimized())
+					error = kernel_cpu_optimized_adaptive_error(kg, render_buffer,
+						tile.sample, x, y, tile.offset, tile.stride);
+				else
+#endif
+					error = kernel_cpu_adaptive_error(kg, render_buffer,
+						tile.sample, x, y, tile.offset, tile.stride);
+
+				error_sum += error;
+				error_max = max(error_max, error);
+			}
+		}
+
+		/* the average decides, but a few much noisier pixels keep sampling
+		 * the tile so noise does not remain in small regions */
+		float error_avg = error_sum / (float)(tile.w * tile.h);
+
+		return (error_avg < task.adaptive_threshold &&
+		        error_max < task.adaptive_threshold * 4.0f);
+	}
+
 	void thread_path_trace(DeviceTask& task)
 	{
 		if(task_pool.cancelled()) {
@@ -153,6 +216,14 @@ public:
 			OSLShader::thread_init(kg);
 #endif
 
+		ProfilingStats thread_profiling_stats;
+
+		if(task.profiling)
+			kernel_profiling_thread_init(&thread_profiling_stats);
+
+		size_t thread_texture_lookups = 0;
+		kernel_texture_cache_thread_init(&thread_texture_lookups);
+
 		RenderTile tile;
 		
 		while(task.acquire_tile(this, tile)) {
@@ -160,6 +231,7 @@ public:
 			uint *rng_state = (uint*)tile.rng_state;
 			int start_sample = tile.start_sample;
 			int end_sample = tile.start_sample + tile.num_samples;
+			bool converged = false;
 
 #ifdef WITH_OPTIMIZED_KERNEL
 			if(system_cpu_support_optimized()) {
@@ -179,6 +251,11 @@ public:
 					tile.sample = sample + 1;
 
 					task.update_progress(tile);
+
+					if(task.adaptive_threshold > 0.0f && adaptive_converged(task, tile)) {
+						converged = true;
+						break;
+					}
 				}
 			}
 			else
@@ -200,9 +277,18 @@ public:
 					tile.sample = sample + 1;
 
 					task.update_progress(tile);
+
+					if(task.adaptive_threshold > 0.0f && adaptive_converged(task, tile)) {
+						converged = true;
+						break;
+					}
 				}
 			}
 
+			tile.finished = (converged || tile.sample == end_sample);
+
+			kernel_texture_cache_thread_flush(kg);
+
 			task.release_tile(tile);
 
 			if(task_pool.cancelled()) {
@@ -211,6 +297,15 @@ public:
 			}
 		}
 
+		kernel_texture_cache_thread_free(kg);
+
+		if(task.profiling) {
+			kernel_profiling_thread_free();
+
+			thread_scoped_lock profiling_lock(profiling_mutex);
+			profiling_stats.add(thread_profiling_stats);
+		}
+
 #ifdef WITH_OSL
 		if(kernel_osl_use(kg))
 			OSLShader::thread_free(kg);
@@ -243,26 +338,42 @@ public:
 			OSLShader::thread_init(kg);
 #endif
 
+		size_t thread_texture_lookups = 0;
+		kernel_texture_cache_thread_init(&thread_texture_lookups);
+
+		/* bake passes take multiple samples per point, accumulated in the output */
+		for(int sample = 0; sample < task.num_samples; sample++) {
 #ifdef WITH_OPTIMIZED_KERNEL
-		if(system_cpu_support_optimized()) {
-			for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
-				kernel_cpu_optimized_shader(kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x);
+			if(system_cpu_support_optimized()) {
+				for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
+					kernel_cpu_optimized_shader(kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x, sample);
 
-				if(task_pool.cancelled())
-					break;
+					if(task_pool.cancelled())
+						break;
+				}
 			}
-		}
-		else
+			else
 #endif
-		{
-			for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
-				kernel_cpu_shader(kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x);
+			{
+				for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
+					kernel_cpu_shader(kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x, sample);
 
-				if(task_pool.cancelled())
-					break;
+					if(task_pool.cancelled())
+						break;
+				}
 			}
+
+			if(task_pool.cancelled() || (task.get_cancel && task.get_cancel()))
+				break;
+
+			kernel_texture_cache_thread_flush(kg);
+
+			if(task.update_progress_sample)
+				task.update_progress_sample();
 		}
 
+		kernel_texture_cache_thread_free(kg);
+
 #ifdef WITH_OSL
 		if(kernel_osl_use(kg))
 			OSLShader::thread_free(kg);
@@ -307,6 +418,15 @@ void device_cpu_info(vector<DeviceInfo>& devices)
 	info.advanced_shading = true;
 	info.pack_images = false;
 
+	/* the QBVH is traversed with SSE in the optimized kernel, without it the
+	 * regular BVH is faster */
+#ifdef WITH_OPTIMIZED_KERNEL
+	info.use_qbvh = system_cpu_support_optimized();
+#endif
+
+	/* curve primitives are only intersected by the CPU kernel */
+	info.use_hair = true;
+
 	devices.insert(devices.begin(), info);
 }
 
@@ -863,6 +863,8 @@ public:
 					task->update_progress(tile);
 				}
 
+				tile.finished = (tile.sample == end_sample);
+
 				task->release_tile(tile);
 			}
 		}
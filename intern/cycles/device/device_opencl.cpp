@@ -703,6 +703,8 @@ public:
 					task->update_progress(tile);
 				}
 
+				tile.finished = (tile.sample == end_sample);
+
 				task->release_tile(tile);
 			}
 		}
@@ -52,6 +52,13 @@ public:
 	int shader_eval_type;
 	int shader_x, shader_w;
 
+	/* adaptive sampling, disabled when the threshold is zero */
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
+	/* count rays, shader nodes and lookups, CPU only */
+	bool profiling;
+
 	DeviceTask(Type type = PATH_TRACE);
 
 	void split(list<DeviceTask>& tasks, int num);
@@ -84,6 +84,6 @@ __kernel void kernel_ocl_tonemap(
 {
 	int x = sx + get_global_id(0);
 
-	kernel_shader_evaluate(input, output, (ShaderEvalType)type, x);
+	kernel_shader_evaluate(input, output, (ShaderEvalType)type, x, 0);
 }*/
 
@@ -25,24 +25,64 @@
 #include "kernel_globals.h"
 #include "kernel_film.h"
 #include "kernel_path.h"
+#include "kernel_bake.h"
 #include "kernel_displace.h"
 
 CCL_NAMESPACE_BEGIN
 
 /* Globals */
 
+tls_ptr(ProfilingStats, kernel_profiling_stats);
+tls_ptr(size_t, kernel_texture_cache_lookups);
+static int kernel_globals_users = 0;
+static thread_mutex kernel_globals_mutex;
+
 KernelGlobals *kernel_globals_create()
 {
 	KernelGlobals *kg = new KernelGlobals();
+	kg->texture_cache = NULL;
 #ifdef WITH_OSL
 	kg->osl.use = false;
 #endif
+
+	/* thread local storage create, shared by all devices */
+	thread_scoped_lock globals_lock(kernel_globals_mutex);
+
+	if(kernel_globals_users == 0) {
+		tls_create(ProfilingStats, kernel_profiling_stats);
+		tls_create(size_t, kernel_texture_cache_lookups);
+	}
+
+	kernel_globals_users++;
+
 	return kg;
 }
 
 void kernel_globals_free(KernelGlobals *kg)
 {
 	delete kg;
+
+	/* thread local storage delete */
+	thread_scoped_lock globals_lock(kernel_globals_mutex);
+
+	kernel_globals_users--;
+
+	if(kernel_globals_users == 0) {
+		tls_delete(ProfilingStats, kernel_profiling_stats);
+		tls_delete(size_t, kernel_texture_cache_lookups);
+	}
+}
+
+/* Profiling */
+
+void kernel_profiling_thread_init(ProfilingStats *stats)
+{
+	tls_set(kernel_profiling_stats, stats);
+}
+
+void kernel_profiling_thread_free()
+{
+	tls_set(kernel_profiling_stats, NULL);
 }
 
 /* OSL */
@@ -118,6 +158,34 @@ void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t
 		assert(0);
 }
 
+void kernel_texture_cache_set(KernelGlobals *kg, TextureCache *cache)
+{
+	kg->texture_cache = cache;
+}
+
+void kernel_texture_cache_thread_init(size_t *num_lookups)
+{
+	tls_set(kernel_texture_cache_lookups, num_lookups);
+}
+
+void kernel_texture_cache_thread_flush(KernelGlobals *kg)
+{
+	size_t *num_lookups = tls_get(size_t, kernel_texture_cache_lookups);
+
+	if(num_lookups && *num_lookups) {
+		if(kg->texture_cache)
+			kg->texture_cache->add_lookups(*num_lookups);
+
+		*num_lookups = 0;
+	}
+}
+
+void kernel_texture_cache_thread_free(KernelGlobals *kg)
+{
+	kernel_texture_cache_thread_flush(kg);
+	tls_set(kernel_texture_cache_lookups, NULL);
+}
+
 /* Path Tracing */
 
 void kernel_cpu_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_state, int sample, int x, int y, int offset, int stride)
@@ -132,11 +200,18 @@ void kernel_cpu_tonemap(KernelGlobals *kg, uchar4 *rgba, float *buffer, int samp
 	kernel_film_tonemap(kg, rgba, buffer, sample, resolution, x, y, offset, stride);
 }
 
+/* Adaptive Sampling */
+
+float kernel_cpu_adaptive_error(KernelGlobals *kg, float *buffer, int sample, int x, int y, int offset, int stride)
+{
+	return kernel_film_adaptive_error(kg, buffer, sample, x, y, offset, stride);
+}
+
 /* Shader Evaluation */
 
-void kernel_cpu_shader(KernelGlobals *kg, uint4 *input, float4 *output, int type, int i)
+void kernel_cpu_shader(KernelGlobals *kg, uint4 *input, float4 *output, int type, int i, int sample)
 {
-	kernel_shader_evaluate(kg, input, output, (ShaderEvalType)type, i);
+	kernel_shader_evaluate(kg, input, output, (ShaderEvalType)type, i, sample);
 }
 
 CCL_NAMESPACE_END
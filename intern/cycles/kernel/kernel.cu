@@ -24,6 +24,7 @@
 #include "kernel_globals.h"
 #include "kernel_film.h"
 #include "kernel_path.h"
+#include "kernel_bake.h"
 #include "kernel_displace.h"
 
 extern "C" __global__ void kernel_cuda_path_trace(float *buffer, uint *rng_state, int sample, int sx, int sy, int sw, int sh, int offset, int stride)
@@ -48,6 +49,6 @@ extern "C" __global__ void kernel_cuda_shader(uint4 *input, float4 *output, int
 {
 	int x = sx + blockDim.x*blockIdx.x + threadIdx.x;
 
-	kernel_shader_evaluate(NULL, input, output, (ShaderEvalType)type, x);
+	kernel_shader_evaluate(NULL, input, output, (ShaderEvalType)type, x, 0);
 }
 
@@ -26,6 +26,8 @@
 CCL_NAMESPACE_BEGIN
 
 struct KernelGlobals;
+class ProfilingStats;
+class TextureCache;
 
 KernelGlobals *kernel_globals_create();
 void kernel_globals_free(KernelGlobals *kg);
@@ -35,21 +37,33 @@ bool kernel_osl_use(KernelGlobals *kg);
 
 void kernel_const_copy(KernelGlobals *kg, const char *name, void *host, size_t size);
 void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t width, size_t height);
+void kernel_texture_cache_set(KernelGlobals *kg, TextureCache *cache);
+
+void kernel_profiling_thread_init(ProfilingStats *stats);
+void kernel_profiling_thread_free();
+
+void kernel_texture_cache_thread_init(size_t *num_lookups);
+void kernel_texture_cache_thread_flush(KernelGlobals *kg);
+void kernel_texture_cache_thread_free(KernelGlobals *kg);
 
 void kernel_cpu_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
 	int sample, int x, int y, int offset, int stride);
 void kernel_cpu_tonemap(KernelGlobals *kg, uchar4 *rgba, float *buffer,
 	int sample, int resolution, int x, int y, int offset, int stride);
+float kernel_cpu_adaptive_error(KernelGlobals *kg, float *buffer,
+	int sample, int x, int y, int offset, int stride);
 void kernel_cpu_shader(KernelGlobals *kg, uint4 *input, float4 *output,
-	int type, int i);
+	int type, int i, int sample);
 
 #ifdef WITH_OPTIMIZED_KERNEL
 void kernel_cpu_optimized_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
 	int sample, int x, int y, int offset, int stride);
 void kernel_cpu_optimized_tonemap(KernelGlobals *kg, uchar4 *rgba, float *buffer,
 	int sample, int resolution, int x, int y, int offset, int stride);
+float kernel_cpu_optimized_adaptive_error(KernelGlobals *kg, float *buffer,
+	int sample, int x, int y, int offset, int stride);
 void kernel_cpu_optimized_shader(KernelGlobals *kg, uint4 *input, float4 *output,
-	int type, int i);
+	int type, int i, int sample);
 #endif
 
 CCL_NAMESPACE_END
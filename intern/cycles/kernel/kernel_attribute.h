@@ -33,6 +33,11 @@ bool kernel_osl_use(KernelGlobals *kg);
 
 __device_inline int find_attribute(KernelGlobals *kg, ShaderData *sd, uint id)
 {
+#ifdef __HAIR__
+	/* curves have no mesh attributes */
+	if(sd->segment != ~0)
+		return (int)ATTR_STD_NOT_FOUND;
+#endif
 
 #ifdef __OSL__
 	if (kernel_osl_use(kg)) {
@@ -0,0 +1,265 @@
+/*
+ * Copyright 2011, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifdef __BAKING__
+
+#include "util_hash.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Baking
+ *
+ * Paths start on the surface point being baked instead of at the camera. The
+ * first vertex is shaded like a camera hit, so the light passes split into
+ * direct and indirect the same way as render passes do, and the rest of the
+ * path is traced by the indirect integrator. */
+
+__device void bake_path_trace(KernelGlobals *kg, ShaderData *sd, RNG *rng, int sample, PathRadiance *L)
+{
+	float3 throughput = make_float3(1.0f, 1.0f, 1.0f);
+	PathState state;
+	int rng_offset = PRNG_BASE_NUM;
+
+	path_state_init(&state);
+
+#ifdef __EMISSION__
+	/* emission */
+	if(sd->flag & SD_EMISSION) {
+		float3 emission = shader_emissive_eval(kg, sd);
+		path_radiance_accum_emission(L, throughput, emission, state.bounce);
+	}
+#endif
+
+#ifdef __AO__
+	/* ambient occlusion */
+	if(kernel_data.integrator.use_ambient_occlusion || (sd->flag & SD_AO)) {
+		float bsdf_u = path_rng(kg, rng, sample, rng_offset + PRNG_BSDF_U);
+		float bsdf_v = path_rng(kg, rng, sample, rng_offset + PRNG_BSDF_V);
+
+		float ao_factor = kernel_data.background.ao_factor;
+		float3 ao_N;
+		float3 ao_bsdf = shader_bsdf_ao(kg, sd, ao_factor, &ao_N);
+		float3 ao_D;
+		float ao_pdf;
+
+		sample_cos_hemisphere(ao_N, bsdf_u, bsdf_v, &ao_D, &ao_pdf);
+
+		if(dot(sd->Ng, ao_D) > 0.0f && ao_pdf != 0.0f) {
+			Ray light_ray;
+			float3 ao_shadow;
+
+			light_ray.P = ray_offset(sd->P, sd->Ng);
+			light_ray.D = ao_D;
+			light_ray.t = kernel_data.background.ao_distance;
+#ifdef __OBJECT_MOTION__
+			light_ray.time = sd->time;
+#endif
+
+			if(!shadow_blocked(kg, &state, &light_ray, &ao_shadow))
+				path_radiance_accum_ao(L, throughput, ao_bsdf, ao_shadow, state.bounce);
+		}
+	}
+#endif
+
+#ifdef __EMISSION__
+	if(kernel_data.integrator.use_direct_light) {
+		/* sample illumination from lights to find path contribution */
+		if(sd->flag & SD_BSDF_HAS_EVAL) {
+			float light_t = path_rng(kg, rng, sample, rng_offset + PRNG_LIGHT);
+			float light_o = path_rng(kg, rng, sample, rng_offset + PRNG_LIGHT_F);
+			float light_u = path_rng(kg, rng, sample, rng_offset + PRNG_LIGHT_U);
+			float light_v = path_rng(kg, rng, sample, rng_offset + PRNG_LIGHT_V);
+
+			Ray light_ray;
+			BsdfEval L_light;
+			bool is_lamp;
+
+#ifdef __OBJECT_MOTION__
+			light_ray.time = sd->time;
+#endif
+
+			if(direct_emission(kg, sd, -1, light_t, light_o, light_u, light_v, &light_ray, &L_light, &is_lamp)) {
+				/* trace shadow ray */
+				float3 shadow;
+
+				if(!shadow_blocked(kg, &state, &light_ray, &shadow)) {
+					/* accumulate */
+					path_radiance_accum_light(L, throughput, &L_light, shadow, state.bounce, is_lamp);
+				}
+			}
+		}
+	}
+#endif
+
+	/* no BSDF? we can stop here */
+	if(!(sd->flag & SD_BSDF))
+		return;
+
+	/* sample BSDF */
+	float bsdf_pdf;
+	BsdfEval bsdf_eval;
+	float3 bsdf_omega_in;
+	differential3 bsdf_domega_in;
+	float bsdf_u = path_rng(kg, rng, sample, rng_offset + PRNG_BSDF_U);
+	float bsdf_v = path_rng(kg, rng, sample, rng_offset + PRNG_BSDF_V);
+	int label;
+
+	label = shader_bsdf_sample(kg, sd, bsdf_u, bsdf_v, &bsdf_eval,
+		&bsdf_omega_in, &bsdf_domega_in, &bsdf_pdf);
+
+	if(bsdf_pdf == 0.0f || bsdf_eval_is_zero(&bsdf_eval))
+		return;
+
+	/* modify throughput */
+	path_radiance_bsdf_bounce(L, &throughput, &bsdf_eval, bsdf_pdf, state.bounce, label);
+
+	/* set labels */
+	float ray_pdf = 0.0f;
+	float min_ray_pdf = FLT_MAX;
+
+	if(!(label & LABEL_TRANSPARENT)) {
+		ray_pdf = bsdf_pdf;
+		min_ray_pdf = bsdf_pdf;
+	}
+
+	/* update path state */
+	path_state_next(kg, &state, label);
+
+	/* setup ray */
+	Ray ray;
+
+	ray.P = ray_offset(sd->P, (label & LABEL_TRANSMIT)? -sd->Ng: sd->Ng);
+	ray.D = bsdf_omega_in;
+	ray.t = FLT_MAX;
+#ifdef __RAY_DIFFERENTIALS__
+	ray.dP = sd->dP;
+	ray.dD = bsdf_domega_in;
+#endif
+#ifdef __OBJECT_MOTION__
+	ray.time = sd->time;
+#endif
+
+	/* continue the path */
+	kernel_path_indirect(kg, rng, sample, ray, NULL,
+		throughput, min_ray_pdf, ray_pdf, state, rng_offset + PRNG_BOUNCE_NUM, L);
+}
+
+__device float3 bake_ambient_occlusion(KernelGlobals *kg, ShaderData *sd, RNG *rng, int sample)
+{
+	float bsdf_u = path_rng(kg, rng, sample, PRNG_BASE_NUM + PRNG_BSDF_U);
+	float bsdf_v = path_rng(kg, rng, sample, PRNG_BASE_NUM + PRNG_BSDF_V);
+	float3 ao_D;
+	float ao_pdf;
+
+	sample_cos_hemisphere(sd->N, bsdf_u, bsdf_v, &ao_D, &ao_pdf);
+
+	if(dot(sd->Ng, ao_D) > 0.0f && ao_pdf != 0.0f) {
+		PathState state;
+		Ray light_ray;
+		float3 ao_shadow;
+
+		path_state_init(&state);
+
+		light_ray.P = ray_offset(sd->P, sd->Ng);
+		light_ray.D = ao_D;
+		light_ray.t = kernel_data.background.ao_distance;
+#ifdef __OBJECT_MOTION__
+		light_ray.time = sd->time;
+#endif
+
+		if(!shadow_blocked(kg, &state, &light_ray, &ao_shadow))
+			return ao_shadow;
+	}
+
+	return make_float3(0.0f, 0.0f, 0.0f);
+}
+
+/* evaluate one sample of a bake pass. input is the object (encoded as in the
+ * BVH), triangle and barycentric coordinates of the point to bake */
+
+__device float3 kernel_bake_evaluate(KernelGlobals *kg, uint4 in, ShaderEvalType type, int i, int sample)
+{
+	ShaderData sd;
+	float3 out;
+
+	int object = in.x;
+	int prim = in.y;
+	float u = __int_as_float(in.z);
+	float v = __int_as_float(in.w);
+
+	/* rng per bake point, only the sample number varies between passes over
+	 * the same points so results converge like render samples do */
+	RNG rng = hash_int_2d(i, kernel_data.integrator.seed);
+#ifndef __SOBOL__
+	rng = hash_int_2d(rng, sample);
+#endif
+
+	shader_setup_from_bake(kg, &sd, object, prim, u, v);
+
+	if(type == SHADER_EVAL_BAKE_NORMAL) {
+		/* world space shading normal, mapped to 0..1 */
+		shader_eval_surface(kg, &sd, 0.0f, PATH_RAY_CAMERA);
+		out = sd.N*0.5f + make_float3(0.5f, 0.5f, 0.5f);
+	}
+	else if(type == SHADER_EVAL_BAKE_AO) {
+		out = bake_ambient_occlusion(kg, &sd, &rng, sample);
+	}
+	else {
+		PathRadiance L;
+
+		path_radiance_init(&L, 1);
+
+		float rbsdf = path_rng(kg, &rng, sample, PRNG_BASE_NUM + PRNG_BSDF);
+		shader_eval_surface(kg, &sd, rbsdf, PATH_RAY_CAMERA|PATH_RAY_SINGULAR|PATH_RAY_MIS_SKIP);
+
+		bake_path_trace(kg, &sd, &rng, sample, &L);
+
+		float3 L_sum = path_radiance_sum(kg, &L);
+
+#ifdef __CLAMP_SAMPLE__
+		path_radiance_clamp(&L, &L_sum, kernel_data.integrator.sample_clamp);
+#endif
+
+		switch(type) {
+			case SHADER_EVAL_BAKE_DIFFUSE_DIRECT:
+				out = L.direct_diffuse;
+				break;
+			case SHADER_EVAL_BAKE_DIFFUSE_INDIRECT:
+				out = L.indirect_diffuse;
+				break;
+			case SHADER_EVAL_BAKE_GLOSSY_DIRECT:
+				out = L.direct_glossy;
+				break;
+			case SHADER_EVAL_BAKE_GLOSSY_INDIRECT:
+				out = L.indirect_glossy;
+				break;
+			default: /* SHADER_EVAL_BAKE_COMBINED */
+				out = L_sum;
+				break;
+		}
+	}
+
+	shader_release(kg, &sd);
+
+	return out;
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __BAKING__ */
+
@@ -205,6 +205,95 @@ __device_inline void bvh_triangle_intersect(KernelGlobals *kg, Intersection *ise
 	}
 }
 
+#ifdef __HAIR__
+/* Curve segment intersection, against a cylinder around the line between two
+ * keys, with the radius interpolated along it. The front of the surface is hit,
+ * or the back if the ray starts inside. */
+__device_inline void bvh_curve_intersect(KernelGlobals *kg, Intersection *isect,
+	float3 P, float3 idir, uint visibility, int object, int curveAddr, int segment)
+{
+	/* fetch segment keys */
+	int prim = kernel_tex_fetch(__prim_index, curveAddr);
+	float4 curvedata = kernel_tex_fetch(__curves, prim);
+	int k0 = __float_as_int(curvedata.x) + segment;
+	float4 P0 = kernel_tex_fetch(__curve_keys, k0);
+	float4 P1 = kernel_tex_fetch(__curve_keys, k0 + 1);
+
+	float3 p0 = float4_to_float3(P0);
+	float3 dir = 1.0f/idir;
+	float l;
+	float3 axis = normalize_len(float4_to_float3(P1) - p0, &l);
+
+	if(l == 0.0f)
+		return;
+
+	/* ray origin and direction, relative to the axis and perpendicular to it */
+	float3 w = P - p0;
+	float wa = dot(w, axis);
+	float da = dot(dir, axis);
+	float3 wp = w - wa*axis;
+	float3 dp = dir - da*axis;
+	float dp2 = dot(dp, dp);
+
+	/* ray parallel to axis */
+	if(dp2 <= 1e-8f*dot(dir, dir))
+		return;
+
+	/* closest approach to the axis, and radius there */
+	float tc = -dot(wp, dp)/dp2;
+	float3 pc = wp + tc*dp;
+	float d2 = dot(pc, pc);
+	float sc = clamp((wa + tc*da)/l, 0.0f, 1.0f);
+	float r = P0.w + sc*(P1.w - P0.w);
+
+	if(d2 > r*r)
+		return;
+
+	float dt = sqrtf((r*r - d2)/dp2);
+	float t = tc - dt;
+
+	if(t <= 0.0f)
+		t = tc + dt;
+
+	if(t > 0.0f && t < isect->t) {
+		/* check position along segment */
+		float s = (wa + t*da)/l;
+
+		if(s >= 0.0f && s <= 1.0f) {
+#ifdef __VISIBILITY_FLAG__
+			if(kernel_tex_fetch(__prim_visibility, curveAddr) & visibility)
+#endif
+			{
+				/* record intersection */
+				isect->prim = curveAddr;
+				isect->object = object;
+				isect->u = s;
+				isect->v = 0.0f;
+				isect->t = t;
+			}
+		}
+	}
+}
+#endif
+
+/* intersect triangle or curve segment in leaf node */
+__device_inline void bvh_primitive_intersect(KernelGlobals *kg, Intersection *isect,
+	float3 P, float3 idir, uint visibility, int object, int primAddr)
+{
+#ifdef __HAIR__
+	if(kernel_data.bvh.have_curves) {
+		uint segment = kernel_tex_fetch(__prim_segment, primAddr);
+
+		if(segment != ~0) {
+			bvh_curve_intersect(kg, isect, P, idir, visibility, object, primAddr, segment);
+			return;
+		}
+	}
+#endif
+
+	bvh_triangle_intersect(kg, isect, P, idir, visibility, object, primAddr);
+}
+
 __device_inline bool bvh_intersect(KernelGlobals *kg, const Ray *ray, const uint visibility, Intersection *isect)
 {
 	/* traversal stack in CUDA thread-local memory */
@@ -227,6 +316,8 @@ __device_inline bool bvh_intersect(KernelGlobals *kg, const Ray *ray, const uint
 	isect->u = 0.0f;
 	isect->v = 0.0f;
 
+	PROFILING_BVH_INIT();
+
 	/* traversal loop */
 	do {
 		do
@@ -234,6 +325,8 @@ __device_inline bool bvh_intersect(KernelGlobals *kg, const Ray *ray, const uint
 			/* traverse internal nodes */
 			while(nodeAddr >= 0 && nodeAddr != ENTRYPOINT_SENTINEL)
 			{
+				PROFILING_BVH_NODE();
+
 				bool traverseChild0, traverseChild1, closestChild1;
 				int nodeAddrChild1;
 
@@ -281,14 +374,17 @@ __device_inline bool bvh_intersect(KernelGlobals *kg, const Ray *ray, const uint
 					nodeAddr = traversalStack[stackPtr];
 					--stackPtr;
 
-					/* triangle intersection */
+					/* primitive intersection */
 					while(primAddr < primAddr2) {
-						/* intersect ray against triangle */
-						bvh_triangle_intersect(kg, isect, P, idir, visibility, object, primAddr);
+						/* intersect ray against triangle or curve */
+						bvh_primitive_intersect(kg, isect, P, idir, visibility, object, primAddr);
+						PROFILING_BVH_PRIM();
 
 						/* shadow ray early termination */
-						if(visibility == PATH_RAY_SHADOW_OPAQUE && isect->prim != ~0)
+						if(visibility == PATH_RAY_SHADOW_OPAQUE && isect->prim != ~0) {
+							PROFILING_BVH_RAY(kg, visibility);
 							return true;
+						}
 
 						primAddr++;
 					}
@@ -321,6 +417,8 @@ __device_inline bool bvh_intersect(KernelGlobals *kg, const Ray *ray, const uint
 #endif
 	} while(nodeAddr != ENTRYPOINT_SENTINEL);
 
+	PROFILING_BVH_RAY(kg, visibility);
+
 	return (isect->prim != ~0);
 }
 
@@ -349,6 +447,8 @@ __device_inline bool bvh_intersect_motion(KernelGlobals *kg, const Ray *ray, con
 	isect->u = 0.0f;
 	isect->v = 0.0f;
 
+	PROFILING_BVH_INIT();
+
 	/* traversal loop */
 	do {
 		do
@@ -356,6 +456,8 @@ __device_inline bool bvh_intersect_motion(KernelGlobals *kg, const Ray *ray, con
 			/* traverse internal nodes */
 			while(nodeAddr >= 0 && nodeAddr != ENTRYPOINT_SENTINEL)
 			{
+				PROFILING_BVH_NODE();
+
 				bool traverseChild0, traverseChild1, closestChild1;
 				int nodeAddrChild1;
 
@@ -401,14 +503,17 @@ __device_inline bool bvh_intersect_motion(KernelGlobals *kg, const Ray *ray, con
 					nodeAddr = traversalStack[stackPtr];
 					--stackPtr;
 
-					/* triangle intersection */
+					/* primitive intersection */
 					while(primAddr < primAddr2) {
-						/* intersect ray against triangle */
-						bvh_triangle_intersect(kg, isect, P, idir, visibility, object, primAddr);
+						/* intersect ray against triangle or curve */
+						bvh_primitive_intersect(kg, isect, P, idir, visibility, object, primAddr);
+						PROFILING_BVH_PRIM();
 
 						/* shadow ray early termination */
-						if(visibility == PATH_RAY_SHADOW_OPAQUE && isect->prim != ~0)
+						if(visibility == PATH_RAY_SHADOW_OPAQUE && isect->prim != ~0) {
+							PROFILING_BVH_RAY(kg, visibility);
 							return true;
+						}
 
 						primAddr++;
 					}
@@ -437,12 +542,27 @@ __device_inline bool bvh_intersect_motion(KernelGlobals *kg, const Ray *ray, con
 		}
 	} while(nodeAddr != ENTRYPOINT_SENTINEL);
 
+	PROFILING_BVH_RAY(kg, visibility);
+
 	return (isect->prim != ~0);
 }
 #endif
 
+CCL_NAMESPACE_END
+
+#ifdef __QBVH__
+#include "kernel_qbvh.h"
+#endif
+
+CCL_NAMESPACE_BEGIN
+
 __device_inline bool scene_intersect(KernelGlobals *kg, const Ray *ray, const uint visibility, Intersection *isect)
 {
+#ifdef __QBVH__
+	if(kernel_data.bvh.use_qbvh)
+		return qbvh_intersect(kg, ray, visibility, isect);
+#endif
+
 #ifdef __OBJECT_MOTION__
 	if(kernel_data.bvh.have_motion)
 		return bvh_intersect_motion(kg, ray, visibility, isect);
@@ -542,5 +662,71 @@ __device_inline float3 bvh_triangle_refine(KernelGlobals *kg, ShaderData *sd, co
 #endif
 }
 
+#ifdef __HAIR__
+/* position on the surface of a curve segment, with the normal pointing away
+ * from its axis and the tangent along it, in object space for instances */
+__device_inline float3 bvh_curve_refine(KernelGlobals *kg, ShaderData *sd, const Intersection *isect, const Ray *ray,
+	float3 *Ng, float3 *dPdu)
+{
+	float3 P = ray->P;
+	float3 D = ray->D;
+	float t = isect->t;
+
+	if(isect->object != ~0) {
+#ifdef __OBJECT_MOTION__
+		Transform tfm = sd->ob_itfm;
+#else
+		Transform tfm = object_fetch_transform(kg, isect->object, OBJECT_INVERSE_TRANSFORM);
+#endif
+
+		P = transform_point(&tfm, P);
+		D = transform_direction(&tfm, D*t);
+		D = normalize_len(D, &t);
+	}
+
+	P = P + D*t;
+
+	/* fetch segment keys */
+	float4 curvedata = kernel_tex_fetch(__curves, sd->prim);
+	int k0 = __float_as_int(curvedata.x) + sd->segment;
+	float4 P0 = kernel_tex_fetch(__curve_keys, k0);
+	float4 P1 = kernel_tex_fetch(__curve_keys, k0 + 1);
+
+	float3 p0 = float4_to_float3(P0);
+	float3 tg = float4_to_float3(P1) - p0;
+	float3 axis = normalize(tg);
+	float r = P0.w + isect->u*(P1.w - P0.w);
+
+	/* normal from the closest point on the axis, and project the position
+	 * onto the surface to remove the error of the intersection */
+	float3 Paxis = p0 + tg*isect->u;
+	float3 N = P - Paxis;
+	N = N - dot(N, axis)*axis;
+
+	float Nlen;
+	N = normalize_len(N, &Nlen);
+
+	if(Nlen == 0.0f)
+		N = normalize(cross(axis, D));
+
+	P = Paxis + N*r;
+
+	*Ng = N;
+	*dPdu = tg;
+
+	if(isect->object != ~0) {
+#ifdef __OBJECT_MOTION__
+		Transform tfm = sd->ob_tfm;
+#else
+		Transform tfm = object_fetch_transform(kg, isect->object, OBJECT_TRANSFORM);
+#endif
+
+		P = transform_point(&tfm, P);
+	}
+
+	return P;
+}
+#endif
+
 CCL_NAMESPACE_END
 
@@ -18,12 +18,26 @@
 
 CCL_NAMESPACE_BEGIN
 
-__device void kernel_shader_evaluate(KernelGlobals *kg, uint4 *input, float4 *output, ShaderEvalType type, int i)
+__device void kernel_shader_evaluate(KernelGlobals *kg, uint4 *input, float4 *output, ShaderEvalType type, int i, int sample)
 {
 	ShaderData sd;
 	uint4 in = input[i];
 	float3 out;
 
+#ifdef __BAKING__
+	if(type >= SHADER_EVAL_BAKE_COMBINED) {
+		out = kernel_bake_evaluate(kg, in, type, i, sample);
+
+		/* accumulate samples, the caller divides by the number of samples */
+		if(sample == 0)
+			output[i] = make_float4(out.x, out.y, out.z, 0.0f);
+		else
+			output[i] += make_float4(out.x, out.y, out.z, 0.0f);
+
+		return;
+	}
+#endif
+
 	if(type == SHADER_EVAL_DISPLACE) {
 		/* setup shader data */
 		int object = in.x;
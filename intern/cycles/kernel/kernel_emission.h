@@ -74,6 +74,8 @@ __device bool direct_emission(KernelGlobals *kg, ShaderData *sd, int lindex,
 
 	float pdf = -1.0f;
 
+	PROFILING_LIGHT_SAMPLE(kg);
+
 #ifdef __NON_PROGRESSIVE__
 	if(lindex != -1) {
 		/* sample position on a specified light */
@@ -66,5 +66,26 @@ __device void kernel_film_tonemap(KernelGlobals *kg,
 	*rgba = byte_result;
 }
 
+/* Error estimate for adaptive sampling, from the difference between the
+ * average of all samples and of only the odd samples in the auxiliary pass,
+ * relative to the square root of the brightness so that dark regions, where
+ * noise is less visible, do not dominate. Sample is the number of samples
+ * taken and must be even. */
+
+__device float kernel_film_adaptive_error(KernelGlobals *kg, __global float *buffer,
+	int sample, int x, int y, int offset, int stride)
+{
+	int index = offset + x + y*stride;
+
+	buffer += index*kernel_data.film.pass_stride;
+
+	float4 I = *((__global float4*)buffer) * (1.0f/(float)sample);
+	float4 A = *((__global float4*)(buffer + kernel_data.film.pass_adaptive_aux)) * (2.0f/(float)sample);
+
+	float error = fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z);
+
+	return error / sqrtf(1e-4f + I.x + I.y + I.z);
+}
+
 CCL_NAMESPACE_END
 
@@ -24,6 +24,10 @@
 #include "osl_globals.h"
 #endif
 
+#include "util_stats.h"
+#include "util_texture_cache.h"
+#include "util_thread.h"
+
 #endif
 
 CCL_NAMESPACE_BEGIN
@@ -48,6 +52,10 @@ typedef struct KernelGlobals {
 
 	KernelData __data;
 
+	/* Image textures loaded on demand, used instead of the full images above
+	 * for slots that were added to it. */
+	TextureCache *texture_cache;
+
 #ifdef __OSL__
 	/* On the CPU, we also have the OSL globals here. Most data structures are shared
 	 * with SVM, the difference is in the shaders and object/mesh attributes. */
@@ -56,6 +64,15 @@ typedef struct KernelGlobals {
 
 } KernelGlobals;
 
+/* Profiling counters of the render thread, NULL when not profiling. This is
+ * thread local rather than in KernelGlobals, which all threads share. */
+extern tls_ptr(ProfilingStats, kernel_profiling_stats);
+
+/* Texture cache lookups of the render thread, added to the cache once per
+ * tile so lookups don't all write to the same counter. NULL when the thread
+ * did not set a counter, then lookups are added to the cache directly. */
+extern tls_ptr(size_t, kernel_texture_cache_lookups);
+
 #endif
 
 /* For CUDA, constant memory textures must be globals, so we can't put them
@@ -90,3 +107,5 @@ typedef struct KernelGlobals {
 
 CCL_NAMESPACE_END
 
+#include "kernel_profiling.h"
+
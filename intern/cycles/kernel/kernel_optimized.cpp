@@ -22,6 +22,9 @@
 
 #ifdef WITH_OPTIMIZED_KERNEL
 
+/* SSE2 is available in this file, used for QBVH traversal */
+#define __KERNEL_SSE2__
+
 #include "kernel.h"
 #include "kernel_compat_cpu.h"
 #include "kernel_math.h"
@@ -29,6 +32,7 @@
 #include "kernel_globals.h"
 #include "kernel_film.h"
 #include "kernel_path.h"
+#include "kernel_bake.h"
 #include "kernel_displace.h"
 
 CCL_NAMESPACE_BEGIN
@@ -47,11 +51,18 @@ void kernel_cpu_optimized_tonemap(KernelGlobals *kg, uchar4 *rgba, float *buffer
 	kernel_film_tonemap(kg, rgba, buffer, sample, resolution, x, y, offset, stride);
 }
 
+/* Adaptive Sampling */
+
+float kernel_cpu_optimized_adaptive_error(KernelGlobals *kg, float *buffer, int sample, int x, int y, int offset, int stride)
+{
+	return kernel_film_adaptive_error(kg, buffer, sample, x, y, offset, stride);
+}
+
 /* Shader Evaluate */
 
-void kernel_cpu_optimized_shader(KernelGlobals *kg, uint4 *input, float4 *output, int type, int i)
+void kernel_cpu_optimized_shader(KernelGlobals *kg, uint4 *input, float4 *output, int type, int i, int sample)
 {
-	kernel_shader_evaluate(kg, input, output, (ShaderEvalType)type, i);
+	kernel_shader_evaluate(kg, input, output, (ShaderEvalType)type, i, sample);
 }
 
 CCL_NAMESPACE_END
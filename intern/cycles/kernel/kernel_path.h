@@ -21,11 +21,7 @@
 #include "kernel_projection.h"
 #include "kernel_object.h"
 #include "kernel_triangle.h"
-#ifdef __QBVH__
-#include "kernel_qbvh.h"
-#else
 #include "kernel_bvh.h"
-#endif
 #include "kernel_accumulate.h"
 #include "kernel_camera.h"
 #include "kernel_shader.h"
@@ -960,6 +956,13 @@ __device void kernel_path_trace(KernelGlobals *kg,
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
 
+#ifdef __PASSES__
+	/* odd samples are accumulated once more, comparing this half of the
+	 * samples with all of them gives an error estimate for adaptive sampling */
+	if((kernel_data.film.pass_flag & PASS_ADAPTIVE_AUX) && (sample & 1))
+		kernel_write_pass_float4(buffer + kernel_data.film.pass_adaptive_aux, sample >> 1, L);
+#endif
+
 	path_rng_end(kg, rng_state, rng);
 }
 
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Profiling Counters
+ *
+ * Counters are only added when the render thread has profiling stats set,
+ * otherwise the cost is a thread local pointer test. Loops that run many
+ * times per ray, like BVH traversal and the SVM interpreter, count in local
+ * variables and add the total once at the end. */
+
+CCL_NAMESPACE_BEGIN
+
+#ifdef __PROFILING__
+
+__device_inline ProfilingStats *profiling_stats(KernelGlobals *kg)
+{
+	return tls_get(ProfilingStats, kernel_profiling_stats);
+}
+
+__device_inline void profiling_ray(KernelGlobals *kg, uint visibility, uint num_nodes, uint num_prims)
+{
+	ProfilingStats *stats = profiling_stats(kg);
+
+	if(!stats)
+		return;
+
+	if(visibility & PATH_RAY_SHADOW)
+		stats->rays[PROFILING_RAY_SHADOW]++;
+	else if(visibility & PATH_RAY_CAMERA)
+		stats->rays[PROFILING_RAY_CAMERA]++;
+	else if(visibility & (PATH_RAY_TRANSMIT|PATH_RAY_TRANSPARENT))
+		stats->rays[PROFILING_RAY_TRANSMIT]++;
+	else
+		stats->rays[PROFILING_RAY_REFLECT]++;
+
+	stats->bvh_nodes += num_nodes;
+	stats->bvh_primitives += num_prims;
+}
+
+__device_inline void profiling_shader(KernelGlobals *kg, int shader, uint num_nodes)
+{
+	ProfilingStats *stats = profiling_stats(kg);
+
+	/* shader ids come in pairs, the second with bump mapping */
+	if(stats)
+		stats->add_shader((shader & SHADER_MASK)/2, num_nodes);
+}
+
+__device_inline void profiling_light_sample(KernelGlobals *kg)
+{
+	ProfilingStats *stats = profiling_stats(kg);
+
+	if(stats)
+		stats->light_samples++;
+}
+
+__device_inline void profiling_image_lookup(KernelGlobals *kg)
+{
+	ProfilingStats *stats = profiling_stats(kg);
+
+	if(stats)
+		stats->image_lookups++;
+}
+
+#define PROFILING_BVH_INIT() uint profiling_nodes = 0, profiling_prims = 0
+#define PROFILING_BVH_NODE() profiling_nodes++
+#define PROFILING_BVH_PRIM() profiling_prims++
+#define PROFILING_BVH_RAY(kg, visibility) profiling_ray(kg, visibility, profiling_nodes, profiling_prims)
+
+#define PROFILING_SVM_INIT() uint profiling_nodes = 0
+#define PROFILING_SVM_NODE() profiling_nodes++
+#define PROFILING_SVM_SHADER(kg, shader) profiling_shader(kg, shader, profiling_nodes)
+
+#define PROFILING_LIGHT_SAMPLE(kg) profiling_light_sample(kg)
+#define PROFILING_IMAGE_LOOKUP(kg) profiling_image_lookup(kg)
+
+#else
+
+#define PROFILING_BVH_INIT()
+#define PROFILING_BVH_NODE()
+#define PROFILING_BVH_PRIM()
+#define PROFILING_BVH_RAY(kg, visibility)
+
+#define PROFILING_SVM_INIT()
+#define PROFILING_SVM_NODE()
+#define PROFILING_SVM_SHADER(kg, shader)
+
+#define PROFILING_LIGHT_SAMPLE(kg)
+#define PROFILING_IMAGE_LOOKUP(kg)
+
+#endif
+
+CCL_NAMESPACE_END
+
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef __KERNEL_SSE2__
+#include <emmintrin.h>
+#endif
+
+CCL_NAMESPACE_BEGIN
+
+/* QBVH traversal
+ *
+ * Nodes have four children, with their bounds stored per axis so they can be
+ * intersected at once with SSE. This is used by the optimized CPU kernel,
+ * other kernels do the same operations one child at a time. Node layout, see
+ * QBVH::pack_inner():
+ *
+ * 0-5: min.x, max.x, min.y, max.y, min.z, max.z of the four children
+ * 6:   child node indexes, negative for leaves
+ * 7:   child visibility flags
+ *
+ * Leaf nodes store the primitive range in the x and y of entry 6. */
+
+#define BVH_QNODE_SIZE 8
+/* up to three children are pushed for every node, for two levels of BVH */
+#define QBVH_STACK_SIZE 384
+
+/* ray data for node intersection, recomputed on instance push and pop */
+typedef struct QBVHRay {
+	float3 idir;
+	float3 org_idir;
+	/* offset of the near bounds in a node for each axis, far is the next */
+	int near_x, near_y, near_z;
+} QBVHRay;
+
+__device_inline void qbvh_ray_init(QBVHRay *qray, float3 P, float3 idir)
+{
+	qray->idir = idir;
+	qray->org_idir = P*idir;
+	qray->near_x = (idir.x >= 0.0f)? 0: 1;
+	qray->near_y = (idir.y >= 0.0f)? 2: 3;
+	qray->near_z = (idir.z >= 0.0f)? 4: 5;
+}
+
+/* index of the lowest bit of a non-zero child mask */
+__device_inline int qbvh_first_child(int mask)
+{
+	return (mask & 1)? 0: (mask & 2)? 1: (mask & 4)? 2: 3;
+}
+
+/* intersect four bounding boxes, returns a bit for each child that was hit
+ * and the distances to them */
+__device_inline int qbvh_node_intersect(KernelGlobals *kg, float dist[4],
+	const QBVHRay *qray, float t, uint visibility, int nodeAddr)
+{
+	int offset = nodeAddr*BVH_QNODE_SIZE;
+
+	/* fetch node data */
+	float4 near_x = kernel_tex_fetch(__bvh_nodes, offset + qray->near_x);
+	float4 far_x = kernel_tex_fetch(__bvh_nodes, offset + (qray->near_x ^ 1));
+	float4 near_y = kernel_tex_fetch(__bvh_nodes, offset + qray->near_y);
+	float4 far_y = kernel_tex_fetch(__bvh_nodes, offset + (qray->near_y ^ 1));
+	float4 near_z = kernel_tex_fetch(__bvh_nodes, offset + qray->near_z);
+	float4 far_z = kernel_tex_fetch(__bvh_nodes, offset + (qray->near_z ^ 1));
+#ifdef __VISIBILITY_FLAG__
+	float4 cvisibility = kernel_tex_fetch(__bvh_nodes, offset + 7);
+#endif
+
+#ifdef __KERNEL_SSE2__
+	const __m128 idir_x = _mm_set1_ps(qray->idir.x);
+	const __m128 idir_y = _mm_set1_ps(qray->idir.y);
+	const __m128 idir_z = _mm_set1_ps(qray->idir.z);
+	const __m128 org_x = _mm_set1_ps(qray->org_idir.x);
+	const __m128 org_y = _mm_set1_ps(qray->org_idir.y);
+	const __m128 org_z = _mm_set1_ps(qray->org_idir.z);
+
+	/* intersect ray against child nodes */
+	__m128 tnear_x = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&near_x.x), idir_x), org_x);
+	__m128 tnear_y = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&near_y.x), idir_y), org_y);
+	__m128 tnear_z = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&near_z.x), idir_z), org_z);
+	__m128 tfar_x = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&far_x.x), idir_x), org_x);
+	__m128 tfar_y = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&far_y.x), idir_y), org_y);
+	__m128 tfar_z = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&far_z.x), idir_z), org_z);
+
+	__m128 tnear = _mm_max_ps(_mm_max_ps(tnear_x, tnear_y), _mm_max_ps(tnear_z, _mm_setzero_ps()));
+	__m128 tfar = _mm_min_ps(_mm_min_ps(tfar_x, tfar_y), _mm_min_ps(tfar_z, _mm_set1_ps(t)));
+
+	int mask = _mm_movemask_ps(_mm_cmple_ps(tnear, tfar));
+
+#ifdef __VISIBILITY_FLAG__
+	__m128i cvis = _mm_and_si128(_mm_loadu_si128((__m128i*)&cvisibility.x), _mm_set1_epi32(visibility));
+	mask &= ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(cvis, _mm_setzero_si128())));
+#endif
+
+	_mm_storeu_ps(dist, tnear);
+
+	return mask;
+#else
+	float3 idir = qray->idir;
+	float3 org_idir = qray->org_idir;
+	int mask = 0;
+
+	for(int i = 0; i < 4; i++) {
+		NO_EXTENDED_PRECISION float tnear = max4(near_x[i]*idir.x - org_idir.x,
+			near_y[i]*idir.y - org_idir.y, near_z[i]*idir.z - org_idir.z, 0.0f);
+		NO_EXTENDED_PRECISION float tfar = min4(far_x[i]*idir.x - org_idir.x,
+			far_y[i]*idir.y - org_idir.y, far_z[i]*idir.z - org_idir.z, t);
+
+		dist[i] = tnear;
+
+#ifdef __VISIBILITY_FLAG__
+		if(tnear <= tfar && (__float_as_uint(cvisibility[i]) & visibility))
+#else
+		if(tnear <= tfar)
+#endif
+			mask |= (1 << i);
+	}
+
+	return mask;
+#endif
+}
+
+__device_inline bool qbvh_intersect(KernelGlobals *kg, const Ray *ray, const uint visibility, Intersection *isect)
+{
+	/* traversal stack */
+	int traversalStack[QBVH_STACK_SIZE];
+	traversalStack[0] = ENTRYPOINT_SENTINEL;
+
+	/* traversal variables */
+	int stackPtr = 0;
+	int nodeAddr = kernel_data.bvh.root;
+
+	/* ray parameters */
+	const float tmax = ray->t;
+	float3 P = ray->P;
+	float3 idir = bvh_inverse_direction(ray->D);
+	int object = ~0;
+	QBVHRay qray;
+
+#ifdef __OBJECT_MOTION__
+	Transform ob_tfm;
+#endif
+
+	qbvh_ray_init(&qray, P, idir);
+
+	isect->t = tmax;
+	isect->object = ~0;
+	isect->prim = ~0;
+	isect->u = 0.0f;
+	isect->v = 0.0f;
+
+	PROFILING_BVH_INIT();
+
+	/* traversal loop */
+	do {
+		do
+		{
+			/* traverse internal nodes */
+			while(nodeAddr >= 0 && nodeAddr != ENTRYPOINT_SENTINEL)
+			{
+				PROFILING_BVH_NODE();
+
+				float dist[4];
+				int mask = qbvh_node_intersect(kg, dist, &qray, isect->t, visibility, nodeAddr);
+
+				if(mask == 0) {
+					/* no child was intersected */
+					nodeAddr = traversalStack[stackPtr];
+					--stackPtr;
+					continue;
+				}
+
+				float4 cnodes = kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+6);
+
+				/* one child intersected, continue with it */
+				int i0 = qbvh_first_child(mask);
+				mask &= mask - 1;
+
+				if(mask == 0) {
+					nodeAddr = __float_as_int(cnodes[i0]);
+					continue;
+				}
+
+				/* two children, push the farther one */
+				int i1 = qbvh_first_child(mask);
+				mask &= mask - 1;
+
+				if(mask == 0) {
+					if(dist[i1] < dist[i0]) {
+						int tmp = i0;
+						i0 = i1;
+						i1 = tmp;
+					}
+
+					++stackPtr;
+					traversalStack[stackPtr] = __float_as_int(cnodes[i1]);
+					nodeAddr = __float_as_int(cnodes[i0]);
+					continue;
+				}
+
+				/* three or four, sort by distance and push all but the closest,
+				 * farthest first */
+				int childAddr[4];
+				float childDist[4];
+				int num = 0;
+
+				mask = (mask | (1 << i0) | (1 << i1));
+
+				for(int i = 0; i < 4; i++) {
+					if(mask & (1 << i)) {
+						int j = num++;
+
+						for(; j > 0 && childDist[j-1] < dist[i]; j--) {
+							childAddr[j] = childAddr[j-1];
+							childDist[j] = childDist[j-1];
+						}
+
+						childAddr[j] = __float_as_int(cnodes[i]);
+						childDist[j] = dist[i];
+					}
+				}
+
+				for(int i = 0; i < num-1; i++) {
+					++stackPtr;
+					traversalStack[stackPtr] = childAddr[i];
+				}
+
+				nodeAddr = childAddr[num-1];
+			}
+
+			/* if node is leaf, fetch triangle list */
+			if(nodeAddr < 0) {
+				float4 leaf = kernel_tex_fetch(__bvh_nodes, (-nodeAddr-1)*BVH_QNODE_SIZE+6);
+				int primAddr = __float_as_int(leaf.x);
+
+#ifdef __INSTANCING__
+				if(primAddr >= 0) {
+#endif
+					int primAddr2 = __float_as_int(leaf.y);
+
+					/* pop */
+					nodeAddr = traversalStack[stackPtr];
+					--stackPtr;
+
+					/* primitive intersection */
+					while(primAddr < primAddr2) {
+						/* intersect ray against triangle or curve */
+						bvh_primitive_intersect(kg, isect, P, idir, visibility, object, primAddr);
+						PROFILING_BVH_PRIM();
+
+						/* shadow ray early termination */
+						if(visibility == PATH_RAY_SHADOW_OPAQUE && isect->prim != ~0) {
+							PROFILING_BVH_RAY(kg, visibility);
+							return true;
+						}
+
+						primAddr++;
+					}
+#ifdef __INSTANCING__
+				}
+				else {
+					/* instance push */
+					object = kernel_tex_fetch(__prim_object, -primAddr-1);
+
+#ifdef __OBJECT_MOTION__
+					if(kernel_data.bvh.have_motion)
+						bvh_instance_motion_push(kg, object, ray, &P, &idir, &isect->t, &ob_tfm, tmax);
+					else
+#endif
+						bvh_instance_push(kg, object, ray, &P, &idir, &isect->t, tmax);
+
+					qbvh_ray_init(&qray, P, idir);
+
+					++stackPtr;
+					traversalStack[stackPtr] = ENTRYPOINT_SENTINEL;
+
+					nodeAddr = kernel_tex_fetch(__object_node, object);
+				}
+#endif
+			}
+		} while(nodeAddr != ENTRYPOINT_SENTINEL);
+
+#ifdef __INSTANCING__
+		if(stackPtr >= 0) {
+			kernel_assert(object != ~0);
+
+			/* instance pop */
+#ifdef __OBJECT_MOTION__
+			if(kernel_data.bvh.have_motion)
+				bvh_instance_motion_pop(kg, object, ray, &P, &idir, &isect->t, &ob_tfm, tmax);
+			else
+#endif
+				bvh_instance_pop(kg, object, ray, &P, &idir, &isect->t, tmax);
+
+			qbvh_ray_init(&qray, P, idir);
+
+			object = ~0;
+			nodeAddr = traversalStack[stackPtr];
+			--stackPtr;
+		}
+#endif
+	} while(nodeAddr != ENTRYPOINT_SENTINEL);
+
+	PROFILING_BVH_RAY(kg, visibility);
+
+	return (isect->prim != ~0);
+}
+
+CCL_NAMESPACE_END
+
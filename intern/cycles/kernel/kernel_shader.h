@@ -67,7 +67,20 @@ __device_inline void shader_setup_from_ray(KernelGlobals *kg, ShaderData *sd,
 
 	/* fetch triangle data */
 	int prim = kernel_tex_fetch(__prim_index, isect->prim);
-	float4 Ns = kernel_tex_fetch(__tri_normal, prim);
+	float4 Ns;
+
+#ifdef __HAIR__
+	sd->segment = (kernel_data.bvh.have_curves)? kernel_tex_fetch(__prim_segment, isect->prim): ~0;
+
+	if(sd->segment != ~0) {
+		/* curve, normal is computed when refining the position */
+		float4 curvedata = kernel_tex_fetch(__curves, prim);
+		Ns = make_float4(0.0f, 0.0f, 0.0f, curvedata.z);
+	}
+	else
+#endif
+		Ns = kernel_tex_fetch(__tri_normal, prim);
+
 	float3 Ng = make_float3(Ns.x, Ns.y, Ns.z);
 	int shader = __float_as_int(Ns.w);
 
@@ -91,21 +104,37 @@ __device_inline void shader_setup_from_ray(KernelGlobals *kg, ShaderData *sd,
 #endif
 
 	/* vectors */
-	sd->P = bvh_triangle_refine(kg, sd, isect, ray);
-	sd->Ng = Ng;
-	sd->N = Ng;
 	sd->I = -ray->D;
 	sd->shader = shader;
 	sd->ray_length = isect->t;
 
-	/* smooth normal */
-	if(sd->shader & SHADER_SMOOTH_NORMAL)
-		sd->N = triangle_smooth_normal(kg, sd->prim, sd->u, sd->v);
+#ifdef __HAIR__
+	if(sd->segment != ~0) {
+		/* curves are not in the light distribution */
+		sd->flag &= ~SD_SAMPLE_AS_LIGHT;
 
+		sd->P = bvh_curve_refine(kg, sd, isect, ray, &sd->Ng, &sd->dPdu);
+		sd->N = sd->Ng;
 #ifdef __DPDU__
-	/* dPdu/dPdv */
-	triangle_dPdudv(kg, &sd->dPdu, &sd->dPdv, sd->prim);
+		sd->dPdv = cross(sd->Ng, sd->dPdu);
 #endif
+	}
+	else
+#endif
+	{
+		sd->P = bvh_triangle_refine(kg, sd, isect, ray);
+		sd->Ng = Ng;
+		sd->N = Ng;
+
+		/* smooth normal */
+		if(sd->shader & SHADER_SMOOTH_NORMAL)
+			sd->N = triangle_smooth_normal(kg, sd->prim, sd->u, sd->v);
+
+#ifdef __DPDU__
+		/* dPdu/dPdv */
+		triangle_dPdudv(kg, &sd->dPdu, &sd->dPdv, sd->prim);
+#endif
+	}
 
 #ifdef __INSTANCING__
 	if(isect->object != ~0) {
@@ -163,6 +192,9 @@ __device void shader_setup_from_sample(KernelGlobals *kg, ShaderData *sd,
 	sd->object = object;
 #endif
 	sd->prim = prim;
+#ifdef __HAIR__
+	sd->segment = ~0;
+#endif
 #ifdef __UV__
 	sd->u = u;
 	sd->v = v;
@@ -273,6 +305,35 @@ __device void shader_setup_from_displace(KernelGlobals *kg, ShaderData *sd,
 	shader_setup_from_sample(kg, sd, P, Ng, I, shader, object, prim, u, v, 0.0f, TIME_INVALID);
 }
 
+#ifdef __BAKING__
+
+/* ShaderData setup for baking, the surface is seen from the front along the
+ * geometric normal. object is encoded as in the BVH, >= 0 for instances */
+
+__device void shader_setup_from_bake(KernelGlobals *kg, ShaderData *sd,
+	int object, int prim, float u, float v)
+{
+	float3 P, Ng, I;
+	int shader;
+
+	P = triangle_point_MT(kg, prim, u, v);
+	Ng = triangle_normal_MT(kg, prim, &shader);
+
+	if(object >= 0) {
+		Transform tfm = object_fetch_transform(kg, object, OBJECT_TRANSFORM);
+		Transform itfm = object_fetch_transform(kg, object, OBJECT_INVERSE_TRANSFORM);
+
+		P = transform_point(&tfm, P);
+		Ng = normalize(transform_direction_transposed(&itfm, Ng));
+	}
+
+	I = Ng;
+
+	shader_setup_from_sample(kg, sd, P, Ng, I, shader, object, prim, u, v, 0.0f, 0.5f);
+}
+
+#endif
+
 /* ShaderData setup from ray into background */
 
 __device_inline void shader_setup_from_background(KernelGlobals *kg, ShaderData *sd, const Ray *ray)
@@ -298,6 +359,9 @@ __device_inline void shader_setup_from_background(KernelGlobals *kg, ShaderData
 	sd->object = ~0;
 #endif
 	sd->prim = ~0;
+#ifdef __HAIR__
+	sd->segment = ~0;
+#endif
 #ifdef __UV__
 	sd->u = 0.0f;
 	sd->v = 0.0f;
@@ -809,8 +873,15 @@ __device void shader_eval_displacement(KernelGlobals *kg, ShaderData *sd)
 __device bool shader_transparent_shadow(KernelGlobals *kg, Intersection *isect)
 {
 	int prim = kernel_tex_fetch(__prim_index, isect->prim);
-	float4 Ns = kernel_tex_fetch(__tri_normal, prim);
-	int shader = __float_as_int(Ns.w);
+	int shader;
+
+#ifdef __HAIR__
+	if(kernel_data.bvh.have_curves && kernel_tex_fetch(__prim_segment, isect->prim) != ~0)
+		shader = __float_as_int(kernel_tex_fetch(__curves, prim).z);
+	else
+#endif
+		shader = __float_as_int(kernel_tex_fetch(__tri_normal, prim).w);
+
 	int flag = kernel_tex_fetch(__shader_flag, (shader & SHADER_MASK)*2);
 
 	return (flag & SD_HAS_SURFACE_TRANSPARENT) != 0;
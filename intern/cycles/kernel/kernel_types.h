@@ -46,6 +46,10 @@ CCL_NAMESPACE_BEGIN
 #define __OSL__
 #endif
 #define __NON_PROGRESSIVE__
+#define __QBVH__
+#define __HAIR__
+#define __BAKING__
+#define __PROFILING__
 #endif
 
 #ifdef __KERNEL_CUDA__
@@ -125,7 +129,16 @@ CCL_NAMESPACE_BEGIN
 
 enum ShaderEvalType {
 	SHADER_EVAL_DISPLACE,
-	SHADER_EVAL_BACKGROUND
+	SHADER_EVAL_BACKGROUND,
+
+	/* bake types */
+	SHADER_EVAL_BAKE_COMBINED,
+	SHADER_EVAL_BAKE_AO,
+	SHADER_EVAL_BAKE_NORMAL,
+	SHADER_EVAL_BAKE_DIFFUSE_DIRECT,
+	SHADER_EVAL_BAKE_DIFFUSE_INDIRECT,
+	SHADER_EVAL_BAKE_GLOSSY_DIRECT,
+	SHADER_EVAL_BAKE_GLOSSY_INDIRECT
 };
 
 /* Path Tracing
@@ -224,7 +237,8 @@ typedef enum PassType {
 	PASS_AO = 131072,
 	PASS_SHADOW = 262144,
 	PASS_MOTION = 524288,
-	PASS_MOTION_WEIGHT = 1048576
+	PASS_MOTION_WEIGHT = 1048576,
+	PASS_ADAPTIVE_AUX = 2097152
 } PassType;
 
 #define PASS_ALL (~0)
@@ -431,6 +445,11 @@ typedef struct ShaderData {
 	/* object id if there is one, ~0 otherwise */
 	int object;
 
+#ifdef __HAIR__
+	/* for curves, segment number in curve, ~0 for triangles */
+	int segment;
+#endif
+
 	/* motion blur sample time */
 	float time;
 	
@@ -565,7 +584,7 @@ typedef struct KernelFilm {
 	int pass_ao;
 
 	int pass_shadow;
-	int pass_pad1;
+	int pass_adaptive_aux;
 	int pass_pad2;
 	int pass_pad3;
 } KernelFilm;
@@ -641,7 +660,9 @@ typedef struct KernelBVH {
 	int root;
 	int attributes_map_stride;
 	int have_motion;
-	int pad2;
+	int use_qbvh;
+	int have_curves;
+	int pad1, pad2, pad3;
 } KernelBVH;
 
 typedef struct KernelData {
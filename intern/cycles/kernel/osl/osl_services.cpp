@@ -593,6 +593,12 @@ bool OSLRenderServices::get_attribute(void *renderstate, bool derivatives, ustri
 	int object = sd->object;
 	int tri = sd->prim;
 
+#ifdef __HAIR__
+	/* curves have no mesh attributes */
+	if(sd->segment != ~0)
+		tri = ~0;
+#endif
+
 	/* lookup of attribute on another object */
 	if (object_name != u_empty) {
 		OSLGlobals::ObjectNameMap::iterator it = kg->osl.object_name_map.find(object_name);
@@ -192,9 +192,13 @@ __device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, ShaderT
 	sd->closure.type = NBUILTIN_CLOSURES;
 #endif
 
+	PROFILING_SVM_INIT();
+
 	while(1) {
 		uint4 node = read_node(kg, &offset);
 
+		PROFILING_SVM_NODE();
+
 		switch(node.x) {
 			case NODE_SHADER_JUMP: {
 				if(type == SHADER_TYPE_SURFACE) offset = node.y;
@@ -413,6 +417,7 @@ __device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, ShaderT
 #ifndef __MULTI_CLOSURE__
 				sd->closure.weight *= closure_weight;
 #endif
+				PROFILING_SVM_SHADER(kg, sd->shader);
 				return;
 		}
 	}
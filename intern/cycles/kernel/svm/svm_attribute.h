@@ -45,6 +45,12 @@ __device void svm_node_attr_init(KernelGlobals *kg, ShaderData *sd,
 		*mesh_type = (NodeAttributeType)node.w;
 	}
 
+#ifdef __HAIR__
+	/* curves have no mesh attributes */
+	if(sd->segment != ~0)
+		*elem = ATTR_ELEMENT_NONE;
+#endif
+
 	*out_offset = node.z;
 	*type = (NodeAttributeType)node.w;
 }
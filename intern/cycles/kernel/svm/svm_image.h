@@ -50,7 +50,7 @@ __device_inline float svm_image_texture_frac(float x, int *ix)
 	return x - (float)i;
 }
 
-__device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb)
+__device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, float width, uint srgb)
 {
 	/* first slots are used by float textures, which are not supported here */
 	if(id < TEX_NUM_FLOAT_IMAGES)
@@ -99,12 +99,27 @@ __device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, u
 
 #else
 
-__device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb)
+__device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, float width, uint srgb)
 {
 	float4 r;
 
 #ifdef __KERNEL_CPU__
-	r = kernel_tex_image_interp(id, x, y);
+	PROFILING_IMAGE_LOOKUP(kg);
+
+	if(kg->texture_cache && kg->texture_cache->has_image(id)) {
+		size_t *num_lookups = tls_get(size_t, kernel_texture_cache_lookups);
+		float f[4];
+
+		if(num_lookups)
+			(*num_lookups)++;
+		else
+			kg->texture_cache->add_lookups(1);
+
+		kg->texture_cache->lookup(id, x, y, width, f);
+		r = make_float4(f[0], f[1], f[2], f[3]);
+	}
+	else
+		r = kernel_tex_image_interp(id, x, y);
 #else
 	/* not particularly proud of this massive switch, what are the
 	 * alternatives?
@@ -241,7 +256,23 @@ __device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *stack
 	decode_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &srgb);
 
 	float3 co = stack_load_float3(stack, co_offset);
-	float4 f = svm_image_texture(kg, id, co.x, co.y, srgb);
+	float width = 0.0f;
+
+#ifdef __KERNEL_CPU__
+	/* filter width from the texture coordinates at the ray differentials,
+	 * only compiled in when the texture cache needs it to pick mip levels */
+	uint dx_offset, dy_offset, unused;
+	decode_node_uchar4(node.w, &dx_offset, &dy_offset, &unused, &unused);
+
+	if(stack_valid(dx_offset) && stack_valid(dy_offset)) {
+		float3 dx = stack_load_float3(stack, dx_offset) - co;
+		float3 dy = stack_load_float3(stack, dy_offset) - co;
+
+		width = max(sqrtf(dx.x*dx.x + dx.y*dx.y), sqrtf(dy.x*dy.x + dy.y*dy.y));
+	}
+#endif
+
+	float4 f = svm_image_texture(kg, id, co.x, co.y, width, srgb);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -324,11 +355,11 @@ __device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float *s
 	float4 f = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
 
 	if(weight.x > 0.0f)
-		f += weight.x*svm_image_texture(kg, id, co.y, co.z, srgb);
+		f += weight.x*svm_image_texture(kg, id, co.y, co.z, 0.0f, srgb);
 	if(weight.y > 0.0f)
-		f += weight.y*svm_image_texture(kg, id, co.x, co.z, srgb);
+		f += weight.y*svm_image_texture(kg, id, co.x, co.z, 0.0f, srgb);
 	if(weight.z > 0.0f)
-		f += weight.z*svm_image_texture(kg, id, co.y, co.x, srgb);
+		f += weight.z*svm_image_texture(kg, id, co.y, co.x, 0.0f, srgb);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -355,7 +386,7 @@ __device void svm_node_tex_environment(KernelGlobals *kg, ShaderData *sd, float
 	else
 		uv = direction_to_mirrorball(co);
 
-	float4 f = svm_image_texture(kg, id, uv.x, uv.y, srgb);
+	float4 f = svm_image_texture(kg, id, uv.x, uv.y, 0.0f, srgb);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
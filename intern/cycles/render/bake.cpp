@@ -0,0 +1,159 @@
+/*
+ * Copyright 2011, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "bake.h"
+#include "device.h"
+#include "mesh.h"
+#include "object.h"
+#include "scene.h"
+
+#include "util_foreach.h"
+#include "util_function.h"
+#include "util_progress.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bake Data */
+
+BakeData::BakeData(int object, size_t num_pixels)
+: object_index(object)
+{
+	primitive.resize(num_pixels, -1);
+	u.resize(num_pixels, 0.0f);
+	v.resize(num_pixels, 0.0f);
+}
+
+void BakeData::set(size_t i, int prim, float u_, float v_)
+{
+	primitive[i] = prim;
+	u[i] = u_;
+	v[i] = v_;
+}
+
+uint4 BakeData::data(size_t i, int object_id, size_t tri_offset) const
+{
+	return make_uint4(object_id, primitive[i] + tri_offset,
+		__float_as_int(u[i]), __float_as_int(v[i]));
+}
+
+/* Bake Manager */
+
+BakeManager::BakeManager()
+{
+	num_samples = 1;
+	batch_size = 64*64;
+}
+
+BakeManager::~BakeManager()
+{
+}
+
+bool BakeManager::is_light_pass(ShaderEvalType type)
+{
+	switch(type) {
+		case SHADER_EVAL_BAKE_COMBINED:
+		case SHADER_EVAL_BAKE_DIFFUSE_DIRECT:
+		case SHADER_EVAL_BAKE_DIFFUSE_INDIRECT:
+		case SHADER_EVAL_BAKE_GLOSSY_DIRECT:
+		case SHADER_EVAL_BAKE_GLOSSY_INDIRECT:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool BakeManager::bake(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress,
+	ShaderEvalType shader_type, BakeData *bake_data, float result[], int depth)
+{
+	/* only valid points are sent to the device, packed together */
+	size_t num_pixels = bake_data->size();
+	vector<size_t> index;
+
+	for(size_t i = 0; i < num_pixels; i++)
+		if(bake_data->is_valid(i))
+			index.push_back(i);
+
+	if(index.size() == 0)
+		return true;
+
+	/* object and triangle offset as they ended up on the device, the object
+	 * is encoded as in the BVH, -object-1 when the transform was applied */
+	Object *object = scene->objects[bake_data->object()];
+	Mesh *mesh = object->mesh;
+	int object_id = (mesh->transform_applied)? ~bake_data->object(): bake_data->object();
+
+	device_vector<uint4> d_input;
+	device_vector<float4> d_output;
+	uint4 *d_input_data = d_input.resize(index.size());
+
+	for(size_t i = 0; i < index.size(); i++)
+		d_input_data[i] = bake_data->data(index[i], object_id, mesh->tri_offset);
+
+	d_output.resize(index.size());
+
+	/* the normal pass is not noisy, no need for more than one sample */
+	int samples = (shader_type == SHADER_EVAL_BAKE_NORMAL)? 1: max(num_samples, 1);
+
+	device->mem_alloc(d_input, MEM_READ_ONLY);
+	device->mem_copy_to(d_input);
+	device->mem_alloc(d_output, MEM_WRITE_ONLY);
+
+	DeviceTask main_task(DeviceTask::SHADER);
+	main_task.shader_input = d_input.device_pointer;
+	main_task.shader_output = d_output.device_pointer;
+	main_task.shader_eval_type = shader_type;
+	main_task.shader_x = 0;
+	main_task.shader_w = d_input.size();
+	main_task.num_samples = samples;
+	main_task.get_cancel = function_bind(&Progress::get_cancel, &progress);
+
+	/* split in batches the size of a render tile, so they are scheduled and
+	 * load balanced over the device threads like tiles are */
+	list<DeviceTask> split_tasks;
+	main_task.split_max_size(split_tasks, max(batch_size, 1));
+
+	foreach(DeviceTask& task, split_tasks)
+		device->task_add(task);
+
+	device->task_wait();
+
+	device->mem_copy_from(d_output, 0, 1, d_output.size(), sizeof(float4));
+	device->mem_free(d_input);
+	device->mem_free(d_output);
+
+	if(progress.get_cancel())
+		return false;
+
+	/* read result, averaging the accumulated samples */
+	float4 *output = (float4*)d_output.data_pointer;
+	float inv_samples = 1.0f/samples;
+	int channels = min(depth, 4);
+
+	for(size_t i = 0; i < index.size(); i++) {
+		float4 out = output[i]*inv_samples;
+		float *pixel = result + index[i]*depth;
+
+		for(int c = 0; c < channels; c++)
+			pixel[c] = (c == 3)? 1.0f: out[c];
+	}
+
+	return true;
+}
+
+CCL_NAMESPACE_END
+
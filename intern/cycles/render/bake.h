@@ -0,0 +1,82 @@
+/*
+ * Copyright 2011, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BAKE_H__
+#define __BAKE_H__
+
+#include "kernel_types.h"
+
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Device;
+class DeviceScene;
+class Progress;
+class Scene;
+
+/* Bake Data
+ *
+ * Points to bake, one per image pixel. Each is a triangle of the object mesh
+ * and barycentric coordinates on it, pixels not covered by any triangle have
+ * primitive -1 and are left untouched in the result. object is the index in
+ * the scene objects and prim the triangle index within the object mesh. */
+
+class BakeData {
+public:
+	BakeData(int object, size_t num_pixels);
+
+	void set(size_t i, int prim, float u, float v);
+
+	int object() const { return object_index; }
+	size_t size() const { return primitive.size(); }
+	bool is_valid(size_t i) const { return primitive[i] != -1; }
+	uint4 data(size_t i, int object_id, size_t tri_offset) const;
+
+protected:
+	int object_index;
+	vector<int> primitive;
+	vector<float> u;
+	vector<float> v;
+};
+
+/* Bake Manager */
+
+class BakeManager {
+public:
+	/* samples per point for the light passes */
+	int num_samples;
+	/* points per device task, the size of a render tile */
+	int batch_size;
+
+	BakeManager();
+	~BakeManager();
+
+	/* evaluate the pass for all valid points, writing depth floats per point
+	 * into result. returns false if cancelled */
+	bool bake(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress,
+		ShaderEvalType shader_type, BakeData *bake_data, float result[], int depth);
+
+	static bool is_light_pass(ShaderEvalType type);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __BAKE_H__ */
+
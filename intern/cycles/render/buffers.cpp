@@ -90,6 +90,8 @@ RenderTile::RenderTile()
 	offset = 0;
 	stride = 0;
 
+	finished = false;
+
 	buffer = 0;
 	rng_state = 0;
 	rgba = 0;
@@ -134,6 +134,10 @@ public:
 	int offset;
 	int stride;
 
+	/* set by the device on release, false when the tile was given back
+	 * before all its samples were rendered or it converged */
+	bool finished;
+
 	device_ptr buffer;
 	device_ptr rng_state;
 	device_ptr rgba;
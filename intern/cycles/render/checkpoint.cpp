@@ -0,0 +1,291 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "buffers.h"
+#include "checkpoint.h"
+
+#include "util_foreach.h"
+#include "util_path.h"
+#include "util_time.h"
+
+CCL_NAMESPACE_BEGIN
+
+#define CHECKPOINT_MAGIC "CYCLCKPT"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_TILE_END 0x454c4954 /* "TILE" */
+
+/* Checkpoint Header */
+
+CheckpointHeader::CheckpointHeader()
+: width(0), height(0), full_x(0), full_y(0), full_width(0), full_height(0),
+  pass_stride(0), num_samples(0), seed(0)
+{
+}
+
+bool CheckpointHeader::modified(const CheckpointHeader& header) const
+{
+	return !(width == header.width
+		&& height == header.height
+		&& full_x == header.full_x
+		&& full_y == header.full_y
+		&& full_width == header.full_width
+		&& full_height == header.full_height
+		&& pass_stride == header.pass_stride
+		&& num_samples == header.num_samples
+		&& seed == header.seed);
+}
+
+/* Render Checkpoint */
+
+RenderCheckpoint::RenderCheckpoint(const string& filepath_, double interval_)
+: filepath(filepath_), interval(interval_), last_write_time(0.0), active(false)
+{
+}
+
+RenderCheckpoint::~RenderCheckpoint()
+{
+}
+
+bool RenderCheckpoint::read(const CheckpointHeader& header, vector<CheckpointTile>& tiles)
+{
+	FILE *rf = fopen(filepath.c_str(), "rb");
+
+	if(!rf)
+		return false;
+
+	char magic[8];
+	int version;
+	CheckpointHeader file_header;
+
+	if(fread(magic, sizeof(magic), 1, rf) != 1 ||
+	   fread(&version, sizeof(version), 1, rf) != 1 ||
+	   fread(&file_header, sizeof(file_header), 1, rf) != 1 ||
+	   memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 ||
+	   version != CHECKPOINT_VERSION ||
+	   file_header.modified(header))
+	{
+		fclose(rf);
+		return false;
+	}
+
+	/* read tiles up to the first incomplete or damaged one */
+	while(1) {
+		CheckpointTile tile;
+		int end = 0;
+
+		if(fread(&tile.x, sizeof(int), 1, rf) != 1 ||
+		   fread(&tile.y, sizeof(int), 1, rf) != 1 ||
+		   fread(&tile.w, sizeof(int), 1, rf) != 1 ||
+		   fread(&tile.h, sizeof(int), 1, rf) != 1 ||
+		   fread(&tile.sample, sizeof(int), 1, rf) != 1)
+			break;
+
+		if(tile.w <= 0 || tile.h <= 0 || tile.w > header.width || tile.h > header.height)
+			break;
+
+		tile.buffer.resize((size_t)tile.w*tile.h*header.pass_stride);
+
+		if(fread(&tile.buffer[0], sizeof(float), tile.buffer.size(), rf) != tile.buffer.size() ||
+		   fread(&end, sizeof(end), 1, rf) != 1 ||
+		   end != CHECKPOINT_TILE_END)
+			break;
+
+		tiles.push_back(tile);
+	}
+
+	fclose(rf);
+
+	return true;
+}
+
+bool RenderCheckpoint::write_tile(FILE *f, const CheckpointTile& tile)
+{
+	int end = CHECKPOINT_TILE_END;
+
+	return (fwrite(&tile.x, sizeof(int), 1, f) == 1 &&
+	        fwrite(&tile.y, sizeof(int), 1, f) == 1 &&
+	        fwrite(&tile.w, sizeof(int), 1, f) == 1 &&
+	        fwrite(&tile.h, sizeof(int), 1, f) == 1 &&
+	        fwrite(&tile.sample, sizeof(int), 1, f) == 1 &&
+	        fwrite(&tile.buffer[0], sizeof(float), tile.buffer.size(), f) == tile.buffer.size() &&
+	        fwrite(&end, sizeof(end), 1, f) == 1);
+}
+
+static bool checkpoint_file_sync(FILE *f)
+{
+	if(fflush(f) != 0)
+		return false;
+
+#ifdef _WIN32
+	return (_commit(_fileno(f)) == 0);
+#else
+	return (fsync(fileno(f)) == 0);
+#endif
+}
+
+bool RenderCheckpoint::write(const vector<CheckpointTile>& tiles, bool new_file)
+{
+	bool ok = true;
+
+	if(!new_file) {
+		/* append to the checkpoint, a record cut off by a crash is dropped
+		 * on reading through its end marker */
+		FILE *f = fopen(filepath.c_str(), "ab");
+
+		if(!f)
+			return false;
+
+		foreach(const CheckpointTile& tile, tiles)
+			ok = ok && write_tile(f, tile);
+
+		ok = ok && checkpoint_file_sync(f);
+
+		if(fclose(f) != 0)
+			ok = false;
+
+		return ok;
+	}
+
+	/* a new file replaces the checkpoint that was read, write it next to
+	 * it so a crash halfway leaves the old one */
+	string tmp_filepath = filepath + ".tmp";
+	FILE *f = fopen(tmp_filepath.c_str(), "wb");
+
+	if(!f)
+		return false;
+
+	int version = CHECKPOINT_VERSION;
+
+	ok = (fwrite(CHECKPOINT_MAGIC, 8, 1, f) == 1 &&
+	      fwrite(&version, sizeof(version), 1, f) == 1 &&
+	      fwrite(&header, sizeof(header), 1, f) == 1);
+
+	foreach(const CheckpointTile& tile, tiles)
+		ok = ok && write_tile(f, tile);
+
+	ok = ok && checkpoint_file_sync(f);
+
+	if(fclose(f) != 0)
+		ok = false;
+
+	if(ok) {
+#ifdef _WIN32
+		/* rename does not replace existing files on windows */
+		::remove(filepath.c_str());
+#endif
+		ok = (::rename(tmp_filepath.c_str(), filepath.c_str()) == 0);
+	}
+
+	if(!ok)
+		::remove(tmp_filepath.c_str());
+
+	return ok;
+}
+
+bool RenderCheckpoint::open(const CheckpointHeader& header_, vector<CheckpointTile>& tiles)
+{
+	header = header_;
+	tiles.clear();
+
+	if(!read(header, tiles))
+		tiles.clear();
+
+	/* always start a new file with the tiles that were read, this drops
+	 * a damaged record at the end so new tiles are not appended after it */
+	path_create_directories(filepath);
+
+	if(!write(tiles, true)) {
+		fprintf(stderr, "Failed to write checkpoint file %s.\n", filepath.c_str());
+		return false;
+	}
+
+	active = true;
+	last_write_time = time_dt();
+
+	return true;
+}
+
+void RenderCheckpoint::add_tile(RenderTile& rtile)
+{
+	if(!active)
+		return;
+
+	RenderBuffers *buffers = rtile.buffers;
+
+	if(!buffers->copy_from_device())
+		return;
+
+	float *data = (float*)buffers->buffer.data_pointer;
+
+	pending_tiles.push_back(CheckpointTile());
+
+	CheckpointTile& tile = pending_tiles.back();
+	tile.x = rtile.x;
+	tile.y = rtile.y;
+	tile.w = rtile.w;
+	tile.h = rtile.h;
+	tile.sample = rtile.sample;
+	tile.buffer.assign(data, data + buffers->buffer.size());
+}
+
+void RenderCheckpoint::update(bool force)
+{
+	if(!active || pending_tiles.empty())
+		return;
+
+	double current_time = time_dt();
+
+	if(!force && current_time - last_write_time < interval)
+		return;
+
+	bool ok = write(pending_tiles, false);
+
+	pending_tiles.clear();
+	last_write_time = current_time;
+
+	/* stop checkpointing rather than leave a file with holes, the file
+	 * from the last successful write stays usable */
+	if(!ok) {
+		fprintf(stderr, "Failed to write checkpoint file %s.\n", filepath.c_str());
+		active = false;
+	}
+}
+
+void RenderCheckpoint::close(bool finished)
+{
+	if(finished)
+		pending_tiles.clear();
+	else
+		update(true);
+
+	active = false;
+
+	if(finished)
+		::remove(filepath.c_str());
+}
+
+CCL_NAMESPACE_END
+
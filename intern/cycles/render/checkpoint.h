@@ -0,0 +1,111 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <stdio.h>
+
+#include "util_string.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class RenderTile;
+
+/* Checkpoint Header
+ *
+ * Render settings a checkpoint is only valid for. Scene contents are not
+ * part of it, a checkpoint left by a render of a modified scene with the
+ * same settings would be resumed too. */
+
+class CheckpointHeader {
+public:
+	int width, height;
+	int full_x, full_y;
+	int full_width, full_height;
+	int pass_stride;
+	int num_samples;
+	int seed;
+
+	CheckpointHeader();
+	bool modified(const CheckpointHeader& header) const;
+};
+
+/* Checkpoint Tile
+ *
+ * Finished tile with its render buffer, position in full image coordinates.
+ * The sample count is kept per tile, adaptive sampling can finish tiles
+ * before all samples. */
+
+class CheckpointTile {
+public:
+	int x, y, w, h;
+	int sample;
+	vector<float> buffer;
+};
+
+/* Render Checkpoint
+ *
+ * File with the tiles finished so far, so an interrupted background render
+ * can continue where it stopped. Tiles are stored as records after the
+ * header, each ending with a marker so a damaged record is detected and
+ * dropped on reading. New tiles are appended to the file, a new file is
+ * written to a temporary file that is renamed over the old one.
+ * Data is in native byte order, checkpoints are meant to be resumed on the
+ * same kind of machine. */
+
+class RenderCheckpoint {
+public:
+	RenderCheckpoint(const string& filepath, double interval);
+	~RenderCheckpoint();
+
+	/* read tiles left by an earlier render with the same header, and write
+	 * them back as the start of the new checkpoint */
+	bool open(const CheckpointHeader& header, vector<CheckpointTile>& tiles);
+
+	/* copy a finished tile, written with the next update */
+	void add_tile(RenderTile& rtile);
+
+	/* write added tiles once the interval passed since the last write, or
+	 * always when forced */
+	void update(bool force = false);
+
+	/* write remaining tiles and close, removing the file when the render
+	 * was finished and there is nothing left to resume */
+	void close(bool finished);
+
+protected:
+	bool read(const CheckpointHeader& header, vector<CheckpointTile>& tiles);
+	bool write(const vector<CheckpointTile>& tiles, bool new_file);
+	bool write_tile(FILE *f, const CheckpointTile& tile);
+
+	string filepath;
+	double interval;
+	double last_write_time;
+
+	bool active;
+	CheckpointHeader header;
+	vector<CheckpointTile> pending_tiles;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __CHECKPOINT_H__ */
+
@@ -138,6 +138,10 @@ void Pass::add(PassType type, vector<Pass>& passes)
 			pass.components = 4;
 			pass.exposure = false;
 			break;
+		case PASS_ADAPTIVE_AUX:
+			pass.components = 4;
+			pass.exposure = false;
+			break;
 	}
 
 	passes.push_back(pass);
@@ -277,6 +281,10 @@ void Film::device_update(Device *device, DeviceScene *dscene)
 				kfilm->use_light_pass = 1;
 			case PASS_NONE:
 				break;
+
+			case PASS_ADAPTIVE_AUX:
+				kfilm->pass_adaptive_aux = kfilm->pass_stride;
+				break;
 		}
 
 		kfilm->pass_stride += pass.components;
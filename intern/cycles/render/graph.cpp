@@ -219,7 +219,7 @@ void ShaderGraph::disconnect(ShaderInput *to)
 	from->links.erase(remove(from->links.begin(), from->links.end(), to), from->links.end());
 }
 
-void ShaderGraph::finalize(bool do_bump, bool do_osl)
+void ShaderGraph::finalize(bool do_bump, bool do_osl, bool do_image_derivatives)
 {
 	/* before compiling, the shader graph may undergo a number of modifications.
 	 * currently we set default geometry shader inputs, and create automatic bump
@@ -234,6 +234,9 @@ void ShaderGraph::finalize(bool do_bump, bool do_osl)
 		if(do_bump)
 			bump_from_displacement();
 
+		if(do_image_derivatives)
+			refine_image_derivatives();
+
 		finalized = true;
 	}
 }
@@ -542,6 +545,50 @@ void ShaderGraph::refine_bump_nodes()
 	}
 }
 
+void ShaderGraph::refine_image_derivatives()
+{
+	/* the texture cache picks mip levels from the texture coordinates at the
+	 * ray differentials. like in refine_bump_nodes(), we copy the sub-graph
+	 * defining the image vector input twice, with coordinates shifted by dx
+	 * and dy, and connect them to the derivative inputs. nodes that are
+	 * already part of a bump evaluation keep using the full resolution. */
+	list<ShaderNode*> image_nodes;
+
+	foreach(ShaderNode *node, nodes)
+		if(node->name == ustring("image_texture") && node->bump == SHADER_BUMP_NONE && node->input("Vector")->link)
+			image_nodes.push_back(node);
+
+	foreach(ShaderNode *node, image_nodes) {
+		ShaderInput *vector_input = node->input("Vector");
+		set<ShaderNode*> nodes_vector;
+
+		map<ShaderNode*, ShaderNode*> nodes_dx;
+		map<ShaderNode*, ShaderNode*> nodes_dy;
+
+		find_dependencies(nodes_vector, vector_input);
+
+		copy_nodes(nodes_vector, nodes_dx);
+		copy_nodes(nodes_vector, nodes_dy);
+
+		foreach(NodePair& pair, nodes_dx)
+			pair.second->bump = SHADER_BUMP_DX;
+		foreach(NodePair& pair, nodes_dy)
+			pair.second->bump = SHADER_BUMP_DY;
+
+		ShaderOutput *out = vector_input->link;
+		ShaderOutput *out_dx = nodes_dx[out->parent]->output(out->name);
+		ShaderOutput *out_dy = nodes_dy[out->parent]->output(out->name);
+
+		connect(out_dx, node->input("VectorDX"));
+		connect(out_dy, node->input("VectorDY"));
+
+		foreach(NodePair& pair, nodes_dx)
+			add(pair.second);
+		foreach(NodePair& pair, nodes_dy)
+			add(pair.second);
+	}
+}
+
 void ShaderGraph::bump_from_displacement()
 {
 	/* generate bump mapping automatically from displacement. bump mapping is
@@ -227,7 +227,7 @@ public:
 	void connect(ShaderOutput *from, ShaderInput *to);
 	void disconnect(ShaderInput *to);
 
-	void finalize(bool do_bump = false, bool do_osl = false);
+	void finalize(bool do_bump = false, bool do_osl = false, bool do_image_derivatives = false);
 
 protected:
 	typedef pair<ShaderNode* const, ShaderNode*> NodePair;
@@ -240,6 +240,7 @@ protected:
 	void clean();
 	void bump_from_displacement();
 	void refine_bump_nodes();
+	void refine_image_derivatives();
 	void default_inputs(bool do_osl);
 };
 
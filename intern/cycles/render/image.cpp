@@ -22,8 +22,12 @@
 
 #include "util_foreach.h"
 #include "util_image.h"
+#include "util_list.h"
 #include "util_path.h"
 #include "util_progress.h"
+#include "util_texture_cache.h"
+
+#include <boost/shared_ptr.hpp>
 
 #ifdef WITH_OSL
 #include <OSL/oslexec.h>
@@ -36,6 +40,7 @@ ImageManager::ImageManager()
 	need_update = true;
 	pack_images = false;
 	osl_texture_system = NULL;
+	texture_cache = NULL;
 	animation_frame = 0;
 
 	tex_num_images = TEX_NUM_IMAGES;
@@ -49,6 +54,8 @@ ImageManager::~ImageManager()
 		assert(!images[slot]);
 	for(size_t slot = 0; slot < float_images.size(); slot++)
 		assert(!float_images[slot]);
+
+	delete texture_cache;
 }
 
 void ImageManager::set_pack_images(bool pack_images_)
@@ -68,6 +75,31 @@ void ImageManager::set_extended_image_limits(void)
 	tex_image_byte_start = TEX_EXTENDED_IMAGE_BYTE_START;
 }
 
+void ImageManager::set_texture_cache_limit(size_t limit)
+{
+	/* with a limit, images are read in tiles on demand by the texture cache
+	 * rather than loaded whole, zero disables it */
+	if(limit == 0) {
+		delete texture_cache;
+		texture_cache = NULL;
+	}
+	else {
+		if(!texture_cache)
+			texture_cache = new TextureCache();
+
+		texture_cache->set_memory_limit(limit);
+	}
+}
+
+bool ImageManager::get_texture_cache_stats(TextureCacheStats& stats)
+{
+	if(!texture_cache)
+		return false;
+
+	texture_cache->get_stats(stats);
+	return true;
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
 	if(frame != animation_frame) {
@@ -237,6 +269,221 @@ void ImageManager::remove_image(const string& filename)
 	}
 }
 
+template<typename T>
+static void file_copy_region(T *scanlines, int width, int components,
+	int x, int w, int h, int stride, T *pixels, T alpha)
+{
+	/* flip rows and expand to RGBA */
+	for(int j = 0; j < h; j++) {
+		T *in = scanlines + ((size_t)(h - 1 - j)*width + x)*components;
+		T *out = pixels + (size_t)j*stride*4;
+
+		for(int i = 0; i < w; i++, in += components, out += 4) {
+			if(components == 1) {
+				out[0] = in[0];
+				out[1] = in[0];
+				out[2] = in[0];
+				out[3] = alpha;
+			}
+			else {
+				out[0] = in[0];
+				out[1] = in[1];
+				out[2] = in[2];
+				out[3] = (components == 4)? in[3]: alpha;
+			}
+		}
+	}
+}
+
+/* Reads regions of mip levels for the texture cache. The file stays open
+ * between reads, they are done with the lock of the image held. Files that
+ * only store scanlines are decoded from the start when reading above the
+ * previous region, the cache reads whole rows of tiles to keep that rare.
+ *
+ * Scenes can have more image files than the system allows to be open, so
+ * only the most recently read files are kept open, the least recently read
+ * one is closed when another file needs to be opened. */
+
+#define IMAGE_READER_MAX_OPEN 64
+
+class ImageFileRegionReader {
+public:
+	ImageFileRegionReader(const string& filename_, bool is_float_)
+	: filename(filename_), is_float(is_float_), in(NULL), failed(false), current_level(-1)
+	{
+	}
+
+	~ImageFileRegionReader()
+	{
+		thread_scoped_lock open_lock(open_mutex);
+
+		if(in) {
+			open_readers.erase(open_it);
+			close();
+		}
+	}
+
+	bool read(int level, int x, int y, int w, int h, int stride, void *pixels)
+	{
+		/* read a region of a mip level for the texture cache, with rows from
+		 * bottom to top like the full images. returning false for levels the
+		 * file does not have makes the cache generate them */
+		thread_scoped_lock read_lock(read_mutex);
+
+		if(!open())
+			return false;
+
+		/* mip level size as the cache computes it */
+		int width = full_width;
+		int height = full_height;
+
+		for(int i = 0; i < level; i++) {
+			width = max(width/2, 1);
+			height = max(height/2, 1);
+		}
+
+		if(level != current_level) {
+			current_level = -1;
+
+			if(!(in->seek_subimage(0, level, spec) && spec.width == width && spec.height == height))
+				return false;
+
+			current_level = level;
+		}
+
+		int components = spec.nchannels;
+
+		if(!(components == 1 || components == 3 || components == 4))
+			return false;
+
+		/* read the whole scanlines covering the region, files are stored top
+		 * to bottom so the region starts at the flipped row */
+		int ybegin = spec.y + height - (y + h);
+		size_t pixelsize = (is_float)? sizeof(float): sizeof(uchar);
+		vector<uchar> scanlines((size_t)width*h*components*pixelsize);
+
+		if(!in->read_scanlines(ybegin, ybegin + h, spec.z,
+			(is_float)? TypeDesc::FLOAT: TypeDesc::UINT8, &scanlines[0]))
+			return false;
+
+		if(is_float)
+			file_copy_region((float*)&scanlines[0], width, components, x, w, h, stride, (float*)pixels, 1.0f);
+		else
+			file_copy_region((uchar*)&scanlines[0], width, components, x, w, h, stride, (uchar*)pixels, (uchar)255);
+
+		return true;
+	}
+
+protected:
+	/* called with read_mutex held */
+	bool open()
+	{
+		thread_scoped_lock open_lock(open_mutex);
+
+		if(in) {
+			/* move to the front, readers at the back are closed first */
+			open_readers.splice(open_readers.begin(), open_readers, open_it);
+			return true;
+		}
+		if(failed)
+			return false;
+
+		/* readers that are busy reading are skipped, they are recently used */
+		list<ImageFileRegionReader*>::iterator it = open_readers.end();
+
+		while(open_readers.size() >= IMAGE_READER_MAX_OPEN && it != open_readers.begin()) {
+			ImageFileRegionReader *reader = *(--it);
+
+			if(reader->read_mutex.try_lock()) {
+				it = open_readers.erase(it);
+				reader->close();
+				reader->read_mutex.unlock();
+			}
+		}
+
+		in = ImageInput::create(filename);
+
+		if(in && in->open(filename, spec)) {
+			full_width = spec.width;
+			full_height = spec.height;
+			current_level = 0;
+
+			open_readers.push_front(this);
+			open_it = open_readers.begin();
+
+			return true;
+		}
+
+		delete in;
+		in = NULL;
+		failed = true;
+
+		return false;
+	}
+
+	/* called with read_mutex and open_mutex held, the file is opened again
+	 * by the next read */
+	void close()
+	{
+		in->close();
+		delete in;
+		in = NULL;
+		current_level = -1;
+	}
+
+	string filename;
+	bool is_float;
+
+	ImageInput *in;
+	ImageSpec spec;
+	bool failed;
+	int current_level;
+	int full_width, full_height;
+
+	thread_mutex read_mutex;
+	list<ImageFileRegionReader*>::iterator open_it;
+
+	static thread_mutex open_mutex;
+	static list<ImageFileRegionReader*> open_readers;
+};
+
+thread_mutex ImageFileRegionReader::open_mutex;
+list<ImageFileRegionReader*> ImageFileRegionReader::open_readers;
+
+bool ImageManager::file_cache_image(Image *img, int slot, bool is_float)
+{
+	if(img->filename == "")
+		return false;
+
+	/* only read the header here, pixels are read when lookups touch them */
+	ImageInput *in = ImageInput::create(img->filename);
+
+	if(!in)
+		return false;
+
+	ImageSpec spec;
+
+	if(!in->open(img->filename, spec)) {
+		delete in;
+		return false;
+	}
+
+	in->close();
+	delete in;
+
+	int components = spec.nchannels;
+
+	if(!(components == 1 || components == 3 || components == 4))
+		return false;
+
+	texture_cache->add_image(slot, spec.width, spec.height, is_float,
+		function_bind(&ImageFileRegionReader::read,
+			boost::shared_ptr<ImageFileRegionReader>(new ImageFileRegionReader(img->filename, is_float)),
+			_1, _2, _3, _4, _5, _6, _7));
+
+	return true;
+}
+
 bool ImageManager::file_load_image(Image *img, device_vector<uchar4>& tex_img)
 {
 	if(img->filename == "")
@@ -391,6 +638,16 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int sl
 			device->tex_free(tex_img);
 		}
 
+		if(texture_cache) {
+			if(file_cache_image(img, slot, true)) {
+				tex_img.clear();
+				img->need_load = false;
+				return;
+			}
+
+			texture_cache->remove_image(slot);
+		}
+
 		if(!file_load_float_image(img, tex_img)) {
 			/* on failure to load, we set a 1x1 pixels pink image */
 			float *pixels = (float*)tex_img.resize(1, 1);
@@ -422,6 +679,16 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int sl
 			device->tex_free(tex_img);
 		}
 
+		if(texture_cache) {
+			if(file_cache_image(img, slot, false)) {
+				tex_img.clear();
+				img->need_load = false;
+				return;
+			}
+
+			texture_cache->remove_image(slot);
+		}
+
 		if(!file_load_image(img, tex_img)) {
 			/* on failure to load, we set a 1x1 pixels pink image */
 			uchar *pixels = (uchar*)tex_img.resize(1, 1);
@@ -461,6 +728,9 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, int sl
 	}
 
 	if(img) {
+		if(texture_cache)
+			texture_cache->remove_image(slot);
+
 		if(osl_texture_system) {
 #ifdef WITH_OSL
 			ustring filename(images[slot]->filename);
@@ -531,6 +801,9 @@ void ImageManager::device_update(Device *device, DeviceScene *dscene, Progress&
 
 	pool.wait_work();
 
+	if(texture_cache)
+		device->set_texture_cache(texture_cache);
+
 	if(pack_images)
 		device_pack_images(device, dscene, progress);
 
@@ -45,6 +45,8 @@ CCL_NAMESPACE_BEGIN
 class Device;
 class DeviceScene;
 class Progress;
+class TextureCache;
+class TextureCacheStats;
 
 class ImageManager {
 public:
@@ -63,6 +65,10 @@ public:
 	void set_extended_image_limits(void);
 	bool set_animation_frame_update(int frame);
 
+	void set_texture_cache_limit(size_t limit);
+	bool has_texture_cache() { return texture_cache != NULL; }
+	bool get_texture_cache_stats(TextureCacheStats& stats);
+
 	bool need_update;
 
 private:
@@ -84,9 +90,11 @@ private:
 	vector<Image*> float_images;
 	void *osl_texture_system;
 	bool pack_images;
+	TextureCache *texture_cache;
 
 	bool file_load_image(Image *img, device_vector<uchar4>& tex_img);
 	bool file_load_float_image(Image *img, device_vector<float4>& tex_img);
+	bool file_cache_image(Image *img, int slot, bool is_float);
 
 	void device_load_image(Device *device, DeviceScene *dscene, int slot, Progress *progess);
 	void device_free_image(Device *device, DeviceScene *dscene, int slot);
@@ -50,6 +50,8 @@ Mesh::Mesh()
 
 	tri_offset = 0;
 	vert_offset = 0;
+	curve_offset = 0;
+	curvekey_offset = 0;
 
 	attributes.mesh = this;
 }
@@ -77,6 +79,9 @@ void Mesh::clear()
 	shader.clear();
 	smooth.clear();
 
+	curve_keys.clear();
+	curves.clear();
+
 	attributes.clear();
 	used_shaders.clear();
 
@@ -96,14 +101,64 @@ void Mesh::add_triangle(int v0, int v1, int v2, int shader_, bool smooth_)
 	smooth.push_back(smooth_);
 }
 
+void Mesh::add_curve_key(float3 co, float radius)
+{
+	curve_keys.push_back(make_float4(co.x, co.y, co.z, radius));
+}
+
+void Mesh::add_curve(int first_key, int num_keys, int shader_)
+{
+	Curve c;
+	c.shader = shader_;
+
+	/* a BVH reference can only store BVH_MAX_CURVE_SEGMENTS segments of a
+	 * curve, longer curves are split in several sharing the joint keys */
+	while(num_keys - 1 > BVH_MAX_CURVE_SEGMENTS) {
+		c.first_key = first_key;
+		c.num_keys = BVH_MAX_CURVE_SEGMENTS + 1;
+		curves.push_back(c);
+
+		first_key += BVH_MAX_CURVE_SEGMENTS;
+		num_keys -= BVH_MAX_CURVE_SEGMENTS;
+	}
+
+	c.first_key = first_key;
+	c.num_keys = num_keys;
+
+	curves.push_back(c);
+}
+
+size_t Mesh::num_curve_segments() const
+{
+	size_t num_segments = 0;
+
+	for(size_t i = 0; i < curves.size(); i++)
+		num_segments += max(curves[i].num_segments(), 0);
+
+	return num_segments;
+}
+
+void Mesh::Curve::bounds_grow(int k, const float4 *curve_keys, BoundBox& bounds) const
+{
+	float4 k0 = curve_keys[first_key + k];
+	float4 k1 = curve_keys[first_key + k + 1];
+
+	bounds.grow(float4_to_float3(k0), k0.w);
+	bounds.grow(float4_to_float3(k1), k1.w);
+}
+
 void Mesh::compute_bounds()
 {
 	BoundBox bnds = BoundBox::empty;
 	size_t verts_size = verts.size();
+	size_t curve_keys_size = curve_keys.size();
 
 	for(size_t i = 0; i < verts_size; i++)
 		bnds.grow(verts[i]);
 
+	for(size_t i = 0; i < curve_keys_size; i++)
+		bnds.grow(float4_to_float3(curve_keys[i]), curve_keys[i].w);
+
 	/* happens mostly on empty meshes */
 	if(!bnds.valid())
 		bnds.grow(make_float3(0.0f, 0.0f, 0.0f));
@@ -243,6 +298,41 @@ void Mesh::pack_verts(float4 *tri_verts, float4 *tri_vindex, size_t vert_offset)
 	}
 }
 
+void Mesh::pack_curves(Scene *scene, float4 *curve_key_co, float4 *curve_data, size_t curvekey_offset)
+{
+	size_t curve_keys_size = curve_keys.size();
+
+	for(size_t i = 0; i < curve_keys_size; i++)
+		curve_key_co[i] = curve_keys[i];
+
+	/* pack curve keys offset, number of keys and shader id */
+	size_t curves_size = curves.size();
+	int shader_id = 0;
+	uint last_shader = -1;
+
+	for(size_t i = 0; i < curves_size; i++) {
+		Curve c = curves[i];
+
+		if(c.shader != last_shader) {
+			last_shader = c.shader;
+			shader_id = scene->shader_manager->get_shader_id(last_shader, this, false);
+		}
+
+		curve_data[i] = make_float4(
+			__int_as_float(c.first_key + curvekey_offset),
+			__int_as_float(c.num_keys),
+			__int_as_float(shader_id),
+			0.0f);
+	}
+}
+
+static bool bvh_refit_degraded(SceneParams *params, BVH *bvh)
+{
+	/* test if refitting made the BVH too slow, so it's better to rebuild */
+	float threshold = params->bvh_refit_threshold;
+	return (threshold > 0.0f && bvh->refit_degradation() > threshold);
+}
+
 void Mesh::compute_bvh(SceneParams *params, Progress *progress, int n, int total)
 {
 	if(progress->get_cancel())
@@ -263,12 +353,17 @@ void Mesh::compute_bvh(SceneParams *params, Progress *progress, int n, int total
 		vector<Object*> objects;
 		objects.push_back(&object);
 
-		if(bvh && !need_update_rebuild) {
+		bool rebuild = (!bvh || need_update_rebuild);
+
+		if(!rebuild) {
 			progress->set_status(msg, "Refitting BVH");
 			bvh->objects = objects;
 			bvh->refit(*progress);
+
+			rebuild = bvh_refit_degraded(params, bvh);
 		}
-		else {
+
+		if(rebuild) {
 			progress->set_status(msg, "Building BVH");
 
 			BVHParams bparams;
@@ -572,13 +667,37 @@ void MeshManager::device_update_mesh(Device *device, DeviceScene *dscene, Scene
 	/* count and update offsets */
 	size_t vert_size = 0;
 	size_t tri_size = 0;
+	size_t curve_key_size = 0;
+	size_t curve_size = 0;
 
 	foreach(Mesh *mesh, scene->meshes) {
 		mesh->vert_offset = vert_size;
 		mesh->tri_offset = tri_size;
+		mesh->curvekey_offset = curve_key_size;
+		mesh->curve_offset = curve_size;
 
 		vert_size += mesh->verts.size();
 		tri_size += mesh->triangles.size();
+		curve_key_size += mesh->curve_keys.size();
+		curve_size += mesh->curves.size();
+	}
+
+	dscene->data.bvh.have_curves = (curve_size != 0);
+
+	/* curves */
+	if(curve_size != 0) {
+		progress.set_status("Updating Mesh", "Copying Curves to device");
+
+		float4 *curve_keys = dscene->curve_keys.resize(curve_key_size);
+		float4 *curves = dscene->curves.resize(curve_size);
+
+		foreach(Mesh *mesh, scene->meshes) {
+			mesh->pack_curves(scene, &curve_keys[mesh->curvekey_offset], &curves[mesh->curve_offset], mesh->curvekey_offset);
+			if(progress.get_cancel()) return;
+		}
+
+		device->tex_alloc("__curve_keys", dscene->curve_keys);
+		device->tex_alloc("__curves", dscene->curves);
 	}
 
 	if(tri_size == 0)
@@ -608,22 +727,77 @@ void MeshManager::device_update_mesh(Device *device, DeviceScene *dscene, Scene
 	device->tex_alloc("__tri_vindex", dscene->tri_vindex);
 }
 
-void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+bool MeshManager::bvh_can_refit(Scene *scene)
 {
+	/* the scene BVH can be refit if there are the same objects and meshes as
+	 * when it was built, and only vertices and objects moved */
+	if(!bvh || bvh_objects.empty() || bvh_objects.size() != scene->objects.size())
+		return false;
+	if(scene->params.use_bvh_cache || bvh->params.use_qbvh != scene->params.use_qbvh)
+		return false;
+
+	foreach(Mesh *mesh, scene->meshes)
+		if(mesh->need_update_rebuild)
+			return false;
+
+	for(size_t i = 0; i < bvh_objects.size(); i++) {
+		Object *ob = scene->objects[i];
+		const BVHObject& bob = bvh_objects[i];
+
+		if(ob != bob.object || ob->mesh != bob.mesh)
+			return false;
+		if(ob->mesh->tri_offset != bob.tri_offset || ob->mesh->transform_applied != bob.transform_applied)
+			return false;
+		if(ob->mesh->curve_offset != bob.curve_offset)
+			return false;
+	}
+
+	return true;
+}
+
+void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, bool refit, Progress& progress)
+{
+	/* bvh refit */
+	if(refit) {
+		progress.set_status("Updating Scene BVH", "Refitting");
+
+		bvh->objects = scene->objects;
+		bvh->refit(progress);
+
+		refit = !bvh_refit_degraded(&scene->params, bvh);
+	}
+
 	/* bvh build */
-	progress.set_status("Updating Scene BVH", "Building");
+	if(!refit) {
+		progress.set_status("Updating Scene BVH", "Building");
 
-	BVHParams bparams;
-	bparams.top_level = true;
-	bparams.use_qbvh = scene->params.use_qbvh;
-	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
-	bparams.use_cache = scene->params.use_bvh_cache;
+		BVHParams bparams;
+		bparams.top_level = true;
+		bparams.use_qbvh = scene->params.use_qbvh;
+		bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
+		bparams.use_cache = scene->params.use_bvh_cache;
 
-	delete bvh;
-	bvh = BVH::create(bparams, scene->objects);
-	bvh->build(progress);
+		delete bvh;
+		bvh = BVH::create(bparams, scene->objects);
+		bvh->build(progress);
 
-	if(progress.get_cancel()) return;
+		bvh_objects.clear();
+
+		if(progress.get_cancel()) return;
+
+		/* remember objects and meshes for refitting on the next update */
+		foreach(Object *ob, scene->objects) {
+			BVHObject bob;
+
+			bob.object = ob;
+			bob.mesh = ob->mesh;
+			bob.tri_offset = ob->mesh->tri_offset;
+			bob.curve_offset = ob->mesh->curve_offset;
+			bob.transform_applied = ob->mesh->transform_applied;
+
+			bvh_objects.push_back(bob);
+		}
+	}
 
 	/* copy to device */
 	progress.set_status("Updating Scene BVH", "Copying BVH to device");
@@ -654,8 +828,13 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 		dscene->prim_object.reference((uint*)&pack.prim_object[0], pack.prim_object.size());
 		device->tex_alloc("__prim_object", dscene->prim_object);
 	}
+	if(pack.prim_segment.size() && dscene->data.bvh.have_curves) {
+		dscene->prim_segment.reference((uint*)&pack.prim_segment[0], pack.prim_segment.size());
+		device->tex_alloc("__prim_segment", dscene->prim_segment);
+	}
 
 	dscene->data.bvh.root = pack.root_index;
+	dscene->data.bvh.use_qbvh = scene->params.use_qbvh;
 }
 
 void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
@@ -707,6 +886,9 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		if(progress.get_cancel()) return;
 	}
 
+	/* test for refitting the scene bvh, before rebuild tags are cleared */
+	bool refit_bvh = bvh_can_refit(scene);
+
 	/* update bvh */
 	size_t i = 0, num_bvh = 0;
 
@@ -741,7 +923,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
-	device_update_bvh(device, dscene, scene, progress);
+	device_update_bvh(device, dscene, scene, refit_bvh, progress);
 
 	need_update = false;
 }
@@ -754,10 +936,13 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->prim_visibility);
 	device->tex_free(dscene->prim_index);
 	device->tex_free(dscene->prim_object);
+	device->tex_free(dscene->prim_segment);
 	device->tex_free(dscene->tri_normal);
 	device->tex_free(dscene->tri_vnormal);
 	device->tex_free(dscene->tri_vindex);
 	device->tex_free(dscene->tri_verts);
+	device->tex_free(dscene->curves);
+	device->tex_free(dscene->curve_keys);
 	device->tex_free(dscene->attributes_map);
 	device->tex_free(dscene->attributes_float);
 	device->tex_free(dscene->attributes_float3);
@@ -768,10 +953,13 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->prim_visibility.clear();
 	dscene->prim_index.clear();
 	dscene->prim_object.clear();
+	dscene->prim_segment.clear();
 	dscene->tri_normal.clear();
 	dscene->tri_vnormal.clear();
 	dscene->tri_vindex.clear();
 	dscene->tri_verts.clear();
+	dscene->curves.clear();
+	dscene->curve_keys.clear();
 	dscene->attributes_map.clear();
 	dscene->attributes_float.clear();
 	dscene->attributes_float3.clear();
@@ -36,6 +36,7 @@ class BVH;
 class Device;
 class DeviceScene;
 class Mesh;
+class Object;
 class Progress;
 class Scene;
 class SceneParams;
@@ -50,6 +51,16 @@ public:
 		int v[3];
 	};
 
+	/* Mesh Curve, a strand of keys with a segment between each pair */
+	struct Curve {
+		int first_key;
+		int num_keys;
+		uint shader;
+
+		int num_segments() const { return num_keys - 1; }
+		void bounds_grow(int k, const float4 *curve_keys, BoundBox& bounds) const;
+	};
+
 	/* Displacement */
 	enum DisplacementMethod {
 		DISPLACE_BUMP,
@@ -65,6 +76,10 @@ public:
 	vector<uint> shader;
 	vector<bool> smooth;
 
+	/* Curve Data, keys are position and radius */
+	vector<float4> curve_keys;
+	vector<Curve> curves;
+
 	vector<uint> used_shaders;
 	AttributeSet attributes;
 
@@ -81,6 +96,8 @@ public:
 	BVH *bvh;
 	size_t tri_offset;
 	size_t vert_offset;
+	size_t curve_offset;
+	size_t curvekey_offset;
 
 	/* Functions */
 	Mesh();
@@ -89,6 +106,9 @@ public:
 	void reserve(int numverts, int numfaces);
 	void clear();
 	void add_triangle(int v0, int v1, int v2, int shader, bool smooth);
+	void add_curve_key(float3 co, float radius);
+	void add_curve(int first_key, int num_keys, int shader);
+	size_t num_curve_segments() const;
 
 	void compute_bounds();
 	void add_face_normals();
@@ -96,6 +116,7 @@ public:
 
 	void pack_normals(Scene *scene, float4 *normal, float4 *vnormal);
 	void pack_verts(float4 *tri_verts, float4 *tri_vindex, size_t vert_offset);
+	void pack_curves(Scene *scene, float4 *curve_key_co, float4 *curve_data, size_t curvekey_offset);
 	void compute_bvh(SceneParams *params, Progress *progress, int n, int total);
 
 	bool need_attribute(Scene *scene, AttributeStandard std);
@@ -125,10 +146,24 @@ public:
 	void device_update_object(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_mesh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_attributes(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
-	void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
+	void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, bool refit, Progress& progress);
 	void device_free(Device *device, DeviceScene *dscene);
 
 	void tag_update(Scene *scene);
+
+protected:
+	/* objects and their meshes as used when building the scene BVH */
+	struct BVHObject {
+		Object *object;
+		Mesh *mesh;
+		size_t tri_offset;
+		size_t curve_offset;
+		bool transform_applied;
+	};
+
+	vector<BVHObject> bvh_objects;
+
+	bool bvh_can_refit(Scene *scene);
 };
 
 CCL_NAMESPACE_END
@@ -148,6 +148,10 @@ ImageTextureNode::ImageTextureNode()
 	animated = false;
 
 	add_input("Vector", SHADER_SOCKET_POINT, ShaderInput::TEXTURE_UV);
+	/* vector at the ray differentials, connected by the graph when the
+	 * texture cache needs them to pick mip levels */
+	add_input("VectorDX", SHADER_SOCKET_POINT);
+	add_input("VectorDY", SHADER_SOCKET_POINT);
 	add_output("Color", SHADER_SOCKET_COLOR);
 	add_output("Alpha", SHADER_SOCKET_FLOAT);
 }
@@ -197,13 +201,41 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 		}
 
 		if(projection == "Flat") {
+			ShaderInput *vector_dx_in = input("VectorDX");
+			ShaderInput *vector_dy_in = input("VectorDY");
+			int vector_dx_offset = SVM_STACK_INVALID;
+			int vector_dy_offset = SVM_STACK_INVALID;
+
+			if(vector_dx_in->link && vector_dy_in->link) {
+				compiler.stack_assign(vector_dx_in);
+				compiler.stack_assign(vector_dy_in);
+
+				vector_dx_offset = vector_dx_in->stack_offset;
+				vector_dy_offset = vector_dy_in->stack_offset;
+
+				if(!tex_mapping.skip()) {
+					vector_dx_offset = compiler.stack_find_offset(SHADER_SOCKET_VECTOR);
+					tex_mapping.compile(compiler, vector_dx_in->stack_offset, vector_dx_offset);
+					vector_dy_offset = compiler.stack_find_offset(SHADER_SOCKET_VECTOR);
+					tex_mapping.compile(compiler, vector_dy_in->stack_offset, vector_dy_offset);
+				}
+			}
+
 			compiler.add_node(NODE_TEX_IMAGE,
 				slot,
 				compiler.encode_uchar4(
 					vector_offset,
 					color_out->stack_offset,
 					alpha_out->stack_offset,
-					srgb));
+					srgb),
+				compiler.encode_uchar4(
+					vector_dx_offset,
+					vector_dy_offset));
+
+			if(vector_dx_in->link && vector_dy_in->link && !tex_mapping.skip()) {
+				compiler.stack_clear_offset(vector_dx_in->type, vector_dx_offset);
+				compiler.stack_clear_offset(vector_dy_in->type, vector_dy_offset);
+			}
 		}
 		else {
 			compiler.add_node(NODE_TEX_IMAGE_BOX,
@@ -86,6 +86,21 @@ void Object::apply_transform()
 	for(size_t i = 0; i < mesh->verts.size(); i++)
 		mesh->verts[i] = transform_point(&tfm, mesh->verts[i]);
 
+	/* curve radius is scaled by the average scale of the transform */
+	if(mesh->curve_keys.size()) {
+		float3 c0 = transform_get_column(&tfm, 0);
+		float3 c1 = transform_get_column(&tfm, 1);
+		float3 c2 = transform_get_column(&tfm, 2);
+		float scale = powf(fabsf(dot(cross(c0, c1), c2)), 1.0f/3.0f);
+
+		for(size_t i = 0; i < mesh->curve_keys.size(); i++) {
+			float4 key = mesh->curve_keys[i];
+			float3 co = transform_point(&tfm, float4_to_float3(key));
+
+			mesh->curve_keys[i] = make_float4(co.x, co.y, co.z, key.w*scale);
+		}
+	}
+
 	Attribute *attr_fN = mesh->attributes.find(ATTR_STD_FACE_NORMAL);
 	Attribute *attr_vN = mesh->attributes.find(ATTR_STD_VERTEX_NORMAL);
 
@@ -366,6 +366,11 @@ bool OSLCompiler::node_skip_input(ShaderNode *node, ShaderInput *input)
 		if(strcmp(input->name, "Height") == 0)
 			return true;
 	}
+	else if(node->name == ustring("image_texture")) {
+		/* only used for the SVM texture cache */
+		if(strcmp(input->name, "VectorDX") == 0 || strcmp(input->name, "VectorDY") == 0)
+			return true;
+	}
 	else if(current_type == SHADER_TYPE_DISPLACEMENT && input->link && input->link->parent->name == ustring("bump"))
 		return true;
 
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 
 #include "background.h"
+#include "bake.h"
 #include "camera.h"
 #include "device.h"
 #include "film.h"
@@ -38,15 +39,28 @@
 
 CCL_NAMESPACE_BEGIN
 
+void SceneParams::limit_to_device(const DeviceInfo& device_info)
+{
+	/* OSL only works on the CPU */
+	if(device_info.type != DEVICE_CPU)
+		shadingsystem = SVM;
+
+	/* QBVH layout only when the device kernel can traverse it */
+	if(!device_info.use_qbvh)
+		use_qbvh = false;
+
+	/* curves only when the device kernel can intersect them */
+	if(!device_info.use_hair)
+		use_hair = false;
+}
+
 Scene::Scene(const SceneParams& params_, const DeviceInfo& device_info_)
 : params(params_)
 {
 	device = NULL;
 	memset(&dscene.data, 0, sizeof(dscene.data));
 
-	/* OSL only works on the CPU */
-	if(device_info_.type != DEVICE_CPU)
-		params.shadingsystem = SceneParams::SVM;
+	params.limit_to_device(device_info_);
 
 	camera = new Camera();
 	filter = new Filter();
@@ -59,9 +73,12 @@ Scene::Scene(const SceneParams& params_, const DeviceInfo& device_info_)
 	image_manager = new ImageManager();
 	shader_manager = ShaderManager::create(this);
 	particle_system_manager = new ParticleSystemManager();
+	bake_manager = new BakeManager();
 
-	if (device_info_.type == DEVICE_CPU)
+	if (device_info_.type == DEVICE_CPU) {
 		image_manager->set_extended_image_limits();
+		image_manager->set_texture_cache_limit(params.texture_cache_size);
+	}
 }
 
 Scene::~Scene()
@@ -96,7 +113,7 @@ void Scene::free_memory(bool final)
 
 		particle_system_manager->device_free(device, &dscene);
 
-		if(!params.persistent_images || final)
+		if(!params.persistent_data || final)
 			image_manager->device_free(device, &dscene);
 	}
 
@@ -112,6 +129,7 @@ void Scene::free_memory(bool final)
 		delete light_manager;
 		delete particle_system_manager;
 		delete image_manager;
+		delete bake_manager;
 	}
 	else {
 		shaders.clear();
@@ -246,7 +264,9 @@ bool Scene::need_reset()
 
 void Scene::reset()
 {
-	shader_manager->add_default(this);
+	/* default shaders are kept along with the other data when it persists */
+	if(shaders.empty())
+		shader_manager->add_default(this);
 
 	/* ensure all objects are updated */
 	camera->tag_update();
@@ -36,6 +36,7 @@ CCL_NAMESPACE_BEGIN
 
 class AttributeRequestSet;
 class Background;
+class BakeManager;
 class Camera;
 class Device;
 class DeviceInfo;
@@ -65,6 +66,7 @@ public:
 	device_vector<uint> prim_visibility;
 	device_vector<uint> prim_index;
 	device_vector<uint> prim_object;
+	device_vector<uint> prim_segment;
 
 	/* mesh */
 	device_vector<float4> tri_normal;
@@ -72,6 +74,10 @@ public:
 	device_vector<float4> tri_vindex;
 	device_vector<float4> tri_verts;
 
+	/* curves */
+	device_vector<float4> curves;
+	device_vector<float4> curve_keys;
+
 	/* objects */
 	device_vector<float4> objects;
 
@@ -119,8 +125,19 @@ public:
 	enum BVHType { BVH_DYNAMIC, BVH_STATIC } bvh_type;
 	bool use_bvh_cache;
 	bool use_bvh_spatial_split;
+	/* QBVH layout on devices that support it, off until it is faster for
+	 * typical scenes, the device limits it with limit_to_device() */
 	bool use_qbvh;
-	bool persistent_images;
+	/* export hair strands as curve primitives */
+	bool use_hair;
+	/* rebuild instead of refitting when the BVH cost increased by this
+	 * factor, zero to always refit */
+	float bvh_refit_threshold;
+	/* keep scene data on the device between renders */
+	bool persistent_data;
+	/* memory limit in bytes for loading image tiles on demand on the CPU,
+	 * zero to load whole images */
+	size_t texture_cache_size;
 
 	SceneParams()
 	{
@@ -128,10 +145,14 @@ public:
 		bvh_type = BVH_DYNAMIC;
 		use_bvh_cache = false;
 		use_bvh_spatial_split = false;
-#ifdef __QBVH__
-		use_qbvh = true;
-#else
+		bvh_refit_threshold = 1.5f;
+		persistent_data = false;
+		texture_cache_size = 0;
 		use_qbvh = false;
+#ifdef __HAIR__
+		use_hair = true;
+#else
+		use_hair = false;
 #endif
 	}
 
@@ -140,8 +161,15 @@ public:
 		&& bvh_type == params.bvh_type
 		&& use_bvh_cache == params.use_bvh_cache
 		&& use_bvh_spatial_split == params.use_bvh_spatial_split
+		&& bvh_refit_threshold == params.bvh_refit_threshold
 		&& use_qbvh == params.use_qbvh
-		&& persistent_images == params.persistent_images); }
+		&& use_hair == params.use_hair
+		&& persistent_data == params.persistent_data
+		&& texture_cache_size == params.texture_cache_size); }
+
+	/* disable features the device doesn't support, done by the scene as well,
+	 * params should be limited the same way before comparing with modified() */
+	void limit_to_device(const DeviceInfo& device_info);
 };
 
 /* Scene */
@@ -169,6 +197,7 @@ public:
 	MeshManager *mesh_manager;
 	ObjectManager *object_manager;
 	ParticleSystemManager *particle_system_manager;
+	BakeManager *bake_manager;
 
 	/* default shaders */
 	int default_surface;
@@ -19,12 +19,17 @@
 #include <string.h>
 #include <limits.h>
 
+#include "bake.h"
 #include "buffers.h"
 #include "camera.h"
+#include "checkpoint.h"
 #include "device.h"
+#include "integrator.h"
 #include "scene.h"
 #include "session.h"
+#include "shader.h"
 
+#include "util_algorithm.h"
 #include "util_foreach.h"
 #include "util_function.h"
 #include "util_math.h"
@@ -68,6 +73,11 @@ Session::Session(const SessionParams& params_)
 	preview_time = 0.0;
 	paused_time = 0.0;
 
+	checkpoint = NULL;
+
+	adaptive_pixel_samples = 0;
+	adaptive_pixels = 0;
+
 	delayed_reset.do_reset = false;
 	delayed_reset.samples = 0;
 
@@ -105,6 +115,7 @@ Session::~Session()
 	foreach(RenderBuffers *buffers, tile_buffers)
 		delete buffers;
 
+	delete checkpoint;
 	delete buffers;
 	delete display;
 	delete scene;
@@ -354,6 +365,7 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 	rtile.start_sample = tile_manager.state.sample;
 	rtile.num_samples = tile_manager.state.num_samples;
 	rtile.resolution = tile_manager.state.resolution_divider;
+	rtile.finished = false;
 
 	tile_lock.unlock();
 
@@ -433,6 +445,24 @@ void Session::release_tile(RenderTile& rtile)
 {
 	thread_scoped_lock tile_lock(tile_mutex);
 
+	if(params.adaptive_threshold > 0.0f) {
+		int skipped = rtile.start_sample + rtile.num_samples - rtile.sample;
+
+		/* samples skipped by adaptive sampling count as done for progress */
+		if(skipped > 0 && !progress.get_cancel())
+			progress.increment_sample(skipped);
+
+		adaptive_pixel_samples += (uint64_t)rtile.sample * rtile.w * rtile.h;
+		adaptive_pixels += (uint64_t)rtile.w * rtile.h;
+	}
+
+	/* only tiles with all their samples can be skipped on resume, tiles given
+	 * back early on cancel are rendered again */
+	if(checkpoint && rtile.finished && !progress.get_cancel()) {
+		checkpoint->add_tile(rtile);
+		checkpoint->update();
+	}
+
 	if(write_render_tile_cb) {
 		if(params.progressive_refine == false) {
 			/* todo: optimize this by making it thread safe and removing lock */
@@ -472,6 +502,10 @@ void Session::run_cpu()
 				progress.set_status("Finished");
 				break;
 			}
+
+			/* resume an interrupted render, once the tiles exist */
+			if(!checkpoint && checkpoint_path != "" && write_render_tile_cb && !params.progressive_refine)
+				checkpoint_begin();
 		}
 		else {
 			/* if in interactive mode, and we are either paused or done for now,
@@ -561,11 +595,13 @@ void Session::run_cpu()
 
 	if(!tiles_written)
 		update_progressive_refine(true);
+
+	if(checkpoint)
+		checkpoint_end(!progress.get_cancel());
 }
 
-void Session::run()
+bool Session::load_kernels()
 {
-	/* load kernels */
 	if(!kernels_loaded) {
 		progress.set_status("Loading render kernels (may take a few minutes the first time)");
 
@@ -576,12 +612,21 @@ void Session::run()
 
 			progress.set_status("Error", message);
 			progress.set_update();
-			return;
+			return false;
 		}
 
 		kernels_loaded = true;
 	}
 
+	return true;
+}
+
+void Session::run()
+{
+	/* load kernels */
+	if(!load_kernels())
+		return;
+
 	/* session thread loop */
 	progress.set_status("Waiting for render to start");
 
@@ -596,6 +641,9 @@ void Session::run()
 			run_cpu();
 	}
 
+	if(params.profiling)
+		update_profiling_stats();
+
 	/* progress update */
 	if(progress.get_cancel())
 		progress.set_status("Cancel", progress.get_cancel_message());
@@ -627,6 +675,9 @@ void Session::reset_(BufferParams& buffer_params, int samples)
 	preview_time = 0.0;
 	paused_time = 0.0;
 
+	adaptive_pixel_samples = 0;
+	adaptive_pixels = 0;
+
 	if(!params.background)
 		progress.set_start_time(start_time + paused_time);
 }
@@ -669,6 +720,36 @@ void Session::set_pause(bool pause_)
 		pause_cond.notify_all();
 }
 
+bool Session::bake(ShaderEvalType shader_type, BakeData *bake_data, float result[], int depth)
+{
+	/* baking runs in the calling thread, no session thread is started */
+	if(!load_kernels())
+		return false;
+
+	progress.reset_sample();
+
+	update_scene();
+
+	if(progress.get_cancel())
+		return false;
+
+	progress.set_status("Baking");
+
+	BakeManager *bake_manager = scene->bake_manager;
+	bake_manager->num_samples = params.samples;
+	bake_manager->batch_size = params.tile_size.x*params.tile_size.y;
+
+	bool success = bake_manager->bake(device, &scene->dscene, scene, progress,
+		shader_type, bake_data, result, depth);
+
+	if(progress.get_cancel())
+		progress.set_status("Cancel", progress.get_cancel_message());
+	else
+		progress.set_status("Done");
+
+	return success;
+}
+
 void Session::wait()
 {
 	session_thread->join();
@@ -718,6 +799,13 @@ void Session::update_status_time(bool show_pause, bool show_done)
 
 		substatus = string_printf("Path Tracing Tile %d/%d", tile, num_tiles);
 
+		if(adaptive_pixels > 0) {
+			/* average over the finished tiles, to compare against the
+			 * number of samples needed for the same noise without it */
+			double spp = (double)adaptive_pixel_samples / (double)adaptive_pixels;
+			substatus += string_printf(", %.1f Samples/Pixel", spp);
+		}
+
 		if((is_gpu && !is_multidevice) || (is_cpu && num_tiles == 1)) {
 			/* when rendering on GPU multithreading happens within single tile, as in
 			 * tiles are handling sequentially and in this case we could display
@@ -743,6 +831,16 @@ void Session::update_status_time(bool show_pause, bool show_done)
 		substatus = string_printf("Path Tracing Sample %d", sample+1);
 	else
 		substatus = string_printf("Path Tracing Sample %d/%d", sample+1, params.samples);
+
+	/* texture cache memory and how often lookups found their tiles loaded */
+	TextureCacheStats cache_stats;
+
+	if(scene->image_manager->get_texture_cache_stats(cache_stats)) {
+		progress.set_texture_cache_stats(cache_stats);
+
+		substatus += string_printf(", Texture Cache %.2fM, %.1f%% Hits",
+			(double)cache_stats.mem_used/(1024.0*1024.0), cache_stats.hit_rate()*100.0f);
+	}
 	
 	if(show_pause)
 		status = "Paused";
@@ -765,6 +863,153 @@ void Session::update_status_time(bool show_pause, bool show_done)
 	progress.set_tile(tile, tile_time);
 }
 
+void Session::update_profiling_stats()
+{
+	ProfilingStats profiling_stats;
+
+	if(device->get_profiling_stats(profiling_stats))
+		progress.set_profiling_stats(profiling_stats);
+}
+
+struct ProfilingShaderCompare {
+	ProfilingShaderCompare(const ProfilingStats& stats_) : stats(stats_) {}
+
+	bool operator()(int a, int b) const
+	{
+		return stats.shader_nodes[a] > stats.shader_nodes[b];
+	}
+
+	const ProfilingStats& stats;
+};
+
+string Session::profiling_report()
+{
+	if(!params.profiling)
+		return "";
+
+	ProfilingStats stats;
+	progress.get_profiling_stats(stats);
+
+	uint64_t num_rays = stats.num_rays();
+	double per_ray = (num_rays)? 1.0/(double)num_rays: 0.0;
+	string report = "Profiling:\n";
+
+	report += string_printf("  Camera Rays        %llu\n", (unsigned long long)stats.rays[PROFILING_RAY_CAMERA]);
+	report += string_printf("  Reflection Rays    %llu\n", (unsigned long long)stats.rays[PROFILING_RAY_REFLECT]);
+	report += string_printf("  Transmission Rays  %llu\n", (unsigned long long)stats.rays[PROFILING_RAY_TRANSMIT]);
+	report += string_printf("  Shadow Rays        %llu\n", (unsigned long long)stats.rays[PROFILING_RAY_SHADOW]);
+	report += string_printf("  BVH Nodes          %llu (%.1f per ray)\n",
+		(unsigned long long)stats.bvh_nodes, stats.bvh_nodes*per_ray);
+	report += string_printf("  BVH Primitives     %llu (%.1f per ray)\n",
+		(unsigned long long)stats.bvh_primitives, stats.bvh_primitives*per_ray);
+	report += string_printf("  Light Samples      %llu\n", (unsigned long long)stats.light_samples);
+	report += string_printf("  Image Lookups      %llu\n", (unsigned long long)stats.image_lookups);
+
+	/* shaders sorted by nodes executed, the closest to time spent we have */
+	uint64_t total_nodes = 0;
+	vector<int> order;
+
+	for(size_t i = 0; i < stats.shader_nodes.size(); i++) {
+		if(stats.shader_evals[i] == 0)
+			continue;
+
+		total_nodes += stats.shader_nodes[i];
+		order.push_back((int)i);
+	}
+
+	sort(order.begin(), order.end(), ProfilingShaderCompare(stats));
+
+	report += "Shaders:\n";
+
+	for(size_t i = 0; i < order.size(); i++) {
+		int id = order[i];
+		string name = (id < (int)scene->shaders.size())? scene->shaders[id]->name: "<unknown>";
+		uint64_t evals = stats.shader_evals[id];
+		uint64_t nodes = stats.shader_nodes[id];
+
+		report += string_printf("  %-30s %12llu evals %14llu nodes (%.1f per eval, %5.1f%%)\n",
+			name.c_str(), (unsigned long long)evals, (unsigned long long)nodes,
+			(double)nodes/(double)evals, (total_nodes)? 100.0*(double)nodes/(double)total_nodes: 0.0);
+	}
+
+	return report;
+}
+
+void Session::checkpoint_begin()
+{
+	BufferParams& buffer_params = tile_manager.params;
+	CheckpointHeader header;
+
+	header.width = buffer_params.width;
+	header.height = buffer_params.height;
+	header.full_x = buffer_params.full_x;
+	header.full_y = buffer_params.full_y;
+	header.full_width = buffer_params.full_width;
+	header.full_height = buffer_params.full_height;
+	header.pass_stride = buffer_params.get_passes_size();
+	header.num_samples = tile_manager.state.num_samples;
+	header.seed = scene->integrator->seed;
+
+	checkpoint = new RenderCheckpoint(checkpoint_path, params.checkpoint_interval);
+
+	vector<CheckpointTile> tiles;
+
+	if(!checkpoint->open(header, tiles)) {
+		delete checkpoint;
+		checkpoint = NULL;
+		return;
+	}
+
+	/* write out the tiles that were already finished and skip rendering them */
+	foreach(CheckpointTile& ctile, tiles) {
+		if(!tile_manager.skip_tile(ctile.x, ctile.y, ctile.w, ctile.h))
+			continue;
+
+		BufferParams tile_params = buffer_params;
+		tile_params.full_x = ctile.x;
+		tile_params.full_y = ctile.y;
+		tile_params.width = ctile.w;
+		tile_params.height = ctile.h;
+
+		RenderBuffers *tilebuffers = new RenderBuffers(device);
+		tilebuffers->reset(device, tile_params);
+
+		memcpy((float*)tilebuffers->buffer.data_pointer, &ctile.buffer[0], sizeof(float)*ctile.buffer.size());
+		device->mem_copy_to(tilebuffers->buffer);
+
+		RenderTile rtile;
+		rtile.x = ctile.x;
+		rtile.y = ctile.y;
+		rtile.w = ctile.w;
+		rtile.h = ctile.h;
+		rtile.start_sample = 0;
+		rtile.num_samples = tile_manager.state.num_samples;
+		rtile.sample = ctile.sample;
+		rtile.resolution = 1;
+		rtile.finished = true;
+		rtile.buffer = tilebuffers->buffer.device_pointer;
+		rtile.rng_state = tilebuffers->rng_state.device_pointer;
+		rtile.buffers = tilebuffers;
+		tile_params.get_offset_stride(rtile.offset, rtile.stride);
+
+		write_render_tile_cb(rtile);
+
+		delete tilebuffers;
+
+		progress.increment_sample(tile_manager.state.num_samples);
+	}
+}
+
+void Session::checkpoint_end(bool finished)
+{
+	thread_scoped_lock tile_lock(tile_mutex);
+
+	checkpoint->close(finished);
+
+	delete checkpoint;
+	checkpoint = NULL;
+}
+
 void Session::update_progress_sample()
 {
 	progress.increment_sample();
@@ -781,6 +1026,9 @@ void Session::path_trace()
 	task.update_tile_sample = function_bind(&Session::update_tile_sample, this, _1);
 	task.update_progress_sample = function_bind(&Session::update_progress_sample, this);
 	task.need_finish_queue = params.progressive_refine;
+	task.adaptive_threshold = params.adaptive_threshold;
+	task.adaptive_min_samples = params.adaptive_min_samples;
+	task.profiling = params.profiling;
 
 	device->task_add(task);
 }
@@ -30,6 +30,8 @@
 
 CCL_NAMESPACE_BEGIN
 
+class BakeData;
+class RenderCheckpoint;
 class BufferParams;
 class Device;
 class DeviceScene;
@@ -54,6 +56,16 @@ public:
 	int start_resolution;
 	int threads;
 
+	/* adaptive sampling, disabled when the threshold is zero */
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
+	/* count rays, shader nodes and lookups while rendering, CPU only */
+	bool profiling;
+
+	/* seconds between writes of finished tiles to the checkpoint file */
+	double checkpoint_interval;
+
 	double cancel_timeout;
 	double reset_timeout;
 	double text_timeout;
@@ -73,6 +85,13 @@ public:
 		start_resolution = INT_MAX;
 		threads = 0;
 
+		adaptive_threshold = 0.0f;
+		adaptive_min_samples = 16;
+
+		profiling = false;
+
+		checkpoint_interval = 60.0;
+
 		cancel_timeout = 0.1;
 		reset_timeout = 0.1;
 		text_timeout = 1.0;
@@ -92,6 +111,10 @@ public:
 		&& tile_size == params.tile_size
 		&& start_resolution == params.start_resolution
 		&& threads == params.threads
+		&& adaptive_threshold == params.adaptive_threshold
+		&& adaptive_min_samples == params.adaptive_min_samples
+		&& profiling == params.profiling
+		&& checkpoint_interval == params.checkpoint_interval
 		&& cancel_timeout == params.cancel_timeout
 		&& reset_timeout == params.reset_timeout
 		&& text_timeout == params.text_timeout
@@ -118,6 +141,11 @@ public:
 	boost::function<void(RenderTile&)> write_render_tile_cb;
 	boost::function<void(RenderTile&)> update_render_tile_cb;
 
+	/* file to keep finished tiles of tiled background renders in, an
+	 * interrupted render with the same settings and seed continues from it.
+	 * set for each render, empty to disable */
+	string checkpoint_path;
+
 	Session(const SessionParams& params);
 	~Session();
 
@@ -130,6 +158,12 @@ public:
 	void set_samples(int samples);
 	void set_pause(bool pause);
 
+	bool bake(ShaderEvalType shader_type, BakeData *bake_data, float result[], int depth);
+
+	/* readable summary of the profiling stats in progress, per shader costs
+	 * sorted from most to least SVM nodes executed, empty without profiling */
+	string profiling_report();
+
 	void device_free();
 protected:
 	struct DelayedReset {
@@ -140,9 +174,11 @@ protected:
 	} delayed_reset;
 
 	void run();
+	bool load_kernels();
 
 	void update_scene();
 	void update_status_time(bool show_pause = false, bool show_done = false);
+	void update_profiling_stats();
 
 	void tonemap();
 	void path_trace();
@@ -162,6 +198,9 @@ protected:
 
 	void update_progress_sample();
 
+	void checkpoint_begin();
+	void checkpoint_end(bool finished);
+
 	bool device_use_gl;
 
 	thread *session_thread;
@@ -186,6 +225,12 @@ protected:
 	double preview_time;
 	double paused_time;
 
+	RenderCheckpoint *checkpoint;
+
+	/* adaptive sampling statistics */
+	uint64_t adaptive_pixel_samples;
+	uint64_t adaptive_pixels;
+
 	/* progressive refine */
 	double last_update_time;
 	bool update_progressive_refine(bool cancel);
@@ -18,6 +18,7 @@
 
 #include "device.h"
 #include "graph.h"
+#include "image.h"
 #include "light.h"
 #include "mesh.h"
 #include "scene.h"
@@ -712,10 +713,12 @@ void SVMCompiler::compile(Shader *shader, vector<int4>& global_svm_nodes, int in
 		if(!shader->graph_bump)
 			shader->graph_bump = shader->graph->copy();
 
-	/* finalize */
-	shader->graph->finalize(false, false);
+	/* finalize, image derivatives are only needed for texture cache mip levels */
+	bool image_derivatives = image_manager->has_texture_cache();
+
+	shader->graph->finalize(false, false, image_derivatives);
 	if(shader->graph_bump)
-		shader->graph_bump->finalize(true, false);
+		shader->graph_bump->finalize(true, false, image_derivatives);
 
 	current_shader = shader;
 
@@ -244,6 +244,29 @@ bool TileManager::next_tile(Tile& tile, int device)
 	return false;
 }
 
+/* mark a tile that was already rendered elsewhere as done, the position
+ * is in full image coordinates like render tiles */
+bool TileManager::skip_tile(int x, int y, int w, int h)
+{
+	list<Tile>::iterator iter;
+
+	for(iter = state.tiles.begin(); iter != state.tiles.end(); iter++) {
+		Tile& tile = *iter;
+
+		if(tile.rendering == false &&
+		   state.buffer.full_x + tile.x == x && state.buffer.full_y + tile.y == y &&
+		   tile.w == w && tile.h == h)
+		{
+			tile.rendering = true;
+			state.num_rendered_tiles++;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool TileManager::done()
 {
 	return (state.sample+state.num_samples >= num_samples && state.resolution_divider == 1);
@@ -66,6 +66,7 @@ public:
 	void set_samples(int num_samples);
 	bool next();
 	bool next_tile(Tile& tile, int device = 0);
+	bool skip_tile(int x, int y, int w, int h);
 	bool done();
 
 protected:
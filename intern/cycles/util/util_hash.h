@@ -61,6 +61,17 @@ static inline uint hash_string(const char *str)
 	return i;
 }
 
+static inline uint hash_data(const void *data, size_t size, uint hash = 2166136261u)
+{
+	/* FNV-1a, for detecting changes in blocks of memory */
+	const uchar *bytes = (const uchar*)data;
+
+	for(size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 16777619u;
+
+	return hash;
+}
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_HASH_H__ */
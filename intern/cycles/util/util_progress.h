@@ -26,6 +26,7 @@
  * except for the constructor/destructor are thread safe. */
 
 #include "util_function.h"
+#include "util_stats.h"
 #include "util_string.h"
 #include "util_time.h"
 #include "util_thread.h"
@@ -81,6 +82,8 @@ public:
 		sync_substatus = "";
 		cancel = false;
 		cancel_message = "";
+		texture_cache_stats = TextureCacheStats();
+		profiling_stats.reset();
 	}
 
 	/* cancel */
@@ -144,11 +147,11 @@ public:
 		sample = 0;
 	}
 
-	void increment_sample()
+	void increment_sample(int num_samples = 1)
 	{
 		thread_scoped_lock lock(progress_mutex);
 
-		sample++;
+		sample += num_samples;
 	}
 
 	int get_sample()
@@ -219,6 +222,38 @@ public:
 		}
 	}
 
+	/* texture cache */
+
+	void set_texture_cache_stats(const TextureCacheStats& stats)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		texture_cache_stats = stats;
+	}
+
+	void get_texture_cache_stats(TextureCacheStats& stats)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		stats = texture_cache_stats;
+	}
+
+	/* profiling */
+
+	void set_profiling_stats(const ProfilingStats& stats)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		profiling_stats = stats;
+	}
+
+	void get_profiling_stats(ProfilingStats& stats)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		stats = profiling_stats;
+	}
+
 	/* callback */
 
 	void set_update()
@@ -255,6 +290,9 @@ protected:
 
 	volatile bool cancel;
 	string cancel_message;
+
+	TextureCacheStats texture_cache_stats;
+	ProfilingStats profiling_stats;
 };
 
 CCL_NAMESPACE_END
@@ -19,6 +19,9 @@
 #ifndef __UTIL_STATS_H__
 #define __UTIL_STATS_H__
 
+#include "util_types.h"
+#include "util_vector.h"
+
 CCL_NAMESPACE_BEGIN
 
 class Stats {
@@ -39,6 +42,117 @@ public:
 	size_t mem_peak;
 };
 
+/* Texture Cache Stats
+ *
+ * Misses count tiles that had to be loaded, so a lookup filtering between
+ * tiles or mip levels can miss more than once. */
+
+class TextureCacheStats {
+public:
+	TextureCacheStats()
+	: lookups(0), misses(0), evictions(0), mem_used(0), mem_peak(0), mem_limit(0) {}
+
+	float hit_rate() const
+	{
+		if(lookups == 0 || misses >= lookups)
+			return (lookups == 0)? 1.0f: 0.0f;
+
+		return 1.0f - (float)misses/(float)lookups;
+	}
+
+	size_t lookups;
+	size_t misses;
+	size_t evictions;
+	size_t mem_used;
+	size_t mem_peak;
+	size_t mem_limit;
+};
+
+/* Profiling Stats
+ *
+ * Render time counters of the CPU kernel. Each render thread counts into its
+ * own copy, which is added to the device total when the thread finishes its
+ * task, so no locking or atomics are needed while rendering. Shader counters
+ * are indexed by the shader index in the scene. */
+
+enum ProfilingRayType {
+	PROFILING_RAY_CAMERA = 0,
+	PROFILING_RAY_REFLECT,
+	PROFILING_RAY_TRANSMIT,
+	PROFILING_RAY_SHADOW,
+	PROFILING_RAY_NUM
+};
+
+class ProfilingStats {
+public:
+	ProfilingStats() { reset(); }
+
+	void reset()
+	{
+		for(int i = 0; i < PROFILING_RAY_NUM; i++)
+			rays[i] = 0;
+
+		bvh_nodes = 0;
+		bvh_primitives = 0;
+		light_samples = 0;
+		image_lookups = 0;
+
+		shader_evals.clear();
+		shader_nodes.clear();
+	}
+
+	void add(const ProfilingStats& other)
+	{
+		for(int i = 0; i < PROFILING_RAY_NUM; i++)
+			rays[i] += other.rays[i];
+
+		bvh_nodes += other.bvh_nodes;
+		bvh_primitives += other.bvh_primitives;
+		light_samples += other.light_samples;
+		image_lookups += other.image_lookups;
+
+		if(shader_evals.size() < other.shader_evals.size()) {
+			shader_evals.resize(other.shader_evals.size(), 0);
+			shader_nodes.resize(other.shader_nodes.size(), 0);
+		}
+
+		for(size_t i = 0; i < other.shader_evals.size(); i++) {
+			shader_evals[i] += other.shader_evals[i];
+			shader_nodes[i] += other.shader_nodes[i];
+		}
+	}
+
+	void add_shader(int shader, uint num_nodes)
+	{
+		if(shader >= (int)shader_evals.size()) {
+			shader_evals.resize(shader + 1, 0);
+			shader_nodes.resize(shader + 1, 0);
+		}
+
+		shader_evals[shader]++;
+		shader_nodes[shader] += num_nodes;
+	}
+
+	uint64_t num_rays() const
+	{
+		uint64_t num = 0;
+
+		for(int i = 0; i < PROFILING_RAY_NUM; i++)
+			num += rays[i];
+
+		return num;
+	}
+
+	uint64_t rays[PROFILING_RAY_NUM];
+	uint64_t bvh_nodes;
+	uint64_t bvh_primitives;
+	uint64_t light_samples;
+	uint64_t image_lookups;
+
+	vector<uint64_t> shader_evals;
+	vector<uint64_t> shader_nodes;
+};
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_STATS_H__ */
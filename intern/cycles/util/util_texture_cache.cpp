@@ -0,0 +1,518 @@
+/*
+ * Copyright 2011, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include "atomic_ops.h"
+
+#include "util_algorithm.h"
+#include "util_foreach.h"
+#include "util_map.h"
+#include "util_math.h"
+#include "util_texture_cache.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* All tiles take the same amount of memory, 128x128 byte or 64x64 float
+ * pixels, so evicted tiles can be reused for any image. */
+#define TILE_BYTES (1 << 16)
+#define TILE_SHIFT_BYTE 7
+#define TILE_SHIFT_FLOAT 6
+
+/* Readers only need their loads to stay in order around the version checks.
+ * x86 does not reorder loads with other loads, so there it is enough to stop
+ * the compiler from doing so. */
+#if defined(__i386__) || defined(__x86_64__)
+#  define read_barrier() __asm__ __volatile__("" ::: "memory")
+#elif defined(_M_IX86) || defined(_M_X64)
+#  define read_barrier() _ReadBarrier()
+#else
+#  define read_barrier() atomic_barrier()
+#endif
+
+struct TextureCache::Tile {
+	/* odd while the tile is not in use by a level, changes every time the
+	 * tile is reused so readers can detect that they read stale data */
+	volatile uint version;
+	uint last_used;
+
+	Level *level;
+	int index;
+
+	uchar data[TILE_BYTES];
+};
+
+struct TextureCache::Level {
+	int width, height;
+	int tiles_x, tiles_y;
+	vector<Tile*> tiles;
+
+	/* cleared when the file does not have this level */
+	bool in_file;
+};
+
+struct TextureCache::Image {
+	int width, height;
+	bool is_float;
+	int tile_shift;
+
+	vector<Level> levels;
+	ReadFunc read;
+
+	/* held while reading tiles of this image from file */
+	thread_mutex mutex;
+};
+
+TextureCache::TextureCache()
+{
+	memory_limit = 0;
+	clock = 0;
+	num_lookups = 0;
+}
+
+TextureCache::~TextureCache()
+{
+	clear();
+}
+
+void TextureCache::set_memory_limit(size_t limit)
+{
+	thread_scoped_lock lock(mutex);
+	memory_limit = limit;
+}
+
+void TextureCache::add_image(int slot, int width, int height, bool is_float, ReadFunc read)
+{
+	remove_image(slot);
+
+	Image *img = new Image();
+	img->width = width;
+	img->height = height;
+	img->is_float = is_float;
+	img->tile_shift = (is_float)? TILE_SHIFT_FLOAT: TILE_SHIFT_BYTE;
+	img->read = read;
+
+	/* create levels down to a single pixel, their tiles are loaded on demand */
+	int size = 1 << img->tile_shift;
+
+	while(1) {
+		Level lvl;
+		lvl.width = width;
+		lvl.height = height;
+		lvl.tiles_x = (width + size - 1) >> img->tile_shift;
+		lvl.tiles_y = (height + size - 1) >> img->tile_shift;
+		lvl.tiles.resize(lvl.tiles_x*lvl.tiles_y, NULL);
+		lvl.in_file = true;
+
+		img->levels.push_back(lvl);
+
+		if(width == 1 && height == 1)
+			break;
+
+		width = max(width/2, 1);
+		height = max(height/2, 1);
+	}
+
+	thread_scoped_lock lock(mutex);
+
+	if(slot >= (int)images.size())
+		images.resize(slot + 1, NULL);
+	images[slot] = img;
+}
+
+void TextureCache::remove_image(int slot)
+{
+	thread_scoped_lock lock(mutex);
+
+	if(slot < 0 || slot >= (int)images.size() || !images[slot])
+		return;
+
+	Image *img = images[slot];
+
+	foreach(Level& lvl, img->levels) {
+		foreach(Tile *tile, lvl.tiles) {
+			if(tile) {
+				tile_unpublish(tile);
+				free_tiles.push_back(tile);
+			}
+		}
+	}
+
+	delete img;
+	images[slot] = NULL;
+}
+
+void TextureCache::clear()
+{
+	thread_scoped_lock lock(mutex);
+
+	foreach(Image *img, images)
+		delete img;
+	foreach(Tile *tile, tiles)
+		delete tile;
+
+	images.clear();
+	tiles.clear();
+	free_tiles.clear();
+
+	stats.mem_used = 0;
+}
+
+void TextureCache::get_stats(TextureCacheStats& stats_)
+{
+	thread_scoped_lock lock(mutex);
+
+	stats_ = stats;
+	stats_.lookups = num_lookups;
+	stats_.mem_limit = memory_limit;
+}
+
+void TextureCache::add_lookups(size_t num)
+{
+	atomic_add_z(&num_lookups, num);
+}
+
+/* Lookup */
+
+void TextureCache::lookup(int slot, float x, float y, float width, float result[4])
+{
+	Image *img = images[slot];
+	int num_levels = img->levels.size();
+
+	/* level of detail from the filter footprint in texels of the full
+	 * resolution image, blending between the two nearest levels */
+	float texels = width*(float)max(img->width, img->height);
+	float lod = (texels > 1.0f)? min(logf(texels)/logf(2.0f), (float)(num_levels - 1)): 0.0f;
+	int level = (int)lod;
+	float t = lod - (float)level;
+
+	lookup_bilinear(img, level, x, y, result);
+
+	if(t > 0.0f && level + 1 < num_levels) {
+		float r[4];
+
+		lookup_bilinear(img, level + 1, x, y, r);
+
+		for(int i = 0; i < 4; i++)
+			result[i] = (1.0f - t)*result[i] + t*r[i];
+	}
+}
+
+static int texture_wrap_periodic(int x, int width)
+{
+	x %= width;
+	if(x < 0)
+		x += width;
+	return x;
+}
+
+static float texture_frac(float x, int *ix)
+{
+	int i = (int)x - ((x < 0.0f)? 1: 0);
+	*ix = i;
+	return x - (float)i;
+}
+
+void TextureCache::lookup_bilinear(Image *img, int level, float x, float y, float r[4])
+{
+	/* same filtering and wrapping as texture_image::interp in the kernel */
+	Level *lvl = &img->levels[level];
+	int width = lvl->width;
+	int height = lvl->height;
+
+	int ix, iy;
+	float tx = texture_frac(x*width, &ix);
+	float ty = texture_frac(y*height, &iy);
+
+	ix = texture_wrap_periodic(ix, width);
+	iy = texture_wrap_periodic(iy, height);
+	int nix = texture_wrap_periodic(ix+1, width);
+	int niy = texture_wrap_periodic(iy+1, height);
+
+	float a[4], b[4], c[4], d[4];
+
+	texel(img, level, ix, iy, a);
+	texel(img, level, nix, iy, b);
+	texel(img, level, ix, niy, c);
+	texel(img, level, nix, niy, d);
+
+	for(int i = 0; i < 4; i++)
+		r[i] = (1.0f - ty)*((1.0f - tx)*a[i] + tx*b[i]) + ty*((1.0f - tx)*c[i] + tx*d[i]);
+}
+
+void TextureCache::texel(Image *img, int level, int x, int y, float r[4])
+{
+	Level *lvl = &img->levels[level];
+	int mask = (1 << img->tile_shift) - 1;
+	int index = (y >> img->tile_shift)*lvl->tiles_x + (x >> img->tile_shift);
+	int offset = ((y & mask) << img->tile_shift) + (x & mask);
+
+	while(1) {
+		Tile *tile = *(Tile * volatile *)&lvl->tiles[index];
+
+		if(tile) {
+			/* the tile may be evicted and reused while we read from it, in that
+			 * case the version will have changed and we try again */
+			uint version = tile->version;
+			read_barrier();
+
+			if(!(version & 1) && tile->level == lvl && tile->index == index) {
+				if(img->is_float) {
+					memcpy(r, tile->data + offset*sizeof(float)*4, sizeof(float)*4);
+				}
+				else {
+					const uchar *p = tile->data + offset*4;
+					const float f = 1.0f/255.0f;
+
+					r[0] = p[0]*f;
+					r[1] = p[1]*f;
+					r[2] = p[2]*f;
+					r[3] = p[3]*f;
+				}
+
+				read_barrier();
+
+				if(tile->version == version) {
+					tile->last_used = clock;
+					return;
+				}
+			}
+		}
+
+		tile_load(img, level, index);
+	}
+}
+
+/* Tiles */
+
+void TextureCache::tile_load(Image *img, int level, int index)
+{
+	Level *lvl = &img->levels[level];
+
+	if(img->read) {
+		thread_scoped_lock img_lock(img->mutex);
+
+		/* another thread may have loaded it while we were waiting for the lock */
+		if(lvl->tiles[index])
+			return;
+
+		if(lvl->in_file) {
+			if(tile_read_row(img, level, index))
+				return;
+
+			lvl->in_file = false;
+		}
+	}
+
+	/* generating a tile loads tiles of the level above, so this is done
+	 * without the image lock. two threads may generate the same tile, only
+	 * the first one is kept */
+	int size = 1 << img->tile_shift;
+	int x = (index % lvl->tiles_x) << img->tile_shift;
+	int y = (index / lvl->tiles_x) << img->tile_shift;
+	int w = min(size, lvl->width - x);
+	int h = min(size, lvl->height - y);
+
+	Tile *tile = tile_alloc();
+
+	if(level > 0)
+		tile_downsample(img, level, tile, x, y, w, h);
+	else
+		memset(tile->data, 0, TILE_BYTES);
+
+	tile_publish(lvl, index, tile);
+}
+
+bool TextureCache::tile_read_row(Image *img, int level, int index)
+{
+	/* read the row of tiles containing the tile at once, files that store
+	 * scanlines have to decode the full width anyway. the requested tile is
+	 * published last, so it is the most recently used one */
+	Level *lvl = &img->levels[level];
+	int size = 1 << img->tile_shift;
+	int ty = index / lvl->tiles_x;
+	int y = ty << img->tile_shift;
+	int h = min(size, lvl->height - y);
+	size_t pixel_size = (img->is_float)? sizeof(float)*4: sizeof(uchar)*4;
+
+	vector<uchar> row((size_t)lvl->width*h*pixel_size);
+
+	if(!img->read(level, 0, y, lvl->width, h, lvl->width, &row[0]))
+		return false;
+
+	for(int tx = 0; tx < lvl->tiles_x; tx++) {
+		int tindex = ty*lvl->tiles_x + tx;
+
+		if(tindex != index && !lvl->tiles[tindex])
+			tile_publish(lvl, tindex, tile_from_row(row, lvl->width, tx << img->tile_shift, h, size, pixel_size));
+	}
+
+	tile_publish(lvl, index, tile_from_row(row, lvl->width, (index - ty*lvl->tiles_x) << img->tile_shift, h, size, pixel_size));
+
+	return true;
+}
+
+TextureCache::Tile *TextureCache::tile_from_row(const vector<uchar>& row, int width, int x, int h, int size, size_t pixel_size)
+{
+	/* not visible to readers until published, so it can be filled without
+	 * holding the cache lock */
+	Tile *tile = tile_alloc();
+	int w = min(size, width - x);
+
+	for(int j = 0; j < h; j++)
+		memcpy(tile->data + (size_t)j*size*pixel_size, &row[((size_t)j*width + x)*pixel_size], w*pixel_size);
+
+	return tile;
+}
+
+void TextureCache::tile_publish(Level *lvl, int index, Tile *tile)
+{
+	thread_scoped_lock lock(mutex);
+
+	if(lvl->tiles[index]) {
+		free_tiles.push_back(tile);
+		return;
+	}
+
+	tile->level = lvl;
+	tile->index = index;
+	tile->last_used = clock;
+
+	atomic_barrier();
+	tile->version++;
+	atomic_barrier();
+
+	lvl->tiles[index] = tile;
+	stats.misses++;
+}
+
+void TextureCache::tile_downsample(Image *img, int level, Tile *tile, int x, int y, int w, int h)
+{
+	/* 2x2 box filter of the level above, for files without mipmaps. the
+	 * tile covers 2x2 tiles of the level above, we filter one quadrant at a
+	 * time so only one of those needs to stay loaded */
+	Level *src = &img->levels[level - 1];
+	int size = 1 << img->tile_shift;
+	int half = size/2;
+
+	for(int q = 0; q < 4; q++) {
+		int qx = (q & 1)*half;
+		int qy = (q >> 1)*half;
+
+		for(int j = qy; j < min(qy + half, h); j++) {
+			int sy = min(2*(y + j), src->height - 1);
+			int nsy = min(sy + 1, src->height - 1);
+
+			for(int i = qx; i < min(qx + half, w); i++) {
+				int sx = min(2*(x + i), src->width - 1);
+				int nsx = min(sx + 1, src->width - 1);
+				float a[4], b[4], c[4], d[4], r[4];
+
+				texel(img, level - 1, sx, sy, a);
+				texel(img, level - 1, nsx, sy, b);
+				texel(img, level - 1, sx, nsy, c);
+				texel(img, level - 1, nsx, nsy, d);
+
+				for(int k = 0; k < 4; k++)
+					r[k] = 0.25f*(a[k] + b[k] + c[k] + d[k]);
+
+				int offset = j*size + i;
+
+				if(img->is_float) {
+					memcpy(tile->data + offset*sizeof(float)*4, r, sizeof(float)*4);
+				}
+				else {
+					uchar *p = tile->data + offset*4;
+
+					for(int k = 0; k < 4; k++)
+						p[k] = (uchar)(clamp(r[k], 0.0f, 1.0f)*255.0f + 0.5f);
+				}
+			}
+		}
+	}
+}
+
+TextureCache::Tile *TextureCache::tile_alloc()
+{
+	thread_scoped_lock lock(mutex);
+
+	clock++;
+
+	if(free_tiles.empty() && memory_limit && stats.mem_used + sizeof(Tile) > memory_limit)
+		tile_evict();
+
+	if(!free_tiles.empty()) {
+		Tile *tile = free_tiles.back();
+		free_tiles.pop_back();
+		return tile;
+	}
+
+	/* tiles are never freed while rendering since readers may still be
+	 * looking at them, only reused. if nothing could be evicted we go over
+	 * the limit rather than fail the lookup. */
+	Tile *tile = new Tile();
+	tile->version = 1;
+	tile->last_used = 0;
+	tile->level = NULL;
+	tile->index = 0;
+
+	tiles.push_back(tile);
+
+	stats.mem_used += sizeof(Tile);
+	if(stats.mem_used > stats.mem_peak)
+		stats.mem_peak = stats.mem_used;
+
+	return tile;
+}
+
+void TextureCache::tile_evict()
+{
+	/* evict the least recently used eighth of the loaded tiles at once, so
+	 * the cost of finding them is spread over many misses */
+	vector<pair<uint, Tile*> > used;
+
+	foreach(Tile *tile, tiles)
+		if(tile->level)
+			used.push_back(pair<uint, Tile*>(tile->last_used, tile));
+
+	if(used.empty())
+		return;
+
+	size_t num = max(used.size()/8, (size_t)1);
+	std::nth_element(used.begin(), used.begin() + (num - 1), used.end());
+
+	for(size_t i = 0; i < num; i++) {
+		tile_unpublish(used[i].second);
+		free_tiles.push_back(used[i].second);
+	}
+
+	stats.evictions += num;
+}
+
+void TextureCache::tile_unpublish(Tile *tile)
+{
+	tile->level->tiles[tile->index] = NULL;
+
+	atomic_barrier();
+	tile->version++;
+
+	tile->level = NULL;
+}
+
+CCL_NAMESPACE_END
+
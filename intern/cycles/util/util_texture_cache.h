@@ -0,0 +1,107 @@
+/*
+ * Copyright 2011, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+#include "util_function.h"
+#include "util_stats.h"
+#include "util_thread.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache
+ *
+ * Mipmapped image storage for the CPU kernel, split into fixed size tiles
+ * that are read from file the first time a lookup touches them. When the
+ * memory limit is reached the least recently used tiles are reused for new
+ * ones, so only the parts of the images that are actually seen at the
+ * resolution they are seen at stay in memory.
+ *
+ * Lookups are done from the render threads without taking a lock, only
+ * loading and evicting tiles does. */
+
+class TextureCache {
+public:
+	/* read a region of a mip level as 4 channel uchar or float pixels, with
+	 * rows from bottom to top and stride in pixels. returning false for a
+	 * level > 0 makes the cache downsample it from the level above. the cache
+	 * reads whole rows of tiles at once, never at the same time for one image */
+	typedef function<bool(int level, int x, int y, int w, int h, int stride, void *pixels)> ReadFunc;
+
+	TextureCache();
+	~TextureCache();
+
+	void set_memory_limit(size_t limit);
+
+	void add_image(int slot, int width, int height, bool is_float, ReadFunc read);
+	void remove_image(int slot);
+	void clear();
+
+	bool has_image(int slot)
+	{
+		return slot >= 0 && slot < (int)images.size() && images[slot] != NULL;
+	}
+
+	/* filtered lookup at x, y in 0..1 image space, with width the size of the
+	 * filter footprint in the same space, used to pick mip levels. the result
+	 * is passed as plain floats because kernels built with different
+	 * instruction sets do not agree on the float4 layout */
+	void lookup(int slot, float x, float y, float width, float result[4]);
+
+	/* lookups are counted by the caller, per thread, and added here in
+	 * batches to keep the render threads from sharing a counter */
+	void add_lookups(size_t num);
+
+	void get_stats(TextureCacheStats& stats);
+
+protected:
+	struct Tile;
+	struct Level;
+	struct Image;
+
+	void texel(Image *img, int level, int x, int y, float r[4]);
+	void lookup_bilinear(Image *img, int level, float x, float y, float r[4]);
+
+	void tile_load(Image *img, int level, int index);
+	bool tile_read_row(Image *img, int level, int index);
+	Tile *tile_from_row(const vector<uchar>& row, int width, int x, int h, int size, size_t pixel_size);
+	void tile_downsample(Image *img, int level, Tile *tile, int x, int y, int w, int h);
+	void tile_publish(Level *lvl, int index, Tile *tile);
+	Tile *tile_alloc();
+	void tile_evict();
+	void tile_unpublish(Tile *tile);
+
+	vector<Image*> images;
+	vector<Tile*> tiles;
+	vector<Tile*> free_tiles;
+
+	thread_mutex mutex;
+	size_t memory_limit;
+	uint clock;
+
+	volatile size_t num_lookups;
+	TextureCacheStats stats;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_TEXTURE_CACHE_H__ */
+
@@ -175,6 +175,7 @@ extern "C" {
 
 	/**
 	 * Are the start/end block markers still correct ?
+	 * The lock-free allocator has no markers, it prints an error and returns 0.
 	 *
 	 * @retval 0 for correct memory, 1 for corrupted memory. */
 	int MEM_check_memory_integrity(void);
@@ -186,6 +187,16 @@ extern "C" {
 	/** Attempt to enforce OSX (or other OS's) to have malloc and stack nonzero */
 	void MEM_set_memory_debug(void);
 
+	/**
+	 * Switch to allocation without a global lock, with per thread caches for
+	 * small blocks and atomic statistics. The lock callback is not used then.
+	 * There are no block markers to check for corruption. With track_blocks
+	 * all blocks are kept in lists (with a lock per list), so leaks can be
+	 * listed by name and MEM_callbackmemlist works, without it those say
+	 * they are not supported.
+	 * Must be called before anything is allocated. */
+	void MEM_use_lockfree_allocator(int track_blocks);
+
 	/**
 	 * Memory usage stats
 	 * - MEM_get_memory_in_use is all memory
@@ -36,14 +36,6 @@
 #include <string.h> /* memcpy */
 #include <stdarg.h>
 #include <sys/types.h>
-/* Blame Microsoft for LLP64 and no inttypes.h, quick workaround needed: */
-#if defined(WIN64)
-#  define SIZET_FORMAT "%I64u"
-#  define SIZET_ARG(a) ((unsigned long long)(a))
-#else
-#  define SIZET_FORMAT "%lu"
-#  define SIZET_ARG(a) ((unsigned long)(a))
-#endif
 
 /* mmap exception */
 #if defined(WIN32)
@@ -54,6 +46,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "mallocn_intern.h"
+
 /* Only for debugging:
  * store original buffer's name when doing MEM_dupallocN
  * helpful to profile issues with non-freed "dup_alloc" buffers,
@@ -159,6 +153,9 @@ static void (*thread_unlock_callback)(void) = NULL;
 
 static int malloc_debug_memset = 0;
 
+/* when set all functions pass on to mallocn_lockfree.c */
+static int use_lockfree = 0;
+
 #ifdef malloc
 #undef malloc
 #endif
@@ -176,10 +173,7 @@ static int malloc_debug_memset = 0;
 /* implementation                                                        */
 /* --------------------------------------------------------------------- */
 
-#ifdef __GNUC__
-__attribute__ ((format(printf, 1, 2)))
-#endif
-static void print_error(const char *str, ...)
+void mem_print_error(const char *str, ...)
 {
 	char buf[512];
 	va_list ap;
@@ -208,6 +202,14 @@ int MEM_check_memory_integrity(void)
 {
 	const char *err_val = NULL;
 	MemHead *listend;
+
+	/* no block markers to check */
+	if (use_lockfree) {
+		mem_print_error("MEM_check_memory_integrity: not available with the lock-free allocator, "
+		                "use --debug-memory\n");
+		return 0;
+	}
+
 	/* check_memlist starts from the front, and runs until it finds
 	 * the requested chunk. For this test, that's the last one. */
 	listend = membase->last;
@@ -235,8 +237,27 @@ void MEM_set_memory_debug(void)
 	malloc_debug_memset = 1;
 }
 
+int mem_debug_memset(void)
+{
+	return malloc_debug_memset;
+}
+
+void MEM_use_lockfree_allocator(int track_blocks)
+{
+	if (totblock != 0) {
+		mem_print_error("MEM_use_lockfree_allocator: %d blocks already allocated, keeping the guarded allocator\n",
+		                totblock);
+		return;
+	}
+
+	use_lockfree = mem_lockfree_init(track_blocks);
+}
+
 size_t MEM_allocN_len(const void *vmemh)
 {
+	if (use_lockfree)
+		return mem_lockfree_allocN_len(vmemh);
+
 	if (vmemh) {
 		const MemHead *memh = vmemh;
 	
@@ -251,6 +272,9 @@ size_t MEM_allocN_len(const void *vmemh)
 void *MEM_dupallocN(const void *vmemh)
 {
 	void *newp = NULL;
+
+	if (use_lockfree)
+		return mem_lockfree_dupallocN(vmemh);
 	
 	if (vmemh) {
 		const MemHead *memh = vmemh;
@@ -295,6 +319,9 @@ void *MEM_dupallocN(const void *vmemh)
 void *MEM_reallocN(void *vmemh, size_t len)
 {
 	void *newp = NULL;
+
+	if (use_lockfree)
+		return mem_lockfree_reallocN(vmemh, len, 0);
 	
 	if (vmemh) {
 		MemHead *memh = vmemh;
@@ -322,6 +349,9 @@ void *MEM_recallocN(void *vmemh, size_t len)
 {
 	void *newp = NULL;
 
+	if (use_lockfree)
+		return mem_lockfree_reallocN(vmemh, len, 1);
+
 	if (vmemh) {
 		MemHead *memh = vmemh;
 		memh--;
@@ -382,6 +412,9 @@ void *MEM_mallocN(size_t len, const char *str)
 {
 	MemHead *memh;
 
+	if (use_lockfree)
+		return mem_lockfree_mallocN(len, str);
+
 	mem_lock_thread();
 
 	len = (len + 3) & ~3;   /* allocate in units of 4 */
@@ -402,8 +435,8 @@ void *MEM_mallocN(size_t len, const char *str)
 		return (++memh);
 	}
 	mem_unlock_thread();
-	print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
-	            SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	mem_print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+	                SIZET_ARG(len), str, (unsigned int) mem_in_use);
 	return NULL;
 }
 
@@ -411,6 +444,9 @@ void *MEM_callocN(size_t len, const char *str)
 {
 	MemHead *memh;
 
+	if (use_lockfree)
+		return mem_lockfree_callocN(len, str);
+
 	mem_lock_thread();
 
 	len = (len + 3) & ~3;   /* allocate in units of 4 */
@@ -428,8 +464,8 @@ void *MEM_callocN(size_t len, const char *str)
 		return (++memh);
 	}
 	mem_unlock_thread();
-	print_error("Calloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
-	            SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	mem_print_error("Calloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+	                SIZET_ARG(len), str, (unsigned int) mem_in_use);
 	return NULL;
 }
 
@@ -438,6 +474,9 @@ void *MEM_mapallocN(size_t len, const char *str)
 {
 	MemHead *memh;
 
+	if (use_lockfree)
+		return mem_lockfree_mapallocN(len, str);
+
 	mem_lock_thread();
 	
 	len = (len + 3) & ~3;   /* allocate in units of 4 */
@@ -460,9 +499,9 @@ void *MEM_mapallocN(size_t len, const char *str)
 	}
 	else {
 		mem_unlock_thread();
-		print_error("Mapalloc returns null, fallback to regular malloc: "
-		            "len=" SIZET_FORMAT " in %s, total %u\n",
-		            SIZET_ARG(len), str, (unsigned int) mmap_in_use);
+		mem_print_error("Mapalloc returns null, fallback to regular malloc: "
+		                "len=" SIZET_FORMAT " in %s, total %u\n",
+		                SIZET_ARG(len), str, (unsigned int) mmap_in_use);
 		return MEM_callocN(len, str);
 	}
 }
@@ -495,34 +534,75 @@ static int compare_len(const void *p1, const void *p2)
 		return -1;
 }
 
+typedef struct MemPrintGather {
+	MemPrintBlock *printblock;
+	int totpb, maxpb;
+} MemPrintGather;
+
+static void mem_printblock_gather(void *userdata, void *UNUSED_vmemh, const char *name, size_t len)
+{
+	MemPrintGather *gather = userdata;
+
+	(void)UNUSED_vmemh;
+
+	/* blocks allocated by other threads meanwhile are skipped */
+	if (gather->totpb < gather->maxpb) {
+		MemPrintBlock *pb = &gather->printblock[gather->totpb++];
+		pb->name = name;
+		pb->len = len;
+		pb->items = 1;
+	}
+}
+
 void MEM_printmemlist_stats(void)
 {
 	MemHead *membl;
 	MemPrintBlock *pb, *printblock;
 	int totpb, a, b;
 
-	mem_lock_thread();
+	if (use_lockfree) {
+		MemPrintGather gather;
 
-	/* put memory blocks into array */
-	printblock = malloc(sizeof(MemPrintBlock) * totblock);
+		gather.maxpb = mem_lockfree_get_memory_blocks_in_use();
+		gather.printblock = malloc(sizeof(MemPrintBlock) * (gather.maxpb + 1));
+		gather.totpb = 0;
 
-	pb = printblock;
-	totpb = 0;
+		if (!mem_lockfree_iter_blocks(mem_printblock_gather, &gather)) {
+			printf("\ntotal memory len: %.3f MB in %d blocks\n",
+			       (double)mem_lockfree_get_memory_in_use() / (double)(1024 * 1024), gather.maxpb);
+			printf("(statistics per block name are not supported by the lock-free allocator "
+			       "without block tracking, use --debug-memory or --debug-memory-track)\n");
+			free(gather.printblock);
+			return;
+		}
 
-	membl = membase->first;
-	if (membl) membl = MEMNEXT(membl);
+		printblock = gather.printblock;
+		totpb = gather.totpb;
+	}
+	else {
+		mem_lock_thread();
 
-	while (membl) {
-		pb->name = membl->name;
-		pb->len = membl->len;
-		pb->items = 1;
+		/* put memory blocks into array */
+		printblock = malloc(sizeof(MemPrintBlock) * totblock);
 
-		totpb++;
-		pb++;
+		pb = printblock;
+		totpb = 0;
 
-		if (membl->next)
-			membl = MEMNEXT(membl->next);
-		else break;
+		membl = membase->first;
+		if (membl) membl = MEMNEXT(membl);
+
+		while (membl) {
+			pb->name = membl->name;
+			pb->len = membl->len;
+			pb->items = 1;
+
+			totpb++;
+			pb++;
+
+			if (membl->next)
+				membl = MEMNEXT(membl->next);
+			else break;
+		}
 	}
 
 	/* sort by name and add together blocks with the same name */
@@ -540,12 +620,12 @@ void MEM_printmemlist_stats(void)
 			memcpy(&printblock[b], &printblock[a], sizeof(MemPrintBlock));
 		}
 	}
-	totpb = b + 1;
+	totpb = (totpb) ? b + 1 : 0;
 
 	/* sort by length and print */
 	qsort(printblock, totpb, sizeof(MemPrintBlock), compare_len);
 	printf("\ntotal memory len: %.3f MB\n",
-	       (double)mem_in_use / (double)(1024 * 1024));
+	       (double)MEM_get_memory_in_use() / (double)(1024 * 1024));
 	printf(" ITEMS TOTAL-MiB AVERAGE-KiB TYPE\n");
 	for (a = 0, pb = printblock; a < totpb; a++, pb++) {
 		printf("%6d (%8.3f  %8.3f) %s\n",
@@ -554,7 +634,8 @@ void MEM_printmemlist_stats(void)
 	}
 	free(printblock);
 	
-	mem_unlock_thread();
+	if (!use_lockfree)
+		mem_unlock_thread();
 
 #if 0 /* GLIBC only */
 	malloc_stats();
@@ -581,54 +662,95 @@ static const char mem_printmemlist_pydict_script[] =
 "        print('name:%%s, users:%%i, len:%%i' %%\n"
 "              (item[0], item[1][0], item[1][1]))\n";
 
+static void mem_printmemlist_block(void *userdata, void *vmemh, const char *name, size_t len)
+{
+	const int pydict = *(int *)userdata;
+
+	if (pydict) {
+		fprintf(stderr,
+		        "    {'len':" SIZET_FORMAT ", "
+		        "'name':'''%s''', "
+		        "'pointer':'%p'},\n",
+		        SIZET_ARG(len), name, vmemh);
+	}
+	else {
+		mem_print_error("%s len: " SIZET_FORMAT " %p\n",
+		                name, SIZET_ARG(len), vmemh);
+	}
+}
+
 /* Prints in python syntax for easy */
 static void MEM_printmemlist_internal(int pydict)
 {
 	MemHead *membl;
 
-	mem_lock_thread();
-
-	membl = membase->first;
-	if (membl) membl = MEMNEXT(membl);
-	
 	if (pydict) {
-		print_error("# membase_debug.py\n");
-		print_error("membase = [\n");
+		mem_print_error("# membase_debug.py\n");
+		mem_print_error("membase = [\n");
 	}
-	while (membl) {
-		if (pydict) {
-			fprintf(stderr,
-			        "    {'len':" SIZET_FORMAT ", "
-			        "'name':'''%s''', "
-			        "'pointer':'%p'},\n",
-			        SIZET_ARG(membl->len), membl->name, (void *)(membl + 1));
+
+	if (use_lockfree) {
+		if (!mem_lockfree_iter_blocks(mem_printmemlist_block, &pydict)) {
+			mem_print_error("%d blocks not listed, not supported by the lock-free allocator "
+			                "without block tracking, use --debug-memory or --debug-memory-track\n",
+			                mem_lockfree_get_memory_blocks_in_use());
 		}
-		else {
+	}
+	else {
+		mem_lock_thread();
+
+		membl = membase->first;
+		if (membl) membl = MEMNEXT(membl);
+
+		while (membl) {
 #ifdef DEBUG_MEMCOUNTER
-			print_error("%s len: " SIZET_FORMAT " %p, count: %d\n",
-			            membl->name, SIZET_ARG(membl->len), membl + 1,
-			            membl->_count);
-#else
-			print_error("%s len: " SIZET_FORMAT " %p\n",
-			            membl->name, SIZET_ARG(membl->len), membl + 1);
+			if (!pydict) {
+				mem_print_error("%s len: " SIZET_FORMAT " %p, count: %d\n",
+				                membl->name, SIZET_ARG(membl->len), membl + 1,
+				                membl->_count);
+			}
+			else
 #endif
+			{
+				mem_printmemlist_block(&pydict, membl + 1, membl->name, membl->len);
+			}
+
+			if (membl->next)
+				membl = MEMNEXT(membl->next);
+			else break;
 		}
-		if (membl->next)
-			membl = MEMNEXT(membl->next);
-		else break;
+
+		mem_unlock_thread();
 	}
+
 	if (pydict) {
 		fprintf(stderr, "]\n\n");
 		fprintf(stderr, mem_printmemlist_pydict_script);
 	}
-	
-	mem_unlock_thread();
+}
+
+static void mem_callbackmemlist_block(void *userdata, void *vmemh, const char *UNUSED_name, size_t UNUSED_len)
+{
+	void (*func)(void *) = *(void (**)(void *))userdata;
+
+	(void)UNUSED_name;
+	(void)UNUSED_len;
+
+	func(vmemh);
 }
 
 void MEM_callbackmemlist(void (*func)(void *))
 {
 	MemHead *membl;
 
+	if (use_lockfree) {
+		if (!mem_lockfree_iter_blocks(mem_callbackmemlist_block, &func)) {
+			mem_print_error("MEM_callbackmemlist: not supported by the lock-free allocator "
+			                "without block tracking, use --debug-memory or --debug-memory-track\n");
+		}
+		return;
+	}
+
 	mem_lock_thread();
 
 	membl = membase->first;
@@ -648,6 +770,9 @@ short MEM_testN(void *vmemh)
 {
 	MemHead *membl;
 
+	if (use_lockfree)
+		return mem_lockfree_testN(vmemh);
+
 	mem_lock_thread();
 
 	membl = membase->first;
@@ -666,7 +791,7 @@ short MEM_testN(void *vmemh)
 
 	mem_unlock_thread();
 
-	print_error("Memoryblock %p: pointer not in memlist\n", vmemh);
+	mem_print_error("Memoryblock %p: pointer not in memlist\n", vmemh);
 	return 0;
 }
 
@@ -686,6 +811,9 @@ short MEM_freeN(void *vmemh)
 	MemHead *memh = vmemh;
 	const char *name;
 
+	if (use_lockfree)
+		return mem_lockfree_freeN(vmemh);
+
 	if (memh == NULL) {
 		MemorY_ErroR("free", "attempt to free NULL pointer");
 		/* print_error(err_stream, "%d\n", (memh+4000)->tag1); */
@@ -826,7 +954,7 @@ static void rem_memblock(MemHead *memh)
 
 static void MemorY_ErroR(const char *block, const char *error)
 {
-	print_error("Memoryblock %s: %s\n", block, error);
+	mem_print_error("Memoryblock %s: %s\n", block, error);
 
 #ifdef WITH_ASSERT_ABORT
 	abort();
@@ -925,6 +1053,9 @@ uintptr_t MEM_get_peak_memory(void)
 {
 	uintptr_t _peak_mem;
 
+	if (use_lockfree)
+		return mem_lockfree_get_peak_memory();
+
 	mem_lock_thread();
 	_peak_mem = peak_mem;
 	mem_unlock_thread();
@@ -934,6 +1065,11 @@ uintptr_t MEM_get_peak_memory(void)
 
 void MEM_reset_peak_memory(void)
 {
+	if (use_lockfree) {
+		mem_lockfree_reset_peak_memory();
+		return;
+	}
+
 	mem_lock_thread();
 	peak_mem = 0;
 	mem_unlock_thread();
@@ -943,6 +1079,9 @@ uintptr_t MEM_get_memory_in_use(void)
 {
 	uintptr_t _mem_in_use;
 
+	if (use_lockfree)
+		return mem_lockfree_get_memory_in_use();
+
 	mem_lock_thread();
 	_mem_in_use = mem_in_use;
 	mem_unlock_thread();
@@ -954,6 +1093,9 @@ uintptr_t MEM_get_mapped_memory_in_use(void)
 {
 	uintptr_t _mmap_in_use;
 
+	if (use_lockfree)
+		return mem_lockfree_get_mapped_memory_in_use();
+
 	mem_lock_thread();
 	_mmap_in_use = mmap_in_use;
 	mem_unlock_thread();
@@ -965,6 +1107,9 @@ int MEM_get_memory_blocks_in_use(void)
 {
 	int _totblock;
 
+	if (use_lockfree)
+		return mem_lockfree_get_memory_blocks_in_use();
+
 	mem_lock_thread();
 	_totblock = totblock;
 	mem_unlock_thread();
@@ -975,6 +1120,9 @@ int MEM_get_memory_blocks_in_use(void)
 #ifndef NDEBUG
 const char *MEM_name_ptr(void *vmemh)
 {
+	if (use_lockfree)
+		return mem_lockfree_name_ptr(vmemh);
+
 	if (vmemh) {
 		MemHead *memh = vmemh;
 		memh--;
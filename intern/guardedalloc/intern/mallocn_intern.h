@@ -0,0 +1,74 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file guardedalloc/intern/mallocn_intern.h
+ *  \ingroup MEM
+ *
+ * Functions shared between the guarded allocator in mallocn.c and the
+ * lock-free allocator in mallocn_lockfree.c, not for use outside of guardedalloc.
+ */
+
+#ifndef __MALLOCN_INTERN_H__
+#define __MALLOCN_INTERN_H__
+
+#include "MEM_sys_types.h"
+
+/* Blame Microsoft for LLP64 and no inttypes.h, quick workaround needed: */
+#if defined(WIN64)
+#  define SIZET_FORMAT "%I64u"
+#  define SIZET_ARG(a) ((unsigned long long)(a))
+#else
+#  define SIZET_FORMAT "%lu"
+#  define SIZET_ARG(a) ((unsigned long)(a))
+#endif
+
+#ifdef __GNUC__
+__attribute__ ((format(printf, 1, 2)))
+#endif
+void mem_print_error(const char *str, ...);
+int  mem_debug_memset(void);
+
+/* called for every block in use, the lock-free allocator only has them with block tracking */
+typedef void (*MemBlockIterFunc)(void *userdata, void *vmemh, const char *name, size_t len);
+
+/* mallocn_lockfree.c */
+int    mem_lockfree_init(int track_blocks);
+
+size_t mem_lockfree_allocN_len(const void *vmemh);
+short  mem_lockfree_freeN(void *vmemh);
+short  mem_lockfree_testN(void *vmemh);
+void  *mem_lockfree_dupallocN(const void *vmemh);
+void  *mem_lockfree_reallocN(void *vmemh, size_t len, int clear);
+void  *mem_lockfree_callocN(size_t len, const char *str);
+void  *mem_lockfree_mallocN(size_t len, const char *str);
+void  *mem_lockfree_mapallocN(size_t len, const char *str);
+const char *mem_lockfree_name_ptr(void *vmemh);
+
+int    mem_lockfree_iter_blocks(MemBlockIterFunc func, void *userdata);
+
+uintptr_t mem_lockfree_get_memory_in_use(void);
+uintptr_t mem_lockfree_get_mapped_memory_in_use(void);
+int       mem_lockfree_get_memory_blocks_in_use(void);
+uintptr_t mem_lockfree_get_peak_memory(void);
+void      mem_lockfree_reset_peak_memory(void);
+
+#endif  /* __MALLOCN_INTERN_H__ */
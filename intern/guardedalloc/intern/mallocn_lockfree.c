@@ -0,0 +1,543 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file guardedalloc/intern/mallocn_lockfree.c
+ *  \ingroup MEM
+ *
+ * Memory allocation without a global lock, see MEM_use_lockfree_allocator().
+ *
+ * Blocks only have a small header, the statistics are atomic counters.
+ * Small blocks that are freed are kept in a cache per thread (per size class,
+ * up to a limit) and reused by the next allocation of that thread, so the
+ * system allocator is not hit for every small allocation either.
+ *
+ * There is no list of all blocks, so no boundary checks or walking the list
+ * to find corruption. When block tracking is enabled at init, every block gets
+ * an extra link in front of its header and is kept in lists (split over many
+ * locks, so threads rarely wait on each other), to list leaks by name and for
+ * MEM_callbackmemlist().
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#if defined(WIN32)
+#  include "mmap_win.h"
+#else
+#  include <sys/mman.h>
+#  include <pthread.h>
+#  define USE_THREAD_CACHE
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "mallocn_intern.h"
+#include "atomic_ops.h"
+
+/* header is 16 bytes on 64 bit systems, keeps the malloc alignment for SSE */
+typedef struct MemHead {
+	const char *name;
+	size_t len;  /* lengths are a multiple of 4, the low bits are flags */
+} MemHead;
+
+#define MEMHEAD_MMAP_FLAG  1
+#define MEMHEAD_FREED_FLAG 2
+#define MEMHEAD_LEN(memh) ((memh)->len & ~(size_t)(MEMHEAD_MMAP_FLAG | MEMHEAD_FREED_FLAG))
+
+/* in front of the MemHead of tracked blocks, same size so the alignment is kept */
+typedef struct MemTrackLink {
+	struct MemTrackLink *next, *prev;
+} MemTrackLink;
+
+#define MEMHEAD_LINK(memh) ((MemTrackLink *)(memh) - 1)
+#define MEMLINK_HEAD(link) ((MemHead *)((link) + 1))
+
+static volatile unsigned int totblock = 0;
+static volatile size_t mem_in_use = 0, mmap_in_use = 0, peak_mem = 0;
+
+/* sizeof(MemTrackLink) when blocks are tracked, set once by mem_lockfree_init() */
+static size_t mem_track_size = 0;
+
+/* --------------------------------------------------------------------- */
+/* thread cache                                                          */
+/* --------------------------------------------------------------------- */
+
+/* blocks up to 1024 bytes (including header) in 16 byte steps */
+#define MEM_CACHE_SHIFT      4
+#define MEM_CACHE_CLASSES    64
+#define MEM_CACHE_MAX_SIZE   (MEM_CACHE_CLASSES << MEM_CACHE_SHIFT)
+#define MEM_CACHE_MAX_BLOCKS 128
+
+#define MEM_CACHE_CLASS(size) (((size) - 1) >> MEM_CACHE_SHIFT)
+#define MEM_CACHE_CLASS_SIZE(cls) (((size_t)(cls) + 1) << MEM_CACHE_SHIFT)
+
+#ifdef USE_THREAD_CACHE
+
+typedef struct MemCacheBlock {
+	struct MemCacheBlock *next;
+} MemCacheBlock;
+
+typedef struct MemThreadCache {
+	MemCacheBlock *blocks[MEM_CACHE_CLASSES];
+	unsigned int totblock[MEM_CACHE_CLASSES];
+} MemThreadCache;
+
+static pthread_key_t cache_key;
+static int cache_key_valid = 0;
+
+/* called when a thread exits, its cache would be lost otherwise */
+static void mem_thread_cache_free(void *cache_v)
+{
+	MemThreadCache *cache = cache_v;
+	int cls;
+
+	for (cls = 0; cls < MEM_CACHE_CLASSES; cls++) {
+		MemCacheBlock *block, *next;
+
+		for (block = cache->blocks[cls]; block; block = next) {
+			next = block->next;
+			free(block);
+		}
+	}
+
+	free(cache);
+}
+
+static MemThreadCache *mem_thread_cache_get(void)
+{
+	MemThreadCache *cache;
+
+	if (!cache_key_valid)
+		return NULL;
+
+	cache = pthread_getspecific(cache_key);
+
+	if (cache == NULL) {
+		cache = calloc(1, sizeof(MemThreadCache));
+		if (cache && pthread_setspecific(cache_key, cache) != 0) {
+			free(cache);
+			cache = NULL;
+		}
+	}
+
+	return cache;
+}
+
+#endif  /* USE_THREAD_CACHE */
+
+int mem_lockfree_init(int track_blocks)
+{
+	mem_track_size = (track_blocks) ? sizeof(MemTrackLink) : 0;
+
+#ifdef USE_THREAD_CACHE
+	if (!cache_key_valid)
+		cache_key_valid = (pthread_key_create(&cache_key, mem_thread_cache_free) == 0);
+#endif
+
+	return 1;
+}
+
+/* size includes the MemHead, room for the tracking link is added here */
+static MemHead *mem_block_alloc(size_t size, int clear)
+{
+	char *block;
+
+	size += mem_track_size;
+
+	if (size <= MEM_CACHE_MAX_SIZE) {
+		const int cls = MEM_CACHE_CLASS(size);
+
+#ifdef USE_THREAD_CACHE
+		MemThreadCache *cache = mem_thread_cache_get();
+
+		if (cache && cache->blocks[cls]) {
+			MemCacheBlock *block = cache->blocks[cls];
+
+			cache->blocks[cls] = block->next;
+			cache->totblock[cls]--;
+
+			if (clear)
+				memset(block, 0, size);
+
+			return (MemHead *)((char *)block + mem_track_size);
+		}
+#endif
+
+		/* allocate the full class size so the block can be cached when freed */
+		size = MEM_CACHE_CLASS_SIZE(cls);
+	}
+
+	block = (clear) ? calloc(size, 1) : malloc(size);
+
+	return (block) ? (MemHead *)(block + mem_track_size) : NULL;
+}
+
+static void mem_block_free(MemHead *memh, size_t size)
+{
+	void *block = (char *)memh - mem_track_size;
+
+	size += mem_track_size;
+
+#ifdef USE_THREAD_CACHE
+	if (size <= MEM_CACHE_MAX_SIZE) {
+		const int cls = MEM_CACHE_CLASS(size);
+		MemThreadCache *cache = mem_thread_cache_get();
+
+		if (cache && cache->totblock[cls] < MEM_CACHE_MAX_BLOCKS) {
+			MemCacheBlock *cache_block = block;
+
+			cache_block->next = cache->blocks[cls];
+			cache->blocks[cls] = cache_block;
+			cache->totblock[cls]++;
+			return;
+		}
+	}
+#else
+	(void)size;
+#endif
+
+	free(block);
+}
+
+/* --------------------------------------------------------------------- */
+/* block tracking                                                        */
+/* --------------------------------------------------------------------- */
+
+#define MEM_TRACK_LISTS 64
+
+typedef struct MemTrackList {
+	volatile unsigned int lock;
+	MemTrackLink *first;
+	char pad[64 - sizeof(unsigned int) - sizeof(MemTrackLink *)];  /* own cache line */
+} MemTrackList;
+
+static MemTrackList mem_track_lists[MEM_TRACK_LISTS];
+
+static MemTrackList *mem_track_list(MemTrackLink *link)
+{
+	uintptr_t key = (uintptr_t)link;
+	return &mem_track_lists[((key >> 4) ^ (key >> 12)) & (MEM_TRACK_LISTS - 1)];
+}
+
+static void mem_track_add(MemHead *memh)
+{
+	MemTrackLink *link = MEMHEAD_LINK(memh);
+	MemTrackList *list = mem_track_list(link);
+
+	atomic_spin_lock(&list->lock);
+	link->prev = NULL;
+	link->next = list->first;
+	if (list->first)
+		list->first->prev = link;
+	list->first = link;
+	atomic_spin_unlock(&list->lock);
+}
+
+static void mem_track_remove(MemHead *memh)
+{
+	MemTrackLink *link = MEMHEAD_LINK(memh);
+	MemTrackList *list = mem_track_list(link);
+
+	atomic_spin_lock(&list->lock);
+	if (link->next)
+		link->next->prev = link->prev;
+	if (link->prev)
+		link->prev->next = link->next;
+	else
+		list->first = link->next;
+	atomic_spin_unlock(&list->lock);
+}
+
+int mem_lockfree_iter_blocks(MemBlockIterFunc func, void *userdata)
+{
+	int a;
+
+	if (!mem_track_size)
+		return 0;
+
+	for (a = 0; a < MEM_TRACK_LISTS; a++) {
+		MemTrackList *list = &mem_track_lists[a];
+		MemTrackLink *link;
+
+		atomic_spin_lock(&list->lock);
+		for (link = list->first; link; link = link->next) {
+			MemHead *memh = MEMLINK_HEAD(link);
+			func(userdata, memh + 1, memh->name, MEMHEAD_LEN(memh));
+		}
+		atomic_spin_unlock(&list->lock);
+	}
+
+	return 1;
+}
+
+/* --------------------------------------------------------------------- */
+/* allocation                                                            */
+/* --------------------------------------------------------------------- */
+
+static void *mem_block_init(MemHead *memh, size_t len, const char *str, int mmap)
+{
+	size_t in_use, peak;
+
+	memh->name = str;
+	memh->len = len | (mmap ? MEMHEAD_MMAP_FLAG : 0);
+
+	if (mem_track_size)
+		mem_track_add(memh);
+
+	atomic_add_uint32(&totblock, 1);
+	in_use = atomic_add_z(&mem_in_use, len);
+	if (mmap)
+		atomic_add_z(&mmap_in_use, len);
+
+	/* retry until the peak is stored or another thread stored a higher one */
+	peak = peak_mem;
+	while (in_use > peak) {
+		const size_t prev = atomic_cas_z(&peak_mem, peak, in_use);
+
+		if (prev == peak)
+			break;
+		peak = prev;
+	}
+
+	return memh + 1;
+}
+
+void *mem_lockfree_mallocN(size_t len, const char *str)
+{
+	MemHead *memh;
+
+	len = (len + 3) & ~3;   /* allocate in units of 4 */
+
+	memh = mem_block_alloc(len + sizeof(MemHead), 0);
+
+	if (memh) {
+		if (mem_debug_memset() && len)
+			memset(memh + 1, 255, len);
+
+		return mem_block_init(memh, len, str, 0);
+	}
+
+	mem_print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+	                SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	return NULL;
+}
+
+void *mem_lockfree_callocN(size_t len, const char *str)
+{
+	MemHead *memh;
+
+	len = (len + 3) & ~3;   /* allocate in units of 4 */
+
+	memh = mem_block_alloc(len + sizeof(MemHead), 1);
+
+	if (memh) {
+		return mem_block_init(memh, len, str, 0);
+	}
+
+	mem_print_error("Calloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+	                SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	return NULL;
+}
+
+/* note; mmap returns zero'd memory */
+void *mem_lockfree_mapallocN(size_t len, const char *str)
+{
+	char *block;
+
+	len = (len + 3) & ~3;   /* allocate in units of 4 */
+
+	block = mmap(NULL, len + sizeof(MemHead) + mem_track_size,
+	             PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+
+	if (block != (char *)-1) {
+		return mem_block_init((MemHead *)(block + mem_track_size), len, str, 1);
+	}
+
+	mem_print_error("Mapalloc returns null, fallback to regular malloc: "
+	                "len=" SIZET_FORMAT " in %s, total %u\n",
+	                SIZET_ARG(len), str, (unsigned int) mmap_in_use);
+	return mem_lockfree_callocN(len, str);
+}
+
+short mem_lockfree_freeN(void *vmemh)
+{
+	MemHead *memh = vmemh;
+	size_t len;
+
+	if (memh == NULL) {
+		mem_print_error("Memoryblock free: attempt to free NULL pointer\n");
+		return -1;
+	}
+
+	if (((intptr_t) memh) & (sizeof(intptr_t) == 8 ? 0x7 : 0x3)) {
+		mem_print_error("Memoryblock free: attempt to free illegal pointer\n");
+		return -1;
+	}
+
+	memh--;
+
+	if (memh->len & MEMHEAD_FREED_FLAG) {
+		mem_print_error("Memoryblock %s: double free\n", memh->name);
+		return -1;
+	}
+
+	len = MEMHEAD_LEN(memh);
+
+	if (mem_track_size)
+		mem_track_remove(memh);
+
+	atomic_sub_uint32(&totblock, 1);
+	atomic_sub_z(&mem_in_use, len);
+
+	if (memh->len & MEMHEAD_MMAP_FLAG) {
+		atomic_sub_z(&mmap_in_use, len);
+
+		if (munmap((char *)memh - mem_track_size, len + sizeof(MemHead) + mem_track_size))
+			mem_print_error("Couldn't unmap memory %s\n", memh->name);
+	}
+	else {
+		if (mem_debug_memset() && len)
+			memset(memh + 1, 255, len);
+
+		memh->len |= MEMHEAD_FREED_FLAG;
+		mem_block_free(memh, len + sizeof(MemHead));
+	}
+
+	return 0;
+}
+
+short mem_lockfree_testN(void *vmemh)
+{
+	MemHead *memh = vmemh;
+
+	/* without the block lists only a freed block can be detected */
+	if (memh && ((memh - 1)->len & MEMHEAD_FREED_FLAG) == 0)
+		return 1;
+
+	mem_print_error("Memoryblock %p: pointer not in memlist\n", vmemh);
+	return 0;
+}
+
+size_t mem_lockfree_allocN_len(const void *vmemh)
+{
+	if (vmemh) {
+		const MemHead *memh = vmemh;
+		return MEMHEAD_LEN(memh - 1);
+	}
+	else {
+		return 0;
+	}
+}
+
+const char *mem_lockfree_name_ptr(void *vmemh)
+{
+	if (vmemh) {
+		MemHead *memh = vmemh;
+		return (memh - 1)->name;
+	}
+	else {
+		return "MEM_name_ptr(NULL)";
+	}
+}
+
+void *mem_lockfree_dupallocN(const void *vmemh)
+{
+	void *newp = NULL;
+
+	if (vmemh) {
+		const MemHead *memh = (const MemHead *)vmemh - 1;
+		const size_t len = MEMHEAD_LEN(memh);
+
+		if (memh->len & MEMHEAD_MMAP_FLAG)
+			newp = mem_lockfree_mapallocN(len, "dupli_mapalloc");
+		else
+			newp = mem_lockfree_mallocN(len, "dupli_alloc");
+
+		if (newp == NULL) return NULL;
+
+		memcpy(newp, vmemh, len);
+	}
+
+	return newp;
+}
+
+void *mem_lockfree_reallocN(void *vmemh, size_t len, int clear)
+{
+	void *newp = NULL;
+
+	if (vmemh) {
+		const MemHead *memh = (const MemHead *)vmemh - 1;
+		const size_t old_len = MEMHEAD_LEN(memh);
+
+		newp = mem_lockfree_mallocN(len, memh->name);
+		if (newp) {
+			if (len < old_len) {
+				/* shrink */
+				memcpy(newp, vmemh, len);
+			}
+			else {
+				/* grow (or remain same size) */
+				memcpy(newp, vmemh, old_len);
+
+				if (clear && len > old_len) {
+					/* zero new bytes */
+					memset(((char *)newp) + old_len, 0, len - old_len);
+				}
+			}
+		}
+
+		mem_lockfree_freeN(vmemh);
+	}
+
+	return newp;
+}
+
+/* --------------------------------------------------------------------- */
+/* statistics                                                            */
+/* --------------------------------------------------------------------- */
+
+uintptr_t mem_lockfree_get_memory_in_use(void)
+{
+	return mem_in_use;
+}
+
+uintptr_t mem_lockfree_get_mapped_memory_in_use(void)
+{
+	return mmap_in_use;
+}
+
+int mem_lockfree_get_memory_blocks_in_use(void)
+{
+	return totblock;
+}
+
+uintptr_t mem_lockfree_get_peak_memory(void)
+{
+	return peak_mem;
+}
+
+void mem_lockfree_reset_peak_memory(void)
+{
+	peak_mem = 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/**
+ * Multi-threaded allocation benchmark, compares the guarded allocator
+ * (with a lock callback, as BLI_begin_threaded_malloc() sets it) to the
+ * lock-free allocator.
+ *
+ * Every thread keeps a table of blocks and replaces random entries with new
+ * blocks of random size (mostly small, some large), then the tables are
+ * freed by another thread than the one that allocated them.
+ *
+ * Build and run from the guardedalloc directory:
+ *
+ *   cc -O2 -I. -Iintern -I../atomic test/threadtest/memtest_threads.c \
+ *       intern/mallocn.c intern/mallocn_lockfree.c -lpthread -o memtest_threads
+ *   ./memtest_threads guarded 8
+ *   ./memtest_threads lockfree 8
+ *   ./memtest_threads lockfree-track 8
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "MEM_guardedalloc.h"
+
+#define MAX_THREADS 64
+#define NUM_SLOTS   4096
+#define NUM_ITER    2000000
+
+typedef struct ThreadData {
+	pthread_t thread;
+	unsigned int seed;
+	void *slots[NUM_SLOTS];
+} ThreadData;
+
+static ThreadData threads[MAX_THREADS];
+static pthread_mutex_t malloc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void lock_malloc(void)
+{
+	pthread_mutex_lock(&malloc_lock);
+}
+
+static void unlock_malloc(void)
+{
+	pthread_mutex_unlock(&malloc_lock);
+}
+
+static void mem_error_cb(const char *errorStr)
+{
+	fprintf(stderr, "%s", errorStr);
+	fflush(stderr);
+}
+
+static double time_seconds(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static unsigned int rand_next(unsigned int *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return (*seed >> 8);
+}
+
+static void *alloc_thread(void *data_v)
+{
+	ThreadData *data = data_v;
+	int i;
+
+	for (i = 0; i < NUM_ITER; i++) {
+		unsigned int r = rand_next(&data->seed);
+		int slot = r % NUM_SLOTS;
+		/* mostly small blocks like ListBase links and customdata, few large ones */
+		size_t len = ((r >> 12) & 15) ? 8 + (r >> 16) % 256 : 1024 + (r >> 16) % 65536;
+
+		if (data->slots[slot])
+			MEM_freeN(data->slots[slot]);
+
+		if (r & (1 << 20))
+			data->slots[slot] = MEM_callocN(len, "memtest_threads calloc");
+		else
+			data->slots[slot] = MEM_mallocN(len, "memtest_threads malloc");
+	}
+
+	return NULL;
+}
+
+static void *free_thread(void *data_v)
+{
+	ThreadData *data = data_v;
+	int slot;
+
+	for (slot = 0; slot < NUM_SLOTS; slot++) {
+		if (data->slots[slot]) {
+			MEM_freeN(data->slots[slot]);
+			data->slots[slot] = NULL;
+		}
+	}
+
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	int totthread = 4, lockfree = 0, track = 0, a;
+	double t_alloc, t_free;
+
+	if (argc > 1) {
+		track = (strcmp(argv[1], "lockfree-track") == 0);
+		lockfree = track || (strcmp(argv[1], "lockfree") == 0);
+	}
+	if (argc > 2)
+		totthread = atoi(argv[2]);
+	if (totthread < 1 || totthread > MAX_THREADS)
+		totthread = 4;
+
+	MEM_set_error_callback(mem_error_cb);
+
+	if (lockfree)
+		MEM_use_lockfree_allocator(track);
+	else
+		MEM_set_lock_callback(lock_malloc, unlock_malloc);
+
+	for (a = 0; a < totthread; a++)
+		threads[a].seed = a + 1;
+
+	t_alloc = time_seconds();
+	for (a = 0; a < totthread; a++)
+		pthread_create(&threads[a].thread, NULL, alloc_thread, &threads[a]);
+	for (a = 0; a < totthread; a++)
+		pthread_join(threads[a].thread, NULL);
+	t_alloc = time_seconds() - t_alloc;
+
+	printf("%s allocator, %d threads\n", (track) ? "lock-free tracked" : (lockfree) ? "lock-free" : "guarded", totthread);
+	printf("  blocks in use: %d, memory in use: %.3f MB\n",
+	       MEM_get_memory_blocks_in_use(), (double)MEM_get_memory_in_use() / (1024.0 * 1024.0));
+
+	/* free the tables of the next thread, blocks go back from another thread */
+	t_free = time_seconds();
+	for (a = 0; a < totthread; a++)
+		pthread_create(&threads[a].thread, NULL, free_thread, &threads[(a + 1) % totthread]);
+	for (a = 0; a < totthread; a++)
+		pthread_join(threads[a].thread, NULL);
+	t_free = time_seconds() - t_free;
+
+	printf("  alloc/free: %.3f sec, %.1f ns per operation\n",
+	       t_alloc, t_alloc * 1e9 / ((double)NUM_ITER * totthread));
+	printf("  free from other threads: %.3f sec\n", t_free);
+
+	if (MEM_get_memory_blocks_in_use() != 0) {
+		printf("Error: not freed memory blocks: %d\n", MEM_get_memory_blocks_in_use());
+		MEM_printmemlist();
+		return 1;
+	}
+
+	return 0;
+}
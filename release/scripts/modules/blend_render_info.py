@@ -32,6 +32,62 @@
 # } BHead;
 
 
+class _BlendFramesFile:
+    """
+    Reads files saved with LZO or LZMA compression, these start with
+    'BLENDZ01' followed by frames with a 12 byte header: codec, 3 padding
+    bytes, compressed and uncompressed size as little endian ints.
+    LZO frames can't be read by Python, only stored and LZMA frames.
+    """
+    CODEC_STORE = 0
+    CODEC_LZMA = 3
+
+    def __init__(self, fileobj):
+        self._file = fileobj
+        self._data = b''
+
+    def _read_frame(self):
+        import struct
+
+        header = self._file.read(12)
+        if len(header) != 12:
+            return False
+
+        codec = header[0]
+        in_len, out_len = struct.unpack('<2I', header[4:12])
+        if out_len == 0:
+            return False
+
+        data = self._file.read(in_len)
+
+        if codec == self.CODEC_STORE:
+            self._data += data
+        elif codec == self.CODEC_LZMA:
+            import lzma
+            props = data[0]
+            filters = [{"id": lzma.FILTER_LZMA1,
+                        "dict_size": struct.unpack('<I', data[1:5])[0],
+                        "lc": props % 9,
+                        "lp": (props // 9) % 5,
+                        "pb": props // 45}]
+            decompressor = lzma.LZMADecompressor(format=lzma.FORMAT_RAW, filters=filters)
+            self._data += decompressor.decompress(data[5:], out_len)
+        else:
+            raise IOError("blend file frames compressed with an unsupported codec")
+
+        return True
+
+    def read(self, size):
+        while len(self._data) < size and self._read_frame():
+            pass
+
+        data, self._data = self._data[:size], self._data[size:]
+        return data
+
+    def close(self):
+        self._file.close()
+
+
 def read_blend_rend_chunk(path):
 
     import struct
@@ -45,6 +101,15 @@ def read_blend_rend_chunk(path):
         blendfile.close()
         blendfile = gzip.open(path, "rb")
         head = blendfile.read(7)
+    elif head[0:6] == b'BLENDZ':  # LZO/LZMA frames
+        blendfile.read(1)  # rest of the magic
+        blendfile = _BlendFramesFile(blendfile)
+        try:
+            head = blendfile.read(7)
+        except IOError as ex:
+            print("%s: %s" % (path, ex))
+            blendfile.close()
+            return []
 
     if head != b'BLENDER':
         print("not a blend file:", path)
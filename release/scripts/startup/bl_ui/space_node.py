@@ -253,6 +253,7 @@ class NODE_PT_quality(bpy.types.Panel):
         col = layout.column()
         col.prop(tree, "use_opencl")
         col.prop(tree, "two_pass")
+        col.prop(tree, "edit_proxy")
         col.prop(snode, "show_highlight")
         col.prop(snode, "use_hidden_preview")
 
@@ -168,6 +168,8 @@ enum {
 #define G_FILE_HISTORY           (1 << 25)
 #define G_FILE_MESH_COMPAT       (1 << 26)              /* BMesh option to save as older mesh format */
 #define G_FILE_SAVE_COPY         (1 << 27)              /* restore paths after editing them */
+#define G_FILE_COMPRESS_LZO      (1 << 28)              /* with G_FILE_COMPRESS, LZO frames instead of gzip */
+#define G_FILE_COMPRESS_LZMA     (1 << 29)              /* with G_FILE_COMPRESS, LZMA frames instead of gzip */
 
 #define G_FILE_FLAGS_RUNTIME (G_FILE_NO_UI | G_FILE_RELATIVE_REMAP | G_FILE_MESH_COMPAT | G_FILE_SAVE_COPY)
 
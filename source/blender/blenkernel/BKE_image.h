@@ -53,6 +53,8 @@ void   BKE_images_exit(void);
 
 /* call from library */
 void    BKE_image_free(struct Image *me);
+/* give the image a generation no other image had, when its buffers change */
+void    BKE_image_new_generation(struct Image *ima);
 
 void    BKE_imbuf_stamp_info(struct Scene *scene, struct Object *camera, struct ImBuf *ibuf);
 void    BKE_stamp_buf(struct Scene *scene, struct Object *camera, unsigned char *rect, float *rectf, int width, int height, int channels);
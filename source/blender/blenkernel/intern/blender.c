@@ -581,9 +581,28 @@ void BKE_write_undo(bContext *C, const char *name)
 		
 		if (curundo->prev) prevfile = &(curundo->prev->memfile);
 		
+		/* hit counts of this push only */
+		BLO_memfile_stats_reset();
+
 		memused = MEM_get_memory_in_use();
 		/* success = */ /* UNUSED */ BLO_write_file_mem(CTX_data_main(C), prevfile, &curundo->memfile, G.fileflags);
 		curundo->undosize = MEM_get_memory_in_use() - memused;
+
+		if (G.debug & G_DEBUG) {
+			MemFileStats stats;
+			unsigned int tot;
+
+			BLO_memfile_stats(&stats);
+			tot = stats.hit_position + stats.hit_hash + stats.miss;
+
+			printf("undo push %s: %.2f MB new, %.2f MB in %u shared chunks for %.2f MB of %d steps, "
+			       "hit rate %.1f%% (%u position, %u hash, %u miss)\n",
+			       curundo->name, curundo->memfile.size / (1024.0 * 1024.0),
+			       stats.mem_shared / (1024.0 * 1024.0), stats.tot_shared,
+			       stats.mem_referenced / (1024.0 * 1024.0), BLI_countlist(&undobase),
+			       tot ? 100.0 * (stats.hit_position + stats.hit_hash) / tot : 0.0,
+			       stats.hit_position, stats.hit_hash, stats.miss);
+		}
 	}
 
 	if (U.undomemory != 0) {
@@ -47,6 +47,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
@@ -192,6 +194,15 @@ void BKE_image_de_interlace(Image *ima, int odd)
 
 /* ***************** ALLOC & FREE, DATA MANAGING *************** */
 
+/* never reused, also not across files, so caches can't confuse an image
+ * that was read again with what it was before */
+static volatile unsigned int image_generation = 0;
+
+void BKE_image_new_generation(Image *ima)
+{
+	ima->generation = (int)atomic_add_uint32(&image_generation, 1);
+}
+
 static void image_free_buffers(Image *ima)
 {
 	ImBuf *ibuf;
@@ -217,6 +228,7 @@ static void image_free_buffers(Image *ima)
 	GPU_free_image(ima);
 
 	ima->ok = IMA_OK;
+	BKE_image_new_generation(ima);
 }
 
 /* called by library too, do not free ima itself */
@@ -259,6 +271,8 @@ static Image *image_alloc(const char *name, short source, short type)
 		ima->source = source;
 		ima->type = type;
 
+		BKE_image_new_generation(ima);
+
 		if (source == IMA_SRC_VIEWER)
 			ima->flag |= IMA_VIEW_AS_RENDER;
 
@@ -1946,12 +1946,14 @@ void BKE_mesh_calc_normals(MVert *mverts, int numVerts, MLoop *mloop, MPoly *mpo
 	BLI_array_free(vertnos);
 	BLI_array_free(edgevecbuf);
 
+	normalize_v3_array(tnorms, numVerts);
+
 	/* following Mesh convention; we use vertex coordinate itself for normal in this case */
 	for (i = 0; i < numVerts; i++) {
 		MVert *mv = &mverts[i];
 		float *no = tnorms[i];
 
-		if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+		if (UNLIKELY(is_zero_v3(no))) {
 			normalize_v3_v3(no, mv->co);
 		}
 
@@ -1984,12 +1986,14 @@ void BKE_mesh_calc_normals_tessface(MVert *mverts, int numVerts, MFace *mfaces,
 		                          f_no, mverts[mf->v1].co, mverts[mf->v2].co, mverts[mf->v3].co, c4);
 	}
 
+	normalize_v3_array(tnorms, numVerts);
+
 	/* following Mesh convention; we use vertex coordinate itself for normal in this case */
 	for (i = 0; i < numVerts; i++) {
 		MVert *mv = &mverts[i];
 		float *no = tnorms[i];
 		
-		if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+		if (UNLIKELY(is_zero_v3(no))) {
 			normalize_v3_v3(no, mv->co);
 		}
 
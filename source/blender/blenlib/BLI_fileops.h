@@ -75,6 +75,24 @@ double BLI_dir_free_space(const char *dir);
 char  *BLI_current_working_dir(char *dir, const size_t maxlen);
 
 unsigned int BLI_dir_contents(const char *dir, struct direntry **filelist);
+void   BLI_dir_contents_free(struct direntry *filelist, const unsigned int nrentries);
+
+/* Asynchronous listing, entries are stat'ed on the task scheduler while the
+ * caller continues. BLI_dir_listing_ready() returns how many entries at the
+ * start of filelist are stat'ed, in directory order, and the total in r_totfile.
+ * BLI_dir_listing_end() waits for the rest and returns them sorted, like
+ * BLI_dir_contents(). The names of an unchanged directory are cached, the
+ * entries are always stat'ed again. */
+struct DirListing;
+
+struct DirListing *BLI_dir_listing_begin(const char *dir);
+unsigned int BLI_dir_listing_ready(struct DirListing *dl, struct direntry **filelist, unsigned int *r_totfile);
+unsigned int BLI_dir_listing_end(struct DirListing *dl, struct direntry **filelist);
+void   BLI_dir_listing_cancel(struct DirListing *dl);
+
+/* BLI_exists() using the cached listing of the directory */
+int    BLI_dir_cache_exists(const char *path);
+void   BLI_dir_cache_free(void);
 
 /* Files */
 
@@ -97,6 +97,10 @@ void mul_m4_v4(const float M[4][4], float r[4]);
 void mul_v4_m4v4(float r[4], const float M[4][4], float v[4]);
 void mul_project_m4_v3(float M[4][4], float vec[3]);
 
+/* same as above for arrays of vectors, r and v may be the same array (math_batch.c) */
+void mul_m4_v3_array(float M[4][4], float (*r)[3], const int size);
+void mul_v3_m4v3_array(float (*r)[3], float M[4][4], const float (*v)[3], const int size);
+
 void mul_m3_v3(float M[3][3], float r[3]);
 void mul_v3_m3v3(float r[3], float M[3][3], float a[3]);
 void mul_transposed_m3_v3(float M[3][3], float r[3]);
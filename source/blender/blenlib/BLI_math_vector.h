@@ -255,6 +255,9 @@ void fill_vn_i(int *array_tar, const int size, const int val);
 void fill_vn_ushort(unsigned short *array_tar, const int size, const unsigned short val);
 void fill_vn_fl(float *array_tar, const int size, const float val);
 
+/* normalize_v3() for an array of vectors (math_batch.c) */
+void normalize_v3_array(float (*array_tar)[3], const int size);
+
 #ifdef __cplusplus
 }
 #endif
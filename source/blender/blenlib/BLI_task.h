@@ -0,0 +1,107 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_TASK_H__
+#define __BLI_TASK_H__
+
+/** \file BLI_task.h
+ *  \ingroup bli
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "BLI_threads.h"
+
+/* Task Scheduler
+ *
+ * Central scheduler that holds running threads ready to execute tasks. Every
+ * worker thread has its own queue, tasks pushed from a worker go to its own
+ * queue, idle workers steal tasks from the queues of other workers.
+ *
+ * BLI_task_scheduler_get() returns the scheduler for the whole process, so
+ * subsystems running at the same time share the cores instead of each starting
+ * a thread per core. */
+
+typedef struct TaskScheduler TaskScheduler;
+
+enum {
+	TASK_SCHEDULER_AUTO_THREADS = 0
+};
+
+TaskScheduler *BLI_task_scheduler_create(int num_threads);
+void BLI_task_scheduler_free(TaskScheduler *scheduler);
+
+/* number of threads that can work on tasks, the thread waiting on a pool counts too */
+int BLI_task_scheduler_num_threads(TaskScheduler *scheduler);
+
+/* Task Pool
+ *
+ * Pool of tasks that will be executed by the central TaskScheduler. For each
+ * pool, we can wait for all tasks to be done, or cancel them before they are
+ * done.
+ *
+ * Tasks can push more tasks into their own pool, and can create and wait on
+ * pools of their own. A thread waiting on a pool runs queued tasks of that pool
+ * itself.
+ *
+ * threadid is 1 .. BLI_task_scheduler_num_threads() - 1 for the worker threads
+ * and 0 for any other thread, so it can index per thread data as long as only
+ * one thread waits on the pool. */
+
+typedef struct TaskPool TaskPool;
+typedef void (*TaskRunFunction)(TaskPool *pool, void *taskdata, int threadid);
+
+TaskPool *BLI_task_pool_create(TaskScheduler *scheduler, void *userdata);
+void BLI_task_pool_free(TaskPool *pool);
+
+void BLI_task_pool_push(TaskPool *pool, TaskRunFunction run, void *taskdata, int free_taskdata);
+
+/* work and wait until all tasks are done */
+void BLI_task_pool_work_and_wait(TaskPool *pool);
+/* cancel all tasks that did not start yet, and wait for the running ones */
+void BLI_task_pool_cancel(TaskPool *pool);
+
+/* for worker threads, test if cancelled */
+int BLI_task_pool_canceled(TaskPool *pool);
+
+void *BLI_task_pool_userdata(TaskPool *pool);
+/* mutex for the tasks of this pool to use, the pool itself doesn't lock it */
+ThreadMutex *BLI_task_pool_user_mutex(TaskPool *pool);
+
+/* Parallel Range
+ *
+ * Runs func(userdata, i) for start <= i < stop on the global scheduler and
+ * returns when all are done. Iterations are split in a few chunks per thread,
+ * ranges shorter than min_iter_per_chunk * 2 are run on the calling thread. */
+
+typedef void (*TaskParallelRangeFunc)(void *userdata, int iter);
+
+void BLI_task_parallel_range(int start, int stop, void *userdata,
+                             TaskParallelRangeFunc func, int min_iter_per_chunk);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
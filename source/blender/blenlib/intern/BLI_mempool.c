@@ -81,12 +81,58 @@ struct BLI_mempool {
 
 #define MEMPOOL_ELEM_SIZE_MIN (sizeof(void *) * 2)
 
+/* allocate a new chunk and add its elements to the end of the free list,
+ * lasttail is the last free element of the previous chunk or NULL when the free list is empty,
+ * returns the last free element of the new chunk */
+static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_freenode *lasttail)
+{
+	BLI_freenode *curnode = NULL;
+	char *addr;
+	int j;
+
+	BLI_mempool_chunk *mpchunk;
+
+	if (pool->flag & BLI_MEMPOOL_SYSMALLOC) {
+		mpchunk       = malloc(sizeof(BLI_mempool_chunk));
+		mpchunk->data = malloc(pool->csize);
+	}
+	else {
+		mpchunk       = MEM_mallocN(sizeof(BLI_mempool_chunk), "BLI_Mempool Chunk");
+		mpchunk->data = MEM_mallocN(pool->csize, "BLI_Mempool Chunk Data");
+	}
+
+	mpchunk->next = mpchunk->prev = NULL;
+	BLI_addtail(&(pool->chunks), mpchunk);
+
+	if (lasttail) {
+		lasttail->next = mpchunk->data;
+	}
+	else {
+		pool->free = mpchunk->data; /* start of the list */
+	}
+
+	/* loop through the allocated data, building the pointer structures */
+	for (addr = mpchunk->data, j = 0; j < pool->pchunk; j++) {
+		curnode = ((BLI_freenode *)addr);
+		addr += pool->esize;
+		curnode->next = (BLI_freenode *)addr;
+
+		if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+			curnode->freeword = FREEWORD;
+		}
+	}
+	curnode->next = NULL; /* terminate the list */
+
+	pool->totalloc += pool->pchunk;
+
+	return curnode;
+}
+
 BLI_mempool *BLI_mempool_create(int esize, int totelem, int pchunk, int flag)
 {
 	BLI_mempool *pool = NULL;
-	BLI_freenode *lasttail = NULL, *curnode = NULL;
-	int i, j, maxchunks;
-	char *addr;
+	BLI_freenode *lasttail = NULL;
+	int i, maxchunks;
 
 	/* allocate the pool structure */
 	if (flag & BLI_MEMPOOL_SYSMALLOC) {
@@ -112,6 +158,8 @@ BLI_mempool *BLI_mempool_create(int esize, int totelem, int pchunk, int flag)
 	pool->pchunk = pchunk;
 	pool->csize = esize * pchunk;
 	pool->chunks.first = pool->chunks.last = NULL;
+	pool->free = NULL;
+	pool->totalloc = 0;
 	pool->totused = 0;
 
 	maxchunks = totelem / pchunk + 1;
@@ -121,53 +169,9 @@ BLI_mempool *BLI_mempool_create(int esize, int totelem, int pchunk, int flag)
 
 	/* allocate the actual chunks */
 	for (i = 0; i < maxchunks; i++) {
-		BLI_mempool_chunk *mpchunk;
-
-		if (flag & BLI_MEMPOOL_SYSMALLOC) {
-			mpchunk = malloc(sizeof(BLI_mempool_chunk));
-			mpchunk->data = malloc(pool->csize);
-		}
-		else {
-			mpchunk = MEM_mallocN(sizeof(BLI_mempool_chunk), "BLI_Mempool Chunk");
-			mpchunk->data = MEM_mallocN(pool->csize, "BLI Mempool Chunk Data");
-		}
-
-		mpchunk->next = mpchunk->prev = NULL;
-		BLI_addtail(&(pool->chunks), mpchunk);
-
-		if (i == 0) {
-			pool->free = mpchunk->data; /* start of the list */
-			if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
-				pool->free->freeword = FREEWORD;
-			}
-		}
-
-		/* loop through the allocated data, building the pointer structures */
-		for (addr = mpchunk->data, j = 0; j < pool->pchunk; j++) {
-			curnode = ((BLI_freenode *)addr);
-			addr += pool->esize;
-			curnode->next = (BLI_freenode *)addr;
-			if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
-				if (j != pool->pchunk - 1)
-					curnode->next->freeword = FREEWORD;
-				curnode->freeword = FREEWORD;
-			}
-		}
-		/* final pointer in the previously allocated chunk is wrong */
-		if (lasttail) {
-			lasttail->next = mpchunk->data;
-			if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
-				lasttail->freeword = FREEWORD;
-			}
-		}
-
-		/* set the end of this chunks memoryy to the new tail for next iteration */
-		lasttail = curnode;
-
-		pool->totalloc += pool->pchunk;
+		lasttail = mempool_chunk_add(pool, lasttail);
 	}
-	/* terminate the list */
-	curnode->next = NULL;
+
 	return pool;
 }
 
@@ -178,45 +182,8 @@ void *BLI_mempool_alloc(BLI_mempool *pool)
 	pool->totused++;
 
 	if (!(pool->free)) {
-		BLI_freenode *curnode = NULL;
-		char *addr;
-		int j;
-
 		/* need to allocate a new chunk */
-		BLI_mempool_chunk *mpchunk;
-
-		if (pool->flag & BLI_MEMPOOL_SYSMALLOC) {
-			mpchunk       = malloc(sizeof(BLI_mempool_chunk));
-			mpchunk->data = malloc(pool->csize);
-		}
-		else {
-			mpchunk       = MEM_mallocN(sizeof(BLI_mempool_chunk), "BLI_Mempool Chunk");
-			mpchunk->data = MEM_mallocN(pool->csize, "BLI_Mempool Chunk Data");
-		}
-
-		mpchunk->next = mpchunk->prev = NULL;
-		BLI_addtail(&(pool->chunks), mpchunk);
-
-		pool->free = mpchunk->data; /* start of the list */
-
-		if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
-			pool->free->freeword = FREEWORD;
-		}
-
-		for (addr = mpchunk->data, j = 0; j < pool->pchunk; j++) {
-			curnode = ((BLI_freenode *)addr);
-			addr += pool->esize;
-			curnode->next = (BLI_freenode *)addr;
-
-			if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
-				curnode->freeword = FREEWORD;
-				if (j != pool->pchunk - 1)
-					curnode->next->freeword = FREEWORD;
-			}
-		}
-		curnode->next = NULL; /* terminate the list */
-
-		pool->totalloc += pool->pchunk;
+		mempool_chunk_add(pool, NULL);
 	}
 
 	retval = pool->free;
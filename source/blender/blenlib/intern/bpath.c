@@ -71,6 +71,8 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_bpath.h"
+#include "BLI_fileops_types.h"
+#include "BLI_ghash.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_font.h"
@@ -84,16 +86,41 @@ static int checkMissingFiles_visit_cb(void *userdata, char *UNUSED(path_dst), co
 {
 	ReportList *reports = (ReportList *)userdata;
 
-	if (!BLI_exists(path_src)) {
+	if (!BLI_dir_cache_exists(path_src)) {
 		BKE_reportf(reports, RPT_WARNING, "Path '%s' not found", path_src);
 	}
 
 	return FALSE;
 }
 
+static int checkMissingFiles_listdir_cb(void *userdata, char *UNUSED(path_dst), const char *path_src)
+{
+	GHash *listings = (GHash *)userdata;
+	char dirname[FILE_MAX];
+
+	BLI_split_dir_part(path_src, dirname, sizeof(dirname));
+
+	if (dirname[0] && !BLI_ghash_haskey(listings, dirname)) {
+		BLI_ghash_insert(listings, BLI_strdup(dirname), BLI_dir_listing_begin(dirname));
+	}
+
+	return FALSE;
+}
+
 /* high level function */
 void BLI_bpath_missing_files_check(Main *bmain, ReportList *reports)
 {
+	GHash *listings = BLI_ghash_str_new(__func__);
+	GHashIterator gh_iter;
+
+	/* list all directories at once first, on slow disks the time goes to waiting
+	 * for the files of every directory, checking the paths then uses the cache */
+	BLI_bpath_traverse_main(bmain, checkMissingFiles_listdir_cb, BLI_BPATH_TRAVERSE_ABS, listings);
+	GHASH_ITER (gh_iter, listings) {
+		BLI_dir_listing_end(BLI_ghashIterator_getValue(&gh_iter), NULL);
+	}
+	BLI_ghash_free(listings, (GHashKeyFreeFP)MEM_freeN, NULL);
+
 	BLI_bpath_traverse_main(bmain, checkMissingFiles_visit_cb, BLI_BPATH_TRAVERSE_ABS, reports);
 }
 
@@ -207,52 +234,50 @@ static int findFileRecursive(char *filename_new,
                              int *filesize,
                              int *recur_depth)
 {
-	/* file searching stuff */
-	DIR *dir;
-	struct dirent *de;
-	struct stat status;
-	char path[FILE_MAX];
+	/* file searching stuff, the listings are cached so searching
+	 * for the next missing file doesn't read the directories again */
+	struct direntry *files;
+	unsigned int totfile, i;
 	int size;
 	int found = FALSE;
 
-	dir = opendir(dirname);
+	totfile = BLI_dir_listing_end(BLI_dir_listing_begin(dirname), &files);
 
-	if (dir == NULL)
+	if (totfile == 0) {
+		BLI_dir_contents_free(files, totfile);
 		return found;
+	}
 
 	if (*filesize == -1)
 		*filesize = 0;  /* dir opened fine */
 
-	while ((de = readdir(dir)) != NULL) {
+	for (i = 0; i < totfile; i++) {
+		struct direntry *file = &files[i];
 
-		if (strcmp(".", de->d_name) == 0 || strcmp("..", de->d_name) == 0)
+		if (strcmp(".", file->relname) == 0 || strcmp("..", file->relname) == 0)
 			continue;
 
-		BLI_join_dirfile(path, sizeof(path), dirname, de->d_name);
-
-		if (stat(path, &status) != 0)
-			continue;  /* cant stat, don't bother with this file, could print debug info here */
-
-		if (S_ISREG(status.st_mode)) { /* is file */
-			if (strncmp(filename, de->d_name, FILE_MAX) == 0) { /* name matches */
+		if (S_ISREG(file->type)) { /* is file */
+			if (strncmp(filename, file->relname, FILE_MAX) == 0) { /* name matches */
 				/* open the file to read its size */
-				size = status.st_size;
+				size = file->s.st_size;
 				if ((size > 0) && (size > *filesize)) { /* find the biggest file */
 					*filesize = size;
-					BLI_strncpy(filename_new, path, FILE_MAX);
+					BLI_strncpy(filename_new, file->path, FILE_MAX);
 					found = TRUE;
 				}
 			}
 		}
-		else if (S_ISDIR(status.st_mode)) { /* is subdir */
+		else if (S_ISDIR(file->type)) { /* is subdir */
 			if (*recur_depth <= MAX_RECUR) {
 				(*recur_depth)++;
-				found |= findFileRecursive(filename_new, path, filename, filesize, recur_depth);
+				found |= findFileRecursive(filename_new, file->path, filename, filesize, recur_depth);
 				(*recur_depth)--;
 			}
 		}
 	}
-	closedir(dir);
+
+	BLI_dir_contents_free(files, totfile);
 	return found;
 }
 
@@ -0,0 +1,197 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/math_batch.c
+ *  \ingroup bli
+ *
+ * Array versions of vector and matrix functions for loops over many
+ * vertices, using SSE2 or NEON when available. Four float[3] vectors are
+ * loaded at once and rearranged into one register for each of x, y and z, so
+ * every instruction works on four vectors. Remaining vectors and builds
+ * without SIMD use the regular functions, results match them up to rounding.
+ */
+
+#include "BLI_math.h"
+#include "BLI_cpu.h"
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#  define USE_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define USE_NEON
+#endif
+
+#ifdef USE_SSE2
+
+/* load 4 float[3] vectors from p as x0 x1 x2 x3, y0 .., z0 .. */
+BLI_INLINE void sse_load_v3_x4(const float *p, __m128 *x, __m128 *y, __m128 *z)
+{
+	const __m128 a = _mm_loadu_ps(p);      /* x0 y0 z0 x1 */
+	const __m128 b = _mm_loadu_ps(p + 4);  /* y1 z1 x2 y2 */
+	const __m128 c = _mm_loadu_ps(p + 8);  /* z2 x3 y3 z3 */
+	const __m128 t_x = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));   /* x2 x2 x3 x3 */
+	const __m128 t_y1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));  /* y0 y0 y1 y1 */
+	const __m128 t_y2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));  /* y2 y2 y3 y3 */
+	const __m128 t_z = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));   /* z0 z0 z1 z1 */
+
+	*x = _mm_shuffle_ps(a, t_x, _MM_SHUFFLE(2, 0, 3, 0));
+	*y = _mm_shuffle_ps(t_y1, t_y2, _MM_SHUFFLE(2, 0, 2, 0));
+	*z = _mm_shuffle_ps(t_z, c, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+/* inverse of sse_load_v3_x4() */
+BLI_INLINE void sse_store_v3_x4(float *p, const __m128 x, const __m128 y, const __m128 z)
+{
+	const __m128 t_xy0 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0));  /* x0 x0 y0 y0 */
+	const __m128 t_zx0 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));  /* z0 z0 x1 x1 */
+	const __m128 t_yz1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));  /* y1 y1 z1 z1 */
+	const __m128 t_xy2 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));  /* x2 x2 y2 y2 */
+	const __m128 t_zx2 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));  /* z2 z2 x3 x3 */
+	const __m128 t_yz3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));  /* y3 y3 z3 z3 */
+
+	_mm_storeu_ps(p,     _mm_shuffle_ps(t_xy0, t_zx0, _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(p + 4, _mm_shuffle_ps(t_yz1, t_xy2, _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(p + 8, _mm_shuffle_ps(t_zx2, t_yz3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+/* one row of the result of mul_v3_m4v3(), for 4 vectors */
+BLI_INLINE __m128 sse_m4_row(float mat[4][4], const int j, const __m128 x, const __m128 y, const __m128 z)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(mat[0][j])),
+	                             _mm_mul_ps(y, _mm_set1_ps(mat[1][j]))),
+	                  _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(mat[2][j])),
+	                             _mm_set1_ps(mat[3][j])));
+}
+
+#endif  /* USE_SSE2 */
+
+#ifdef USE_NEON
+
+BLI_INLINE float32x4_t neon_m4_row(float mat[4][4], const int j, const float32x4x3_t v)
+{
+	float32x4_t r = vdupq_n_f32(mat[3][j]);
+	r = vmlaq_n_f32(r, v.val[0], mat[0][j]);
+	r = vmlaq_n_f32(r, v.val[1], mat[1][j]);
+	r = vmlaq_n_f32(r, v.val[2], mat[2][j]);
+	return r;
+}
+
+#endif  /* USE_NEON */
+
+/********************************* Matrix ************************************/
+
+void mul_v3_m4v3_array(float (*r)[3], float mat[4][4], const float (*v)[3], const int size)
+{
+	int i = 0;
+
+#if defined(USE_SSE2)
+	if (BLI_cpu_support_sse2()) {
+		for (; i + 4 <= size; i += 4) {
+			__m128 x, y, z;
+
+			sse_load_v3_x4(v[i], &x, &y, &z);
+			sse_store_v3_x4(r[i],
+			                sse_m4_row(mat, 0, x, y, z),
+			                sse_m4_row(mat, 1, x, y, z),
+			                sse_m4_row(mat, 2, x, y, z));
+		}
+	}
+#elif defined(USE_NEON)
+	for (; i + 4 <= size; i += 4) {
+		const float32x4x3_t in = vld3q_f32(v[i]);
+		float32x4x3_t out;
+
+		out.val[0] = neon_m4_row(mat, 0, in);
+		out.val[1] = neon_m4_row(mat, 1, in);
+		out.val[2] = neon_m4_row(mat, 2, in);
+		vst3q_f32(r[i], out);
+	}
+#endif
+
+	for (; i < size; i++) {
+		mul_v3_m4v3(r[i], mat, v[i]);
+	}
+}
+
+void mul_m4_v3_array(float mat[4][4], float (*r)[3], const int size)
+{
+	mul_v3_m4v3_array(r, mat, (const float (*)[3])r, size);
+}
+
+/********************************* Vector ************************************/
+
+void normalize_v3_array(float (*n)[3], const int size)
+{
+	int i = 0;
+
+#if defined(USE_SSE2)
+	if (BLI_cpu_support_sse2()) {
+		const __m128 eps = _mm_set1_ps(1.0e-35f);
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		for (; i + 4 <= size; i += 4) {
+			__m128 x, y, z, d, mask;
+
+			sse_load_v3_x4(n[i], &x, &y, &z);
+
+			d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+			/* zero vectors that are too short, like normalize_v3() */
+			mask = _mm_cmpgt_ps(d, eps);
+			d = _mm_and_ps(mask, _mm_div_ps(one, _mm_sqrt_ps(d)));
+
+			sse_store_v3_x4(n[i], _mm_mul_ps(x, d), _mm_mul_ps(y, d), _mm_mul_ps(z, d));
+		}
+	}
+#elif defined(USE_NEON)
+	{
+		const float32x4_t eps = vdupq_n_f32(1.0e-35f);
+
+		for (; i + 4 <= size; i += 4) {
+			float32x4x3_t v = vld3q_f32(n[i]);
+			float32x4_t d, inv;
+			uint32x4_t mask;
+
+			d = vmulq_f32(v.val[0], v.val[0]);
+			d = vmlaq_f32(d, v.val[1], v.val[1]);
+			d = vmlaq_f32(d, v.val[2], v.val[2]);
+			mask = vcgtq_f32(d, eps);
+
+			/* no square root on ARMv7 NEON, refine the estimate of 1 / sqrt(d) twice
+			 * for about full float precision */
+			inv = vrsqrteq_f32(d);
+			inv = vmulq_f32(inv, vrsqrtsq_f32(vmulq_f32(d, inv), inv));
+			inv = vmulq_f32(inv, vrsqrtsq_f32(vmulq_f32(d, inv), inv));
+			inv = vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(inv)));
+
+			v.val[0] = vmulq_f32(v.val[0], inv);
+			v.val[1] = vmulq_f32(v.val[1], inv);
+			v.val[2] = vmulq_f32(v.val[2], inv);
+			vst3q_f32(n[i], v);
+		}
+	}
+#endif
+
+	for (; i < size; i++) {
+		normalize_v3(n[i]);
+	}
+}
@@ -84,19 +84,18 @@
 
 #include "DNA_listBase.h"
 
+#include "BLI_utildefines.h"
 #include "BLI_listbase.h"
 #include "BLI_linklist.h"
 #include "BLI_string.h"
 #include "BLI_fileops.h"
 #include "BLI_fileops_types.h"
 #include "BLI_path_util.h"
+#include "BLI_ghash.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
-/* vars: */
-static int totnum, actnum;
-static struct direntry *files;
-
-static struct ListBase dirbase_ = {NULL, NULL};
-static struct ListBase *dirbase = &dirbase_;
+#include "PIL_time.h"
 
 /* can return NULL when the size is not big enough */
 char *BLI_current_working_dir(char *dir, const size_t maxncpy)
@@ -197,118 +196,486 @@ double BLI_dir_free_space(const char *dir)
 #endif
 }
 
-static void bli_builddir(const char *dirname, const char *relname)
+/* ************************************************************************** */
+/* Directory Listing
+ *
+ * Names are read with readdir() on the calling thread, then the entries are
+ * stat'ed in chunks on the task scheduler, on slow (network) disks most of the
+ * time goes to waiting for stat(). Finished listings are cached by directory
+ * path and the names are used again as long as the modification time of the
+ * directory is unchanged, adding, removing and renaming files changes it. Writing
+ * to a file doesn't, so cached entries are stat'ed again like newly read ones. */
+
+/* entries stat'ed by one task */
+#define DIR_LISTING_CHUNK 64
+/* entries kept in the cache, the least recently used directories are freed first */
+#define DIR_CACHE_MAX_FILES 100000
+/* seconds BLI_dir_cache_exists() uses a listing without checking the directory again */
+#define DIR_CACHE_CHECK_TIME 2.0
+
+/* DirCacheEntry.uncached, why the listing of a directory isn't cached */
+#define DIR_CACHE_UNCACHED_LARGE 1   /* more than DIR_CACHE_MAX_FILES entries */
+#define DIR_CACHE_UNCACHED_RECENT 2  /* modified within the same second as it was read */
+
+struct DirListing {
+	char dirname[FILE_MAX];  /* with trailing slash */
+	time_t mtime;
+	int exists;
+
+	struct direntry *files;  /* directory order until sorted in BLI_dir_listing_end() */
+	unsigned int totfile;
+
+	TaskPool *pool;
+	char *chunk_done;
+	unsigned int totchunk, ready_chunk;  /* locked by the pool user mutex */
+};
+
+typedef struct DirCacheEntry {
+	struct DirCacheEntry *next, *prev;
+	char *dirname;
+	time_t mtime;
+	double checktime;
+
+	struct direntry *files;        /* sorted, as returned by BLI_dir_contents() */
+	struct direntry **files_name;  /* sorted by name for lookups, created on first use */
+	unsigned int totfile;
+
+	/* only a marker without files, so BLI_dir_cache_exists() checks files directly
+	 * instead of reading the directory again for each of them */
+	int uncached;
+} DirCacheEntry;
+
+static ListBase dircache_lru = {NULL, NULL};  /* most recently used first */
+static GHash *dircache_hash = NULL;
+static unsigned int dircache_totfile = 0;
+static ThreadMutex dircache_mutex = BLI_MUTEX_INITIALIZER;
+
+static int bli_compare_name(const void *a, const void *b)
 {
-	struct dirent *fname;
-	struct dirlink *dlink;
-	int rellen, newnum = 0;
-	char buf[256];
-	DIR *dir;
+	const struct direntry *entry1 = *(const struct direntry **)a;
+	const struct direntry *entry2 = *(const struct direntry **)b;
 
-	BLI_strncpy(buf, relname, sizeof(buf));
-	rellen = strlen(relname);
+#ifdef WIN32
+	return BLI_strcasecmp(entry1->relname, entry2->relname);
+#else
+	return strcmp(entry1->relname, entry2->relname);
+#endif
+}
 
-	if (rellen) {
-		buf[rellen] = '/';
-		rellen++;
-	}
-#ifndef WIN32
-	if (chdir(dirname) == -1) {
-		perror(dirname);
-		return;
+static int bli_dir_mtime(const char *dirname, time_t *r_mtime)
+{
+	char path[FILE_MAX];
+	struct stat st;
+
+	/* stat() of windows fails with a trailing slash */
+	BLI_strncpy(path, dirname, sizeof(path));
+	if (strlen(path) > 3) {
+		BLI_del_slash(path);
 	}
-#else
-	UTF16_ENCODE(dirname);
-	if (!SetCurrentDirectoryW(dirname_16)) {
-		perror(dirname);
-		free(dirname_16);
-		return;
+
+	if (BLI_stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+		return FALSE;
 	}
-	UTF16_UN_ENCODE(dirname);
 
-#endif
-	if ((dir = (DIR *)opendir("."))) {
-		while ((fname = (struct dirent *) readdir(dir)) != NULL) {
-			dlink = (struct dirlink *)malloc(sizeof(struct dirlink));
-			if (dlink) {
-				BLI_strncpy(buf + rellen, fname->d_name, sizeof(buf) - rellen);
-				dlink->name = BLI_strdup(buf);
-				BLI_addhead(dirbase, dlink);
-				newnum++;
-			}
-		}
-		
-		if (newnum) {
+	*r_mtime = st.st_mtime;
+	return TRUE;
+}
 
-			if (files) {
-				void *tmp = realloc(files, (totnum + newnum) * sizeof(struct direntry));
-				if (tmp) {
-					files = (struct direntry *)tmp;
-				}
-				else { /* realloc fail */
-					free(files);
-					files = NULL;
-				}
-			}
-			
-			if (files == NULL)
-				files = (struct direntry *)malloc(newnum * sizeof(struct direntry));
-
-			if (files) {
-				dlink = (struct dirlink *) dirbase->first;
-				while (dlink) {
-					memset(&files[actnum], 0, sizeof(struct direntry));
-					files[actnum].relname = dlink->name;
-					files[actnum].path = BLI_strdupcat(dirname, dlink->name);
+static void bli_stat_direntry(struct direntry *file)
+{
 // use 64 bit file size, only needed for WIN32 and WIN64. 
 // Excluding other than current MSVC compiler until able to test
 #ifdef WIN32
-					{
-						wchar_t *name_16 = alloc_utf16_from_8(dlink->name, 0);
+	wchar_t *name_16 = alloc_utf16_from_8(file->path, 0);
 #if (defined(WIN32) || defined(WIN64)) && (_MSC_VER >= 1500)
-						_wstat64(name_16, &files[actnum].s);
+	_wstat64(name_16, &file->s);
 #elif defined(__MINGW32__)
-						_stati64(dlink->name, &files[actnum].s);
+	_stati64(file->path, &file->s);
 #endif
-						free(name_16);
-					}
-
+	free(name_16);
 #else
-					stat(dlink->name, &files[actnum].s);
+	stat(file->path, &file->s);
 #endif
-					files[actnum].type = files[actnum].s.st_mode;
-					files[actnum].flags = 0;
-					totnum++;
-					actnum++;
-					dlink = dlink->next;
-				}
+	file->type = file->s.st_mode;
+}
+
+/* copy of the names of a listing, the array is malloc'ed like the result of
+ * BLI_dir_contents(), the strings are added again after stat'ing */
+static struct direntry *bli_direntries_copy(const struct direntry *files, const unsigned int totfile)
+{
+	struct direntry *copy = malloc(sizeof(struct direntry) * MAX2(totfile, 1));
+	unsigned int i;
+
+	if (copy == NULL) {
+		printf("Couldn't get memory for dir\n");
+		exit(1);
+	}
+
+	for (i = 0; i < totfile; i++) {
+		copy[i] = files[i];
+		copy[i].relname = BLI_strdup(files[i].relname);
+		copy[i].path = BLI_strdup(files[i].path);
+		copy[i].string = NULL;
+		copy[i].image = NULL;
+		copy[i].poin = NULL;
+	}
+
+	return copy;
+}
+
+/* Directory Cache, all functions expect dircache_mutex to be locked */
+
+static void dircache_remove(DirCacheEntry *dce)
+{
+	unsigned int i;
+
+	BLI_ghash_remove(dircache_hash, dce->dirname, NULL, NULL);
+	BLI_remlink(&dircache_lru, dce);
+	dircache_totfile -= dce->totfile;
+
+	for (i = 0; i < dce->totfile; i++) {
+		MEM_freeN(dce->files[i].relname);
+		MEM_freeN(dce->files[i].path);
+		MEM_freeN(dce->files[i].string);
+	}
+	if (dce->files) {
+		MEM_freeN(dce->files);
+	}
+	if (dce->files_name) {
+		MEM_freeN(dce->files_name);
+	}
+	MEM_freeN(dce->dirname);
+	MEM_freeN(dce);
+}
+
+/* the listing of dirname if it is up to date. Compared with mtime when given,
+ * otherwise with the directory if it wasn't checked for DIR_CACHE_CHECK_TIME */
+static DirCacheEntry *dircache_lookup(const char *dirname, const time_t *mtime)
+{
+	DirCacheEntry *dce = (dircache_hash) ? BLI_ghash_lookup(dircache_hash, dirname) : NULL;
+
+	if (dce) {
+		if (dce->uncached == DIR_CACHE_UNCACHED_RECENT && time(NULL) - dce->mtime >= 2) {
+			/* can be cached now */
+			dircache_remove(dce);
+			return NULL;
+		}
+
+		if (mtime) {
+			if (*mtime != dce->mtime) {
+				dircache_remove(dce);
+				return NULL;
 			}
-			else {
-				printf("Couldn't get memory for dir\n");
-				exit(1);
+			dce->checktime = PIL_check_seconds_timer();
+		}
+		else {
+			const double time = PIL_check_seconds_timer();
+
+			if (time - dce->checktime > DIR_CACHE_CHECK_TIME) {
+				time_t dir_mtime;
+
+				if (!bli_dir_mtime(dirname, &dir_mtime) || dir_mtime != dce->mtime) {
+					dircache_remove(dce);
+					return NULL;
+				}
+				dce->checktime = time;
 			}
+		}
+
+		BLI_remlink(&dircache_lru, dce);
+		BLI_addhead(&dircache_lru, dce);
+	}
+
+	return dce;
+}
 
-			BLI_freelist(dirbase);
-			if (files) qsort(files, actnum, sizeof(struct direntry), (int (*)(const void *, const void *))bli_compare);
+static void dircache_insert(const struct DirListing *dl)
+{
+	DirCacheEntry *dce;
+	unsigned int i;
+	int uncached = 0;
+
+	/* files added within the same second as the listing was read don't change the
+	 * time of the directory, only cache listings of directories that weren't just modified */
+	if (dl->totfile > DIR_CACHE_MAX_FILES) {
+		uncached = DIR_CACHE_UNCACHED_LARGE;
+	}
+	else if (time(NULL) - dl->mtime < 2) {
+		uncached = DIR_CACHE_UNCACHED_RECENT;
+	}
+
+	if (dircache_hash == NULL) {
+		dircache_hash = BLI_ghash_str_new("dircache_hash");
+	}
+	else if ((dce = BLI_ghash_lookup(dircache_hash, dl->dirname))) {
+		/* read by another thread at the same time */
+		dircache_remove(dce);
+	}
+
+	dce = MEM_callocN(sizeof(DirCacheEntry), "DirCacheEntry");
+	dce->dirname = BLI_strdup(dl->dirname);
+	dce->mtime = dl->mtime;
+	dce->checktime = PIL_check_seconds_timer();
+	dce->uncached = uncached;
+
+	if (!uncached) {
+		dce->totfile = dl->totfile;
+		dce->files = MEM_mallocN(sizeof(struct direntry) * MAX2(dl->totfile, 1), "DirCacheEntry files");
+
+		for (i = 0; i < dl->totfile; i++) {
+			dce->files[i] = dl->files[i];
+			dce->files[i].relname = BLI_strdup(dl->files[i].relname);
+			dce->files[i].path = BLI_strdup(dl->files[i].path);
+			dce->files[i].string = BLI_strdup(dl->files[i].string);
 		}
-		else {
-			printf("%s empty directory\n", dirname);
+	}
+
+	BLI_ghash_insert(dircache_hash, dce->dirname, dce);
+	BLI_addhead(&dircache_lru, dce);
+	dircache_totfile += dce->totfile;
+
+	while (dircache_totfile > DIR_CACHE_MAX_FILES) {
+		dircache_remove(dircache_lru.last);
+	}
+}
+
+static struct direntry *dircache_find(DirCacheEntry *dce, const char *filename)
+{
+	struct direntry key, *key_p = &key, **found;
+	unsigned int i;
+
+	if (dce->files_name == NULL) {
+		dce->files_name = MEM_mallocN(sizeof(struct direntry *) * MAX2(dce->totfile, 1), "DirCacheEntry files_name");
+		for (i = 0; i < dce->totfile; i++) {
+			dce->files_name[i] = &dce->files[i];
+		}
+		qsort(dce->files_name, dce->totfile, sizeof(struct direntry *), bli_compare_name);
+	}
+
+	key.relname = (char *)filename;
+	found = bsearch(&key_p, dce->files_name, dce->totfile, sizeof(struct direntry *), bli_compare_name);
+
+	return (found) ? *found : NULL;
+}
+
+/* Listing */
+
+static void bli_adddirstrings(struct direntry *files, const unsigned int totfile);
+
+static void dir_listing_stat_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	struct DirListing *dl = BLI_task_pool_userdata(pool);
+	ThreadMutex *mutex = BLI_task_pool_user_mutex(pool);
+	const unsigned int chunk = (unsigned int)GET_INT_FROM_POINTER(taskdata);
+	const unsigned int end = MIN2((chunk + 1) * DIR_LISTING_CHUNK, dl->totfile);
+	unsigned int i;
+
+	for (i = chunk * DIR_LISTING_CHUNK; i < end; i++) {
+		bli_stat_direntry(&dl->files[i]);
+	}
+
+	/* chunks can finish in any order, entries are ready up to the first unfinished one */
+	BLI_mutex_lock(mutex);
+	dl->chunk_done[chunk] = TRUE;
+	while (dl->ready_chunk < dl->totchunk && dl->chunk_done[dl->ready_chunk]) {
+		dl->ready_chunk++;
+	}
+	BLI_mutex_unlock(mutex);
+}
+
+struct DirListing *BLI_dir_listing_begin(const char *dirname)
+{
+	struct DirListing *dl = MEM_callocN(sizeof(struct DirListing), "DirListing");
+	struct dirent *fname;
+	DirCacheEntry *dce;
+	unsigned int maxfile = 0, chunk;
+	int cached = FALSE;
+	DIR *dir;
+
+	BLI_strncpy(dl->dirname, dirname, sizeof(dl->dirname));
+	BLI_add_slash(dl->dirname);
+
+	/* time before reading, so changes while reading make the listing outdated */
+	if (!bli_dir_mtime(dl->dirname, &dl->mtime)) {
+		return dl;
+	}
+
+	BLI_mutex_lock(&dircache_mutex);
+	dce = dircache_lookup(dl->dirname, &dl->mtime);
+	if (dce && !dce->uncached) {
+		dl->files = bli_direntries_copy(dce->files, dce->totfile);
+		dl->totfile = dce->totfile;
+		cached = TRUE;
+	}
+	BLI_mutex_unlock(&dircache_mutex);
+
+	if (!cached) {
+		if ((dir = opendir(dl->dirname)) == NULL) {
+			return dl;
+		}
+
+		while ((fname = readdir(dir)) != NULL) {
+			struct direntry *file;
+
+			if (dl->totfile == maxfile) {
+				void *tmp;
+
+				maxfile = MAX2(maxfile * 2, DIR_LISTING_CHUNK);
+				tmp = realloc(dl->files, maxfile * sizeof(struct direntry));
+				if (tmp == NULL) {
+					printf("Couldn't get memory for dir\n");
+					exit(1);
+				}
+				dl->files = tmp;
+			}
+
+			file = &dl->files[dl->totfile++];
+			memset(file, 0, sizeof(struct direntry));
+			file->relname = BLI_strdup(fname->d_name);
+			file->path = BLI_strdupcat(dl->dirname, fname->d_name);
 		}
 
 		closedir(dir);
 	}
+
+	dl->exists = TRUE;
+
+	if (dl->totfile) {
+		dl->totchunk = (dl->totfile + DIR_LISTING_CHUNK - 1) / DIR_LISTING_CHUNK;
+		dl->chunk_done = MEM_callocN(dl->totchunk, "DirListing chunk_done");
+		dl->pool = BLI_task_pool_create(BLI_task_scheduler_get(), dl);
+
+		for (chunk = 0; chunk < dl->totchunk; chunk++) {
+			BLI_task_pool_push(dl->pool, dir_listing_stat_task, SET_INT_IN_POINTER(chunk), FALSE);
+		}
+	}
+
+	return dl;
+}
+
+unsigned int BLI_dir_listing_ready(struct DirListing *dl, struct direntry **filelist, unsigned int *r_totfile)
+{
+	unsigned int totready = dl->totfile;
+
+	if (dl->pool) {
+		ThreadMutex *mutex = BLI_task_pool_user_mutex(dl->pool);
+
+		BLI_mutex_lock(mutex);
+		totready = MIN2(dl->ready_chunk * DIR_LISTING_CHUNK, dl->totfile);
+		BLI_mutex_unlock(mutex);
+	}
+
+	*filelist = dl->files;
+	if (r_totfile) {
+		*r_totfile = dl->totfile;
+	}
+	return totready;
+}
+
+static void dir_listing_free(struct DirListing *dl)
+{
+	if (dl->pool) {
+		BLI_task_pool_free(dl->pool);
+		MEM_freeN(dl->chunk_done);
+	}
+
+	MEM_freeN(dl);
+}
+
+unsigned int BLI_dir_listing_end(struct DirListing *dl, struct direntry **filelist)
+{
+	const unsigned int totfile = dl->totfile;
+
+	if (dl->pool) {
+		BLI_task_pool_work_and_wait(dl->pool);
+	}
+
+	if (dl->exists) {
+		qsort(dl->files, dl->totfile, sizeof(struct direntry), (int (*)(const void *, const void *))bli_compare);
+		bli_adddirstrings(dl->files, dl->totfile);
+
+		BLI_mutex_lock(&dircache_mutex);
+		dircache_insert(dl);
+		BLI_mutex_unlock(&dircache_mutex);
+	}
+
+	if (filelist) {
+		*filelist = dl->files;
+	}
 	else {
-		printf("%s non-existant directory\n", dirname);
+		BLI_dir_contents_free(dl->files, dl->totfile);
+	}
+
+	dir_listing_free(dl);
+
+	return totfile;
+}
+
+void BLI_dir_listing_cancel(struct DirListing *dl)
+{
+	if (dl->pool) {
+		BLI_task_pool_cancel(dl->pool);
 	}
+
+	BLI_dir_contents_free(dl->files, dl->totfile);
+	dir_listing_free(dl);
 }
 
-static void bli_adddirstrings(void)
+int BLI_dir_cache_exists(const char *path)
+{
+	char dirname[FILE_MAX], filename[FILE_MAX];
+	DirCacheEntry *dce;
+	int mode = -1;
+
+	BLI_split_dirfile(path, dirname, filename, sizeof(dirname), sizeof(filename));
+	if (dirname[0] == '\0' || filename[0] == '\0') {
+		return BLI_exists(path);
+	}
+	BLI_add_slash(dirname);
+
+	BLI_mutex_lock(&dircache_mutex);
+	dce = dircache_lookup(dirname, NULL);
+	if (dce == NULL) {
+		BLI_mutex_unlock(&dircache_mutex);
+		BLI_dir_listing_end(BLI_dir_listing_begin(dirname), NULL);
+		BLI_mutex_lock(&dircache_mutex);
+		dce = dircache_lookup(dirname, NULL);
+	}
+	if (dce && !dce->uncached) {
+		struct direntry *file = dircache_find(dce, filename);
+		mode = (file) ? (int)file->s.st_mode : 0;
+	}
+	BLI_mutex_unlock(&dircache_mutex);
+
+	/* the directory is missing, or its listing isn't cached */
+	if (mode == -1) {
+		return BLI_exists(path);
+	}
+
+	return mode;
+}
+
+void BLI_dir_cache_free(void)
+{
+	BLI_mutex_lock(&dircache_mutex);
+	while (dircache_lru.first) {
+		dircache_remove(dircache_lru.first);
+	}
+	if (dircache_hash) {
+		BLI_ghash_free(dircache_hash, NULL, NULL);
+		dircache_hash = NULL;
+	}
+	BLI_mutex_unlock(&dircache_mutex);
+}
+
+static void bli_adddirstrings(struct direntry *files, const unsigned int totfile)
 {
 	char datum[100];
 	char buf[512];
 	char size[250];
 	static const char *types[8] = {"---", "--x", "-w-", "-wx", "r--", "r-x", "rw-", "rwx"};
-	int num, mode;
+	unsigned int num;
+	int mode;
 #ifdef WIN32
 	__int64 st_size;
 #else
@@ -319,7 +686,7 @@ static void bli_adddirstrings(void)
 	struct tm *tm;
 	time_t zero = 0;
 	
-	for (num = 0, file = files; num < actnum; num++, file++) {
+	for (num = 0, file = files; num < totfile; num++, file++) {
 #ifdef WIN32
 		mode = 0;
 		BLI_strncpy(file->mode1, types[0], sizeof(file->mode1));
@@ -350,7 +717,11 @@ static void bli_adddirstrings(void)
 #ifdef WIN32
 		strcpy(file->owner, "user");
 #else
-		{
+		/* files in a directory mostly have the same owner, getpwuid() reads the user database */
+		if (num > 0 && file->s.st_uid == file[-1].s.st_uid) {
+			BLI_strncpy(file->owner, file[-1].owner, sizeof(file->owner));
+		}
+		else {
 			struct passwd *pwuser;
 			pwuser = getpwuid(file->s.st_uid);
 			if (pwuser) {
@@ -418,26 +789,40 @@ static void bli_adddirstrings(void)
 
 unsigned int BLI_dir_contents(const char *dirname,  struct direntry **filelist)
 {
-	/* reset global variables
-	 * memory stored in files is free()'d in
-	 * filesel.c:freefilelist() */
+	struct DirListing *dl = BLI_dir_listing_begin(dirname);
+	unsigned int totfile;
 
-	actnum = totnum = 0;
-	files = NULL;
+	if (!dl->exists) {
+		printf("%s non-existant directory\n", dirname);
+	}
 
-	bli_builddir(dirname, "");
-	bli_adddirstrings();
+	totfile = BLI_dir_listing_end(dl, filelist);
 
-	if (files) {
-		*(filelist) = files;
-	}
-	else {
+	if (*filelist == NULL) {
 		// keep blender happy. Blender stores this in a variable
 		// where 0 has special meaning.....
-		*(filelist) = files = malloc(sizeof(struct direntry));
+		*filelist = malloc(sizeof(struct direntry));
+	}
+
+	return totfile;
+}
+
+/* frees the result of BLI_dir_contents() or BLI_dir_listing_end() */
+void BLI_dir_contents_free(struct direntry *filelist, const unsigned int nrentries)
+{
+	unsigned int i;
+
+	for (i = 0; i < nrentries; i++) {
+		MEM_freeN(filelist[i].relname);
+		MEM_freeN(filelist[i].path);
+		if (filelist[i].string) {
+			MEM_freeN(filelist[i].string);
+		}
 	}
 
-	return(actnum);
+	if (filelist) {
+		free(filelist);
+	}
 }
 
 
@@ -0,0 +1,580 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/task.c
+ *  \ingroup bli
+ *
+ * A generic task system, see BLI_task.h.
+ *
+ * Every worker has a deque of tasks. The owner pushes and pops at the tail
+ * (most recent task first, its data is likely still in cache), idle threads
+ * steal from the head (oldest task, typically the largest piece of work left).
+ * Deques are short and only locked briefly, so a spinlock per deque is enough.
+ * Threads with nothing to do sleep on a single condition, which is signaled
+ * on push when anyone sleeps.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+typedef struct Task {
+	TaskRunFunction run;
+	void *taskdata;
+	int free_taskdata;
+	TaskPool *pool;
+} Task;
+
+typedef struct TaskDeque {
+	SpinLock lock;
+	Task **tasks;
+	/* ring buffer, head and tail only increase, tail - head is the number of tasks */
+	unsigned int head, tail, mask;
+} TaskDeque;
+
+typedef struct TaskThread {
+	TaskScheduler *scheduler;
+	int id;
+	int started;
+	pthread_t pthread;
+	TaskDeque deque;
+} TaskThread;
+
+struct TaskScheduler {
+	TaskThread *threads;
+	int num_threads;
+	pthread_key_t thread_key;  /* TaskThread of the calling worker, NULL otherwise */
+
+	ThreadMutex queue_mutex;
+	pthread_cond_t queue_cond;
+	int num_sleeping;
+	unsigned int push_next;
+	volatile int do_exit;
+};
+
+struct TaskPool {
+	TaskScheduler *scheduler;
+	void *userdata;
+	ThreadMutex user_mutex;
+
+	ThreadMutex num_mutex;
+	pthread_cond_t num_cond;
+	int num;              /* tasks pushed and not done yet */
+	unsigned int change;  /* increased on every push and finished task, wakes up waiting threads */
+	volatile int do_cancel;
+
+	int threaded_malloc;
+};
+
+/* Task */
+
+static void task_free(Task *task)
+{
+	if (task->free_taskdata)
+		MEM_freeN(task->taskdata);
+	MEM_freeN(task);
+}
+
+/* Task Deque */
+
+#define TASK_DEQUE_INIT_SIZE 64
+
+static void task_deque_init(TaskDeque *deque)
+{
+	BLI_spin_init(&deque->lock);
+	deque->tasks = MEM_mallocN(sizeof(Task *) * TASK_DEQUE_INIT_SIZE, "TaskDeque");
+	deque->head = deque->tail = 0;
+	deque->mask = TASK_DEQUE_INIT_SIZE - 1;
+}
+
+static void task_deque_push(TaskDeque *deque, Task *task)
+{
+	BLI_spin_lock(&deque->lock);
+
+	if (deque->tail - deque->head > deque->mask) {
+		/* full, double the size keeping the order */
+		unsigned int size = deque->mask + 1, a;
+		Task **tasks = MEM_mallocN(sizeof(Task *) * size * 2, "TaskDeque");
+
+		for (a = 0; a < size; a++)
+			tasks[a] = deque->tasks[(deque->head + a) & deque->mask];
+
+		MEM_freeN(deque->tasks);
+		deque->tasks = tasks;
+		deque->head = 0;
+		deque->tail = size;
+		deque->mask = size * 2 - 1;
+	}
+
+	deque->tasks[deque->tail++ & deque->mask] = task;
+
+	BLI_spin_unlock(&deque->lock);
+}
+
+static void task_deque_remove_index(TaskDeque *deque, unsigned int index)
+{
+	for (; index + 1 != deque->tail; index++)
+		deque->tasks[index & deque->mask] = deque->tasks[(index + 1) & deque->mask];
+	deque->tail--;
+}
+
+/* the owner takes from the tail, others from the head,
+ * when pool is set only tasks of that pool are taken */
+static Task *task_deque_pop(TaskDeque *deque, TaskPool *pool, int from_tail)
+{
+	Task *task = NULL;
+
+	/* unlocked test, pushes are announced through the queue condition anyway */
+	if (deque->head == deque->tail)
+		return NULL;
+
+	BLI_spin_lock(&deque->lock);
+
+	if (deque->head != deque->tail) {
+		if (pool == NULL) {
+			if (from_tail)
+				task = deque->tasks[--deque->tail & deque->mask];
+			else
+				task = deque->tasks[deque->head++ & deque->mask];
+		}
+		else {
+			unsigned int tot = deque->tail - deque->head, a, index;
+
+			for (a = 0; a < tot; a++) {
+				index = (from_tail) ? deque->tail - 1 - a : deque->head + a;
+
+				if (deque->tasks[index & deque->mask]->pool == pool) {
+					task = deque->tasks[index & deque->mask];
+					task_deque_remove_index(deque, index);
+					break;
+				}
+			}
+		}
+	}
+
+	BLI_spin_unlock(&deque->lock);
+
+	return task;
+}
+
+/* free tasks of pool that didn't start, returns the number removed */
+static int task_deque_clear_pool(TaskDeque *deque, TaskPool *pool)
+{
+	unsigned int a, tot;
+	int removed = 0;
+
+	BLI_spin_lock(&deque->lock);
+
+	tot = deque->tail - deque->head;
+	deque->tail = deque->head;
+
+	for (a = 0; a < tot; a++) {
+		Task *task = deque->tasks[(deque->head + a) & deque->mask];
+
+		if (pool == NULL || task->pool == pool) {
+			task_free(task);
+			removed++;
+		}
+		else {
+			deque->tasks[deque->tail++ & deque->mask] = task;
+		}
+	}
+
+	BLI_spin_unlock(&deque->lock);
+
+	return removed;
+}
+
+static void task_deque_free(TaskDeque *deque)
+{
+	if (task_deque_clear_pool(deque, NULL))
+		printf("%s: tasks left in a deque, pool was not freed before the scheduler\n", __func__);
+
+	MEM_freeN(deque->tasks);
+	BLI_spin_end(&deque->lock);
+}
+
+/* Task Pool counters */
+
+static void task_pool_num_change(TaskPool *pool, int num)
+{
+	BLI_mutex_lock(&pool->num_mutex);
+
+	pool->num += num;
+	pool->change++;
+
+	pthread_cond_broadcast(&pool->num_cond);
+	BLI_mutex_unlock(&pool->num_mutex);
+}
+
+static void task_run(Task *task, int threadid)
+{
+	TaskPool *pool = task->pool;
+
+	if (!pool->do_cancel)
+		task->run(pool, task->taskdata, threadid);
+
+	task_free(task);
+
+	/* last access to the pool, the waiting thread may free it after this */
+	task_pool_num_change(pool, -1);
+}
+
+/* Task Scheduler */
+
+/* own deque first, then steal from the other threads */
+static Task *task_scheduler_find(TaskScheduler *scheduler, TaskThread *thread, TaskPool *pool)
+{
+	int start = (thread) ? thread->id : 0;
+	int a;
+
+	for (a = 0; a < scheduler->num_threads; a++) {
+		TaskThread *other = &scheduler->threads[(start + a) % scheduler->num_threads];
+		Task *task = task_deque_pop(&other->deque, pool, other == thread);
+
+		if (task)
+			return task;
+	}
+
+	return NULL;
+}
+
+static Task *task_scheduler_thread_wait_pop(TaskScheduler *scheduler, TaskThread *thread)
+{
+	Task *task = task_scheduler_find(scheduler, thread, NULL);
+
+	if (task)
+		return task;
+
+	/* search again with the lock held, a push after this will signal us */
+	BLI_mutex_lock(&scheduler->queue_mutex);
+
+	while (!scheduler->do_exit && !(task = task_scheduler_find(scheduler, thread, NULL))) {
+		scheduler->num_sleeping++;
+		pthread_cond_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+		scheduler->num_sleeping--;
+	}
+
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+
+	return task;
+}
+
+static void *task_scheduler_thread_run(void *thread_p)
+{
+	TaskThread *thread = (TaskThread *)thread_p;
+	TaskScheduler *scheduler = thread->scheduler;
+	Task *task;
+
+	pthread_setspecific(scheduler->thread_key, thread);
+
+	while ((task = task_scheduler_thread_wait_pop(scheduler, thread)))
+		task_run(task, thread->id + 1);
+
+	return NULL;
+}
+
+static TaskThread *task_scheduler_thread_get(TaskScheduler *scheduler)
+{
+	return (TaskThread *)pthread_getspecific(scheduler->thread_key);
+}
+
+TaskScheduler *BLI_task_scheduler_create(int num_threads)
+{
+	TaskScheduler *scheduler = MEM_callocN(sizeof(TaskScheduler), "TaskScheduler");
+	int a;
+
+	if (num_threads == TASK_SCHEDULER_AUTO_THREADS)
+		num_threads = BLI_system_thread_count();
+
+	/* the thread waiting on a pool does work too */
+	num_threads = CLAMPIS(num_threads - 1, 1, BLENDER_MAX_THREADS - 1);
+
+	BLI_mutex_init(&scheduler->queue_mutex);
+	pthread_cond_init(&scheduler->queue_cond, NULL);
+	pthread_key_create(&scheduler->thread_key, NULL);
+
+	scheduler->num_threads = num_threads;
+	scheduler->threads = MEM_callocN(sizeof(TaskThread) * num_threads, "TaskScheduler threads");
+
+	for (a = 0; a < num_threads; a++) {
+		TaskThread *thread = &scheduler->threads[a];
+
+		thread->scheduler = scheduler;
+		thread->id = a;
+		task_deque_init(&thread->deque);
+	}
+
+	/* start after all deques exist, threads steal from each other right away */
+	for (a = 0; a < num_threads; a++) {
+		TaskThread *thread = &scheduler->threads[a];
+
+		if (pthread_create(&thread->pthread, NULL, task_scheduler_thread_run, thread) == 0)
+			thread->started = TRUE;
+		else
+			printf("ERROR: could not create task thread %d\n", a);
+	}
+
+	return scheduler;
+}
+
+void BLI_task_scheduler_free(TaskScheduler *scheduler)
+{
+	int a;
+
+	BLI_mutex_lock(&scheduler->queue_mutex);
+	scheduler->do_exit = TRUE;
+	pthread_cond_broadcast(&scheduler->queue_cond);
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+
+	for (a = 0; a < scheduler->num_threads; a++) {
+		if (scheduler->threads[a].started)
+			pthread_join(scheduler->threads[a].pthread, NULL);
+	}
+
+	for (a = 0; a < scheduler->num_threads; a++)
+		task_deque_free(&scheduler->threads[a].deque);
+
+	MEM_freeN(scheduler->threads);
+
+	pthread_key_delete(scheduler->thread_key);
+	pthread_cond_destroy(&scheduler->queue_cond);
+	BLI_mutex_end(&scheduler->queue_mutex);
+
+	MEM_freeN(scheduler);
+}
+
+int BLI_task_scheduler_num_threads(TaskScheduler *scheduler)
+{
+	return scheduler->num_threads + 1;
+}
+
+/* Task Pool */
+
+TaskPool *BLI_task_pool_create(TaskScheduler *scheduler, void *userdata)
+{
+	TaskPool *pool = MEM_callocN(sizeof(TaskPool), "TaskPool");
+
+	pool->scheduler = scheduler;
+	pool->userdata = userdata;
+
+	BLI_mutex_init(&pool->user_mutex);
+	BLI_mutex_init(&pool->num_mutex);
+	pthread_cond_init(&pool->num_cond, NULL);
+
+	/* workers only run while a pool exists that was created outside of them */
+	if (task_scheduler_thread_get(scheduler) == NULL) {
+		BLI_begin_threaded_malloc();
+		pool->threaded_malloc = TRUE;
+	}
+
+	return pool;
+}
+
+void BLI_task_pool_free(TaskPool *pool)
+{
+	BLI_task_pool_cancel(pool);
+
+	pthread_cond_destroy(&pool->num_cond);
+	BLI_mutex_end(&pool->num_mutex);
+	BLI_mutex_end(&pool->user_mutex);
+
+	if (pool->threaded_malloc)
+		BLI_end_threaded_malloc();
+
+	MEM_freeN(pool);
+}
+
+void BLI_task_pool_push(TaskPool *pool, TaskRunFunction run, void *taskdata, int free_taskdata)
+{
+	TaskScheduler *scheduler = pool->scheduler;
+	TaskThread *thread = task_scheduler_thread_get(scheduler);
+	Task *task = MEM_mallocN(sizeof(Task), "Task");
+
+	task->run = run;
+	task->taskdata = taskdata;
+	task->free_taskdata = free_taskdata;
+	task->pool = pool;
+
+	task_pool_num_change(pool, 1);
+
+	if (thread) {
+		/* workers keep their own tasks */
+		task_deque_push(&thread->deque, task);
+
+		BLI_mutex_lock(&scheduler->queue_mutex);
+	}
+	else {
+		/* spread over the workers, they steal from each other when unbalanced */
+		BLI_mutex_lock(&scheduler->queue_mutex);
+
+		thread = &scheduler->threads[scheduler->push_next++ % scheduler->num_threads];
+		task_deque_push(&thread->deque, task);
+	}
+
+	if (scheduler->num_sleeping)
+		pthread_cond_signal(&scheduler->queue_cond);
+
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+}
+
+void BLI_task_pool_work_and_wait(TaskPool *pool)
+{
+	TaskScheduler *scheduler = pool->scheduler;
+	TaskThread *thread = task_scheduler_thread_get(scheduler);
+	int threadid = (thread) ? thread->id + 1 : 0;
+	unsigned int change;
+	Task *task;
+
+	BLI_mutex_lock(&pool->num_mutex);
+
+	while (pool->num != 0) {
+		change = pool->change;
+		BLI_mutex_unlock(&pool->num_mutex);
+
+		/* only run tasks of this pool, other pools may not expect this thread */
+		task = task_scheduler_find(scheduler, thread, pool);
+
+		if (task) {
+			task_run(task, threadid);
+			BLI_mutex_lock(&pool->num_mutex);
+		}
+		else {
+			/* all remaining tasks are running, wait for one to finish or push more work */
+			BLI_mutex_lock(&pool->num_mutex);
+
+			while (pool->change == change)
+				pthread_cond_wait(&pool->num_cond, &pool->num_mutex);
+		}
+	}
+
+	BLI_mutex_unlock(&pool->num_mutex);
+}
+
+void BLI_task_pool_cancel(TaskPool *pool)
+{
+	TaskScheduler *scheduler = pool->scheduler;
+	int a, removed = 0;
+
+	pool->do_cancel = TRUE;
+
+	for (a = 0; a < scheduler->num_threads; a++)
+		removed += task_deque_clear_pool(&scheduler->threads[a].deque, pool);
+
+	/* wait for running tasks, tasks they push are skipped in task_run() */
+	BLI_mutex_lock(&pool->num_mutex);
+
+	pool->num -= removed;
+	pool->change++;
+
+	while (pool->num != 0)
+		pthread_cond_wait(&pool->num_cond, &pool->num_mutex);
+
+	BLI_mutex_unlock(&pool->num_mutex);
+
+	pool->do_cancel = FALSE;
+}
+
+int BLI_task_pool_canceled(TaskPool *pool)
+{
+	return pool->do_cancel;
+}
+
+void *BLI_task_pool_userdata(TaskPool *pool)
+{
+	return pool->userdata;
+}
+
+ThreadMutex *BLI_task_pool_user_mutex(TaskPool *pool)
+{
+	return &pool->user_mutex;
+}
+
+/* Parallel Range */
+
+typedef struct ParallelRangeState {
+	void *userdata;
+	TaskParallelRangeFunc func;
+} ParallelRangeState;
+
+typedef struct ParallelRangeChunk {
+	int start, stop;
+} ParallelRangeChunk;
+
+static void parallel_range_func(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	ParallelRangeState *state = BLI_task_pool_userdata(pool);
+	ParallelRangeChunk *chunk = taskdata;
+	int i;
+
+	for (i = chunk->start; i < chunk->stop; i++)
+		state->func(state->userdata, i);
+}
+
+void BLI_task_parallel_range(int start, int stop, void *userdata,
+                             TaskParallelRangeFunc func, int min_iter_per_chunk)
+{
+	TaskScheduler *scheduler;
+	TaskPool *pool;
+	ParallelRangeState state;
+	ParallelRangeChunk *chunks;
+	int num_threads, chunk_size, tot_chunk, a, i;
+
+	if (min_iter_per_chunk < 1)
+		min_iter_per_chunk = 1;
+
+	if (stop - start < min_iter_per_chunk * 2) {
+		for (i = start; i < stop; i++)
+			func(userdata, i);
+		return;
+	}
+
+	scheduler = BLI_task_scheduler_get();
+	num_threads = BLI_task_scheduler_num_threads(scheduler);
+
+	/* a few chunks per thread, so threads finishing early can steal the rest */
+	chunk_size = max_ii((stop - start) / (num_threads * 4), min_iter_per_chunk);
+	tot_chunk = (stop - start + chunk_size - 1) / chunk_size;
+
+	state.userdata = userdata;
+	state.func = func;
+
+	chunks = MEM_mallocN(sizeof(ParallelRangeChunk) * tot_chunk, "ParallelRangeChunk");
+	pool = BLI_task_pool_create(scheduler, &state);
+
+	for (a = 0, i = start; a < tot_chunk; a++, i += chunk_size) {
+		chunks[a].start = i;
+		chunks[a].stop = min_ii(i + chunk_size, stop);
+		BLI_task_pool_push(pool, parallel_range_func, &chunks[a], FALSE);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	MEM_freeN(chunks);
+}
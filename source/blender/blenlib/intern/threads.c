@@ -38,6 +38,7 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_gsqueue.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "PIL_time.h"
@@ -114,8 +115,11 @@ static pthread_mutex_t _opengl_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _nodes_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _movieclip_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t _colormanage_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t _task_scheduler_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t _thread_levels_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t mainid;
-static int thread_levels = 0;  /* threads can be invoked inside threads */
+static TaskScheduler *task_scheduler = NULL;
+static int thread_levels = 0;  /* threads can be invoked inside threads, locked by _thread_levels_lock */
 
 /* just a max for security reasons */
 #define RE_MAX_THREAD BLENDER_MAX_THREADS
@@ -143,6 +147,26 @@ void BLI_threadapi_init(void)
 	mainid = pthread_self();
 }
 
+void BLI_threadapi_exit(void)
+{
+	if (task_scheduler) {
+		BLI_task_scheduler_free(task_scheduler);
+		task_scheduler = NULL;
+	}
+}
+
+TaskScheduler *BLI_task_scheduler_get(void)
+{
+	/* created on first use, so tools that never run tasks don't start threads */
+	pthread_mutex_lock(&_task_scheduler_lock);
+	if (task_scheduler == NULL) {
+		task_scheduler = BLI_task_scheduler_create(TASK_SCHEDULER_AUTO_THREADS);
+	}
+	pthread_mutex_unlock(&_task_scheduler_lock);
+
+	return task_scheduler;
+}
+
 /* tot = 0 only initializes malloc mutex in a safe way (see sequence.c)
  * problem otherwise: scene render will kill of the mutex!
  */
@@ -165,6 +189,7 @@ void BLI_init_threads(ListBase *threadbase, void *(*do_thread)(void *), int tot)
 		}
 	}
 	
+	pthread_mutex_lock(&_thread_levels_lock);
 	if (thread_levels == 0) {
 		MEM_set_lock_callback(BLI_lock_malloc_thread, BLI_unlock_malloc_thread);
 
@@ -177,6 +202,7 @@ void BLI_init_threads(ListBase *threadbase, void *(*do_thread)(void *), int tot)
 	}
 
 	thread_levels++;
+	pthread_mutex_unlock(&_thread_levels_lock);
 }
 
 /* amount of available threads */
@@ -295,9 +321,11 @@ void BLI_end_threads(ListBase *threadbase)
 		BLI_freelistN(threadbase);
 	}
 
+	pthread_mutex_lock(&_thread_levels_lock);
 	thread_levels--;
 	if (thread_levels == 0)
 		MEM_set_lock_callback(NULL, NULL);
+	pthread_mutex_unlock(&_thread_levels_lock);
 }
 
 /* System Information */
@@ -727,18 +755,24 @@ void BLI_thread_queue_wait_finish(ThreadQueue *queue)
 
 /* ************************************************ */
 
+/* called from any thread by task pools, the level is changed under a lock
+ * so the lock callback is always set while a level is held */
 void BLI_begin_threaded_malloc(void)
 {
+	pthread_mutex_lock(&_thread_levels_lock);
 	if (thread_levels == 0) {
 		MEM_set_lock_callback(BLI_lock_malloc_thread, BLI_unlock_malloc_thread);
 	}
 	thread_levels++;
+	pthread_mutex_unlock(&_thread_levels_lock);
 }
 
 void BLI_end_threaded_malloc(void)
 {
+	pthread_mutex_lock(&_thread_levels_lock);
 	thread_levels--;
 	if (thread_levels == 0)
 		MEM_set_lock_callback(NULL, NULL);
+	pthread_mutex_unlock(&_thread_levels_lock);
 }
 
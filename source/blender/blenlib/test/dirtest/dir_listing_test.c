@@ -0,0 +1,219 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/**
+ * Checks the directory listing of storage.c: the asynchronous API returns the
+ * same entries as BLI_dir_contents(), stat'ed ones only, and a cancelled listing
+ * frees everything. A file written in place, which doesn't change the time of
+ * the directory, must show its new size in the next (cached) listing.
+ *
+ * Build from the blenlib directory, against the libraries of a build (unix only):
+ *
+ *   cc -O2 -I. -I../makesdna -I../../../intern/guardedalloc \
+ *       test/dirtest/dir_listing_test.c \
+ *       $BUILD/lib/libbf_blenlib.a $BUILD/lib/libbf_intern_guardedalloc.a \
+ *       -lpthread -lm -o dir_listing_test
+ *   ./dir_listing_test 1000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+
+#include "PIL_time.h"
+
+static int num_files = 1000;
+static int result_error = 0;
+
+static void check(const char *what, int ok)
+{
+	if (!ok) {
+		printf("  Error: %s\n", what);
+		result_error = 1;
+	}
+}
+
+static void write_file(const char *dir, const int index, const int size)
+{
+	char name[32], path[FILE_MAX];
+	FILE *fp;
+
+	BLI_snprintf(name, sizeof(name), "file%05d", index);
+	BLI_join_dirfile(path, sizeof(path), dir, name);
+
+	fp = fopen(path, "wb");
+	if (fp == NULL) {
+		printf("Couldn't write %s\n", path);
+		exit(1);
+	}
+	if (size > 0) {
+		fseek(fp, size - 1, SEEK_SET);
+		fputc(0, fp);
+	}
+	fclose(fp);
+}
+
+/* an old time, so the listing isn't considered to be read while the directory changes */
+static void set_old_mtime(const char *dir)
+{
+	struct utimbuf times;
+
+	times.actime = times.modtime = time(NULL) - 60;
+	utime(dir, &times);
+}
+
+static int file_size(struct direntry *files, const unsigned int totfile, const int index)
+{
+	char name[32];
+	unsigned int i;
+
+	BLI_snprintf(name, sizeof(name), "file%05d", index);
+
+	for (i = 0; i < totfile; i++) {
+		if (strcmp(files[i].relname, name) == 0) {
+			return (int)files[i].s.st_size;
+		}
+	}
+
+	return -1;
+}
+
+static void test_async(const char *dir)
+{
+	struct DirListing *dl;
+	struct direntry *files;
+	unsigned int totready, totfile, i;
+	int ok = TRUE;
+
+	printf("async listing\n");
+
+	dl = BLI_dir_listing_begin(dir);
+	do {
+		totready = BLI_dir_listing_ready(dl, &files, &totfile);
+
+		/* the ready entries must be stat'ed */
+		for (i = 0; i < totready; i++) {
+			if (files[i].relname[0] == 'f' && files[i].s.st_size != atoi(files[i].relname + 4)) {
+				ok = FALSE;
+			}
+		}
+	} while (totready < totfile);
+	check("ready entries aren't stat'ed", ok);
+
+	/* the file entries, '.' and '..' */
+	check("ready count differs", totfile == (unsigned int)num_files + 2);
+
+	/* directories first, then the files by name */
+	totfile = BLI_dir_listing_end(dl, &files);
+	check("end count differs", totfile == (unsigned int)num_files + 2);
+	ok = (strcmp(files[0].relname, ".") == 0 && strcmp(files[1].relname, "..") == 0);
+	for (i = 2; i < totfile; i++) {
+		char name[32];
+
+		BLI_snprintf(name, sizeof(name), "file%05d", (int)i - 2);
+		if (strcmp(files[i].relname, name) != 0) {
+			ok = FALSE;
+		}
+	}
+	check("end entries aren't sorted", ok);
+	BLI_dir_contents_free(files, totfile);
+
+	/* cancelling while the entries are stat'ed */
+	BLI_dir_listing_cancel(BLI_dir_listing_begin(dir));
+}
+
+static void test_cache(const char *dir)
+{
+	struct direntry *files;
+	unsigned int totfile;
+	double time;
+
+	printf("cached listing\n");
+
+	time = PIL_check_seconds_timer();
+	totfile = BLI_dir_contents(dir, &files);
+	printf("  first listing  %8.3f ms\n", (PIL_check_seconds_timer() - time) * 1000.0);
+	check("size of file00003 differs", file_size(files, totfile, 3) == 3);
+	BLI_dir_contents_free(files, totfile);
+
+	/* doesn't change the time of the directory */
+	write_file(dir, 3, 12345);
+
+	time = PIL_check_seconds_timer();
+	totfile = BLI_dir_contents(dir, &files);
+	printf("  cached listing %8.3f ms\n", (PIL_check_seconds_timer() - time) * 1000.0);
+	check("size of a file written in place is outdated", file_size(files, totfile, 3) == 12345);
+	BLI_dir_contents_free(files, totfile);
+
+	/* a new file changes the time */
+	write_file(dir, num_files, 7);
+	totfile = BLI_dir_contents(dir, &files);
+	check("new file is missing", file_size(files, totfile, num_files) == 7);
+	BLI_dir_contents_free(files, totfile);
+}
+
+int main(int argc, char *argv[])
+{
+	char dir[] = "/tmp/dir_listing_test_XXXXXX";
+	int i;
+
+	if (argc > 1)
+		num_files = atoi(argv[1]);
+	if (num_files < 8)
+		num_files = 1000;
+
+	BLI_threadapi_init();
+
+	if (mkdtemp(dir) == NULL) {
+		printf("Couldn't create a directory in /tmp\n");
+		return 1;
+	}
+
+	/* file names contain the size, so the entries can be checked */
+	for (i = 0; i < num_files; i++) {
+		write_file(dir, i, i);
+	}
+	set_old_mtime(dir);
+
+	printf("%d files in %s\n", num_files, dir);
+
+	test_async(dir);
+	test_cache(dir);
+
+	BLI_dir_cache_free();
+	BLI_threadapi_exit();
+	BLI_delete(dir, TRUE, TRUE);
+
+	return result_error;
+}
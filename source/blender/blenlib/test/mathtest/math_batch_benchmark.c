@@ -0,0 +1,188 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/**
+ * Compares the array functions of math_batch.c with loops over the regular
+ * functions: transforming vectors by a matrix and normalizing vectors. Also
+ * checks the results match, including sizes that are not a multiple of four
+ * and zero length vectors.
+ *
+ * Build from the blenlib directory, against the libraries of a build:
+ *
+ *   cc -O2 -I. -I../makesdna -I../../../intern/guardedalloc \
+ *       test/mathtest/math_batch_benchmark.c \
+ *       $BUILD/lib/libbf_blenlib.a $BUILD/lib/libbf_intern_guardedalloc.a \
+ *       -lpthread -lm -o math_batch_benchmark
+ *   ./math_batch_benchmark 1000000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+
+#include "PIL_time.h"
+
+#define NUM_RUNS 20
+
+static int num_vecs = 1000000;
+static int result_error = 0;
+
+static void print_time(const char *what, double time_scalar, double time_array)
+{
+	printf("  %-22s %8.2f ns/vec  %8.2f ns/vec  (%.2fx)\n", what,
+	       time_scalar * 1e9 / ((double)num_vecs * NUM_RUNS),
+	       time_array * 1e9 / ((double)num_vecs * NUM_RUNS),
+	       time_scalar / time_array);
+}
+
+static void check_error(const char *what, const float *a, const float *b, const int len, const float limit)
+{
+	float max_error = 0.0f;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		max_error = max_ff(max_error, fabsf(a[i] - b[i]));
+	}
+
+	if (max_error > limit) {
+		printf("  Error: %s differs by %g\n", what, max_error);
+		result_error = 1;
+	}
+}
+
+static void vecs_random(float (*vecs)[3], const int len, const int seed)
+{
+	RNG *rng = BLI_rng_new(seed);
+	int i;
+
+	for (i = 0; i < len; i++) {
+		vecs[i][0] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+		vecs[i][1] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+		vecs[i][2] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+	}
+
+	BLI_rng_free(rng);
+}
+
+static void bench_transform(float (*src)[3], float (*a)[3], float (*b)[3])
+{
+	const float loc[3] = {1.0f, 2.0f, 3.0f};
+	const float eul[3] = {0.3f, 0.7f, 1.1f};
+	const float size[3] = {1.5f, 0.5f, 2.0f};
+	float mat[4][4];
+	double time, time_scalar, time_array;
+	int i, run, len;
+
+	loc_eulO_size_to_mat4(mat, loc, eul, size, EULER_ORDER_XYZ);
+
+	time = PIL_check_seconds_timer();
+	for (run = 0; run < NUM_RUNS; run++) {
+		memcpy(a, src, sizeof(*a) * num_vecs);
+		for (i = 0; i < num_vecs; i++) {
+			mul_m4_v3(mat, a[i]);
+		}
+	}
+	time_scalar = PIL_check_seconds_timer() - time;
+
+	time = PIL_check_seconds_timer();
+	for (run = 0; run < NUM_RUNS; run++) {
+		memcpy(b, src, sizeof(*b) * num_vecs);
+		mul_m4_v3_array(mat, b, num_vecs);
+	}
+	time_array = PIL_check_seconds_timer() - time;
+
+	print_time("mul_m4_v3", time_scalar, time_array);
+	check_error("mul_m4_v3_array", a[0], b[0], num_vecs * 3, 1e-5f);
+
+	/* separate output and the remainder loop */
+	for (len = 0; len < 8 && len <= num_vecs; len++) {
+		memset(b, 0, sizeof(*b) * 8);
+		mul_v3_m4v3_array(b, mat, (const float (*)[3])src, len);
+		for (i = 0; i < len; i++) {
+			mul_v3_m4v3(a[i], mat, src[i]);
+		}
+		check_error("mul_v3_m4v3_array", a[0], b[0], len * 3, 1e-5f);
+	}
+}
+
+static void bench_normalize(float (*src)[3], float (*a)[3], float (*b)[3])
+{
+	double time, time_scalar, time_array;
+	int i, run;
+
+	/* zero length vectors stay zero */
+	for (i = 0; i < num_vecs; i += 7) {
+		zero_v3(src[i]);
+	}
+
+	time = PIL_check_seconds_timer();
+	for (run = 0; run < NUM_RUNS; run++) {
+		memcpy(a, src, sizeof(*a) * num_vecs);
+		for (i = 0; i < num_vecs; i++) {
+			normalize_v3(a[i]);
+		}
+	}
+	time_scalar = PIL_check_seconds_timer() - time;
+
+	time = PIL_check_seconds_timer();
+	for (run = 0; run < NUM_RUNS; run++) {
+		memcpy(b, src, sizeof(*b) * num_vecs);
+		normalize_v3_array(b, num_vecs);
+	}
+	time_array = PIL_check_seconds_timer() - time;
+
+	print_time("normalize_v3", time_scalar, time_array);
+	check_error("normalize_v3_array", a[0], b[0], num_vecs * 3, 1e-6f);
+}
+
+int main(int argc, char *argv[])
+{
+	float (*src)[3], (*a)[3], (*b)[3];
+
+	if (argc > 1)
+		num_vecs = atoi(argv[1]);
+	if (num_vecs < 8)
+		num_vecs = 1000000;
+
+	src = MEM_mallocN(sizeof(*src) * num_vecs, "src");
+	a = MEM_mallocN(sizeof(*a) * num_vecs, "a");
+	b = MEM_mallocN(sizeof(*b) * num_vecs, "b");
+
+	vecs_random(src, num_vecs, 1);
+
+	printf("%d vectors, %d runs                 regular        array\n", num_vecs, NUM_RUNS);
+
+	bench_transform(src, a, b);
+	bench_normalize(src, a, b);
+
+	MEM_freeN(src);
+	MEM_freeN(a);
+	MEM_freeN(b);
+
+	return result_error;
+}
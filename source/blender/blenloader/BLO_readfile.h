@@ -192,6 +192,20 @@ BLO_blendhandle_close(BlendHandle *bh);
 	
 /***/
 
+/**
+ * Sequential reading of a blend file from the start, for code that only
+ * needs the first blocks, like thumbnails. Reads plain and gzip files,
+ * and LZO/LZMA framed files starting with 'BLENDZ'.
+ */
+typedef struct BlendFileReader BlendFileReader;
+
+BlendFileReader *BLO_file_reader_open(const char *filepath);
+int BLO_file_reader_read(BlendFileReader *reader, void *buffer, unsigned int size);
+int BLO_file_reader_skip(BlendFileReader *reader, unsigned int size);
+void BLO_file_reader_close(BlendFileReader *reader);
+
+/***/
+
 #define GROUP_MAX 32
 
 int BLO_has_bfile_extension(const char *str);
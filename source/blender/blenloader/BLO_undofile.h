@@ -33,25 +33,43 @@
  *  \ingroup blenloader
  */
 
+struct MemFileShared;
+
 typedef struct {
 	void *next, *prev;
 	
 	char *buf;
-	unsigned int ident, size;
+	unsigned int size;
+	struct MemFileShared *shared;  /* refcounted buffer, shared between all memfiles */
 	
 } MemFileChunk;
 
 typedef struct MemFile {
 	ListBase chunks;
-	unsigned int size;
+	unsigned int size;  /* memory newly allocated for this file, shared chunks not counted */
 } MemFile;
 
+/* totals over all memfiles, see BLO_memfile_stats() */
+typedef struct MemFileStats {
+	size_t mem_shared;        /* memory of all unique chunk buffers */
+	size_t mem_referenced;    /* memory all memfiles would use without sharing */
+	unsigned int tot_shared;  /* number of unique chunk buffers */
+	unsigned int tot_chunks;  /* number of chunks in all memfiles */
+
+	/* chunks added since the last BLO_memfile_stats_reset() */
+	unsigned int hit_position;  /* equal to the chunk at the same position of the previous file */
+	unsigned int hit_hash;      /* found elsewhere in the pool by content hash */
+	unsigned int miss;          /* new buffer allocated */
+} MemFileStats;
+
 /* actually only used writefile.c */
 extern void add_memfilechunk(MemFile *compare, MemFile *current, const char *buf, unsigned int size);
 
 /* exports */
 extern void BLO_free_memfile(MemFile *memfile);
 extern void BLO_merge_memfile(MemFile *first, MemFile *second);
+extern void BLO_memfile_stats(MemFileStats *stats);
+extern void BLO_memfile_stats_reset(void);
 
 #endif
 
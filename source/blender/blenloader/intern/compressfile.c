@@ -0,0 +1,760 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ * framed compression of .blend files
+ */
+
+/** \file blender/blenloader/intern/compressfile.c
+ *  \ingroup blenloader
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "zlib.h"
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#ifdef WITH_LZO
+#  include "minilzo.h"
+#  define LZO_OUT_LEN(size)     ((size) + (size) / 16 + 64 + 3)
+#endif
+
+#ifdef WITH_LZMA
+#  include "LzmaLib.h"
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_listBase.h"
+
+#include "BLI_blenlib.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "compressfile.h"
+
+/* gzip member with a 'BL' extra field, see write_gzip_header() */
+#define GZ_HEADER_SIZE      20
+#define GZ_TRAILER_SIZE     8
+
+#define FRAME_HEADER_SIZE   12
+
+/* ************************ helpers ************************ */
+
+#ifdef WITH_LZO
+/* lzo_init() checks the library was built for this platform, it must
+ * succeed once before any (de)compression */
+static ThreadMutex lzo_init_mutex = BLI_MUTEX_INITIALIZER;
+static int lzo_init_state = 0;  /* 0: not called yet, 1: ok, -1: failed */
+
+static int compress_lzo_init(void)
+{
+	BLI_mutex_lock(&lzo_init_mutex);
+	if (lzo_init_state == 0) {
+		lzo_init_state = (lzo_init() == LZO_E_OK) ? 1 : -1;
+		if (lzo_init_state == -1)
+			printf("Failed to initialize LZO, LZO compressed files can't be read or written\n");
+	}
+	BLI_mutex_unlock(&lzo_init_mutex);
+
+	return (lzo_init_state == 1);
+}
+#endif
+
+static void put_le32(unsigned char *p, unsigned int v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+static unsigned int get_le32(const unsigned char *p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned int get_le16(const unsigned char *p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+}
+
+static void write_gzip_header(unsigned char *out, unsigned int member_size)
+{
+	static const unsigned char header[GZ_HEADER_SIZE - 4] = {
+		0x1f, 0x8b, 8,     /* magic, deflate */
+		4,                 /* FEXTRA */
+		0, 0, 0, 0,        /* mtime */
+		0, 255,            /* xfl, os unknown */
+		8, 0,              /* XLEN */
+		'B', 'L', 4, 0     /* subfield id and length */
+	};
+
+	memcpy(out, header, sizeof(header));
+	put_le32(out + GZ_HEADER_SIZE - 4, member_size);
+}
+
+/* returns the size of the gzip member at mem when it has our 'BL' extra field, else zero */
+static size_t gzip_frame_size(const unsigned char *mem, size_t size)
+{
+	size_t member_size;
+
+	if (size < GZ_HEADER_SIZE + GZ_TRAILER_SIZE)
+		return 0;
+
+	if (mem[0] != 0x1f || mem[1] != 0x8b || mem[2] != 8 || (mem[3] & 4) == 0)
+		return 0;
+
+	if (get_le16(mem + 10) != 8 || mem[12] != 'B' || mem[13] != 'L' || get_le16(mem + 14) != 4)
+		return 0;
+
+	member_size = get_le32(mem + 16);
+	if (member_size < GZ_HEADER_SIZE + GZ_TRAILER_SIZE || member_size > size)
+		return 0;
+
+	return member_size;
+}
+
+static void write_frame_header(unsigned char *out, int codec, unsigned int clen, unsigned int ulen)
+{
+	out[0] = (unsigned char)codec;
+	out[1] = out[2] = out[3] = 0;
+	put_le32(out + 4, clen);
+	put_le32(out + 8, ulen);
+}
+
+static int read_full(int file, void *buffer, unsigned int size)
+{
+	unsigned int totread = 0;
+
+	while (totread < size) {
+		int readsize = read(file, (char *)buffer + totread, size - totread);
+		if (readsize <= 0)
+			break;
+		totread += readsize;
+	}
+
+	return (int)totread;
+}
+
+/* ************************ frame compression ************************ */
+
+typedef struct WriteFrame {
+	struct WriteFrame *next, *prev;
+	int codec;
+	int error;
+
+	unsigned char *in;
+	unsigned int in_len;
+
+	unsigned char *out;     /* including the frame or gzip header */
+	unsigned int out_len;
+} WriteFrame;
+
+static void frame_store(WriteFrame *frame)
+{
+	if (frame->out)
+		MEM_freeN(frame->out);
+
+	frame->out = MEM_mallocN(FRAME_HEADER_SIZE + frame->in_len, "frame store");
+	write_frame_header(frame->out, BLO_CODEC_STORE, frame->in_len, frame->in_len);
+	memcpy(frame->out + FRAME_HEADER_SIZE, frame->in, frame->in_len);
+	frame->out_len = FRAME_HEADER_SIZE + frame->in_len;
+}
+
+static void frame_deflate(WriteFrame *frame)
+{
+	z_stream strm;
+	unsigned int bound, clen;
+
+	memset(&strm, 0, sizeof(strm));
+
+	/* level 1, see BLI_file_gzip() */
+	if (deflateInit2(&strm, 1, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		frame->error = 1;
+		return;
+	}
+
+	bound = deflateBound(&strm, frame->in_len);
+	frame->out = MEM_mallocN(GZ_HEADER_SIZE + bound + GZ_TRAILER_SIZE, "frame deflate");
+
+	strm.next_in = frame->in;
+	strm.avail_in = frame->in_len;
+	strm.next_out = frame->out + GZ_HEADER_SIZE;
+	strm.avail_out = bound;
+
+	if (deflate(&strm, Z_FINISH) != Z_STREAM_END) {
+		frame->error = 1;
+	}
+	clen = (unsigned int)strm.total_out;
+	deflateEnd(&strm);
+
+	frame->out_len = GZ_HEADER_SIZE + clen + GZ_TRAILER_SIZE;
+	write_gzip_header(frame->out, frame->out_len);
+	put_le32(frame->out + GZ_HEADER_SIZE + clen, (unsigned int)crc32(0, frame->in, frame->in_len));
+	put_le32(frame->out + GZ_HEADER_SIZE + clen + 4, frame->in_len);
+}
+
+#ifdef WITH_LZO
+static void frame_lzo(WriteFrame *frame)
+{
+	lzo_voidp wrkmem = MEM_mallocN(LZO1X_1_MEM_COMPRESS, "frame lzo wrkmem");
+	lzo_uint out_len = LZO_OUT_LEN(frame->in_len);
+	int r;
+
+	frame->out = MEM_mallocN(FRAME_HEADER_SIZE + out_len, "frame lzo");
+
+	r = lzo1x_1_compress(frame->in, frame->in_len, frame->out + FRAME_HEADER_SIZE, &out_len, wrkmem);
+	MEM_freeN(wrkmem);
+
+	if (r != LZO_E_OK || out_len >= frame->in_len) {
+		frame_store(frame);
+	}
+	else {
+		write_frame_header(frame->out, BLO_CODEC_LZO, (unsigned int)out_len, frame->in_len);
+		frame->out_len = FRAME_HEADER_SIZE + (unsigned int)out_len;
+	}
+}
+#endif
+
+#ifdef WITH_LZMA
+static void frame_lzma(WriteFrame *frame)
+{
+	size_t out_len = frame->in_len;  /* when it doesn't fit storing is better anyway */
+	size_t props_len = LZMA_PROPS_SIZE;
+	unsigned char *props;
+	int r;
+
+	frame->out = MEM_mallocN(FRAME_HEADER_SIZE + LZMA_PROPS_SIZE + out_len, "frame lzma");
+	props = frame->out + FRAME_HEADER_SIZE;
+
+	/* dictionary doesn't need to be larger than a frame, single threaded
+	 * since frames are already compressed in parallel */
+	r = LzmaCompress(props + LZMA_PROPS_SIZE, &out_len, frame->in, frame->in_len,
+	                 props, &props_len, 5, BLO_FRAME_SIZE, 3, 0, 2, 32, 1);
+
+	if (r != SZ_OK || props_len != LZMA_PROPS_SIZE || out_len + LZMA_PROPS_SIZE >= frame->in_len) {
+		frame_store(frame);
+	}
+	else {
+		write_frame_header(frame->out, BLO_CODEC_LZMA, LZMA_PROPS_SIZE + (unsigned int)out_len, frame->in_len);
+		frame->out_len = FRAME_HEADER_SIZE + LZMA_PROPS_SIZE + (unsigned int)out_len;
+	}
+}
+#endif
+
+static void *compress_frame_thread(void *frame_v)
+{
+	WriteFrame *frame = frame_v;
+
+	switch (frame->codec) {
+#ifdef WITH_LZO
+		case BLO_CODEC_LZO:
+			frame_lzo(frame);
+			break;
+#endif
+#ifdef WITH_LZMA
+		case BLO_CODEC_LZMA:
+			frame_lzma(frame);
+			break;
+#endif
+		case BLO_CODEC_DEFLATE:
+			frame_deflate(frame);
+			break;
+		default:
+			frame_store(frame);
+			break;
+	}
+
+	return NULL;
+}
+
+static void frame_free(WriteFrame *frame)
+{
+	if (frame->in)
+		MEM_freeN(frame->in);
+	if (frame->out)
+		MEM_freeN(frame->out);
+	MEM_freeN(frame);
+}
+
+/* ************************ writing ************************ */
+
+typedef struct CompressWriter {
+	int file;
+	int codec;
+	int error;
+
+	WriteFrame *frame;  /* being filled */
+
+	ListBase threads;
+	ListBase queue;     /* frames being compressed, in file order */
+} CompressWriter;
+
+CompressWriter *blo_compress_writer_new(int file, int codec)
+{
+	CompressWriter *cw = MEM_callocN(sizeof(CompressWriter), "CompressWriter");
+
+#ifdef WITH_LZO
+	if (codec == BLO_CODEC_LZO && !compress_lzo_init()) codec = BLO_CODEC_DEFLATE;
+#else
+	if (codec == BLO_CODEC_LZO) codec = BLO_CODEC_DEFLATE;
+#endif
+#ifndef WITH_LZMA
+	if (codec == BLO_CODEC_LZMA) codec = BLO_CODEC_DEFLATE;
+#endif
+
+	cw->file = file;
+	cw->codec = codec;
+
+	/* compress on all cores, the caller only fills frames and
+	 * waits when they come in faster than they compress */
+	BLI_init_threads(&cw->threads, compress_frame_thread, BLI_system_thread_count());
+
+	if (codec != BLO_CODEC_DEFLATE) {
+		if (write(file, BLO_FRAMES_MAGIC, BLO_FRAMES_MAGIC_LEN) != BLO_FRAMES_MAGIC_LEN)
+			cw->error = 1;
+	}
+
+	return cw;
+}
+
+/* join the oldest frame and write it out, keeps frames in order */
+static void compress_writer_write_first(CompressWriter *cw)
+{
+	WriteFrame *frame = cw->queue.first;
+
+	BLI_remove_thread(&cw->threads, frame);
+
+	if (!cw->error) {
+		if (frame->error || write(cw->file, frame->out, frame->out_len) != (int)frame->out_len)
+			cw->error = 1;
+	}
+
+	BLI_remlink(&cw->queue, frame);
+	frame_free(frame);
+}
+
+static void compress_writer_push(CompressWriter *cw)
+{
+	WriteFrame *frame = cw->frame;
+
+	cw->frame = NULL;
+
+	while (BLI_available_threads(&cw->threads) == 0) {
+		compress_writer_write_first(cw);
+	}
+
+	BLI_addtail(&cw->queue, frame);
+	BLI_insert_thread(&cw->threads, frame);
+}
+
+void blo_compress_writer_write(CompressWriter *cw, const void *mem, unsigned int memlen)
+{
+	const unsigned char *cmem = mem;
+
+	while (memlen && !cw->error) {
+		WriteFrame *frame = cw->frame;
+		unsigned int len;
+
+		if (frame == NULL) {
+			frame = cw->frame = MEM_callocN(sizeof(WriteFrame), "WriteFrame");
+			frame->codec = cw->codec;
+			frame->in = MEM_mallocN(BLO_FRAME_SIZE, "WriteFrame in");
+		}
+
+		len = MIN2(memlen, BLO_FRAME_SIZE - frame->in_len);
+		memcpy(frame->in + frame->in_len, cmem, len);
+		frame->in_len += len;
+		cmem += len;
+		memlen -= len;
+
+		if (frame->in_len == BLO_FRAME_SIZE) {
+			compress_writer_push(cw);
+		}
+	}
+}
+
+/* returns 1 if writing failed */
+int blo_compress_writer_end(CompressWriter *cw)
+{
+	int err;
+
+	if (cw->frame) {
+		if (cw->frame->in_len && !cw->error) {
+			compress_writer_push(cw);
+		}
+		else {
+			frame_free(cw->frame);
+			cw->frame = NULL;
+		}
+	}
+
+	while (cw->queue.first) {
+		compress_writer_write_first(cw);
+	}
+
+	BLI_end_threads(&cw->threads);
+
+	if (cw->codec != BLO_CODEC_DEFLATE && !cw->error) {
+		unsigned char end[FRAME_HEADER_SIZE];
+
+		write_frame_header(end, BLO_CODEC_STORE, 0, 0);
+		if (write(cw->file, end, sizeof(end)) != sizeof(end))
+			cw->error = 1;
+	}
+
+	err = cw->error;
+	MEM_freeN(cw);
+
+	return err;
+}
+
+/* ************************ frame decompression ************************ */
+
+typedef struct ReadFrame {
+	int codec;
+	const unsigned char *in;
+	unsigned int in_len;
+	unsigned int crc;       /* gzip only */
+	char *out;
+	unsigned int out_len;
+} ReadFrame;
+
+static int frame_decompress(const ReadFrame *rf)
+{
+	switch (rf->codec) {
+		case BLO_CODEC_STORE:
+			if (rf->in_len != rf->out_len)
+				return 0;
+			memcpy(rf->out, rf->in, rf->out_len);
+			return 1;
+		case BLO_CODEC_DEFLATE:
+		{
+			z_stream strm;
+			int ok;
+
+			memset(&strm, 0, sizeof(strm));
+			if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+				return 0;
+
+			strm.next_in = (unsigned char *)rf->in;
+			strm.avail_in = rf->in_len;
+			strm.next_out = (unsigned char *)rf->out;
+			strm.avail_out = rf->out_len;
+
+			ok = (inflate(&strm, Z_FINISH) == Z_STREAM_END) && (strm.total_out == rf->out_len);
+			inflateEnd(&strm);
+
+			return ok && ((unsigned int)crc32(0, (unsigned char *)rf->out, rf->out_len) == rf->crc);
+		}
+#ifdef WITH_LZO
+		case BLO_CODEC_LZO:
+		{
+			lzo_uint out_len = rf->out_len;
+			int r;
+
+			if (!compress_lzo_init())
+				return 0;
+
+			r = lzo1x_decompress_safe(rf->in, rf->in_len, (unsigned char *)rf->out, &out_len, NULL);
+			return (r == LZO_E_OK) && (out_len == rf->out_len);
+		}
+#endif
+#ifdef WITH_LZMA
+		case BLO_CODEC_LZMA:
+		{
+			size_t in_len, out_len = rf->out_len;
+			int r;
+
+			if (rf->in_len < LZMA_PROPS_SIZE)
+				return 0;
+
+			in_len = rf->in_len - LZMA_PROPS_SIZE;
+			r = LzmaUncompress((unsigned char *)rf->out, &out_len, rf->in + LZMA_PROPS_SIZE, &in_len,
+			                   rf->in, LZMA_PROPS_SIZE);
+			return (r == SZ_OK) && (out_len == rf->out_len);
+		}
+#endif
+		default:
+			/* codec not built in */
+			return 0;
+	}
+}
+
+/* ************************ reading ************************ */
+
+int blo_compressed_type(const unsigned char *mem, size_t size)
+{
+	if (size >= BLO_FRAMES_MAGIC_LEN && memcmp(mem, BLO_FRAMES_MAGIC, BLO_FRAMES_MAGIC_LEN) == 0)
+		return BLO_COMPRESSED_FRAMES;
+	else if (gzip_frame_size(mem, size))
+		return BLO_COMPRESSED_GZIP_FRAMES;
+
+	return BLO_COMPRESSED_NONE;
+}
+
+/* fills frames (when not NULL), returns the number of frames or -1 for invalid files */
+static int scan_frames(const unsigned char *mem, size_t size, ReadFrame *frames, size_t *r_totsize)
+{
+	size_t offset, totsize = 0;
+	int tot = 0;
+
+	if (blo_compressed_type(mem, size) == BLO_COMPRESSED_GZIP_FRAMES) {
+		for (offset = 0; offset < size; tot++) {
+			size_t member_size = gzip_frame_size(mem + offset, size - offset);
+			const unsigned char *trailer;
+
+			/* a plain gzip member appended, can't tell its size */
+			if (member_size == 0)
+				return -1;
+
+			trailer = mem + offset + member_size - GZ_TRAILER_SIZE;
+
+			if (frames) {
+				frames[tot].codec = BLO_CODEC_DEFLATE;
+				frames[tot].in = mem + offset + GZ_HEADER_SIZE;
+				frames[tot].in_len = (unsigned int)(member_size - GZ_HEADER_SIZE - GZ_TRAILER_SIZE);
+				frames[tot].crc = get_le32(trailer);
+				frames[tot].out_len = get_le32(trailer + 4);
+			}
+
+			totsize += get_le32(trailer + 4);
+			offset += member_size;
+		}
+	}
+	else {
+		offset = BLO_FRAMES_MAGIC_LEN;
+
+		while (1) {
+			unsigned int clen, ulen;
+
+			if (offset + FRAME_HEADER_SIZE > size)
+				return -1;
+
+			clen = get_le32(mem + offset + 4);
+			ulen = get_le32(mem + offset + 8);
+			offset += FRAME_HEADER_SIZE;
+
+			if (ulen == 0)
+				break;
+			/* deflate frames are only stored as gzip members */
+			if (offset + clen > size || mem[offset - FRAME_HEADER_SIZE] == BLO_CODEC_DEFLATE)
+				return -1;
+
+			if (frames) {
+				frames[tot].codec = mem[offset - FRAME_HEADER_SIZE];
+				frames[tot].in = mem + offset;
+				frames[tot].in_len = clen;
+				frames[tot].out_len = ulen;
+			}
+
+			totsize += ulen;
+			offset += clen;
+			tot++;
+		}
+	}
+
+	*r_totsize = totsize;
+
+	return tot;
+}
+
+typedef struct DecompressThread {
+	ReadFrame *frames;
+	int start, end;
+	int error;
+} DecompressThread;
+
+static void *decompress_frames_thread(void *dt_v)
+{
+	DecompressThread *dt = dt_v;
+	int i;
+
+	for (i = dt->start; i < dt->end && !dt->error; i++) {
+		if (!frame_decompress(&dt->frames[i]))
+			dt->error = 1;
+	}
+
+	return NULL;
+}
+
+/* decompress a whole file on threads, returns NULL on failure */
+char *blo_decompress_frames(const unsigned char *mem, size_t size, size_t *r_size)
+{
+	DecompressThread dt[BLENDER_MAX_THREADS];
+	ListBase threads;
+	ReadFrame *frames;
+	char *out;
+	size_t totsize, offset;
+	int tot, totthread, a, i, error = 0;
+
+	tot = scan_frames(mem, size, NULL, &totsize);
+	if (tot <= 0 || totsize == 0)
+		return NULL;
+
+	frames = MEM_mallocN(sizeof(ReadFrame) * tot, "ReadFrames");
+	scan_frames(mem, size, frames, &totsize);
+
+	out = MEM_mapallocN(totsize, "decompressed blend file");
+	if (out == NULL) {
+		MEM_freeN(frames);
+		return NULL;
+	}
+
+	for (i = 0, offset = 0; i < tot; i++) {
+		frames[i].out = out + offset;
+		offset += frames[i].out_len;
+	}
+
+	/* frames are all about the same size, split them evenly */
+	totthread = MIN3(BLI_system_thread_count(), tot, BLENDER_MAX_THREADS);
+
+	BLI_init_threads(&threads, decompress_frames_thread, totthread);
+	for (a = 0; a < totthread; a++) {
+		dt[a].frames = frames;
+		dt[a].start = (tot * a) / totthread;
+		dt[a].end = (tot * (a + 1)) / totthread;
+		dt[a].error = 0;
+		BLI_insert_thread(&threads, &dt[a]);
+	}
+	BLI_end_threads(&threads);
+
+	for (a = 0; a < totthread; a++)
+		error |= dt[a].error;
+
+	MEM_freeN(frames);
+
+	if (error) {
+		MEM_freeN(out);
+		return NULL;
+	}
+
+	*r_size = totsize;
+	return out;
+}
+
+/* ************************ streaming ************************ */
+
+typedef struct FrameReader {
+	int file;
+	int eof;
+
+	unsigned char *in;
+	unsigned int in_size;
+
+	char *out;
+	unsigned int out_size, out_len, out_pos;
+} FrameReader;
+
+FrameReader *blo_frame_reader_new(int file)
+{
+	FrameReader *fr;
+	char magic[BLO_FRAMES_MAGIC_LEN];
+
+	if (read_full(file, magic, sizeof(magic)) != sizeof(magic) ||
+	    memcmp(magic, BLO_FRAMES_MAGIC, BLO_FRAMES_MAGIC_LEN) != 0)
+	{
+		return NULL;
+	}
+
+	fr = MEM_callocN(sizeof(FrameReader), "FrameReader");
+	fr->file = file;
+
+	return fr;
+}
+
+static int frame_reader_next(FrameReader *fr)
+{
+	unsigned char header[FRAME_HEADER_SIZE];
+	ReadFrame rf;
+
+	if (read_full(fr->file, header, sizeof(header)) != sizeof(header))
+		return 0;
+
+	rf.codec = header[0];
+	rf.in_len = get_le32(header + 4);
+	rf.out_len = get_le32(header + 8);
+
+	if (rf.out_len == 0 || rf.codec == BLO_CODEC_DEFLATE)
+		return 0;
+
+	if (rf.in_len > fr->in_size) {
+		if (fr->in) MEM_freeN(fr->in);
+		fr->in = MEM_mallocN(rf.in_len, "FrameReader in");
+		fr->in_size = rf.in_len;
+	}
+	if (rf.out_len > fr->out_size) {
+		if (fr->out) MEM_freeN(fr->out);
+		fr->out = MEM_mallocN(rf.out_len, "FrameReader out");
+		fr->out_size = rf.out_len;
+	}
+
+	if (read_full(fr->file, fr->in, rf.in_len) != (int)rf.in_len)
+		return 0;
+
+	rf.in = fr->in;
+	rf.out = fr->out;
+	if (!frame_decompress(&rf))
+		return 0;
+
+	fr->out_len = rf.out_len;
+	fr->out_pos = 0;
+
+	return 1;
+}
+
+int blo_frame_reader_read(FrameReader *fr, void *buffer, unsigned int size)
+{
+	unsigned int totread = 0;
+
+	while (totread < size) {
+		unsigned int len;
+
+		if (fr->out_pos == fr->out_len) {
+			if (fr->eof || !frame_reader_next(fr)) {
+				fr->eof = 1;
+				break;
+			}
+		}
+
+		len = MIN2(size - totread, fr->out_len - fr->out_pos);
+		memcpy((char *)buffer + totread, fr->out + fr->out_pos, len);
+		fr->out_pos += len;
+		totread += len;
+	}
+
+	return (int)totread;
+}
+
+void blo_frame_reader_free(FrameReader *fr)
+{
+	if (fr->in)
+		MEM_freeN(fr->in);
+	if (fr->out)
+		MEM_freeN(fr->out);
+	MEM_freeN(fr);
+}
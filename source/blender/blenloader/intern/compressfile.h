@@ -0,0 +1,79 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ * blenloader framed compression private function prototypes
+ */
+
+/** \file blender/blenloader/intern/compressfile.h
+ *  \ingroup blenloader
+ *
+ * Compressed .blend files are split in frames of BLO_FRAME_SIZE which are
+ * compressed independently, so both writing and reading can use all cores.
+ * Every frame starts with its sizes so the file can still be read as a stream.
+ *
+ * - Deflate frames are gzip members with a 'BL' extra field holding the
+ *   member size. Any gzip reader (older Blender versions too) reads these
+ *   as a regular multi-member .gz file.
+ * - LZO and LZMA frames use a small container starting with BLO_FRAMES_MAGIC,
+ *   each frame has a 12 byte header (codec, 3 padding bytes, compressed and
+ *   uncompressed size as little endian 32 bit ints), a frame with uncompressed
+ *   size zero ends the file.
+ */
+
+#ifndef __COMPRESSFILE_H__
+#define __COMPRESSFILE_H__
+
+#define BLO_FRAME_SIZE      (1 << 20)
+#define BLO_FRAMES_MAGIC    "BLENDZ01"
+#define BLO_FRAMES_MAGIC_LEN 8
+
+/* frame codecs */
+enum {
+	BLO_CODEC_STORE   = 0,
+	BLO_CODEC_DEFLATE = 1,
+	BLO_CODEC_LZO     = 2,
+	BLO_CODEC_LZMA    = 3
+};
+
+/* blo_compressed_type() */
+enum {
+	BLO_COMPRESSED_NONE        = 0,  /* not compressed, or gzip without frame sizes */
+	BLO_COMPRESSED_GZIP_FRAMES = 1,
+	BLO_COMPRESSED_FRAMES      = 2
+};
+
+struct CompressWriter;
+struct FrameReader;
+
+/* writing, frames are compressed on threads while the caller keeps writing */
+struct CompressWriter *blo_compress_writer_new(int file, int codec);
+void blo_compress_writer_write(struct CompressWriter *cw, const void *mem, unsigned int memlen);
+int  blo_compress_writer_end(struct CompressWriter *cw);
+
+/* reading the whole file at once, frames are decompressed on threads */
+int   blo_compressed_type(const unsigned char *mem, size_t size);
+char *blo_decompress_frames(const unsigned char *mem, size_t size, size_t *r_size);
+
+/* streaming read of BLO_COMPRESSED_FRAMES files, gzip frames can use gzread */
+struct FrameReader *blo_frame_reader_new(int file);
+int   blo_frame_reader_read(struct FrameReader *fr, void *buffer, unsigned int size);
+void  blo_frame_reader_free(struct FrameReader *fr);
+
+#endif  /* __COMPRESSFILE_H__ */
@@ -37,6 +37,15 @@
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <fcntl.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "zlib.h"
 
 #include "MEM_guardedalloc.h"
 
@@ -62,6 +71,7 @@
 #include "BLO_blend_defs.h"
 
 #include "readfile.h"
+#include "compressfile.h"
 
 #include "BLO_sys_types.h" // needed for intptr_t
 
@@ -351,3 +361,93 @@ void BLO_blendfiledata_free(BlendFileData *bfd)
 	MEM_freeN(bfd);
 }
 
+/* File reader, framed files use the frame reader, others zlib which also
+ * reads uncompressed files */
+
+struct BlendFileReader {
+	gzFile gzfile;
+	int file;
+	struct FrameReader *frame_reader;
+};
+
+BlendFileReader *BLO_file_reader_open(const char *filepath)
+{
+	BlendFileReader *reader;
+	char magic[BLO_FRAMES_MAGIC_LEN];
+	int file;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1)
+		return NULL;
+
+	reader = MEM_callocN(sizeof(BlendFileReader), "BlendFileReader");
+	reader->file = -1;
+
+	if (read(file, magic, sizeof(magic)) == sizeof(magic) &&
+	    memcmp(magic, BLO_FRAMES_MAGIC, BLO_FRAMES_MAGIC_LEN) == 0 &&
+	    lseek(file, 0, SEEK_SET) == 0)
+	{
+		reader->frame_reader = blo_frame_reader_new(file);
+		if (reader->frame_reader == NULL) {
+			close(file);
+			MEM_freeN(reader);
+			return NULL;
+		}
+
+		reader->file = file;
+		return reader;
+	}
+
+	close(file);
+
+	reader->gzfile = BLI_gzopen(filepath, "rb");
+	if (reader->gzfile == NULL) {
+		MEM_freeN(reader);
+		return NULL;
+	}
+
+	return reader;
+}
+
+int BLO_file_reader_read(BlendFileReader *reader, void *buffer, unsigned int size)
+{
+	if (reader->frame_reader)
+		return blo_frame_reader_read(reader->frame_reader, buffer, size);
+	else
+		return gzread(reader->gzfile, buffer, size);
+}
+
+/* returns false when the end of the file was reached first */
+int BLO_file_reader_skip(BlendFileReader *reader, unsigned int size)
+{
+	if (reader->frame_reader) {
+		char buffer[4096];
+
+		while (size > 0) {
+			unsigned int len = MIN2(size, sizeof(buffer));
+
+			if (blo_frame_reader_read(reader->frame_reader, buffer, len) != (int)len)
+				return FALSE;
+
+			size -= len;
+		}
+
+		return TRUE;
+	}
+	else {
+		return (gzseek(reader->gzfile, size, SEEK_CUR) != -1);
+	}
+}
+
+void BLO_file_reader_close(BlendFileReader *reader)
+{
+	if (reader->frame_reader) {
+		blo_frame_reader_free(reader->frame_reader);
+		close(reader->file);
+	}
+	else {
+		gzclose(reader->gzfile);
+	}
+
+	MEM_freeN(reader);
+}
@@ -43,6 +43,8 @@
 
 #ifndef WIN32
 #  include <unistd.h> // for read close
+#  include <sys/mman.h> // for mmap munmap
+#  include <sys/stat.h> // for fstat
 #else
 #  include <io.h> // for open close read
 #  include "winsock2.h"
@@ -104,6 +106,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
 #include "BLI_edgehash.h"
+#include "BLI_threads.h"
 
 #include "BLF_translation.h"
 
@@ -156,6 +159,7 @@
 #include "RE_engine.h"
 
 #include "readfile.h"
+#include "compressfile.h"
 
 #include "PIL_time.h"
 
@@ -210,6 +214,25 @@
  * - initialize FileGlobal and copy pointers to Global
  */
 
+/* Memory map uncompressed files instead of reading them through zlib.
+ * When the file needs no endian or pointer size conversion the BHead's are
+ * used in place (FD_FLAGS_MMAP_INPLACE), this relies on unaligned reads being
+ * cheap since blocks in the file are only 4 byte aligned. */
+#ifndef WIN32
+#  define USE_MMAP_READ
+#  if defined(__i386__) || defined(__x86_64__)
+#    define USE_MMAP_INPLACE
+#  endif
+#endif
+
+/* Reconstruct the data blocks of one ID on multiple threads
+ * when their total size is larger than this. DNA_struct_find_nr() only
+ * doesn't write to the SDNA when it uses the hash, see dna_genfile.c */
+#ifdef WITH_DNA_GHASH
+#  define USE_THREADED_READ
+#  define THREADED_READ_MIN_SIZE (4 * 1024 * 1024)
+#endif
+
 /* also occurs in library.c */
 /* GS reads the memory pointed at in a specific ordering. There are,
  * however two definitions for it. I have jotted them down here, both,
@@ -234,8 +257,12 @@ typedef struct OldNew {
 typedef struct OldNewMap {
 	OldNew *entries;
 	int nentries, entriessize;
-	int sorted;
 	int lasthit;
+
+	/* open addressing index into 'entries', -1 for empty slots,
+	 * always twice the size of 'entries' so the load factor stays under 0.5 */
+	int *map;
+	unsigned int map_mask;
 } OldNewMap;
 
 
@@ -275,30 +302,51 @@ static void BKE_reportf_wrap(ReportList *reports, ReportType type, const char *f
 	}
 }
 
-static OldNewMap *oldnewmap_new(void) 
+#define ONM_DEFAULT_SIZE 1024
+#define ONM_SLOT_EMPTY -1
+
+/* pointers from the file are at least 4 byte aligned, mix the upper bits
+ * down so consecutive allocations don't cluster in the same slots */
+BLI_INLINE unsigned int oldnewmap_hash(const void *ptr)
 {
-	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
-	
-	onm->entriessize = 1024;
-	onm->entries = MEM_mallocN(sizeof(*onm->entries)*onm->entriessize, "OldNewMap.entries");
-	
-	return onm;
+	uintptr_t key = (uintptr_t)ptr;
+
+	key ^= key >> 16;
+	key *= 0x45d9f3bu;
+	key ^= key >> 16;
+
+	return (unsigned int)key;
 }
 
-static int verg_oldnewmap(const void *v1, const void *v2)
+static void oldnewmap_map_alloc(OldNewMap *onm)
 {
-	const struct OldNew *x1=v1, *x2=v2;
-	
-	if (x1->old > x2->old) return 1;
-	else if (x1->old < x2->old) return -1;
-	return 0;
+	const int map_size = onm->entriessize * 2;
+
+	onm->map = MEM_mallocN(sizeof(*onm->map) * map_size, "OldNewMap.map");
+	onm->map_mask = (unsigned int)map_size - 1;
+	memset(onm->map, 0xff, sizeof(*onm->map) * map_size);  /* ONM_SLOT_EMPTY */
 }
 
+static void oldnewmap_map_insert(OldNewMap *onm, int index)
+{
+	unsigned int slot = oldnewmap_hash(onm->entries[index].old) & onm->map_mask;
+
+	while (onm->map[slot] != ONM_SLOT_EMPTY) {
+		slot = (slot + 1) & onm->map_mask;
+	}
 
-static void oldnewmap_sort(FileData *fd) 
+	onm->map[slot] = index;
+}
+
+static OldNewMap *oldnewmap_new(void) 
 {
-	qsort(fd->libmap->entries, fd->libmap->nentries, sizeof(OldNew), verg_oldnewmap);
-	fd->libmap->sorted = 1;
+	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
+	
+	onm->entriessize = ONM_DEFAULT_SIZE;
+	onm->entries = MEM_mallocN(sizeof(*onm->entries)*onm->entriessize, "OldNewMap.entries");
+	oldnewmap_map_alloc(onm);
+	
+	return onm;
 }
 
 /* nr is zero for data, and ID code for libdata */
@@ -311,18 +359,29 @@ static void oldnewmap_insert(OldNewMap *onm, void *oldaddr, void *newaddr, int n
 	if (onm->nentries == onm->entriessize) {
 		int osize = onm->entriessize;
 		OldNew *oentries = onm->entries;
+		int i;
 		
 		onm->entriessize *= 2;
 		onm->entries = MEM_mallocN(sizeof(*onm->entries)*onm->entriessize, "OldNewMap.entries");
 		
 		memcpy(onm->entries, oentries, sizeof(*oentries)*osize);
 		MEM_freeN(oentries);
+
+		/* rehash, insertion order is kept so duplicate keys still resolve to the first entry */
+		MEM_freeN(onm->map);
+		oldnewmap_map_alloc(onm);
+		for (i = 0; i < onm->nentries; i++) {
+			oldnewmap_map_insert(onm, i);
+		}
 	}
 
-	entry = &onm->entries[onm->nentries++];
+	entry = &onm->entries[onm->nentries];
 	entry->old = oldaddr;
 	entry->newp = newaddr;
 	entry->nr = nr;
+
+	oldnewmap_map_insert(onm, onm->nentries);
+	onm->nentries++;
 }
 
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, void *oldaddr, void *newaddr, int nr)
@@ -330,12 +389,29 @@ void blo_do_versions_oldnewmap_insert(OldNewMap *onm, void *oldaddr, void *newad
 	oldnewmap_insert(onm, oldaddr, newaddr, nr);
 }
 
+/* returns the index of the first entry inserted for addr, or -1 */
+static int oldnewmap_lookup_index(OldNewMap *onm, void *addr)
+{
+	unsigned int slot = oldnewmap_hash(addr) & onm->map_mask;
+	int index;
+
+	while ((index = onm->map[slot]) != ONM_SLOT_EMPTY) {
+		if (onm->entries[index].old == addr) {
+			return index;
+		}
+		slot = (slot + 1) & onm->map_mask;
+	}
+
+	return -1;
+}
+
 static void *oldnewmap_lookup_and_inc(OldNewMap *onm, void *addr) 
 {
 	int i;
 	
 	if (addr == NULL) return NULL;
 	
+	/* most pointers are read in the same order they were written */
 	if (onm->lasthit < onm->nentries-1) {
 		OldNew *entry = &onm->entries[++onm->lasthit];
 		
@@ -345,15 +421,14 @@ static void *oldnewmap_lookup_and_inc(OldNewMap *onm, void *addr)
 		}
 	}
 	
-	for (i = 0; i < onm->nentries; i++) {
+	i = oldnewmap_lookup_index(onm, addr);
+	if (i != -1) {
 		OldNew *entry = &onm->entries[i];
-		
-		if (entry->old == addr) {
-			onm->lasthit = i;
-			
-			entry->nr++;
-			return entry->newp;
-		}
+
+		onm->lasthit = i;
+
+		entry->nr++;
+		return entry->newp;
 	}
 	
 	return NULL;
@@ -362,39 +437,26 @@ static void *oldnewmap_lookup_and_inc(OldNewMap *onm, void *addr)
 /* for libdata, nr has ID code, no increment */
 static void *oldnewmap_liblookup(OldNewMap *onm, void *addr, void *lib)
 {
+	unsigned int slot;
+	int index;
+
 	if (addr == NULL) {
 		return NULL;
 	}
 
-	/* lasthit works fine for non-libdata, linking there is done in same sequence as writing */
-	if (onm->sorted) {
-		OldNew entry_s, *entry;
+	/* the same old address may be stored more than once (indirectly linked data),
+	 * walk the whole probe sequence for matches, in insertion order */
+	slot = oldnewmap_hash(addr) & onm->map_mask;
+	while ((index = onm->map[slot]) != ONM_SLOT_EMPTY) {
+		OldNew *entry = &onm->entries[index];
 
-		entry_s.old = addr;
-
-		entry = bsearch(&entry_s, onm->entries, onm->nentries, sizeof(OldNew), verg_oldnewmap);
-		if (entry) {
+		if (entry->old == addr) {
 			ID *id = entry->newp;
-
 			if (id && (!lib || id->lib)) {
 				return id;
 			}
 		}
-	}
-	else {
-		/* note, this can be a bottle neck when loading some files */
-		unsigned int nentries = (unsigned int)onm->nentries;
-		unsigned int i;
-		OldNew *entry;
-
-		for (i = 0, entry = onm->entries; i < nentries; i++, entry++) {
-			if (entry->old == addr) {
-				ID *id = id = entry->newp;
-				if (id && (!lib || id->lib)) {
-					return id;
-				}
-			}
-		}
+		slot = (slot + 1) & onm->map_mask;
 	}
 
 	return NULL;
@@ -415,6 +477,26 @@ static void oldnewmap_free_unused(OldNewMap *onm)
 
 static void oldnewmap_clear(OldNewMap *onm) 
 {
+	/* the datamap is cleared after every ID, so avoid touching the whole index
+	 * when only a few entries were used: find and reset only their slots.
+	 * Slots are searched without stopping at empty ones since earlier
+	 * entries of the same probe sequence may already be reset. */
+	if ((unsigned int)onm->nentries * 8 < onm->map_mask) {
+		int i;
+
+		for (i = 0; i < onm->nentries; i++) {
+			unsigned int slot = oldnewmap_hash(onm->entries[i].old) & onm->map_mask;
+
+			while (onm->map[slot] != i) {
+				slot = (slot + 1) & onm->map_mask;
+			}
+			onm->map[slot] = ONM_SLOT_EMPTY;
+		}
+	}
+	else {
+		memset(onm->map, 0xff, sizeof(*onm->map) * (onm->map_mask + 1));  /* ONM_SLOT_EMPTY */
+	}
+
 	onm->nentries = 0;
 	onm->lasthit = 0;
 }
@@ -422,9 +504,13 @@ static void oldnewmap_clear(OldNewMap *onm)
 static void oldnewmap_free(OldNewMap *onm) 
 {
 	MEM_freeN(onm->entries);
+	MEM_freeN(onm->map);
 	MEM_freeN(onm);
 }
 
+#undef ONM_DEFAULT_SIZE
+#undef ONM_SLOT_EMPTY
+
 /***/
 
 static void read_libraries(FileData *basefd, ListBase *mainlist);
@@ -737,11 +823,72 @@ static BHeadN *get_bhead(FileData *fd)
 	return(new_bhead);
 }
 
+#ifdef USE_MMAP_READ
+
+/* returns the in place BHead at offset, or NULL when it doesn't fit in the file */
+static BHead *mmap_bhead_at(FileData *fd, size_t offset)
+{
+	BHead *bhead;
+
+	if (offset + sizeof(BHead) > fd->mmap_size)
+		return NULL;
+
+	bhead = (BHead *)(fd->mmap_buffer + offset);
+
+	/* make sure people are not trying to pass bad blend files */
+	if (bhead->len < 0 || offset + sizeof(BHead) + (size_t)bhead->len > fd->mmap_size)
+		return NULL;
+
+	return bhead;
+}
+
+static int verg_bhead_ptr(const void *v1, const void *v2)
+{
+	const BHead *x1 = *(BHead **)v1, *x2 = *(BHead **)v2;
+
+	if (x1 > x2) return 1;
+	else if (x1 < x2) return -1;
+	return 0;
+}
+
+static BHead *mmap_prevbhead(FileData *fd, BHead *thisblock)
+{
+	BHead **found;
+
+	if (fd->mmap_bheads == NULL) {
+		BHead *bhead;
+		int tot = 0;
+
+		for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead))
+			tot++;
+
+		fd->mmap_bheads = MEM_mallocN(sizeof(*fd->mmap_bheads) * MAX2(tot, 1), "mmap_bheads");
+		fd->mmap_tot_bheads = tot;
+
+		/* file order is address order */
+		tot = 0;
+		for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead))
+			fd->mmap_bheads[tot++] = bhead;
+	}
+
+	found = bsearch(&thisblock, fd->mmap_bheads, fd->mmap_tot_bheads, sizeof(*fd->mmap_bheads), verg_bhead_ptr);
+
+	return (found && found != fd->mmap_bheads) ? *(found - 1) : NULL;
+}
+
+#endif  /* USE_MMAP_READ */
+
 BHead *blo_firstbhead(FileData *fd)
 {
 	BHeadN *new_bhead;
 	BHead *bhead = NULL;
 	
+#ifdef USE_MMAP_READ
+	if (fd->flags & FD_FLAGS_MMAP_INPLACE) {
+		return mmap_bhead_at(fd, SIZEOFBLENDERHEADER);
+	}
+#endif
+
 	/* Rewind the file
 	 * Read in a new block if necessary
 	 */
@@ -757,10 +904,20 @@ BHead *blo_firstbhead(FileData *fd)
 	return(bhead);
 }
 
-BHead *blo_prevbhead(FileData *UNUSED(fd), BHead *thisblock)
+BHead *blo_prevbhead(FileData *fd, BHead *thisblock)
 {
-	BHeadN *bheadn = (BHeadN *) (((char *) thisblock) - offsetof(BHeadN, bhead));
-	BHeadN *prev = bheadn->prev;
+	BHeadN *bheadn, *prev;
+	
+#ifdef USE_MMAP_READ
+	if (fd->flags & FD_FLAGS_MMAP_INPLACE) {
+		return mmap_prevbhead(fd, thisblock);
+	}
+#else
+	(void)fd;
+#endif
+
+	bheadn = (BHeadN *) (((char *) thisblock) - offsetof(BHeadN, bhead));
+	prev = bheadn->prev;
 	
 	return (prev) ? &prev->bhead : NULL;
 }
@@ -770,6 +927,16 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	BHeadN *new_bhead = NULL;
 	BHead *bhead = NULL;
 	
+#ifdef USE_MMAP_READ
+	if (fd->flags & FD_FLAGS_MMAP_INPLACE) {
+		if (thisblock == NULL || thisblock->code == ENDB)
+			return NULL;
+
+		/* blocks follow each other in the file */
+		return mmap_bhead_at(fd, (size_t)(((char *)(thisblock + 1) + thisblock->len) - fd->mmap_buffer));
+	}
+#endif
+
 	if (thisblock) {
 		/* bhead is actually a sub part of BHeadN
 		 * We calculate the BHeadN pointer from the BHead pointer below */
@@ -896,6 +1063,28 @@ static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int si
 	return (readsize);
 }
 
+static int fd_read_from_frames(FileData *filedata, void *buffer, unsigned int size)
+{
+	int readsize = blo_frame_reader_read(filedata->frame_reader, buffer, size);
+	
+	filedata->seek += readsize;
+	
+	return readsize;
+}
+
+#ifdef USE_MMAP_READ
+static int fd_read_from_mmap(FileData *filedata, void *buffer, unsigned int size)
+{
+	/* don't read more bytes then there are available in the mapping */
+	unsigned int readsize = (unsigned int)MIN2((size_t)size, filedata->mmap_size - filedata->mmap_seek);
+	
+	memcpy(buffer, filedata->mmap_buffer + filedata->mmap_seek, readsize);
+	filedata->mmap_seek += readsize;
+	
+	return (int)readsize;
+}
+#endif
+
 static int fd_read_from_memfile(FileData *filedata, void *buffer, unsigned int size)
 {
 	static unsigned int seek = (1<<30);	/* the current position */
@@ -979,6 +1168,13 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 {
 	decode_blender_header(fd);
 	
+#ifdef USE_MMAP_INPLACE
+	/* the file layout matches BHead exactly, no need to copy blocks out of the mapping */
+	if (fd->mmap_buffer && !(fd->flags & (FD_FLAGS_SWITCH_ENDIAN | FD_FLAGS_POINTSIZE_DIFFERS))) {
+		fd->flags |= FD_FLAGS_MMAP_INPLACE;
+	}
+#endif
+
 	if (fd->flags & FD_FLAGS_FILE_OK) {
 		if (!read_file_dna(fd)) {
 			BKE_reportf(reports, RPT_ERROR, "Failed to read blend file '%s', incomplete", fd->relabase);
@@ -995,11 +1191,141 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
+#ifdef USE_MMAP_READ
+/* map uncompressed files read-only into memory, copy-on-write since
+ * some versioning code patches block headers in place.
+ * Framed compressed files are decompressed on threads into memory.
+ * returns NULL for other compressed files or on failure, so zlib reading is used */
+static FileData *blo_openblenderfile_mmap(const char *filepath)
+{
+	FileData *fd;
+	struct stat st;
+	unsigned char *mem;
+	size_t size;
+	int file, compressed;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1)
+		return NULL;
+
+	if (fstat(file, &st) == -1 || st.st_size < SIZEOFBLENDERHEADER) {
+		close(file);
+		return NULL;
+	}
+
+	size = (size_t)st.st_size;
+	mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	close(file);
+
+	if (mem == MAP_FAILED)
+		return NULL;
+
+	compressed = blo_compressed_type(mem, size);
+
+	if (compressed != BLO_COMPRESSED_NONE) {
+		char *data = blo_decompress_frames(mem, size, &size);
+
+		munmap(mem, (size_t)st.st_size);
+
+		if (data == NULL)
+			return NULL;
+
+		fd = filedata_new();
+		fd->mmap_buffer = data;
+		fd->flags |= FD_FLAGS_MMAP_DECOMPRESSED;
+	}
+	else if (mem[0] == 0x1f && mem[1] == 0x8b) {  /* gzip */
+		munmap(mem, size);
+		return NULL;
+	}
+	else {
+		fd = filedata_new();
+		fd->mmap_buffer = (char *)mem;
+	}
+
+	fd->mmap_size = size;
+	fd->read = fd_read_from_mmap;
+
+	return fd;
+}
+#endif
+
+/* returns true when the file starts with BLO_FRAMES_MAGIC, LZO and LZMA
+ * framed files can't be read with zlib */
+static int blo_is_frames_file(const char *filepath)
+{
+	char magic[BLO_FRAMES_MAGIC_LEN];
+	int file, ok;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1)
+		return FALSE;
+
+	ok = (read(file, magic, sizeof(magic)) == sizeof(magic) &&
+	      memcmp(magic, BLO_FRAMES_MAGIC, BLO_FRAMES_MAGIC_LEN) == 0);
+	close(file);
+
+	return ok;
+}
+
+/* LZO and LZMA framed files, read as a stream when they can't be mapped */
+static FileData *blo_openblenderfile_frames(const char *filepath, ReportList *reports)
+{
+	FileData *fd;
+	struct FrameReader *fr;
+	int file;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		BKE_reportf(reports, RPT_WARNING, "Unable to open '%s': %s", filepath, strerror(errno));
+		return NULL;
+	}
+
+	fr = blo_frame_reader_new(file);
+	if (fr == NULL) {
+		BKE_reportf(reports, RPT_WARNING, "Unable to open '%s': %s", filepath, TIP_("unknown error reading file"));
+		close(file);
+		return NULL;
+	}
+
+	fd = filedata_new();
+	fd->filedes = file;
+	fd->frame_reader = fr;
+	fd->read = fd_read_from_frames;
+
+	return fd;
+}
+
 /* cannot be called with relative paths anymore! */
 /* on each new library added, it now checks for the current FileData and expands relativeness */
 FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
 {
 	gzFile gzfile;
+
+#ifdef USE_MMAP_READ
+	{
+		FileData *fd = blo_openblenderfile_mmap(filepath);
+		if (fd) {
+			/* needed for library_append and read_libraries */
+			BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+			
+			return blo_decode_and_check(fd, reports);
+		}
+	}
+#endif
+
+	if (blo_is_frames_file(filepath)) {
+		FileData *fd = blo_openblenderfile_frames(filepath, reports);
+		if (fd) {
+			/* needed for library_append and read_libraries */
+			BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+			
+			return blo_decode_and_check(fd, reports);
+		}
+
+		return NULL;
+	}
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
 	
@@ -1066,6 +1392,22 @@ void blo_freefiledata(FileData *fd)
 			gzclose(fd->gzfiledes);
 		}
 		
+		if (fd->frame_reader) {
+			blo_frame_reader_free(fd->frame_reader);
+		}
+		
+#ifdef USE_MMAP_READ
+		if (fd->mmap_buffer) {
+			if (fd->flags & FD_FLAGS_MMAP_DECOMPRESSED)
+				MEM_freeN(fd->mmap_buffer);
+			else
+				munmap(fd->mmap_buffer, fd->mmap_size);
+		}
+		if (fd->mmap_bheads) {
+			MEM_freeN(fd->mmap_bheads);
+		}
+#endif
+		
 		if (fd->buffer && !(fd->flags & FD_FLAGS_NOT_MY_BUFFER)) {
 			MEM_freeN(fd->buffer);
 			fd->buffer = NULL;
@@ -3069,6 +3411,9 @@ static void direct_link_image(FileData *fd, Image *ima)
 	ima->packedfile = direct_link_packedfile(fd, ima->packedfile);
 	ima->preview = direct_link_preview_image(fd, ima->preview);
 	ima->ok = 1;
+
+	/* the saved value may match one of images that were read before */
+	BKE_image_new_generation(ima);
 }
 
 
@@ -6426,10 +6771,103 @@ static const char *dataname(short id_code)
 	
 }
 
+#ifdef USE_THREADED_READ
+typedef struct ReadStructThread {
+	FileData *fd;
+	BHead **bheads;
+	void **data;
+	int start, end;
+	const char *allocname;
+} ReadStructThread;
+
+static void *read_struct_thread(void *arg)
+{
+	ReadStructThread *rst = arg;
+	int i;
+	
+	for (i = rst->start; i < rst->end; i++) {
+		rst->data[i] = read_struct(rst->fd, rst->bheads[i], rst->allocname);
+	}
+	
+	return NULL;
+}
+
+/* read_struct() for a run of independent data blocks, split over threads by size */
+static void read_structs_threaded(FileData *fd, BHead *first, int tot, size_t totsize, const char *allocname)
+{
+	ListBase threads;
+	ReadStructThread rst[BLENDER_MAX_THREADS];
+	BHead **bheads = MEM_mallocN(sizeof(*bheads) * tot, "read_structs_threaded bheads");
+	void **data = MEM_mallocN(sizeof(*data) * tot, "read_structs_threaded data");
+	BHead *bhead;
+	size_t size_per_thread, size;
+	int totthread, a, i;
+	
+	for (i = 0, bhead = first; i < tot; i++, bhead = blo_nextbhead(fd, bhead)) {
+		bheads[i] = bhead;
+	}
+	
+	totthread = MIN3(BLI_system_thread_count(), tot, BLENDER_MAX_THREADS);
+	size_per_thread = totsize / totthread + 1;
+	
+	/* contiguous ranges of about equal size, order is kept for the datamap */
+	for (a = 0, i = 0; a < totthread; a++) {
+		rst[a].fd = fd;
+		rst[a].bheads = bheads;
+		rst[a].data = data;
+		rst[a].allocname = allocname;
+		rst[a].start = i;
+		
+		for (size = 0; i < tot && (size < size_per_thread || a == totthread - 1); i++) {
+			size += bheads[i]->len;
+		}
+		rst[a].end = i;
+	}
+	
+	BLI_init_threads(&threads, read_struct_thread, totthread);
+	for (a = 0; a < totthread; a++) {
+		BLI_insert_thread(&threads, &rst[a]);
+	}
+	BLI_end_threads(&threads);
+	
+	for (i = 0; i < tot; i++) {
+		if (data[i]) {
+			oldnewmap_insert(fd->datamap, bheads[i]->old, data[i], 0);
+		}
+	}
+	
+	MEM_freeN(bheads);
+	MEM_freeN(data);
+}
+#endif  /* USE_THREADED_READ */
+
 static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *allocname)
 {
 	bhead = blo_nextbhead(fd, bhead);
 	
+#ifdef USE_THREADED_READ
+	{
+		BHead *first = bhead;
+		size_t totsize = 0;
+		int tot = 0;
+		
+		/* big ID's (meshes, images with packed data...) are mostly a few
+		 * large blocks that can be converted independently */
+		while (bhead && bhead->code == DATA) {
+			totsize += bhead->len;
+			tot++;
+			bhead = blo_nextbhead(fd, bhead);
+		}
+		
+		if (tot > 1 && totsize > THREADED_READ_MIN_SIZE && BLI_system_thread_count() > 1) {
+			read_structs_threaded(fd, first, tot, totsize, allocname);
+			return bhead;
+		}
+		
+		bhead = first;
+	}
+#endif
+	
 	while (bhead && bhead->code==DATA) {
 		void *data;
 #if 0
@@ -8397,8 +8835,6 @@ static void do_versions_after_linking(FileData *fd, Library *lib, Main *main)
 
 static void lib_link_all(FileData *fd, Main *main)
 {
-	oldnewmap_sort(fd);
-	
 	lib_link_windowmanager(fd, main);
 	lib_link_screen(fd, main);
 	lib_link_scene(fd, main);
@@ -36,6 +36,7 @@
 #include "zlib.h"
 
 struct OldNewMap;
+struct FrameReader;
 struct MemFile;
 struct bheadsort;
 struct ReportList;
@@ -62,6 +63,17 @@ typedef struct FileData {
 	int filedes;
 	gzFile gzfiledes;
 
+	// variables needed for reading LZO/LZMA frames as a stream
+	struct FrameReader *frame_reader;
+
+	// variables needed for reading from a memory mapped file, or a decompressed file in memory
+	char *mmap_buffer;
+	size_t mmap_size;
+	size_t mmap_seek;
+	// with FD_FLAGS_MMAP_INPLACE, sorted BHead's for blo_prevbhead, built on demand
+	struct BHead **mmap_bheads;
+	int mmap_tot_bheads;
+
 	// now only in use for library appending
 	char relabase[FILE_MAX];
 	
@@ -108,6 +120,8 @@ typedef struct BHeadN {
 #define FD_FLAGS_FILE_OK                   (1 << 3)
 #define FD_FLAGS_NOT_MY_BUFFER             (1 << 4)
 #define FD_FLAGS_NOT_MY_LIBMAP             (1 << 5)
+#define FD_FLAGS_MMAP_INPLACE              (1 << 6)  /* BHead's point into mmap_buffer, no BHeadN copies */
+#define FD_FLAGS_MMAP_DECOMPRESSED         (1 << 7)  /* mmap_buffer is MEM allocated, not mapped */
 
 #define SIZEOFBLENDERHEADER 12
 
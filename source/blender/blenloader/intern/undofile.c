@@ -44,19 +44,128 @@
 #include "BLO_undofile.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 #include "BLI_linklist.h"
+#include "BLI_utildefines.h"
 
 
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/* Chunk buffers live in a pool keyed by their content, so a chunk that is
+ * equal to any chunk of any memfile is stored once, also when preceding data
+ * changed size and the chunks don't line up with the previous file anymore. */
+
+typedef struct MemFileShared {
+	char *buf;
+	unsigned int size;
+	unsigned int hash;
+	unsigned int users;
+} MemFileShared;
+
+static struct {
+	GHash *pool;
+	MemFileStats stats;
+} memfile_global = {NULL};
+
+/* FNV-1a on words with a final mix, the tail bytes are folded in separately.
+ * Words are copied out since buf has no alignment, compilers make that one load */
+static unsigned int memfile_hash_buf(const char *buf, unsigned int size)
+{
+	unsigned int hash = 2166136261u ^ size;
+	unsigned int word, a;
+
+	for (a = 0; a + 4 <= size; a += 4) {
+		memcpy(&word, buf + a, sizeof(word));
+		hash = (hash ^ word) * 16777619u;
+	}
+	for (a = size & ~3u; a < size; a++) {
+		hash = (hash ^ (unsigned char)buf[a]) * 16777619u;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3b;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+static unsigned int memfile_shared_hash(const void *key)
+{
+	return ((const MemFileShared *)key)->hash;
+}
+
+static int memfile_shared_cmp(const void *a, const void *b)
+{
+	const MemFileShared *sa = a, *sb = b;
+
+	if (sa->hash != sb->hash || sa->size != sb->size) return 1;
+	if (sa->buf == sb->buf) return 0;
+	return memcmp(sa->buf, sb->buf, sa->size) != 0;
+}
+
+static MemFileShared *memfile_shared_add(const char *buf, unsigned int size, unsigned int hash, int *r_is_new)
+{
+	MemFileShared key, *shared;
+
+	if (memfile_global.pool == NULL) {
+		memfile_global.pool = BLI_ghash_new(memfile_shared_hash, memfile_shared_cmp, "memfile chunk pool");
+	}
+
+	key.buf = (char *)buf;
+	key.size = size;
+	key.hash = hash;
+
+	shared = BLI_ghash_lookup(memfile_global.pool, &key);
+	*r_is_new = (shared == NULL);
+
+	if (shared == NULL) {
+		shared = MEM_mallocN(sizeof(MemFileShared), "MemFileShared");
+		shared->buf = MEM_mallocN(size, "Chunk buffer");
+		memcpy(shared->buf, buf, size);
+		shared->size = size;
+		shared->hash = hash;
+		shared->users = 0;
+		BLI_ghash_insert(memfile_global.pool, shared, shared);
+
+		memfile_global.stats.mem_shared += size;
+		memfile_global.stats.tot_shared++;
+	}
+
+	shared->users++;
+	return shared;
+}
+
+static void memfile_shared_release(MemFileShared *shared)
+{
+	BLI_assert(shared->users > 0);
+
+	if (--shared->users == 0) {
+		BLI_ghash_remove(memfile_global.pool, shared, NULL, NULL);
+
+		memfile_global.stats.mem_shared -= shared->size;
+		memfile_global.stats.tot_shared--;
+
+		MEM_freeN(shared->buf);
+		MEM_freeN(shared);
+
+		/* don't keep the pool around when undo is cleared, avoids leak reports on exit */
+		if (BLI_ghash_size(memfile_global.pool) == 0) {
+			BLI_ghash_free(memfile_global.pool, NULL, NULL);
+			memfile_global.pool = NULL;
+		}
+	}
+}
+
 /* not memfile itself */
 void BLO_free_memfile(MemFile *memfile)
 {
 	MemFileChunk *chunk;
 	
 	while ( (chunk = (memfile->chunks.first) ) ) {
-		if (chunk->ident == 0) MEM_freeN(chunk->buf);
+		memfile_global.stats.mem_referenced -= chunk->size;
+		memfile_global.stats.tot_chunks--;
+
+		memfile_shared_release(chunk->shared);
 		BLI_remlink(&memfile->chunks, chunk);
 		MEM_freeN(chunk);
 	}
@@ -67,36 +176,22 @@ void BLO_free_memfile(MemFile *memfile)
 /* result is that 'first' is being freed */
 void BLO_merge_memfile(MemFile *first, MemFile *second)
 {
-	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
-				sc->ident = 0;
-				fc->ident = 1;
-			}
-		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
-	}
-	
+	/* chunks 'second' shares with 'first' hold their own reference */
+	(void)second;
+
 	BLO_free_memfile(first);
 }
 
-static int my_memcmp(const int *mem1, const int *mem2, const int len)
+void BLO_memfile_stats(MemFileStats *stats)
 {
-	register int a = len;
-	register const int *mema = mem1;
-	register const int *memb = mem2;
-	
-	while (a--) {
-		if (*mema != *memb) return 1;
-		mema++;
-		memb++;
-	}
-	return 0;
+	*stats = memfile_global.stats;
+}
+
+void BLO_memfile_stats_reset(void)
+{
+	memfile_global.stats.hit_position = 0;
+	memfile_global.stats.hit_hash = 0;
+	memfile_global.stats.miss = 0;
 }
 
 void add_memfilechunk(MemFile *compare, MemFile *current, const char *buf, unsigned int size)
@@ -116,26 +211,39 @@ void add_memfilechunk(MemFile *compare, MemFile *current, const char *buf, unsig
 	
 	curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
-	curchunk->buf = NULL;
-	curchunk->ident = 0;
+	curchunk->shared = NULL;
 	BLI_addtail(&current->chunks, curchunk);
 	
-	/* we compare compchunk with buf */
+	/* we compare compchunk with buf, the common case of unchanged data
+	 * doesn't need hashing */
 	if (compchunk) {
-		if (compchunk->size == curchunk->size) {
-			if (my_memcmp((int *)compchunk->buf, (const int *)buf, size / 4) == 0) {
-				curchunk->buf = compchunk->buf;
-				curchunk->ident = 1;
+		if (compchunk->size == size) {
+			if (memcmp(compchunk->buf, buf, size) == 0) {
+				curchunk->shared = compchunk->shared;
+				curchunk->shared->users++;
+				memfile_global.stats.hit_position++;
 			}
 		}
 		compchunk = compchunk->next;
 	}
 	
-	/* not equal... */
-	if (curchunk->buf == NULL) {
-		curchunk->buf = MEM_mallocN(size, "Chunk buffer");
-		memcpy(curchunk->buf, buf, size);
-		current->size += size;
+	/* not equal, look it up by content */
+	if (curchunk->shared == NULL) {
+		int is_new;
+
+		curchunk->shared = memfile_shared_add(buf, size, memfile_hash_buf(buf, size), &is_new);
+
+		if (is_new) {
+			current->size += size;
+			memfile_global.stats.miss++;
+		}
+		else {
+			memfile_global.stats.hit_hash++;
+		}
 	}
-}
 
+	curchunk->buf = curchunk->shared->buf;
+
+	memfile_global.stats.mem_referenced += size;
+	memfile_global.stats.tot_chunks++;
+}
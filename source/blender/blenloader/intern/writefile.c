@@ -165,6 +165,7 @@
 #include "BLO_blend_defs.h"
 
 #include "readfile.h"
+#include "compressfile.h"
 
 #include <errno.h>
 
@@ -179,6 +180,7 @@ typedef struct {
 	int file;
 	unsigned char *buf;
 	MemFile *compare, *current;
+	struct CompressWriter *compress;  /* compressed on threads when set */
 	
 	int tot, count, error, memsize;
 
@@ -215,6 +217,9 @@ static void writedata_do_write(WriteData *wd, const void *mem, int memlen)
 	if (wd->current) {
 		add_memfilechunk(NULL, wd->current, mem, memlen);
 	}
+	else if (wd->compress) {
+		blo_compress_writer_write(wd->compress, mem, memlen);
+	}
 	else {
 		if (write(wd->file, mem, memlen) != memlen)
 			wd->error= 1;
@@ -322,6 +327,8 @@ static int endwrite(WriteData *wd)
 	}
 	
 	err= wd->error;
+	if (wd->compress)
+		err |= blo_compress_writer_end(wd->compress);
 	writedata_free(wd);
 
 	return err;
@@ -2927,6 +2934,15 @@ static int write_file_handle(Main *mainvar, int handle, MemFile *compare, MemFil
 
 	wd= bgnwrite(handle, compare, current);
 
+	if (current == NULL && (write_flags & G_FILE_COMPRESS)) {
+		int codec = BLO_CODEC_DEFLATE;
+
+		if (write_flags & G_FILE_COMPRESS_LZMA) codec = BLO_CODEC_LZMA;
+		else if (write_flags & G_FILE_COMPRESS_LZO) codec = BLO_CODEC_LZO;
+
+		wd->compress = blo_compress_writer_new(handle, codec);
+	}
+
 #ifdef USE_BMESH_SAVE_AS_COMPAT
 	wd->use_mesh_compat = (write_flags & G_FILE_MESH_COMPAT) != 0;
 #endif
@@ -3106,34 +3122,8 @@ int BLO_write_file(Main *mainvar, const char *filepath, int write_flags, ReportL
 		}
 	}
 
-	if (write_flags & G_FILE_COMPRESS) {
-		/* compressed files have the same ending as regular files... only from 2.4!!! */
-		char gzname[FILE_MAX+4];
-		int ret;
-
-		/* first write compressed to separate @.gz */
-		BLI_snprintf(gzname, sizeof(gzname), "%s@.gz", filepath);
-		ret = BLI_file_gzip(tempname, gzname);
-		
-		if (0==ret) {
-			/* now rename to real file name, and delete temp @ file too */
-			if (BLI_rename(gzname, filepath) != 0) {
-				BKE_report(reports, RPT_ERROR, "Cannot change old file (file saved with @)");
-				return 0;
-			}
-
-			BLI_delete(tempname, 0, 0);
-		}
-		else if (-1==ret) {
-			BKE_report(reports, RPT_ERROR, "Failed opening .gz file");
-			return 0;
-		}
-		else if (-2==ret) {
-			BKE_report(reports, RPT_ERROR, "Failed opening .blend file for compression");
-			return 0;
-		}
-	}
-	else if (BLI_rename(tempname, filepath) != 0) {
+	/* compressed files were already written in frames by write_file_handle() */
+	if (BLI_rename(tempname, filepath) != 0) {
 		BKE_report(reports, RPT_ERROR, "Cannot change old file (file saved with @)");
 		return 0;
 	}
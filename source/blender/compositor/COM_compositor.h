@@ -324,8 +324,9 @@ void COM_deinitialize(void);
 /**
  * @brief Clear all compositor caches. (Compositor system will still remain available). 
  * To deinitialize the compositor use the COM_deinitialize method.
+ * Called when a file is read, cached results must not outlive the data they were made from.
  */
-// void COM_clearCaches(void); // NOT YET WRITTEN
+void COM_clearCaches(void);
 
 /**
  * @brief Return a list of highlighted bnodes pointers.
@@ -107,6 +107,32 @@ typedef enum OrderOfChunks {
 
 #define COM_NUMBER_OF_CHANNELS 4
 
+/**
+ * @brief maximum number of pixels calculated by one executeRow call.
+ * chunks are split into row segments of at most this size, so operations can keep
+ * the rows of their inputs on the stack
+ * @see SocketReader.executeRow
+ */
+#define COM_ROW_SIZE 128
+
+/**
+ * @brief bpy.app.debug_value to calculate every pixel separately, for comparing with row execution
+ * @see CompositorContext.isRowExecution
+ */
+#define COM_DEBUG_VALUE_PIXEL_EXECUTION 710
+
 #define COM_BLUR_BOKEH_PIXELS 512
 
+/**
+ * @brief blur radius in pixels from which BokehBlurOperation convolves the whole image at once
+ * @see FFTConvolution
+ */
+#define COM_BOKEH_BLUR_FFT_RADIUS 32
+
+/**
+ * @brief memory in bytes for results of complex operations kept between executions
+ * @see ResultCache
+ */
+#define COM_RESULT_CACHE_SIZE (256 * 1024 * 1024)
+
 #endif
@@ -31,6 +31,8 @@ CompositorContext::CompositorContext()
 	this->m_hasActiveOpenCLDevices = false;
 	this->m_activegNode = NULL;
 	this->m_fastCalculation = false;
+	this->m_rowExecution = true;
+	this->m_resolutionDivider = 1;
 	this->m_viewSettings = NULL;
 	this->m_displaySettings = NULL;
 }
@@ -80,6 +80,17 @@ private:
 	 */
 	bool m_fastCalculation;
 
+	/**
+	 * @brief calculate ExecutionGroups of row operations in rows
+	 */
+	bool m_rowExecution;
+
+	/**
+	 * @brief the resolution is divided by this, for the proxy pass during editing
+	 * @see ExecutionSystem.addProxyScaleOperations
+	 */
+	int m_resolutionDivider;
+
 	/* @brief color management settings */
 	const ColorManagedViewSettings *m_viewSettings;
 	const ColorManagedDisplaySettings *m_displaySettings;
@@ -178,6 +189,12 @@ public:
 	
 	void setFastCalculation(bool fastCalculation) {this->m_fastCalculation = fastCalculation;}
 	bool isFastCalculation() {return this->m_fastCalculation;}
+
+	void setRowExecution(bool rowExecution) { this->m_rowExecution = rowExecution; }
+	bool isRowExecution() const { return this->m_rowExecution; }
+
+	void setResolutionDivider(int resolutionDivider) { this->m_resolutionDivider = resolutionDivider; }
+	int getResolutionDivider() const { return this->m_resolutionDivider; }
 };
 
 
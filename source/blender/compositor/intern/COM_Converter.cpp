@@ -519,6 +519,7 @@ void Converter::convertResolution(SocketConnection *connection, ExecutionSystem
 		}
 
 		TranslateOperation *translateOperation = new TranslateOperation();
+		translateOperation->setIsProxyDelta(true);
 		if (!first) first = translateOperation;
 		SetValueOperation *xop = new SetValueOperation();
 		xop->setValue(addX);
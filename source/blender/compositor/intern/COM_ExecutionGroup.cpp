@@ -59,6 +59,7 @@ ExecutionGroup::ExecutionGroup()
 	this->m_initialized = false;
 	this->m_openCL = false;
 	this->m_singleThreaded = false;
+	this->m_useRowExecution = false;
 	this->m_chunksFinished = 0;
 }
 
@@ -164,6 +165,8 @@ void ExecutionGroup::initExecution()
 
 
 	unsigned int maxNumber = 0;
+	NodeOperation *outputOperation = this->getOutputNodeOperation();
+	bool rowExecution = this->m_useRowExecution;
 
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
@@ -172,10 +175,16 @@ void ExecutionGroup::initExecution()
 			this->m_cachedReadOperations.push_back(readOperation);
 			maxNumber = max(maxNumber, readOperation->getOffset());
 		}
+		else if (operation != outputOperation && !operation->isRowOperation()) {
+			rowExecution = false;
+		}
 	}
 	maxNumber++;
 	this->m_cachedMaxReadBufferOffset = maxNumber;
 
+	/* the output operation reads its inputs a row at a time when they all support it */
+	outputOperation->setRowExecution(rowExecution);
+
 }
 
 void ExecutionGroup::deinitExecution()
@@ -397,6 +406,7 @@ MemoryBuffer **ExecutionGroup::getInputBuffersOpenCL(int chunkNumber)
 MemoryBuffer *ExecutionGroup::constructConsolidatedMemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
 {
 	MemoryBuffer *imageBuffer = memoryProxy->getBuffer();
+	/* OpenCL kernels expect four channels, whatever the data type of the proxy */
 	MemoryBuffer *result = new MemoryBuffer(memoryProxy, rect);
 	result->copyContentFrom(imageBuffer);
 	return result;
@@ -428,6 +438,26 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
 	}
 }
 
+void ExecutionGroup::setExecuted()
+{
+	for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+		this->m_chunkExecutionStates[index] = COM_ES_EXECUTED;
+	}
+}
+
+bool ExecutionGroup::isExecuted() const
+{
+	if (this->m_numberOfChunks == 0) {
+		return false;
+	}
+	for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+		if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+			return false;
+		}
+	}
+	return true;
+}
+
 inline void ExecutionGroup::determineChunkRect(rcti *rect, const unsigned int xChunk, const unsigned int yChunk) const
 {
 	if (this->m_singleThreaded) {
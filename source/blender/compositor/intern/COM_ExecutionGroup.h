@@ -120,6 +120,12 @@ private:
 	 * @brief Is this Execution group SingleThreaded
 	 */
 	bool m_singleThreaded;
+
+	/**
+	 * @brief may this ExecutionGroup be calculated in rows
+	 * @see NodeOperation.isRowOperation
+	 */
+	bool m_useRowExecution;
 	
 	/**
 	 * @brief what is the maximum number field of all ReadBufferOperation in this ExecutionGroup.
@@ -342,6 +348,17 @@ public:
 	 * @param memorybuffers
 	 */
 	void finalizeChunkExecution(int chunkNumber, MemoryBuffer **memoryBuffers);
+
+	/**
+	 * @brief mark all chunks as executed, the groups this group depends on will not be scheduled for it.
+	 * @note used when the result of this ExecutionGroup was restored from the ResultCache
+	 */
+	void setExecuted();
+
+	/**
+	 * @brief are all chunks of this ExecutionGroup executed
+	 */
+	bool isExecuted() const;
 	
 	/**
 	 * @brief deinitExecution is called just after execution the whole graph.
@@ -389,6 +406,12 @@ public:
 
 	void setChunksize(int chunksize) { this->m_chunkSize = chunksize; }
 
+	/**
+	 * @brief allow calculating this ExecutionGroup in rows when all its operations support it
+	 * @see initExecution
+	 */
+	void setUseRowExecution(bool useRowExecution) { this->m_useRowExecution = useRowExecution; }
+
 	/**
 	 * @brief get the Render priority of this ExecutionGroup
 	 * @see ExecutionSystem.execute
@@ -26,6 +26,7 @@
 
 #include "PIL_time.h"
 #include "BLI_utildefines.h"
+#include "BLI_string.h"
 #include "BKE_node.h"
 
 #include "COM_Converter.h"
@@ -38,6 +39,8 @@
 #include "COM_WriteBufferOperation.h"
 #include "COM_ReadBufferOperation.h"
 #include "COM_ExecutionSystemHelper.h"
+#include "COM_ResultCache.h"
+#include "COM_ProxyScaleOperation.h"
 
 #include "BKE_global.h"
 
@@ -46,10 +49,12 @@
 #endif
 
 ExecutionSystem::ExecutionSystem(RenderData *rd, bNodeTree *editingtree, bool rendering, bool fastcalculation,
-                                 const ColorManagedViewSettings *viewSettings, const ColorManagedDisplaySettings *displaySettings)
+                                 const ColorManagedViewSettings *viewSettings, const ColorManagedDisplaySettings *displaySettings,
+                                 int resolutionDivider)
 {
 	this->m_context.setbNodeTree(editingtree);
 	this->m_context.setFastCalculation(fastcalculation);
+	this->m_context.setResolutionDivider(resolutionDivider);
 	bNode *gnode;
 	for (gnode = (bNode *)editingtree->nodes.first; gnode; gnode = gnode->next) {
 		if (gnode->type == NODE_GROUP && gnode->typeinfo->group_edit_get(gnode)) {
@@ -67,6 +72,7 @@ ExecutionSystem::ExecutionSystem(RenderData *rd, bNodeTree *editingtree, bool re
 	}
 	this->m_context.setRendering(rendering);
 	this->m_context.setHasActiveOpenCLDevices(WorkScheduler::hasGPUDevices() && (editingtree->flag & NTREE_COM_OPENCL));
+	this->m_context.setRowExecution(G.debug_value != COM_DEBUG_VALUE_PIXEL_EXECUTION);
 
 	ExecutionSystemHelper::addbNodeTree(*this, 0, editingtree, NULL);
 
@@ -76,6 +82,7 @@ ExecutionSystem::ExecutionSystem(RenderData *rd, bNodeTree *editingtree, bool re
 
 	this->convertToOperations();
 	this->groupOperations(); /* group operations in ExecutionGroups */
+	this->determineMemoryProxyDataTypes();
 	unsigned int index;
 	unsigned int resolution[2];
 	for (index = 0; index < this->m_groups.size(); index++) {
@@ -117,6 +124,8 @@ ExecutionSystem::~ExecutionSystem()
 
 void ExecutionSystem::execute()
 {
+	MemoryBuffer::resetPeakMemory();
+
 	unsigned int order = 0;
 	for (vector<NodeOperation *>::iterator iter = this->m_operations.begin(); iter != this->m_operations.end(); ++iter) {
 		NodeBase *node = *iter;
@@ -132,8 +141,16 @@ void ExecutionSystem::execute()
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
 		operation->setbNodeTree(this->m_context.getbNodeTree());
+		operation->setResolutionDivider(this->m_context.getResolutionDivider());
 		operation->initExecution();
 	}
+	for (index = 0; index < this->m_groups.size(); index++) {
+		ExecutionGroup *executionGroup = this->m_groups[index];
+		executionGroup->setChunksize(this->m_context.getChunksize());
+		executionGroup->setUseRowExecution(this->m_context.isRowExecution());
+		executionGroup->initExecution();
+	}
+	this->restoreCachedResults();
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
 		if (operation->isReadBufferOperation()) {
@@ -141,11 +158,6 @@ void ExecutionSystem::execute()
 			readOperation->updateMemoryBuffer();
 		}
 	}
-	for (index = 0; index < this->m_groups.size(); index++) {
-		ExecutionGroup *executionGroup = this->m_groups[index];
-		executionGroup->setChunksize(this->m_context.getChunksize());
-		executionGroup->initExecution();
-	}
 
 	WorkScheduler::start(this->m_context);
 
@@ -158,6 +170,8 @@ void ExecutionSystem::execute()
 	WorkScheduler::finish();
 	WorkScheduler::stop();
 
+	this->storeCachedResults();
+
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
 		operation->deinitExecution();
@@ -166,6 +180,76 @@ void ExecutionSystem::execute()
 		ExecutionGroup *executionGroup = this->m_groups[index];
 		executionGroup->deinitExecution();
 	}
+
+	this->reportPeakMemory();
+}
+
+void ExecutionSystem::reportPeakMemory()
+{
+	const bNodeTree *bTree = this->m_context.getbNodeTree();
+	char str[64];
+
+	BLI_snprintf(str, sizeof(str), "Compositing | Peak buffer memory: %.2fM",
+	             (double)MemoryBuffer::getPeakMemory() / (1024.0 * 1024.0));
+
+	if (bTree->stats_draw) {
+		bTree->stats_draw(bTree->sdh, str);
+	}
+	if (G.debug & G_DEBUG) {
+		printf("%s\n", str);
+	}
+}
+
+void ExecutionSystem::restoreCachedResults()
+{
+	unsigned int index;
+	for (index = 0; index < this->m_operations.size(); index++) {
+		NodeOperation *operation = this->m_operations[index];
+		if (!operation->isWriteBufferOperation()) {
+			continue;
+		}
+
+		/* only complex operations are worth keeping */
+		WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+		ExecutionGroup *group = writeOperation->getMemoryProxy()->getExecutor();
+		uint64_t key;
+		if (group == NULL || !group->isComplex() ||
+		    !ResultCache::determineKey(writeOperation, this->m_context, &key))
+		{
+			continue;
+		}
+
+		writeOperation->setCacheKey(key);
+		MemoryBuffer *buffer = ResultCache::take(key, writeOperation->getWidth(), writeOperation->getHeight(),
+		                                         writeOperation->getMemoryProxy()->getDataType());
+		if (buffer) {
+			writeOperation->getMemoryProxy()->setBuffer(buffer);
+			writeOperation->setRestored();
+			group->setExecuted();
+		}
+	}
+}
+
+void ExecutionSystem::storeCachedResults()
+{
+	/* when cancelled buffers can be partly calculated, only the restored ones are complete */
+	const bNodeTree *bTree = this->m_context.getbNodeTree();
+	const bool breaked = bTree->test_break && bTree->test_break(bTree->tbh);
+
+	unsigned int index;
+	for (index = 0; index < this->m_operations.size(); index++) {
+		NodeOperation *operation = this->m_operations[index];
+		if (operation->isWriteBufferOperation()) {
+			WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+			MemoryProxy *memoryProxy = writeOperation->getMemoryProxy();
+			if (!writeOperation->hasCacheKey() || (breaked && !writeOperation->isRestored())) {
+				continue;
+			}
+			if (memoryProxy->getExecutor()->isExecuted()) {
+				ResultCache::store(writeOperation->getCacheKey(), memoryProxy->releaseBuffer());
+			}
+		}
+	}
 }
 
 void ExecutionSystem::executeGroups(CompositorPriority priority)
@@ -241,6 +325,52 @@ void ExecutionSystem::addReadWriteBufferOperations(NodeOperation *operation)
 	}
 }
 
+void ExecutionSystem::addProxyScaleOperations()
+{
+	const int divider = this->m_context.getResolutionDivider();
+	const unsigned int numberOfOperations = this->m_operations.size();
+	unsigned int index;
+
+	for (index = 0; index < numberOfOperations; index++) {
+		NodeOperation *operation = this->m_operations[index];
+
+		if (operation->getNumberOfInputSockets() == 0 && !operation->isSetOperation()) {
+			/* operations reading images, render layers, clips and masks at their own resolution */
+			for (unsigned int socketIndex = 0; socketIndex < operation->getNumberOfOutputSockets(); socketIndex++) {
+				OutputSocket *outputSocket = operation->getOutputSocket(socketIndex);
+				if (outputSocket->isConnected()) {
+					ProxyDownscaleOperation *downscale = new ProxyDownscaleOperation(outputSocket->getDataType(), divider);
+					outputSocket->relinkConnections(downscale->getOutputSocket());
+					ExecutionSystemHelper::addLink(this->getConnections(), outputSocket, downscale->getInputSocket(0));
+					this->addOperation(downscale);
+				}
+			}
+		}
+		else if (operation->isOutputOperation(this->m_context.isRendering()) && !operation->isPreviewOperation()) {
+			for (unsigned int socketIndex = 0; socketIndex < operation->getNumberOfInputSockets(); socketIndex++) {
+				InputSocket *inputSocket = operation->getInputSocket(socketIndex);
+				if (!inputSocket->isConnected()) {
+					continue;
+				}
+				NodeOperation *fromOperation = (NodeOperation *)inputSocket->getConnection()->getFromNode();
+				if (!fromOperation->isSetOperation()) {
+					ProxyUpscaleOperation *upscale = new ProxyUpscaleOperation(inputSocket->getDataType(), divider,
+					                                                           fromOperation->getWidth(),
+					                                                           fromOperation->getHeight());
+					inputSocket->relinkConnections(upscale->getInputSocket(0));
+					ExecutionSystemHelper::addLink(this->getConnections(), upscale->getOutputSocket(), inputSocket);
+					this->addOperation(upscale);
+				}
+			}
+		}
+	}
+
+	/* resolutions are determined again with the reduced inputs */
+	for (index = 0; index < this->m_operations.size(); index++) {
+		this->m_operations[index]->resetResolution();
+	}
+}
+
 #ifndef NDEBUG
 /* if this fails, there are still connection to/from this node,
  * which have not been properly relinked to operations!
@@ -269,8 +399,17 @@ void ExecutionSystem::convertToOperations()
 	unsigned int index;
 	for (index = 0; index < this->m_nodes.size(); index++) {
 		Node *node = (Node *)this->m_nodes[index];
+		unsigned int firstOperation = this->m_operations.size();
 		node->convertToOperations(this, &this->m_context);
 
+		/* remember which node the operations were created from, the settings are part of the ResultCache key */
+		for (unsigned int operationIndex = firstOperation; operationIndex < this->m_operations.size(); operationIndex++) {
+			NodeOperation *operation = this->m_operations[operationIndex];
+			if (operation->getbNode() == NULL) {
+				operation->setbNode(node->getbNode());
+			}
+		}
+
 		debug_check_node_connections(node);
 	}
 
@@ -283,6 +422,35 @@ void ExecutionSystem::convertToOperations()
 		}
 	}
 
+	if (this->m_context.getResolutionDivider() > 1) {
+		/* the outputs keep the resolution of the full resolution pass */
+		this->determineResolutions();
+		this->addProxyScaleOperations();
+	}
+
+	this->determineResolutions();
+
+	// add convert resolution operations when needed.
+	for (index = 0; index < this->m_connections.size(); index++) {
+		SocketConnection *connection = this->m_connections[index];
+		if (connection->isValid()) {
+			if (connection->needsResolutionConversion()) {
+				Converter::convertResolution(connection, this);
+			}
+		}
+	}
+}
+
+void ExecutionSystem::determineResolutions()
+{
+	unsigned int index;
+
+	/* operations scaling their settings for a proxy pass need the divider
+	 * when their resolution is determined */
+	for (index = 0; index < this->m_operations.size(); index++) {
+		this->m_operations[index]->setResolutionDivider(this->m_context.getResolutionDivider());
+	}
+
 	// determine all resolutions of the operations (Width/Height)
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
@@ -302,16 +470,6 @@ void ExecutionSystem::convertToOperations()
 			operation->setResolution(resolution);
 		}
 	}
-
-	// add convert resolution operations when needed.
-	for (index = 0; index < this->m_connections.size(); index++) {
-		SocketConnection *connection = this->m_connections[index];
-		if (connection->isValid()) {
-			if (connection->needsResolutionConversion()) {
-				Converter::convertResolution(connection, this);
-			}
-		}
-	}
 }
 
 void ExecutionSystem::groupOperations()
@@ -336,6 +494,46 @@ void ExecutionSystem::groupOperations()
 	}
 }
 
+void ExecutionSystem::determineMemoryProxyDataTypes()
+{
+	unsigned int index;
+	/* buffers store the channels of the data type that is written */
+	for (index = 0; index < this->m_operations.size(); index++) {
+		NodeOperation *operation = this->m_operations[index];
+		if (operation->isWriteBufferOperation()) {
+			WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+			InputSocket *inputSocket = writeOperation->getInputSocket(0);
+			if (inputSocket->isConnected()) {
+				writeOperation->getMemoryProxy()->setDataType(inputSocket->getConnection()->getFromSocket()->getDataType());
+			}
+		}
+	}
+
+	/* unless a complex operation reading it directly expects all channels */
+	for (index = 0; index < this->m_operations.size(); index++) {
+		NodeOperation *operation = this->m_operations[index];
+		if (!operation->isReadBufferOperation()) {
+			continue;
+		}
+		ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+		OutputSocket *outputSocket = readOperation->getOutputSocket();
+		for (int connectionIndex = 0; connectionIndex < outputSocket->getNumberOfConnections(); connectionIndex++) {
+			SocketConnection *connection = outputSocket->getConnection(connectionIndex);
+			NodeOperation *toOperation = (NodeOperation *)connection->getToNode();
+			if (!toOperation->isComplex()) {
+				continue;
+			}
+			for (unsigned int socketIndex = 0; socketIndex < toOperation->getNumberOfInputSockets(); socketIndex++) {
+				if (toOperation->getInputSocket(socketIndex)->getConnection() == connection &&
+				    !toOperation->isChannelAwareInput(socketIndex))
+				{
+					readOperation->getMemoryProxy()->setDataType(COM_DT_COLOR);
+				}
+			}
+		}
+	}
+}
+
 void ExecutionSystem::addSocketConnection(SocketConnection *connection)
 {
 	this->m_connections.push_back(connection);
@@ -138,6 +138,24 @@ private: //methods
 	 */
 	void addReadWriteBufferOperations(NodeOperation *operation);
 
+	/**
+	 * @brief calculate the tree at a lower resolution for the proxy pass
+	 *
+	 * The data of operations without inputs, like images and render layers, is scaled down.
+	 * Inputs of output operations are scaled back up to the resolution they have in the full
+	 * resolution pass, so viewers and the composite keep their size.
+	 * Operations divide their settings in pixels by the divider themselves.
+	 * @note expects the resolutions of the full resolution pass to be determined, clears them
+	 * @see CompositorContext.getResolutionDivider
+	 * @see NodeOperation.getResolutionDivider
+	 */
+	void addProxyScaleOperations();
+
+	/**
+	 * @brief determine the resolution of all operations, starting at the outputs
+	 */
+	void determineResolutions();
+
 
 	/**
 	 * find all execution group with output nodes
@@ -156,9 +174,11 @@ public:
 	 *
 	 * @param editingtree [bNodeTree *]
 	 * @param rendering [true false]
+	 * @param resolutionDivider calculate at the resolution divided by this, for the proxy pass
 	 */
 	ExecutionSystem(RenderData *rd, bNodeTree *editingtree, bool rendering, bool fastcalculation,
-	                const ColorManagedViewSettings *viewSettings, const ColorManagedDisplaySettings *displaySettings);
+	                const ColorManagedViewSettings *viewSettings, const ColorManagedDisplaySettings *displaySettings,
+	                int resolutionDivider);
 
 	/**
 	 * Destructor
@@ -204,6 +224,18 @@ public:
 	 */
 	void groupOperations();
 
+	/**
+	 * @brief determine the data types of the MemoryProxies, so buffers of values and vectors
+	 * are stored with less channels
+	 * @see MemoryBuffer.getNumberOfChannels
+	 */
+	void determineMemoryProxyDataTypes();
+
+	/**
+	 * @brief report the peak memory of the MemoryBuffers during the last execution
+	 */
+	void reportPeakMemory();
+
 	/**
 	 * @brief get the reference to the compositor context
 	 */
@@ -239,6 +271,18 @@ private:
 	
 	void executeGroups(CompositorPriority priority);
 
+	/**
+	 * @brief restore buffers of complex ExecutionGroups calculated by an earlier execution
+	 * the restored groups and the groups only they depend on are not calculated again
+	 * @see ResultCache
+	 */
+	void restoreCachedResults();
+
+	/**
+	 * @brief give the fully calculated buffers of complex ExecutionGroups to the ResultCache
+	 */
+	void storeCachedResults();
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:ExecutionSystem")
 #endif
@@ -24,6 +24,27 @@
 #include "MEM_guardedalloc.h"
 //#include "BKE_global.h"
 
+extern "C" {
+	#include "BLI_threads.h"
+}
+
+/* memory of all buffers, allocated from any thread */
+static ThreadMutex s_memoryMutex = BLI_MUTEX_INITIALIZER;
+static size_t s_memoryInUse = 0;
+static size_t s_peakMemory = 0;
+
+static unsigned int datatype_channels(DataType datatype)
+{
+	switch (datatype) {
+		case COM_DT_VALUE:
+			return 1;
+		case COM_DT_VECTOR:
+			return 3;
+		default:
+			return COM_NUMBER_OF_CHANNELS;
+	}
+}
+
 unsigned int MemoryBuffer::determineBufferSize()
 {
 	return getWidth() * getHeight();
@@ -38,36 +59,60 @@ int MemoryBuffer::getHeight() const
 	return this->m_rect.ymax - this->m_rect.ymin;
 }
 
-MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect)
+MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect, DataType datatype)
 {
 	BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
 	this->m_memoryProxy = memoryProxy;
 	this->m_chunkNumber = chunkNumber;
-	this->m_buffer = (float *)MEM_mallocN(sizeof(float) * determineBufferSize() * COM_NUMBER_OF_CHANNELS, "COM_MemoryBuffer");
+	this->allocate(datatype);
 	this->m_state = COM_MB_ALLOCATED;
-	this->m_datatype = COM_DT_COLOR;
-	this->m_chunkWidth = this->m_rect.xmax - this->m_rect.xmin;
 }
 
-MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
+MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect, DataType datatype)
 {
 	BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
 	this->m_memoryProxy = memoryProxy;
 	this->m_chunkNumber = -1;
-	this->m_buffer = (float *)MEM_mallocN(sizeof(float) * determineBufferSize() * COM_NUMBER_OF_CHANNELS, "COM_MemoryBuffer");
+	this->allocate(datatype);
 	this->m_state = COM_MB_TEMPORARILY;
-	this->m_datatype = COM_DT_COLOR;
+}
+
+void MemoryBuffer::allocate(DataType datatype)
+{
+	const size_t size = sizeof(float) * determineBufferSize() * datatype_channels(datatype);
+
+	this->m_datatype = datatype;
+	this->m_numberOfChannels = datatype_channels(datatype);
 	this->m_chunkWidth = this->m_rect.xmax - this->m_rect.xmin;
+	this->m_buffer = (float *)MEM_mallocN(size, "COM_MemoryBuffer");
+
+	BLI_mutex_lock(&s_memoryMutex);
+	s_memoryInUse += size;
+	s_peakMemory = max(s_peakMemory, s_memoryInUse);
+	BLI_mutex_unlock(&s_memoryMutex);
+}
+
+void MemoryBuffer::resetPeakMemory()
+{
+	BLI_mutex_lock(&s_memoryMutex);
+	s_peakMemory = s_memoryInUse;
+	BLI_mutex_unlock(&s_memoryMutex);
 }
+
+size_t MemoryBuffer::getPeakMemory()
+{
+	return s_peakMemory;
+}
+
 MemoryBuffer *MemoryBuffer::duplicate()
 {
-	MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect);
-	memcpy(result->m_buffer, this->m_buffer, this->determineBufferSize() * COM_NUMBER_OF_CHANNELS * sizeof(float));
+	MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect, this->m_datatype);
+	memcpy(result->m_buffer, this->m_buffer, this->determineBufferSize() * this->m_numberOfChannels * sizeof(float));
 	return result;
 }
 void MemoryBuffer::clear()
 {
-	memset(this->m_buffer, 0, this->determineBufferSize() * COM_NUMBER_OF_CHANNELS * sizeof(float));
+	memset(this->m_buffer, 0, this->determineBufferSize() * this->m_numberOfChannels * sizeof(float));
 }
 
 float *MemoryBuffer::convertToValueBuffer()
@@ -80,7 +125,7 @@ float *MemoryBuffer::convertToValueBuffer()
 	const float *fp_src = this->m_buffer;
 	float       *fp_dst = result;
 
-	for (i = 0; i < size; i++, fp_dst++, fp_src += COM_NUMBER_OF_CHANNELS) {
+	for (i = 0; i < size; i++, fp_dst++, fp_src += this->m_numberOfChannels) {
 		*fp_dst = *fp_src;
 	}
 
@@ -95,7 +140,7 @@ float MemoryBuffer::getMaximumValue()
 
 	const float *fp_src = this->m_buffer;
 
-	for (i = 0; i < size; i++, fp_src += COM_NUMBER_OF_CHANNELS) {
+	for (i = 0; i < size; i++, fp_src += this->m_numberOfChannels) {
 		float value = *fp_src;
 		if (value > result) {
 			result = value;
@@ -113,7 +158,7 @@ float MemoryBuffer::getMaximumValue(rcti *rect)
 	BLI_rcti_isect(rect, &this->m_rect, &rect_clamp);
 
 	if (!BLI_rcti_is_empty(&rect_clamp)) {
-		MemoryBuffer *temp = new MemoryBuffer(NULL, &rect_clamp);
+		MemoryBuffer *temp = new MemoryBuffer(NULL, &rect_clamp, this->m_datatype);
 		temp->copyContentFrom(this);
 		float result = temp->getMaximumValue();
 		delete temp;
@@ -125,9 +170,42 @@ float MemoryBuffer::getMaximumValue(rcti *rect)
 	}
 }
 
+void MemoryBuffer::readRow(float *result, int x, int y, int width)
+{
+	const int xmin = max_ii(x, this->m_rect.xmin);
+	const int xmax = min_ii(x + width, this->m_rect.xmax);
+
+	if (y < this->m_rect.ymin || y >= this->m_rect.ymax || xmin >= xmax) {
+		memset(result, 0, sizeof(float) * width * COM_NUMBER_OF_CHANNELS);
+		return;
+	}
+
+	const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + (xmin - this->m_rect.xmin)) * this->m_numberOfChannels;
+
+	if (xmin > x) {
+		memset(result, 0, sizeof(float) * (xmin - x) * COM_NUMBER_OF_CHANNELS);
+	}
+	if (this->m_numberOfChannels == COM_NUMBER_OF_CHANNELS) {
+		memcpy(&result[(xmin - x) * COM_NUMBER_OF_CHANNELS], &this->m_buffer[offset],
+		       sizeof(float) * (xmax - xmin) * COM_NUMBER_OF_CHANNELS);
+	}
+	else {
+		for (int i = 0; i < xmax - xmin; i++) {
+			readPixel(&result[(xmin - x + i) * COM_NUMBER_OF_CHANNELS], offset + i * this->m_numberOfChannels);
+		}
+	}
+	if (xmax < x + width) {
+		memset(&result[(xmax - x) * COM_NUMBER_OF_CHANNELS], 0, sizeof(float) * (x + width - xmax) * COM_NUMBER_OF_CHANNELS);
+	}
+}
+
 MemoryBuffer::~MemoryBuffer()
 {
 	if (this->m_buffer) {
+		BLI_mutex_lock(&s_memoryMutex);
+		s_memoryInUse -= sizeof(float) * determineBufferSize() * this->m_numberOfChannels;
+		BLI_mutex_unlock(&s_memoryMutex);
+
 		MEM_freeN(this->m_buffer);
 		this->m_buffer = NULL;
 	}
@@ -144,14 +222,28 @@ void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
 	unsigned int maxX = min(this->m_rect.xmax, otherBuffer->m_rect.xmax);
 	unsigned int minY = max(this->m_rect.ymin, otherBuffer->m_rect.ymin);
 	unsigned int maxY = min(this->m_rect.ymax, otherBuffer->m_rect.ymax);
+	const unsigned int numberOfChannels = this->m_numberOfChannels;
+	const unsigned int otherNumberOfChannels = otherBuffer->m_numberOfChannels;
 	int offset;
 	int otherOffset;
 
 
 	for (otherY = minY; otherY < maxY; otherY++) {
-		otherOffset = ((otherY - otherBuffer->m_rect.ymin) * otherBuffer->m_chunkWidth + minX - otherBuffer->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		offset = ((otherY - this->m_rect.ymin) * this->m_chunkWidth + minX - this->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		memcpy(&this->m_buffer[offset], &otherBuffer->m_buffer[otherOffset], (maxX - minX) * COM_NUMBER_OF_CHANNELS * sizeof(float));
+		otherOffset = ((otherY - otherBuffer->m_rect.ymin) * otherBuffer->m_chunkWidth + minX - otherBuffer->m_rect.xmin) * otherNumberOfChannels;
+		offset = ((otherY - this->m_rect.ymin) * this->m_chunkWidth + minX - this->m_rect.xmin) * numberOfChannels;
+		if (numberOfChannels == otherNumberOfChannels) {
+			memcpy(&this->m_buffer[offset], &otherBuffer->m_buffer[otherOffset], (maxX - minX) * numberOfChannels * sizeof(float));
+		}
+		else {
+			/* channels the other buffer does not store are zero */
+			float color[4];
+			for (unsigned int x = minX; x < maxX; x++) {
+				otherBuffer->readPixel(color, otherOffset);
+				memcpy(&this->m_buffer[offset], color, numberOfChannels * sizeof(float));
+				offset += numberOfChannels;
+				otherOffset += otherNumberOfChannels;
+			}
+		}
 	}
 }
 
@@ -160,8 +252,8 @@ void MemoryBuffer::writePixel(int x, int y, const float color[4])
 	if (x >= this->m_rect.xmin && x < this->m_rect.xmax &&
 	    y >= this->m_rect.ymin && y < this->m_rect.ymax)
 	{
-		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		copy_v4_v4(&this->m_buffer[offset], color);
+		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * this->m_numberOfChannels;
+		memcpy(&this->m_buffer[offset], color, this->m_numberOfChannels * sizeof(float));
 	}
 }
 
@@ -170,8 +262,10 @@ void MemoryBuffer::addPixel(int x, int y, const float color[4])
 	if (x >= this->m_rect.xmin && x < this->m_rect.xmax &&
 	    y >= this->m_rect.ymin && y < this->m_rect.ymax)
 	{
-		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		add_v4_v4(&this->m_buffer[offset], color);
+		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * this->m_numberOfChannels;
+		for (unsigned int channel = 0; channel < this->m_numberOfChannels; channel++) {
+			this->m_buffer[offset + channel] += color[channel];
+		}
 	}
 }
 
@@ -62,6 +62,11 @@ private:
 	 * @brief the type of buffer COM_DT_VALUE, COM_DT_VECTOR, COM_DT_COLOR
 	 */
 	DataType m_datatype;
+
+	/**
+	 * @brief number of floats stored per pixel, 1 for values, 3 for vectors and 4 for colors
+	 */
+	unsigned int m_numberOfChannels;
 	
 	
 	/**
@@ -94,12 +99,12 @@ public:
 	/**
 	 * @brief construct new MemoryBuffer for a chunk
 	 */
-	MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect);
+	MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect, DataType datatype = COM_DT_COLOR);
 	
 	/**
 	 * @brief construct new temporarily MemoryBuffer for an area
 	 */
-	MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect);
+	MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect, DataType datatype = COM_DT_COLOR);
 	
 	/**
 	 * @brief destructor
@@ -110,12 +115,30 @@ public:
 	 * @brief read the ChunkNumber of this MemoryBuffer
 	 */
 	unsigned int getChunkNumber() { return this->m_chunkNumber; }
+
+	/**
+	 * @brief set the proxy of a buffer kept from an earlier execution
+	 * @see MemoryProxy.setBuffer
+	 */
+	void setMemoryProxy(MemoryProxy *memoryProxy) { this->m_memoryProxy = memoryProxy; }
 	
 	/**
 	 * @brief get the data of this MemoryBuffer
 	 * @note buffer should already be available in memory
 	 */
 	float *getBuffer() { return this->m_buffer; }
+
+	/**
+	 * @brief get the data type of this MemoryBuffer
+	 */
+	DataType getDataType() const { return this->m_datatype; }
+
+	/**
+	 * @brief get the number of floats per pixel in the data of this MemoryBuffer
+	 * @note all read methods return COM_NUMBER_OF_CHANNELS floats per pixel, channels that are
+	 * not stored are zero
+	 */
+	unsigned int getNumberOfChannels() const { return this->m_numberOfChannels; }
 	
 	/**
 	 * @brief after execution the state will be set to available by calling this method
@@ -132,8 +155,8 @@ public:
 		{
 			const int dx = x - this->m_rect.xmin;
 			const int dy = y - this->m_rect.ymin;
-			const int offset = (this->m_chunkWidth * dy + dx) * COM_NUMBER_OF_CHANNELS;
-			copy_v4_v4(result, &this->m_buffer[offset]);
+			const int offset = (this->m_chunkWidth * dy + dx) * this->m_numberOfChannels;
+			readPixel(result, offset);
 		}
 		else {
 			zero_v4(result);
@@ -144,22 +167,28 @@ public:
 	{
 		const int dx = x - this->m_rect.xmin;
 		const int dy = y - this->m_rect.ymin;
-		const int offset = (this->m_chunkWidth * dy + dx) * COM_NUMBER_OF_CHANNELS;
+		const int offset = (this->m_chunkWidth * dy + dx) * this->m_numberOfChannels;
 
 		BLI_assert(offset >= 0);
-		BLI_assert(offset < this->determineBufferSize() * COM_NUMBER_OF_CHANNELS);
+		BLI_assert(offset < this->determineBufferSize() * this->m_numberOfChannels);
 		BLI_assert(x >= this->m_rect.xmin && x < this->m_rect.xmax &&
 		           y >= this->m_rect.ymin && y < this->m_rect.ymax);
 
 #if 0
 		/* always true */
 		BLI_assert((int)(MEM_allocN_len(this->m_buffer) / sizeof(*this->m_buffer)) ==
-		           (int)(this->determineBufferSize() * COM_NUMBER_OF_CHANNELS));
+		           (int)(this->determineBufferSize() * this->m_numberOfChannels));
 #endif
 
-		copy_v4_v4(result, &this->m_buffer[offset]);
+		readPixel(result, offset);
 	}
 	
+	/**
+	 * @brief read a row of pixels, pixels outside of this buffer are black transparent
+	 * @see read
+	 */
+	void readRow(float *result, int x, int y, int width);
+
 	void writePixel(int x, int y, const float color[4]);
 	void addPixel(int x, int y, const float color[4]);
 	inline void readCubic(float result[4], float x, float y)
@@ -243,9 +272,37 @@ public:
 	float *convertToValueBuffer();
 	float getMaximumValue();
 	float getMaximumValue(rcti *rect);
+
+	/**
+	 * @brief start measuring the peak memory used by all MemoryBuffers from the memory currently in use
+	 */
+	static void resetPeakMemory();
+
+	/**
+	 * @brief get the peak memory in bytes used by all MemoryBuffers since resetPeakMemory
+	 */
+	static size_t getPeakMemory();
 private:
 	unsigned int determineBufferSize();
 
+	void allocate(DataType datatype);
+
+	inline void readPixel(float result[4], const int offset)
+	{
+		if (this->m_numberOfChannels == COM_NUMBER_OF_CHANNELS) {
+			copy_v4_v4(result, &this->m_buffer[offset]);
+		}
+		else {
+			unsigned int channel;
+			for (channel = 0; channel < this->m_numberOfChannels; channel++) {
+				result[channel] = this->m_buffer[offset + channel];
+			}
+			for (; channel < COM_NUMBER_OF_CHANNELS; channel++) {
+				result[channel] = 0.0f;
+			}
+		}
+	}
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryBuffer")
 #endif
@@ -27,6 +27,8 @@ MemoryProxy::MemoryProxy()
 {
 	this->m_writeBufferOperation = NULL;
 	this->m_executor = NULL;
+	this->m_buffer = NULL;
+	this->m_datatype = COM_DT_COLOR;
 }
 
 void MemoryProxy::allocate(unsigned int width, unsigned int height)
@@ -37,7 +39,7 @@ void MemoryProxy::allocate(unsigned int width, unsigned int height)
 	result.ymin = 0;
 	result.ymax = height;
 
-	this->m_buffer = new MemoryBuffer(this, 1, &result);
+	this->m_buffer = new MemoryBuffer(this, 1, &result, this->m_datatype);
 }
 
 void MemoryProxy::free()
@@ -48,3 +50,16 @@ void MemoryProxy::free()
 	}
 }
 
+void MemoryProxy::setBuffer(MemoryBuffer *buffer)
+{
+	this->free();
+	buffer->setMemoryProxy(this);
+	this->m_buffer = buffer;
+}
+
+MemoryBuffer *MemoryProxy::releaseBuffer()
+{
+	MemoryBuffer *buffer = this->m_buffer;
+	this->m_buffer = NULL;
+	return buffer;
+}
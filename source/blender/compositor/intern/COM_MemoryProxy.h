@@ -48,9 +48,9 @@ private:
 	ExecutionGroup *m_executor;
 	
 	/**
-	 * @brief datatype of this MemoryProxy
+	 * @brief datatype of this MemoryProxy, determines the number of channels of the buffer
 	 */
-	/* DataType m_datatype; */ /* UNUSED */
+	DataType m_datatype;
 	
 	/**
 	 * @brief channel information of this buffer
@@ -88,6 +88,17 @@ public:
 	 */
 	WriteBufferOperation *getWriteBufferOperation() { return this->m_writeBufferOperation; }
 
+	/**
+	 * @brief set the datatype of the buffer, values and vectors are stored with less channels
+	 * @see ExecutionSystem.determineMemoryProxyDataTypes
+	 */
+	void setDataType(DataType datatype) { this->m_datatype = datatype; }
+
+	/**
+	 * @brief get the datatype of the buffer
+	 */
+	DataType getDataType() const { return this->m_datatype; }
+
 	/**
 	 * @brief allocate memory of size width x height
 	 */
@@ -103,6 +114,19 @@ public:
 	 */
 	inline MemoryBuffer *getBuffer() { return this->m_buffer; }
 
+	/**
+	 * @brief replace the allocated memory by a buffer that was calculated before
+	 * @note the proxy takes ownership of the buffer
+	 * @see ResultCache
+	 */
+	void setBuffer(MemoryBuffer *buffer);
+
+	/**
+	 * @brief take the allocated memory from the proxy, it will not be freed by the proxy
+	 * @see ResultCache
+	 */
+	MemoryBuffer *releaseBuffer();
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryProxy")
 #endif
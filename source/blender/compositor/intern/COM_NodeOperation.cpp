@@ -35,7 +35,9 @@ NodeOperation::NodeOperation() : NodeBase()
 	this->m_width = 0;
 	this->m_height = 0;
 	this->m_openCL = false;
+	this->m_rowExecution = false;
 	this->m_btree = NULL;
+	this->m_resolutionDivider = 1;
 }
 
 void NodeOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
@@ -65,6 +65,13 @@ private:
 	 */
 	bool m_openCL;
 
+	/**
+	 * @brief is the output of this operation calculated in rows.
+	 * @note only set for the output operation of an ExecutionGroup
+	 * @see ExecutionGroup.initExecution
+	 */
+	bool m_rowExecution;
+
 	/**
 	 * @brief mutex reference for very special node initializations
 	 * @note only use when you really know what you are doing.
@@ -81,6 +88,12 @@ private:
 	 */
 	const bNodeTree *m_btree;
 
+	/**
+	 * @brief the resolution of the inputs is divided by this in the proxy pass
+	 * @see CompositorContext.getResolutionDivider
+	 */
+	int m_resolutionDivider;
+
 public:
 	/**
 	 * @brief is this node an operation?
@@ -125,6 +138,7 @@ public:
 	virtual int isSingleThreaded() { return false; }
 
 	void setbNodeTree(const bNodeTree *tree) { this->m_btree = tree; }
+	void setResolutionDivider(int divider) { this->m_resolutionDivider = divider; }
 	virtual void initExecution();
 	
 	/**
@@ -183,6 +197,15 @@ public:
 			this->m_height = resolution[1];
 		}
 	}
+
+	/**
+	 * @brief clear the resolution, so it is determined again
+	 * @see ExecutionSystem.addProxyScaleOperations
+	 */
+	void resetResolution() {
+		this->m_width = 0;
+		this->m_height = 0;
+	}
 	
 
 	void getConnectedInputSockets(vector<InputSocket *> *sockets);
@@ -196,6 +219,32 @@ public:
 	const bool isComplex() const { return this->m_complex; }
 	virtual const bool isSetOperation() const { return false; }
 
+	/**
+	 * @brief can this operation calculate whole rows at once.
+	 *
+	 * Row operations implement executeRow by reading rows of their inputs with readRow at the same
+	 * coordinates, so a row costs one virtual call per operation instead of one per pixel.
+	 * Only operations that read their inputs at the pixel they calculate can be row operations.
+	 * @see SocketReader.executeRow
+	 */
+	virtual const bool isRowOperation() const { return false; }
+
+	/**
+	 * @brief can this complex operation read an input buffer with less channels than COM_NUMBER_OF_CHANNELS.
+	 *
+	 * Complex operations get the MemoryBuffer of their inputs. Operations only reading it with
+	 * MemoryBuffer.read or convertToValueBuffer, or taking MemoryBuffer.getNumberOfChannels into
+	 * account when accessing MemoryBuffer.getBuffer, can read values and vectors with less channels.
+	 * @see ExecutionSystem.determineMemoryProxyDataTypes
+	 */
+	virtual bool isChannelAwareInput(unsigned int inputSocketIndex) const { return false; }
+
+	/**
+	 * @brief set whether this output operation calculates its chunks in rows
+	 * @see ExecutionGroup.initExecution
+	 */
+	void setRowExecution(bool rowExecution) { this->m_rowExecution = rowExecution; }
+
 	/**
 	 * @brief is this operation of type ReadBufferOperation
 	 * @return [true:false]
@@ -251,10 +300,17 @@ protected:
 	NodeOperation();
 
 	void setWidth(unsigned int width) { this->m_width = width; }
+	bool isRowExecution() const { return this->m_rowExecution; }
 	void setHeight(unsigned int height) { this->m_height = height; }
 	SocketReader *getInputSocketReader(unsigned int inputSocketindex);
 	NodeOperation *getInputOperation(unsigned int inputSocketindex);
 
+	/**
+	 * @brief settings in pixels are divided by this, so the proxy pass looks like the full resolution result
+	 * @note only valid from initExecution on
+	 */
+	int getResolutionDivider() const { return this->m_resolutionDivider; }
+
 	void deinitMutex();
 	void initMutex();
 	void lockMutex();
@@ -0,0 +1,338 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <map>
+#include <string.h>
+#include <typeinfo>
+
+#include "COM_ResultCache.h"
+#include "COM_InputSocket.h"
+#include "COM_SocketConnection.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_defines.h"
+
+extern "C" {
+	#include "DNA_camera_types.h"
+	#include "DNA_color_types.h"
+	#include "DNA_image_types.h"
+	#include "DNA_node_types.h"
+	#include "DNA_object_types.h"
+	#include "DNA_scene_types.h"
+	#include "BLI_utildefines.h"
+	#include "BKE_global.h"
+	#include "BKE_image.h"
+	#include "BKE_node.h"
+	#include "IMB_imbuf_types.h"
+	#include "RE_pipeline.h"
+	#include "MEM_guardedalloc.h"
+}
+
+/* 64 bit FNV-1a */
+#define RESULT_HASH_INIT 14695981039346656037ULL
+#define RESULT_HASH_PRIME 1099511628211ULL
+
+typedef map<NodeOperation *, uint64_t> OperationHashes;
+
+class CachedResult {
+public:
+	uint64_t m_key;
+	MemoryBuffer *m_buffer;
+	size_t m_size;
+	unsigned int m_lastUsage;
+};
+
+static vector<CachedResult> s_results;
+static size_t s_totalSize = 0;
+static unsigned int s_usage = 0;
+
+static void hash_data(uint64_t *hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+	for (size_t index = 0; index < size; index++) {
+		*hash ^= bytes[index];
+		*hash *= RESULT_HASH_PRIME;
+	}
+}
+
+template<typename T> static void hash_value(uint64_t *hash, const T &value)
+{
+	hash_data(hash, &value, sizeof(value));
+}
+
+static void hash_curve_mapping(uint64_t *hash, const CurveMapping *cumap)
+{
+	/* the tables are recreated for every copy of the tree, only hash the points */
+	hash_value(hash, cumap->flag);
+	hash_value(hash, cumap->clipr);
+	hash_data(hash, cumap->black, sizeof(cumap->black));
+	hash_data(hash, cumap->white, sizeof(cumap->white));
+	for (int index = 0; index < CM_TOT; index++) {
+		const CurveMap *cuma = &cumap->cm[index];
+		hash_value(hash, cuma->totpoint);
+		hash_value(hash, cuma->flag);
+		if (cuma->curve) {
+			hash_data(hash, cuma->curve, sizeof(CurveMapPoint) * cuma->totpoint);
+		}
+	}
+}
+
+static bool hash_image(uint64_t *hash, Image *image)
+{
+	/* render results and viewers are written by the compositor itself */
+	if (ELEM(image->type, IMA_TYPE_R_RESULT, IMA_TYPE_COMPOSITE) || image->source == IMA_SRC_VIEWER) {
+		return false;
+	}
+
+	/* buffers can be allocated at the same address again after a reload,
+	 * so identify them by the generation of the image instead of pointers */
+	hash_data(hash, image->id.name, strlen(image->id.name));
+	hash_data(hash, image->name, strlen(image->name));
+	hash_value(hash, image->generation);
+	hash_value(hash, image->source);
+	hash_value(hash, image->type);
+	hash_value(hash, image->gen_x);
+	hash_value(hash, image->gen_y);
+	hash_value(hash, image->gen_type);
+	hash_value(hash, image->gen_flag);
+
+	for (ImBuf *ibuf = (ImBuf *)image->ibufs.first; ibuf; ibuf = ibuf->next) {
+		if (ibuf->userflags & IB_BITMAPDIRTY) {
+			/* painting does not change the key, results calculated from the image before are outdated */
+			ResultCache::clear();
+			return false;
+		}
+		hash_value(hash, ibuf->index);
+		hash_value(hash, ibuf->x);
+		hash_value(hash, ibuf->y);
+		hash_value(hash, ibuf->userflags);
+	}
+	return true;
+}
+
+static bool hash_scene(uint64_t *hash, bNode *node, Scene *scene)
+{
+	hash_value(hash, scene);
+
+	if (node->type == CMP_NODE_R_LAYERS) {
+		/* the render result is only complete when rendering finished, every render has a new start time */
+		if (G.is_rendering) {
+			return false;
+		}
+		Render *re = RE_GetRender(scene->id.name);
+		if (re) {
+			hash_value(hash, RE_GetStats(re)->starttime);
+		}
+	}
+	else {
+		/* defocus reads the lens of the scene camera */
+		Object *camob = scene->camera;
+		hash_value(hash, camob);
+		if (camob && camob->type == OB_CAMERA) {
+			Camera *camera = (Camera *)camob->data;
+			if (camera->dof_ob) {
+				return false;
+			}
+			hash_data(hash, camera, sizeof(Camera));
+		}
+	}
+	return true;
+}
+
+static bool hash_node(uint64_t *hash, bNode *node)
+{
+	hash_value(hash, node->type);
+	hash_value(hash, node->custom1);
+	hash_value(hash, node->custom2);
+	hash_value(hash, node->custom3);
+	hash_value(hash, node->custom4);
+	hash_value(hash, (int)(node->flag & NODE_MUTED));
+
+	if (node->storage) {
+		if (ELEM4(node->type, CMP_NODE_CURVE_RGB, CMP_NODE_CURVE_VEC, CMP_NODE_TIME, CMP_NODE_HUECORRECT)) {
+			hash_curve_mapping(hash, (CurveMapping *)node->storage);
+		}
+		else {
+			hash_data(hash, node->storage, MEM_allocN_len(node->storage));
+		}
+	}
+
+	for (bNodeSocket *sock = (bNodeSocket *)node->inputs.first; sock; sock = sock->next) {
+		if (sock->default_value) {
+			hash_data(hash, sock->default_value, MEM_allocN_len(sock->default_value));
+		}
+	}
+
+	if (node->id) {
+		switch (GS(node->id->name)) {
+			case ID_IM:
+				return hash_image(hash, (Image *)node->id);
+			case ID_SCE:
+				return hash_scene(hash, node, (Scene *)node->id);
+			case ID_NT:
+				break;
+			default:
+				/* movie clips, masks and textures can change without a way to notice */
+				return false;
+		}
+	}
+	return true;
+}
+
+static bool hash_operation(NodeOperation *operation, OperationHashes &hashes, uint64_t *r_hash)
+{
+	OperationHashes::iterator found = hashes.find(operation);
+	if (found != hashes.end()) {
+		*r_hash = found->second;
+		return true;
+	}
+
+	uint64_t hash = RESULT_HASH_INIT;
+	const char *type = typeid(*operation).name();
+	hash_data(&hash, type, strlen(type));
+	hash_value(&hash, operation->getWidth());
+	hash_value(&hash, operation->getHeight());
+
+	if (operation->isSetOperation()) {
+		/* values of unconnected sockets are only known by the operation */
+		float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		operation->read(value, 0.0f, 0.0f, COM_PS_NEAREST);
+		hash_data(&hash, value, sizeof(value));
+	}
+
+	bNode *node = operation->getbNode();
+	if (node && !hash_node(&hash, node)) {
+		return false;
+	}
+
+	uint64_t inputHash;
+	if (operation->isReadBufferOperation()) {
+		ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+		WriteBufferOperation *writeOperation = readOperation->getMemoryProxy()->getWriteBufferOperation();
+		if (!hash_operation(writeOperation, hashes, &inputHash)) {
+			return false;
+		}
+		hash_value(&hash, inputHash);
+	}
+
+	for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+		InputSocket *inputSocket = operation->getInputSocket(index);
+		if (inputSocket->isConnected()) {
+			NodeOperation *inputOperation = (NodeOperation *)inputSocket->getConnection()->getFromNode();
+			if (!hash_operation(inputOperation, hashes, &inputHash)) {
+				return false;
+			}
+		}
+		else {
+			inputHash = 0;
+		}
+		hash_value(&hash, inputHash);
+	}
+
+	hashes[operation] = hash;
+	*r_hash = hash;
+	return true;
+}
+
+bool ResultCache::determineKey(WriteBufferOperation *operation, CompositorContext &context, uint64_t *r_key)
+{
+	const RenderData *rd = context.getRenderData();
+	OperationHashes hashes;
+	uint64_t key = RESULT_HASH_INIT;
+	uint64_t operationHash;
+
+	hash_value(&key, context.getFramenumber());
+	hash_value(&key, context.getQuality());
+	hash_value(&key, context.isFastCalculation());
+	hash_value(&key, context.getResolutionDivider());
+	if (rd) {
+		hash_value(&key, rd->xsch);
+		hash_value(&key, rd->ysch);
+		hash_value(&key, rd->size);
+	}
+
+	if (!hash_operation(operation, hashes, &operationHash)) {
+		return false;
+	}
+	hash_value(&key, operationHash);
+
+	*r_key = key;
+	return true;
+}
+
+MemoryBuffer *ResultCache::take(uint64_t key, unsigned int width, unsigned int height, DataType datatype)
+{
+	for (vector<CachedResult>::iterator it = s_results.begin(); it != s_results.end(); ++it) {
+		if (it->m_key == key) {
+			MemoryBuffer *buffer = it->m_buffer;
+			s_totalSize -= it->m_size;
+			s_results.erase(it);
+
+			if (buffer->getWidth() == (int)width && buffer->getHeight() == (int)height &&
+			    buffer->getDataType() == datatype)
+			{
+				return buffer;
+			}
+			delete buffer;
+			return NULL;
+		}
+	}
+	return NULL;
+}
+
+void ResultCache::store(uint64_t key, MemoryBuffer *buffer)
+{
+	const size_t size = sizeof(float) * buffer->getNumberOfChannels() * buffer->getWidth() * buffer->getHeight();
+
+	/* a result with the same key can be calculated twice in one execution */
+	delete take(key, buffer->getWidth(), buffer->getHeight(), buffer->getDataType());
+
+	if (size > COM_RESULT_CACHE_SIZE) {
+		delete buffer;
+		return;
+	}
+
+	/* free least recently used results until the new one fits */
+	while (s_totalSize + size > COM_RESULT_CACHE_SIZE) {
+		vector<CachedResult>::iterator leastRecent = s_results.begin();
+		for (vector<CachedResult>::iterator it = s_results.begin(); it != s_results.end(); ++it) {
+			if (it->m_lastUsage < leastRecent->m_lastUsage) {
+				leastRecent = it;
+			}
+		}
+		delete leastRecent->m_buffer;
+		s_totalSize -= leastRecent->m_size;
+		s_results.erase(leastRecent);
+	}
+
+	CachedResult result;
+	result.m_key = key;
+	result.m_buffer = buffer;
+	result.m_size = size;
+	result.m_lastUsage = s_usage++;
+	s_results.push_back(result);
+	s_totalSize += size;
+}
+
+void ResultCache::clear()
+{
+	while (s_results.size() > 0) {
+		delete s_results.back().m_buffer;
+		s_results.pop_back();
+	}
+	s_totalSize = 0;
+}
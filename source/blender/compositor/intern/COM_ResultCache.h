@@ -0,0 +1,67 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_ResultCache_h_
+#define _COM_ResultCache_h_
+
+#include "COM_CompositorContext.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_WriteBufferOperation.h"
+#include "BLO_sys_types.h"
+
+/**
+ * @brief keeps the results of complex operations between executions of the compositor
+ *
+ * Every update creates a new ExecutionSystem from a copy of the node tree, so results are found by
+ * a key: a hash of the operations upstream of a WriteBufferOperation, the settings of the nodes they
+ * were created from, the identity of the input images and the version of the render result.
+ * When a key is found the buffer is restored and the ExecutionGroup writing it is not calculated,
+ * neither are the groups only it depends on.
+ *
+ * Restored buffers are taken out of the cache while in use and stored again after execution.
+ * When the buffers exceed COM_RESULT_CACHE_SIZE the least recently used ones are freed.
+ *
+ * @note only used while the compositor mutex is locked, it does not need a lock of its own
+ * @ingroup Memory
+ */
+class ResultCache {
+public:
+	/**
+	 * @brief determine the key of the buffer written by a WriteBufferOperation
+	 * @return false when the result can not be cached, for example when it depends on a movie clip
+	 */
+	static bool determineKey(WriteBufferOperation *operation, CompositorContext &context, uint64_t *r_key);
+
+	/**
+	 * @brief take a buffer out of the cache
+	 * @return the buffer or NULL when no buffer of this size and data type was stored with the key
+	 */
+	static MemoryBuffer *take(uint64_t key, unsigned int width, unsigned int height, DataType datatype);
+
+	/**
+	 * @brief store a fully calculated buffer, the cache takes ownership of it
+	 */
+	static void store(uint64_t key, MemoryBuffer *buffer);
+
+	/**
+	 * @brief free all stored buffers
+	 */
+	static void clear();
+};
+
+#endif
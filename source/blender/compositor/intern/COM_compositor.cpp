@@ -33,6 +33,7 @@ extern "C" {
 #include "COM_WorkScheduler.h"
 #include "OCL_opencl.h"
 #include "COM_MovieDistortionOperation.h"
+#include "COM_ResultCache.h"
 
 static ThreadMutex s_compositorMutex;
 static char is_compositorMutex_init = FALSE;
@@ -40,6 +41,7 @@ static char is_compositorMutex_init = FALSE;
 static void intern_freeCompositorCaches()
 {
 	deintializeDistortionCache();
+	ResultCache::clear();
 }
 
 void COM_execute(RenderData *rd, bNodeTree *editingtree, int rendering,
@@ -70,10 +72,21 @@ void COM_execute(RenderData *rd, bNodeTree *editingtree, int rendering,
 	/* set progress bar to 0% and status to init compositing */
 	editingtree->progress(editingtree->prh, 0.0);
 
-	bool twopass = (editingtree->flag & NTREE_TWO_PASS) > 0 && !rendering;
+	int proxyDivider = 1;
+	if (!rendering) {
+		if (editingtree->flag & NTREE_COM_PROXY_25) {
+			proxyDivider = 4;
+		}
+		else if (editingtree->flag & NTREE_COM_PROXY_50) {
+			proxyDivider = 2;
+		}
+	}
+	/* the proxy pass replaces the fast first pass of two pass editing */
+	bool twopass = (editingtree->flag & NTREE_TWO_PASS) > 0 && !rendering && proxyDivider == 1;
 	/* initialize execution system */
-	if (twopass) {
-		ExecutionSystem *system = new ExecutionSystem(rd, editingtree, rendering, twopass, viewSettings, displaySettings);
+	if (twopass || proxyDivider > 1) {
+		ExecutionSystem *system = new ExecutionSystem(rd, editingtree, rendering, twopass, viewSettings, displaySettings,
+		                                              proxyDivider);
 		system->execute();
 		delete system;
 		
@@ -86,14 +99,14 @@ void COM_execute(RenderData *rd, bNodeTree *editingtree, int rendering,
 	}
 
 	
-	ExecutionSystem *system = new ExecutionSystem(rd, editingtree, rendering, false, viewSettings, displaySettings);
+	ExecutionSystem *system = new ExecutionSystem(rd, editingtree, rendering, false, viewSettings, displaySettings, 1);
 	system->execute();
 	delete system;
 
 	BLI_mutex_unlock(&s_compositorMutex);
 }
 
-static void UNUSED_FUNCTION(COM_freeCaches)()
+void COM_clearCaches()
 {
 	if (is_compositorMutex_init) {
 		BLI_mutex_lock(&s_compositorMutex);
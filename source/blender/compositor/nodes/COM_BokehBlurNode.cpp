@@ -54,7 +54,7 @@ void BokehBlurNode::convertToOperations(ExecutionSystem *graph, CompositorContex
 		this->getOutputSocket(0)->relinkConnections(operation->getOutputSocket());
 
 		operation->setThreshold(0.0f);
-		operation->setMaxBlur(b_node->custom4);
+		operation->setMaxBlur(b_node->custom4 / context->getResolutionDivider());
 		operation->setDoScaleSize(true);
 	}
 	else {
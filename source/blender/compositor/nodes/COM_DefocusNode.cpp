@@ -45,14 +45,17 @@ void DefocusNode::convertToOperations(ExecutionSystem *graph, CompositorContext
 	Scene *scene = (Scene *)node->id;
 	Object *camob = (scene) ? scene->camera : NULL;
 	NodeDefocus *data = (NodeDefocus *)node->storage;
+	/* radii are in pixels of the full resolution */
+	const float divider = context->getResolutionDivider();
+	const float maxblur = data->maxblur / divider;
 
 	NodeOperation *radiusOperation;
 	if (data->no_zbuf) {
 		MathMultiplyOperation *multiply = new MathMultiplyOperation();
 		SetValueOperation *multiplier = new SetValueOperation();
-		multiplier->setValue(data->scale);
+		multiplier->setValue(data->scale / divider);
 		SetValueOperation *maxRadius = new SetValueOperation();
-		maxRadius->setValue(data->maxblur);
+		maxRadius->setValue(maxblur);
 		MathMinimumOperation *minimize = new MathMinimumOperation();
 		this->getInputSocket(1)->relinkConnections(multiply->getInputSocket(0), 1, graph);
 		addLink(graph, multiplier->getOutputSocket(), multiply->getInputSocket(1));
@@ -69,7 +72,7 @@ void DefocusNode::convertToOperations(ExecutionSystem *graph, CompositorContext
 		ConvertDepthToRadiusOperation *converter = new ConvertDepthToRadiusOperation();
 		converter->setCameraObject(camob);
 		converter->setfStop(data->fstop);
-		converter->setMaxRadius(data->maxblur);
+		converter->setMaxRadius(maxblur);
 		this->getInputSocket(1)->relinkConnections(converter->getInputSocket(0), 1, graph);
 		graph->addOperation(converter);
 		
@@ -102,7 +105,7 @@ void DefocusNode::convertToOperations(ExecutionSystem *graph, CompositorContext
 #ifdef COM_DEFOCUS_SEARCH	
 	InverseSearchRadiusOperation *search = new InverseSearchRadiusOperation();
 	addLink(graph, radiusOperation->getOutputSocket(0), search->getInputSocket(0));
-	search->setMaxBlur(data->maxblur);
+	search->setMaxBlur(maxblur);
 	graph->addOperation(search);
 #endif
 	VariableSizeBokehBlurOperation *operation = new VariableSizeBokehBlurOperation();
@@ -112,7 +115,7 @@ void DefocusNode::convertToOperations(ExecutionSystem *graph, CompositorContext
 	else {
 		operation->setQuality(context->getQuality());
 	}
-	operation->setMaxBlur(data->maxblur);
+	operation->setMaxBlur(maxblur);
 	operation->setbNode(node);
 	operation->setThreshold(data->bthresh);
 	addLink(graph, bokeh->getOutputSocket(), operation->getInputSocket(1));
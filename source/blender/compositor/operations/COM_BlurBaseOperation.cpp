@@ -41,8 +41,28 @@ BlurBaseOperation::BlurBaseOperation(DataType data_type) : NodeOperation()
 	this->m_deleteData = false;
 	this->m_sizeavailable = false;
 }
+void BlurBaseOperation::initData()
+{
+	const int divider = this->getResolutionDivider();
+
+	if (divider > 1 && !this->m_data->relative) {
+		/* the node settings are shared with the full resolution pass,
+		 * scale the absolute sizes in a copy of our own */
+		NodeBlurData *data = new NodeBlurData(*this->m_data);
+		data->sizex = (data->sizex + divider / 2) / divider;
+		data->sizey = (data->sizey + divider / 2) / divider;
+		if (this->m_deleteData) {
+			delete this->m_data;
+		}
+		this->m_data = data;
+		this->m_deleteData = true;
+	}
+}
+
 void BlurBaseOperation::initExecution()
 {
+	initData();
+
 	this->m_inputProgram = this->getInputSocketReader(0);
 	this->m_inputSize = this->getInputSocketReader(1);
 	this->m_data->image_in_width = this->getWidth();
@@ -36,6 +36,12 @@ protected:
 
 	void updateSize();
 
+	/**
+	 * Divide the absolute blur sizes by the resolution divider of the proxy pass,
+	 * called by initExecution
+	 */
+	void initData();
+
 	/**
 	 * Cached reference to the inputProgram
 	 */
@@ -23,6 +23,7 @@
 #include "COM_BokehBlurOperation.h"
 #include "BLI_math.h"
 #include "COM_OpenCLDevice.h"
+#include "COM_FFTConvolution.h"
 
 extern "C" {
 	#include "RE_pipeline.h"
@@ -43,6 +44,7 @@ BokehBlurOperation::BokehBlurOperation() : NodeOperation()
 	this->m_inputProgram = NULL;
 	this->m_inputBokehProgram = NULL;
 	this->m_inputBoundingBoxReader = NULL;
+	this->m_convolved = NULL;
 }
 
 void *BokehBlurOperation::initializeTileData(rcti *rect)
@@ -51,11 +53,67 @@ void *BokehBlurOperation::initializeTileData(rcti *rect)
 	if (!this->m_sizeavailable) {
 		updateSize();
 	}
-	void *buffer = getInputOperation(0)->initializeTileData(NULL);
+	MemoryBuffer *buffer = (MemoryBuffer *)getInputOperation(0)->initializeTileData(NULL);
+	if (this->m_convolved == NULL) {
+		const float max_dim = max(this->getWidth(), this->getHeight());
+		int pixelSize = this->m_size * max_dim / 100.0f;
+		if (pixelSize >= COM_BOKEH_BLUR_FFT_RADIUS) {
+			convolveFFT(buffer, pixelSize);
+		}
+	}
 	unlockMutex();
 	return buffer;
 }
 
+void BokehBlurOperation::convolveFFT(MemoryBuffer *inputBuffer, int pixelSize)
+{
+	const int kernelSize = 2 * pixelSize + 1;
+	const float m = this->m_bokehDimension / pixelSize;
+	rcti kernelRect;
+	float bokeh[4];
+	int x, y;
+
+	/* the bokeh as read by executePixel, offsets -pixelSize .. pixelSize - 1 around the center */
+	BLI_rcti_init(&kernelRect, 0, kernelSize, 0, kernelSize);
+	MemoryBuffer *kernel = new MemoryBuffer(NULL, &kernelRect);
+	kernel->clear();
+	for (y = 1; y < kernelSize; y++) {
+		for (x = 1; x < kernelSize; x++) {
+			float u = this->m_bokehMidX + (x - pixelSize) * m;
+			float v = this->m_bokehMidY + (y - pixelSize) * m;
+			this->m_inputBokehProgram->read(bokeh, u, v, COM_PS_NEAREST);
+			kernel->writePixel(x, y, bokeh);
+		}
+	}
+
+	const int width = inputBuffer->getWidth();
+	const int height = inputBuffer->getHeight();
+	MemoryBuffer *convolved = new MemoryBuffer(NULL, inputBuffer->getRect());
+	FFTConvolution::convolve(convolved->getBuffer(), inputBuffer->getBuffer(), width, height,
+	                         kernel->getBuffer(), kernelSize, kernelSize, COM_NUMBER_OF_CHANNELS);
+
+	/* executePixel divides by the bokeh inside the image, convolve the image area to get the same */
+	MemoryBuffer *imageArea = new MemoryBuffer(NULL, inputBuffer->getRect());
+	float *area = imageArea->getBuffer();
+	for (int i = 0; i < width * height * COM_NUMBER_OF_CHANNELS; i++) {
+		area[i] = 1.0f;
+	}
+	MemoryBuffer *multiplier = new MemoryBuffer(NULL, inputBuffer->getRect());
+	FFTConvolution::convolve(multiplier->getBuffer(), area, width, height,
+	                         kernel->getBuffer(), kernelSize, kernelSize, COM_NUMBER_OF_CHANNELS);
+
+	float *color = convolved->getBuffer();
+	float *multiplier_accum = multiplier->getBuffer();
+	for (int i = 0; i < width * height * COM_NUMBER_OF_CHANNELS; i++) {
+		color[i] = (multiplier_accum[i] != 0.0f) ? color[i] / multiplier_accum[i] : 0.0f;
+	}
+
+	delete multiplier;
+	delete imageArea;
+	delete kernel;
+	this->m_convolved = convolved;
+}
+
 void BokehBlurOperation::initExecution()
 {
 	initMutex();
@@ -81,7 +139,10 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 	float bokeh[4];
 
 	this->m_inputBoundingBoxReader->read(tempBoundingBox, x, y, COM_PS_NEAREST);
-	if (tempBoundingBox[0] > 0.0f) {
+	if (tempBoundingBox[0] > 0.0f && this->m_convolved) {
+		this->m_convolved->readNoCheck(output, x, y);
+	}
+	else if (tempBoundingBox[0] > 0.0f) {
 		float multiplier_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 		MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
 		float *buffer = inputBuffer->getBuffer();
@@ -137,6 +198,10 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 void BokehBlurOperation::deinitExecution()
 {
 	deinitMutex();
+	if (this->m_convolved) {
+		delete this->m_convolved;
+		this->m_convolved = NULL;
+	}
 	this->m_inputProgram = NULL;
 	this->m_inputBokehProgram = NULL;
 	this->m_inputBoundingBoxReader = NULL;
@@ -147,8 +212,16 @@ bool BokehBlurOperation::determineDependingAreaOfInterest(rcti *input, ReadBuffe
 	rcti newInput;
 	rcti bokehInput;
 	const float max_dim = max(this->getWidth(), this->getHeight());
+	const float maxSize = this->m_sizeavailable ? this->m_size : 10.0f;
 
-	if (this->m_sizeavailable) {
+	if ((int)(maxSize * max_dim / 100.0f) >= COM_BOKEH_BLUR_FFT_RADIUS) {
+		/* the whole image is convolved at once */
+		newInput.xmin = 0;
+		newInput.ymin = 0;
+		newInput.xmax = this->getWidth();
+		newInput.ymax = this->getHeight();
+	}
+	else if (this->m_sizeavailable) {
 		newInput.xmax = input->xmax + (this->m_size * max_dim / 100.0f);
 		newInput.xmin = input->xmin - (this->m_size * max_dim / 100.0f);
 		newInput.ymax = input->ymax + (this->m_size * max_dim / 100.0f);
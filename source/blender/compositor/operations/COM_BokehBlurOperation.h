@@ -36,6 +36,13 @@ private:
 	float m_bokehMidX;
 	float m_bokehMidY;
 	float m_bokehDimension;
+	MemoryBuffer *m_convolved;
+
+	/**
+	 * @brief convolve the whole image with the bokeh for large sizes
+	 * @see FFTConvolution
+	 */
+	void convolveFFT(MemoryBuffer *inputBuffer, int pixelSize);
 public:
 	BokehBlurOperation();
 
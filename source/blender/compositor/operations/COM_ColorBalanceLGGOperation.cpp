@@ -23,6 +23,10 @@
 #include "COM_ColorBalanceLGGOperation.h"
 #include "BLI_math.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 
 inline float colorbalance_lgg(float in, float lift_lgg, float gamma_inv, float gain)
 {
@@ -73,6 +77,38 @@ void ColorBalanceLGGOperation::executePixel(float output[4], float x, float y, P
 
 }
 
+void ColorBalanceLGGOperation::executeRow(float *output, int x, int y, int width)
+{
+	float inputColor[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float value[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	this->m_inputValueOperation->readRow(value, x, y, width);
+	this->m_inputColorOperation->readRow(inputColor, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+		const float fac = min(1.0f, value[i]);
+		const float mfac = 1.0f - fac;
+		float balanced[4];
+
+		/* the curves use powf per channel, only the mix is vectorized */
+		balanced[0] = colorbalance_lgg(inputColor[i + 0], this->m_lift[0], this->m_gamma_inv[0], this->m_gain[0]);
+		balanced[1] = colorbalance_lgg(inputColor[i + 1], this->m_lift[1], this->m_gamma_inv[1], this->m_gain[1]);
+		balanced[2] = colorbalance_lgg(inputColor[i + 2], this->m_lift[2], this->m_gamma_inv[2], this->m_gain[2]);
+		balanced[3] = 0.0f;
+
+#ifdef __SSE2__
+		const __m128 color = _mm_loadu_ps(&inputColor[i]);
+		_mm_storeu_ps(&output[i], _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mfac), color),
+		                                     _mm_mul_ps(_mm_set1_ps(fac), _mm_loadu_ps(balanced))));
+#else
+		output[i + 0] = mfac * inputColor[i + 0] + fac * balanced[0];
+		output[i + 1] = mfac * inputColor[i + 1] + fac * balanced[1];
+		output[i + 2] = mfac * inputColor[i + 2] + fac * balanced[2];
+#endif
+		output[i + 3] = inputColor[i + 3];
+	}
+}
+
 void ColorBalanceLGGOperation::deinitExecution()
 {
 	this->m_inputValueOperation = NULL;
@@ -135,6 +135,11 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 	int y;
 	bool breaked = false;
 
+	if (this->isRowExecution()) {
+		executeRegionRows(rect);
+		return;
+	}
+
 	for (y = y1; y < y2 && (!breaked); y++) {
 		for (x = x1; x < x2 && (!breaked); x++) {
 			this->m_imageInput->read(color, x, y, COM_PS_NEAREST);
@@ -158,6 +163,46 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 	}
 }
 
+void CompositorOperation::executeRegionRows(rcti *rect)
+{
+	float row[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float *buffer = this->m_outputBuffer;
+	float *zbuffer = this->m_depthBuffer;
+	int x1 = rect->xmin;
+	int y1 = rect->ymin;
+	int x2 = rect->xmax;
+	int y2 = rect->ymax;
+	int x;
+	int y;
+	int i;
+
+	for (y = y1; y < y2; y++) {
+		for (x = x1; x < x2; x += COM_ROW_SIZE) {
+			const int width = min_ii(x2 - x, COM_ROW_SIZE);
+			const int offset = y * this->getWidth() + x;
+			float *output = buffer + offset * COM_NUMBER_OF_CHANNELS;
+
+			this->m_imageInput->readRow(output, x, y, width);
+			if (this->m_alphaInput != NULL) {
+				this->m_alphaInput->readRow(row, x, y, width);
+				for (i = 0; i < width; i++) {
+					output[i * COM_NUMBER_OF_CHANNELS + 3] = row[i * COM_NUMBER_OF_CHANNELS];
+				}
+			}
+
+			if (this->m_depthInput != NULL) {
+				this->m_depthInput->readRow(row, x, y, width);
+				for (i = 0; i < width; i++) {
+					zbuffer[offset + i] = row[i * COM_NUMBER_OF_CHANNELS];
+				}
+			}
+		}
+		if (isBreaked()) {
+			break;
+		}
+	}
+}
+
 void CompositorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	int width = this->m_rd->xsch * this->m_rd->size / 100;
@@ -68,6 +68,7 @@ private:
 public:
 	CompositorOperation();
 	void executeRegion(rcti *rect, unsigned int tileNumber);
+	void executeRegionRows(rcti *rect);
 	void setSceneName(const char *sceneName) { BLI_strncpy(this->m_sceneName, sceneName, sizeof(this->m_sceneName)); }
 	void setRenderData(const RenderData *rd) { this->m_rd = rd; }
 	bool isOutputOperation(bool rendering) const { return true; }
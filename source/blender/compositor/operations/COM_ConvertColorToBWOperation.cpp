@@ -41,6 +41,17 @@ void ConvertColorToBWOperation::executePixel(float output[4], float x, float y,
 	output[0] = rgb_to_bw(inputColor);
 }
 
+void ConvertColorToBWOperation::executeRow(float *output, int x, int y, int width)
+{
+	float inputColor[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	this->m_inputOperation->readRow(inputColor, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+		output[i] = rgb_to_bw(&inputColor[i]);
+	}
+}
+
 void ConvertColorToBWOperation::deinitExecution()
 {
 	this->m_inputOperation = NULL;
@@ -41,6 +41,17 @@ void ConvertColorToValueProg::executePixel(float output[4], float x, float y, Pi
 	output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
+void ConvertColorToValueProg::executeRow(float *output, int x, int y, int width)
+{
+	float inputColor[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	this->m_inputOperation->readRow(inputColor, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+		output[i] = (inputColor[i + 0] + inputColor[i + 1] + inputColor[i + 2]) / 3.0f;
+	}
+}
+
 void ConvertColorToValueProg::deinitExecution()
 {
 	this->m_inputOperation = NULL;
@@ -68,7 +68,7 @@ void ConvertDepthToRadiusOperation::initExecution()
 	this->m_dof_sp = minsz / ((cam_sensor / 2.0f) / this->m_cam_lens);    // <- == aspect * min(img->x, img->y) / tan(0.5f * fov);
 
 	if (this->m_blurPostOperation) {
-		m_blurPostOperation->setSigma(min(m_aperture * 128.0f, this->m_maxRadius));
+		m_blurPostOperation->setSigma(min(m_aperture * 128.0f / this->getResolutionDivider(), this->m_maxRadius));
 	}
 }
 
@@ -22,6 +22,10 @@
 
 #include "COM_ConvertValueToColorProg.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 ConvertValueToColorProg::ConvertValueToColorProg() : NodeOperation()
 {
 	this->addInputSocket(COM_DT_VALUE);
@@ -41,6 +45,22 @@ void ConvertValueToColorProg::executePixel(float output[4], float x, float y, Pi
 	output[3] = 1.0f;
 }
 
+void ConvertValueToColorProg::executeRow(float *output, int x, int y, int width)
+{
+	float inputValue[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	this->m_inputProgram->readRow(inputValue, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+#ifdef __SSE2__
+		_mm_storeu_ps(&output[i], _mm_set_ps(1.0f, inputValue[i], inputValue[i], inputValue[i]));
+#else
+		output[i + 0] = output[i + 1] = output[i + 2] = inputValue[i];
+		output[i + 3] = 1.0f;
+#endif
+	}
+}
+
 void ConvertValueToColorProg::deinitExecution()
 {
 	this->m_inputProgram = NULL;
@@ -38,6 +38,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int width);
+	const bool isRowOperation() const { return true; }
 	
 	/**
 	 * Initialize the execution
@@ -38,25 +38,36 @@ void CropBaseOperation::updateArea()
 	float height = inputReference->getHeight();
 	
 	if (width > 0.0f && height > 0.0f) {
+		/* the node settings are shared with the full resolution pass,
+		 * keep the clamped area in our own members */
+		int x1, x2, y1, y2;
+
 		if (this->m_relative) {
-			this->m_settings->x1 = width * this->m_settings->fac_x1;
-			this->m_settings->x2 = width * this->m_settings->fac_x2;
-			this->m_settings->y1 = height * this->m_settings->fac_y1;
-			this->m_settings->y2 = height * this->m_settings->fac_y2;
+			x1 = width * this->m_settings->fac_x1;
+			x2 = width * this->m_settings->fac_x2;
+			y1 = height * this->m_settings->fac_y1;
+			y2 = height * this->m_settings->fac_y2;
+		}
+		else {
+			const int divider = this->getResolutionDivider();
+			x1 = this->m_settings->x1 / divider;
+			x2 = this->m_settings->x2 / divider;
+			y1 = this->m_settings->y1 / divider;
+			y2 = this->m_settings->y2 / divider;
 		}
-		if (width <= this->m_settings->x1 + 1)
-			this->m_settings->x1 = width - 1;
-		if (height <= this->m_settings->y1 + 1)
-			this->m_settings->y1 = height - 1;
-		if (width <= this->m_settings->x2 + 1)
-			this->m_settings->x2 = width - 1;
-		if (height <= this->m_settings->y2 + 1)
-			this->m_settings->y2 = height - 1;
+		if (width <= x1 + 1)
+			x1 = width - 1;
+		if (height <= y1 + 1)
+			y1 = height - 1;
+		if (width <= x2 + 1)
+			x2 = width - 1;
+		if (height <= y2 + 1)
+			y2 = height - 1;
 		
-		this->m_xmax = max(this->m_settings->x1, this->m_settings->x2) + 1;
-		this->m_xmin = min(this->m_settings->x1, this->m_settings->x2);
-		this->m_ymax = max(this->m_settings->y1, this->m_settings->y2) + 1;
-		this->m_ymin = min(this->m_settings->y1, this->m_settings->y2);
+		this->m_xmax = max(x1, x2) + 1;
+		this->m_xmin = min(x1, x2);
+		this->m_ymax = max(y1, y2) + 1;
+		this->m_ymin = min(y1, y2);
 	}
 }
 
@@ -40,6 +40,8 @@ DilateErodeThresholdOperation::DilateErodeThresholdOperation() : NodeOperation()
 void DilateErodeThresholdOperation::initExecution()
 {
 	this->m_inputProgram = this->getInputSocketReader(0);
+	this->m_distance /= this->getResolutionDivider();
+	this->m_inset /= this->getResolutionDivider();
 	if (this->m_distance < 0.0f) {
 		this->m_scope = -this->m_distance + this->m_inset;
 	}
@@ -175,6 +177,7 @@ DilateDistanceOperation::DilateDistanceOperation() : NodeOperation()
 void DilateDistanceOperation::initExecution()
 {
 	this->m_inputProgram = this->getInputSocketReader(0);
+	this->m_distance /= this->getResolutionDivider();
 	this->m_scope = this->m_distance;
 	if (this->m_scope < 3) {
 		this->m_scope = 3;
@@ -323,6 +326,9 @@ DilateStepOperation::DilateStepOperation() : NodeOperation()
 void DilateStepOperation::initExecution()
 {
 	this->m_inputProgram = this->getInputSocketReader(0);
+	if (this->m_iterations > 0) {
+		this->m_iterations = max(this->m_iterations / this->getResolutionDivider(), 1);
+	}
 	this->m_cached_buffer = NULL;
 	this->initMutex();
 }
@@ -151,6 +151,11 @@ public:
 	void setIterations(int iterations) { this->m_iterations = iterations; }
 	
 	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
+
+	/**
+	 * the input is converted to a value buffer
+	 */
+	bool isChannelAwareInput(unsigned int inputSocketIndex) const { return true; }
 };
 
 class ErodeStepOperation : public DilateStepOperation {
@@ -60,5 +60,10 @@ public:
 	
 	void setAdjecentOnly(bool adjecentOnly) { this->m_adjecentOnly = adjecentOnly; }
 	void setKeepInside(bool keepInside) { this->m_keepInside = keepInside; }
+
+	/**
+	 * both masks are converted to value buffers
+	 */
+	bool isChannelAwareInput(unsigned int inputSocketIndex) const { return true; }
 };
 #endif
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_FFTConvolution_h
+#define _COM_FFTConvolution_h
+#include "COM_defines.h"
+
+/**
+ * @brief convolution with large kernels through the 2D Fast Hartley Transform
+ *
+ * The image is convolved in blocks that are added together (overlap-add), the cost per pixel
+ * grows with the log of the kernel size instead of with its area.
+ * The row and column passes of every transform are split over the threads of the task scheduler,
+ * operations using it hold their own lock, so the WorkScheduler threads would only wait for it.
+ */
+class FFTConvolution {
+public:
+	/**
+	 * @brief convolve every channel of an image with the same channel of a kernel
+	 *
+	 * All buffers store COM_NUMBER_OF_CHANNELS floats per pixel.
+	 * The center of the kernel is at (kernelWidth / 2, kernelHeight / 2), pixels outside the image are zero.
+	 *
+	 * @param dst result of imageWidth * imageHeight pixels, channels after numberOfChannels are set to zero
+	 * @param numberOfChannels number of channels to convolve, starting at the first
+	 */
+	static void convolve(float *dst, const float *image, int imageWidth, int imageHeight,
+	                     const float *kernel, int kernelWidth, int kernelHeight, int numberOfChannels);
+};
+
+#endif
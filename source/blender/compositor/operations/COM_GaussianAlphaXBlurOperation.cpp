@@ -50,6 +50,7 @@ void *GaussianAlphaXBlurOperation::initializeTileData(rcti *rect)
 void GaussianAlphaXBlurOperation::initExecution()
 {
 	/* BlurBaseOperation::initExecution(); */ /* until we suppoer size input - comment this */
+	initData();
 
 	initMutex();
 
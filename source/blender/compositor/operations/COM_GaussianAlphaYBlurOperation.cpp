@@ -50,6 +50,7 @@ void *GaussianAlphaYBlurOperation::initializeTileData(rcti *rect)
 void GaussianAlphaYBlurOperation::initExecution()
 {
 	/* BlurBaseOperation::initExecution(); */ /* until we suppoer size input - comment this */
+	initData();
 
 	initMutex();
 
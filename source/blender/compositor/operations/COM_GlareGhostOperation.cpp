@@ -40,7 +40,7 @@ static float smoothMask(float x, float y)
 void GlareGhostOperation::generateGlare(float *data, MemoryBuffer *inputTile, NodeGlare *settings)
 {
 	const int qt = 1 << settings->quality;
-	const float s1 = 4.f / (float)qt, s2 = 2.f * s1;
+	const float s1 = 4.f / (float)(qt * this->getResolutionDivider()), s2 = 2.f * s1;
 	int x, y, n, p, np;
 	fRGB c, tc, cm[64];
 	float sc, isc, u, v, sm, s, t, ofs, scalef[64];
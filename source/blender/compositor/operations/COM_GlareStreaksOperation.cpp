@@ -44,7 +44,7 @@ void GlareStreaksOperation::generateGlare(float *data, MemoryBuffer *inputTile,
 		const float an = a + settings->angle_ofs;
 		const float vx = cos((double)an), vy = sin((double)an);
 		for (n = 0; n < settings->iter && (!breaked); ++n) {
-			const float p4 = pow(4.0, (double)n);
+			const float p4 = pow(4.0, (double)n) / this->getResolutionDivider();
 			const float vxp = vx * p4, vyp = vy * p4;
 			const float wt = pow((double)settings->fade, (double)p4);
 			const float cmo = 1.f - (float)pow((double)settings->colmod, (double)n + 1);  // colormodulation amount relative to current pass
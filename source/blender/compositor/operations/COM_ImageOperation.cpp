@@ -132,6 +132,21 @@ void ImageOperation::executePixel(float output[4], float x, float y, PixelSample
 	}
 }
 
+void ImageOperation::executeRow(float *output, int x, int y, int width)
+{
+	/* rows partly outside of the image are left to executePixel */
+	if (this->m_imageBuffer == NULL || this->m_numberOfChannels != COM_NUMBER_OF_CHANNELS ||
+	    x < 0 || y < 0 || x + width > (int)this->getWidth() || y >= (int)this->getHeight() ||
+	    x + width > this->m_imagewidth || y >= this->m_imageheight)
+	{
+		NodeOperation::executeRow(output, x, y, width);
+		return;
+	}
+
+	memcpy(output, &this->m_imageBuffer[(y * this->m_imagewidth + x) * COM_NUMBER_OF_CHANNELS],
+	       sizeof(float) * width * COM_NUMBER_OF_CHANNELS);
+}
+
 void ImageAlphaOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float tempcolor[4];
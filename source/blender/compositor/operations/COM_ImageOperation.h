@@ -73,6 +73,8 @@ public:
 	 */
 	ImageOperation();
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int width);
+	const bool isRowOperation() const { return true; }
 };
 class ImageAlphaOperation : public BaseImageOperation {
 public:
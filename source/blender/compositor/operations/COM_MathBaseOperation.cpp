@@ -72,6 +72,12 @@ void MathBaseOperation::clampIfNeeded(float *color)
 	}
 }
 
+void MathBaseOperation::readRows(float *value1, float *value2, int x, int y, int width)
+{
+	this->m_inputValue1Operation->readRow(value1, x, y, width);
+	this->m_inputValue2Operation->readRow(value2, x, y, width);
+}
+
 void MathAddOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -85,6 +91,20 @@ void MathAddOperation::executePixel(float output[4], float x, float y, PixelSamp
 	clampIfNeeded(output);
 }
 
+void MathAddOperation::executeRow(float *output, int x, int y, int width)
+{
+	float inputValue1[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float inputValue2[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	readRows(inputValue1, inputValue2, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+		output[i] = inputValue1[i] + inputValue2[i];
+
+		clampIfNeeded(&output[i]);
+	}
+}
+
 void MathSubtractOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -98,6 +118,20 @@ void MathSubtractOperation::executePixel(float output[4], float x, float y, Pixe
 	clampIfNeeded(output);
 }
 
+void MathSubtractOperation::executeRow(float *output, int x, int y, int width)
+{
+	float inputValue1[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float inputValue2[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	readRows(inputValue1, inputValue2, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+		output[i] = inputValue1[i] - inputValue2[i];
+
+		clampIfNeeded(&output[i]);
+	}
+}
+
 void MathMultiplyOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -111,6 +145,20 @@ void MathMultiplyOperation::executePixel(float output[4], float x, float y, Pixe
 	clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::executeRow(float *output, int x, int y, int width)
+{
+	float inputValue1[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float inputValue2[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	readRows(inputValue1, inputValue2, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+		output[i] = inputValue1[i] * inputValue2[i];
+
+		clampIfNeeded(&output[i]);
+	}
+}
+
 void MathDivideOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -127,6 +175,23 @@ void MathDivideOperation::executePixel(float output[4], float x, float y, PixelS
 	clampIfNeeded(output);
 }
 
+void MathDivideOperation::executeRow(float *output, int x, int y, int width)
+{
+	float inputValue1[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float inputValue2[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	readRows(inputValue1, inputValue2, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+		if (inputValue2[i] == 0) /* We don't want to divide by zero. */
+			output[i] = 0.0;
+		else
+			output[i] = inputValue1[i] / inputValue2[i];
+
+		clampIfNeeded(&output[i]);
+	}
+}
+
 void MathSineOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -265,6 +330,20 @@ void MathMinimumOperation::executePixel(float output[4], float x, float y, Pixel
 	clampIfNeeded(output);
 }
 
+void MathMinimumOperation::executeRow(float *output, int x, int y, int width)
+{
+	float inputValue1[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float inputValue2[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	readRows(inputValue1, inputValue2, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+		output[i] = min(inputValue1[i], inputValue2[i]);
+
+		clampIfNeeded(&output[i]);
+	}
+}
+
 void MathMaximumOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -278,6 +357,20 @@ void MathMaximumOperation::executePixel(float output[4], float x, float y, Pixel
 	clampIfNeeded(output);
 }
 
+void MathMaximumOperation::executeRow(float *output, int x, int y, int width)
+{
+	float inputValue1[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float inputValue2[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	readRows(inputValue1, inputValue2, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+		output[i] = max(inputValue1[i], inputValue2[i]);
+
+		clampIfNeeded(&output[i]);
+	}
+}
+
 void MathRoundOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -63,6 +63,19 @@ void MixBaseOperation::executePixel(float output[4], float x, float y, PixelSamp
 	output[3] = inputColor1[3];
 }
 
+void MixBaseOperation::readRows(float *value, float *color1, float *color2, int x, int y, int width)
+{
+	this->m_inputValueOperation->readRow(value, x, y, width);
+	this->m_inputColor1Operation->readRow(color1, x, y, width);
+	this->m_inputColor2Operation->readRow(color2, x, y, width);
+
+	if (this->useValueAlphaMultiply()) {
+		for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+			value[i] *= color2[i + 3];
+		}
+	}
+}
+
 void MixBaseOperation::deinitExecution()
 {
 	this->m_inputValueOperation = NULL;
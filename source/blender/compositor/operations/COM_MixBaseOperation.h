@@ -49,6 +49,12 @@ protected:
 			CLAMP(color[3], 0.0f, 1.0f);
 		}
 	}
+
+	/**
+	 * read the input rows for executeRow, with the factor already multiplied by the alpha
+	 * of the second color when needed
+	 */
+	void readRows(float *value, float *color1, float *color2, int x, int y, int width);
 	
 public:
 	/**
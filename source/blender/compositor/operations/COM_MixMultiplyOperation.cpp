@@ -22,6 +22,10 @@
 
 #include "COM_MixMultiplyOperation.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 MixMultiplyOperation::MixMultiplyOperation() : MixBaseOperation()
 {
 	/* pass */
@@ -50,3 +54,30 @@ void MixMultiplyOperation::executePixel(float output[4], float x, float y, Pixel
 	clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::executeRow(float *output, int x, int y, int width)
+{
+	float inputColor1[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float inputColor2[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float inputValue[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+
+	readRows(inputValue, inputColor1, inputColor2, x, y, width);
+
+	for (int i = 0; i < width * COM_NUMBER_OF_CHANNELS; i += COM_NUMBER_OF_CHANNELS) {
+#ifdef __SSE2__
+		const __m128 valuem = _mm_set1_ps(1.0f - inputValue[i]);
+		const __m128 value = _mm_set1_ps(inputValue[i]);
+		const __m128 color1 = _mm_loadu_ps(&inputColor1[i]);
+		const __m128 color2 = _mm_loadu_ps(&inputColor2[i]);
+		_mm_storeu_ps(&output[i], _mm_mul_ps(color1, _mm_add_ps(valuem, _mm_mul_ps(value, color2))));
+#else
+		const float value = inputValue[i];
+		const float valuem = 1.0f - value;
+		output[i + 0] = inputColor1[i + 0] * (valuem + value * inputColor2[i + 0]);
+		output[i + 1] = inputColor1[i + 1] * (valuem + value * inputColor2[i + 1]);
+		output[i + 2] = inputColor1[i + 2] * (valuem + value * inputColor2[i + 2]);
+#endif
+		output[i + 3] = inputColor1[i + 3];
+
+		clampIfNeeded(&output[i]);
+	}
+}
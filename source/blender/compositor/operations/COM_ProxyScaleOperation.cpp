@@ -0,0 +1,157 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "COM_ProxyScaleOperation.h"
+#include "BLI_math.h"
+
+ProxyDownscaleOperation::ProxyDownscaleOperation(DataType datatype, int divider) : NodeOperation()
+{
+	this->addInputSocket(datatype, COM_SC_NO_RESIZE);
+	this->addOutputSocket(datatype);
+	this->setResolutionInputSocketIndex(0);
+	this->m_inputOperation = NULL;
+	this->m_divider = divider;
+}
+
+void ProxyDownscaleOperation::initExecution()
+{
+	this->m_inputOperation = this->getInputSocketReader(0);
+}
+
+void ProxyDownscaleOperation::deinitExecution()
+{
+	this->m_inputOperation = NULL;
+}
+
+void ProxyDownscaleOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+{
+	const int inputX = (int)x * this->m_divider;
+	const int inputY = (int)y * this->m_divider;
+	/* the last row and column are partly outside the input when its size is not a multiple of the divider */
+	const int sizeX = min_ii(this->m_divider, this->m_inputOperation->getWidth() - inputX);
+	const int sizeY = min_ii(this->m_divider, this->m_inputOperation->getHeight() - inputY);
+	float color[4];
+
+	zero_v4(output);
+	if (sizeX <= 0 || sizeY <= 0) {
+		return;
+	}
+
+	for (int j = 0; j < sizeY; j++) {
+		for (int i = 0; i < sizeX; i++) {
+			this->m_inputOperation->read(color, inputX + i, inputY + j, sampler);
+			add_v4_v4(output, color);
+		}
+	}
+	mul_v4_fl(output, 1.0f / (sizeX * sizeY));
+}
+
+bool ProxyDownscaleOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
+{
+	rcti newInput;
+
+	newInput.xmin = input->xmin * this->m_divider;
+	newInput.xmax = input->xmax * this->m_divider;
+	newInput.ymin = input->ymin * this->m_divider;
+	newInput.ymax = input->ymax * this->m_divider;
+
+	return NodeOperation::determineDependingAreaOfInterest(&newInput, readOperation, output);
+}
+
+void ProxyDownscaleOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
+{
+	unsigned int inputPreferredResolution[2];
+	inputPreferredResolution[0] = preferredResolution[0] * this->m_divider;
+	inputPreferredResolution[1] = preferredResolution[1] * this->m_divider;
+
+	NodeOperation::determineResolution(resolution, inputPreferredResolution);
+
+	/* round up, so the full resolution is covered */
+	resolution[0] = (resolution[0] + this->m_divider - 1) / this->m_divider;
+	resolution[1] = (resolution[1] + this->m_divider - 1) / this->m_divider;
+}
+
+
+ProxyUpscaleOperation::ProxyUpscaleOperation(DataType datatype, int divider,
+                                             unsigned int fullWidth, unsigned int fullHeight) : NodeOperation()
+{
+	this->addInputSocket(datatype, COM_SC_NO_RESIZE);
+	this->addOutputSocket(datatype);
+	this->setResolutionInputSocketIndex(0);
+	this->m_inputOperation = NULL;
+	this->m_divider = divider;
+	this->m_fullWidth = fullWidth;
+	this->m_fullHeight = fullHeight;
+}
+
+void ProxyUpscaleOperation::initExecution()
+{
+	this->m_inputOperation = this->getInputSocketReader(0);
+}
+
+void ProxyUpscaleOperation::deinitExecution()
+{
+	this->m_inputOperation = NULL;
+}
+
+void ProxyUpscaleOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+{
+	/* the input is usually rounded up from the full resolution divided by the divider,
+	 * scale by the actual ratio so the last row and column are read from the input as well */
+	const float inputX = x * this->m_inputOperation->getWidth() / this->getWidth();
+	const float inputY = y * this->m_inputOperation->getHeight() / this->getHeight();
+
+	this->m_inputOperation->read(output, floorf(inputX), floorf(inputY), sampler);
+}
+
+bool ProxyUpscaleOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
+{
+	NodeOperation *inputOperation = this->getInputOperation(0);
+	const float scaleX = (float)inputOperation->getWidth() / this->getWidth();
+	const float scaleY = (float)inputOperation->getHeight() / this->getHeight();
+	rcti newInput;
+
+	newInput.xmin = floorf(input->xmin * scaleX);
+	newInput.xmax = ceilf(input->xmax * scaleX);
+	newInput.ymin = floorf(input->ymin * scaleY);
+	newInput.ymax = ceilf(input->ymax * scaleY);
+
+	return NodeOperation::determineDependingAreaOfInterest(&newInput, readOperation, output);
+}
+
+void ProxyUpscaleOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
+{
+	unsigned int inputPreferredResolution[2];
+	inputPreferredResolution[0] = (preferredResolution[0] + this->m_divider - 1) / this->m_divider;
+	inputPreferredResolution[1] = (preferredResolution[1] + this->m_divider - 1) / this->m_divider;
+
+	NodeOperation::determineResolution(resolution, inputPreferredResolution);
+
+	if (resolution[0] == 0 || resolution[1] == 0) {
+		return;
+	}
+
+	if (this->m_fullWidth != 0 && this->m_fullHeight != 0) {
+		resolution[0] = this->m_fullWidth;
+		resolution[1] = this->m_fullHeight;
+	}
+	else {
+		resolution[0] *= this->m_divider;
+		resolution[1] *= this->m_divider;
+	}
+}
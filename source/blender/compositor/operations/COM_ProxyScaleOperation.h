@@ -0,0 +1,66 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_ProxyScaleOperation_h_
+#define _COM_ProxyScaleOperation_h_
+
+#include "COM_NodeOperation.h"
+
+/**
+ * @brief reduces the resolution of input data for the proxy pass, averaging blocks of pixels
+ * @see ExecutionSystem.addProxyScaleOperations
+ */
+class ProxyDownscaleOperation : public NodeOperation {
+private:
+	SocketReader *m_inputOperation;
+	int m_divider;
+public:
+	ProxyDownscaleOperation(DataType datatype, int divider);
+	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
+	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
+	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+
+	void initExecution();
+	void deinitExecution();
+};
+
+/**
+ * @brief scales the result of the proxy pass back to the resolution of an output, repeating pixels
+ * @see ExecutionSystem.addProxyScaleOperations
+ */
+class ProxyUpscaleOperation : public NodeOperation {
+private:
+	SocketReader *m_inputOperation;
+	int m_divider;
+
+	/**
+	 * @brief resolution of the input in the full resolution pass, the resolution of this operation
+	 */
+	unsigned int m_fullWidth;
+	unsigned int m_fullHeight;
+public:
+	ProxyUpscaleOperation(DataType datatype, int divider, unsigned int fullWidth, unsigned int fullHeight);
+	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
+	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
+	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+
+	void initExecution();
+	void deinitExecution();
+};
+
+#endif
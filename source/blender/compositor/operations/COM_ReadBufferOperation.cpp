@@ -64,6 +64,11 @@ void ReadBufferOperation::executePixel(float output[4], float x, float y, float
 	m_buffer->readEWA(output, x, y, dx, dy, sampler);
 }
 
+void ReadBufferOperation::executeRow(float *output, int x, int y, int width)
+{
+	m_buffer->readRow(output, x, y, width);
+}
+
 bool ReadBufferOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
 {
 	if (this == readOperation) {
@@ -30,6 +30,9 @@ public:
 	RenderLayersAlphaProg();
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
 
+	/* reads the alpha of the combined pass, which the rows of the base class do not */
+	const bool isRowOperation() const { return false; }
+
 };
 
 #endif
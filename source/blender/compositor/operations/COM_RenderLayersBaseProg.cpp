@@ -122,6 +122,38 @@ void RenderLayersBaseProg::executePixel(float output[4], float x, float y, Pixel
 	}
 }
 
+void RenderLayersBaseProg::executeRow(float *output, int x, int y, int width)
+{
+	const int imagewidth = this->getWidth();
+
+	/* rows partly outside of the image are left to executePixel */
+	if (this->m_inputBuffer == NULL || x < 0 || y < 0 || x + width > imagewidth || y >= (int)this->getHeight()) {
+		NodeOperation::executeRow(output, x, y, width);
+		return;
+	}
+
+	const float *input = &this->m_inputBuffer[(y * imagewidth + x) * this->m_elementsize];
+	int i;
+
+	if (this->m_elementsize == 4) {
+		memcpy(output, input, sizeof(float) * width * COM_NUMBER_OF_CHANNELS);
+	}
+	else if (this->m_elementsize == 3) {
+		for (i = 0; i < width; i++, input += 3, output += COM_NUMBER_OF_CHANNELS) {
+			copy_v3_v3(output, input);
+			output[3] = 1.0f;
+		}
+	}
+	else {
+		for (i = 0; i < width; i++, input++, output += COM_NUMBER_OF_CHANNELS) {
+			output[0] = input[0];
+			output[1] = 0.0f;
+			output[2] = 0.0f;
+			output[3] = 0.0f;
+		}
+	}
+}
+
 void RenderLayersBaseProg::deinitExecution()
 {
 	this->m_inputBuffer = NULL;
@@ -94,6 +94,8 @@ public:
 	void initExecution();
 	void deinitExecution();
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int width);
+	const bool isRowOperation() const { return true; }
 };
 
 #endif
@@ -56,9 +56,11 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int width);
 
 	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 	const bool isSetOperation() const { return true; }
+	const bool isRowOperation() const { return true; }
 
 };
 #endif
@@ -33,12 +33,17 @@ TranslateOperation::TranslateOperation() : NodeOperation()
 	this->m_inputXOperation = NULL;
 	this->m_inputYOperation = NULL;
 	this->m_isDeltaSet = false;
+	this->m_factor = 1.0f;
+	this->m_isProxyDelta = false;
 }
 void TranslateOperation::initExecution()
 {
 	this->m_inputOperation = this->getInputSocketReader(0);
 	this->m_inputXOperation = this->getInputSocketReader(1);
 	this->m_inputYOperation = this->getInputSocketReader(2);
+	if (!this->m_isProxyDelta) {
+		this->m_factor = 1.0f / this->getResolutionDivider();
+	}
 
 }
 
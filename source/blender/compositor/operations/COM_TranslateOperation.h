@@ -33,6 +33,8 @@ private:
 	float m_deltaX;
 	float m_deltaY;
 	bool m_isDeltaSet;
+	float m_factor;
+	bool m_isProxyDelta;
 public:
 	TranslateOperation();
 	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
@@ -41,6 +43,12 @@ public:
 	void initExecution();
 	void deinitExecution();
 
+	/**
+	 * The delta is already in pixels of the proxy resolution,
+	 * don't scale it by the resolution divider.
+	 */
+	void setIsProxyDelta(bool isProxyDelta) { this->m_isProxyDelta = isProxyDelta; }
+
 	float getDeltaX() { return this->m_deltaX; }
 	float getDeltaY() { return this->m_deltaY; }
 	
@@ -48,9 +56,9 @@ public:
 		if (!this->m_isDeltaSet) {
 			float tempDelta[4];
 			this->m_inputXOperation->read(tempDelta, 0, 0, COM_PS_NEAREST);
-			this->m_deltaX = tempDelta[0];
+			this->m_deltaX = tempDelta[0] * this->m_factor;
 			this->m_inputYOperation->read(tempDelta, 0, 0, COM_PS_NEAREST);
-			this->m_deltaY = tempDelta[0];
+			this->m_deltaY = tempDelta[0] * this->m_factor;
 			this->m_isDeltaSet = true;
 		}
 	}
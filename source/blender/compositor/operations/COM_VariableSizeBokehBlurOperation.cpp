@@ -138,15 +138,19 @@ void VariableSizeBokehBlurOperation::executePixel(float output[4], int x, int y,
 		float size_center = tempSize[0] * scalar;
 		
 		const int addXStep = QualityStepHelper::getStep() * COM_NUMBER_OF_CHANNELS;
+		/* the size buffer can store less channels than the color buffer */
+		const int sizeChannels = inputSizeBuffer->getNumberOfChannels();
+		const int addXSizeStep = QualityStepHelper::getStep() * sizeChannels;
 		
 		if (size_center > this->m_threshold) {
 			for (int ny = miny; ny < maxy; ny += QualityStepHelper::getStep()) {
 				float dy = ny - y;
 				int offsetNy = ny * inputSizeBuffer->getWidth() * COM_NUMBER_OF_CHANNELS;
 				int offsetNxNy = offsetNy + (minx * COM_NUMBER_OF_CHANNELS);
+				int offsetSizeNxNy = (ny * inputSizeBuffer->getWidth() + minx) * sizeChannels;
 				for (int nx = minx; nx < maxx; nx += QualityStepHelper::getStep()) {
 					if (nx != x || ny != y) {
-						float size = inputSizeFloatBuffer[offsetNxNy] * scalar;
+						float size = inputSizeFloatBuffer[offsetSizeNxNy] * scalar;
 						if (size > this->m_threshold) {
 							float dx = nx - x;
 							if (size > fabsf(dx) && size > fabsf(dy)) {
@@ -160,6 +164,7 @@ void VariableSizeBokehBlurOperation::executePixel(float output[4], int x, int y,
 						}
 					}
 					offsetNxNy += addXStep;
+					offsetSizeNxNy += addXSizeStep;
 				}
 			}
 		}
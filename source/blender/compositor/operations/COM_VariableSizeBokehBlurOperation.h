@@ -69,6 +69,11 @@ public:
 
 	void setDoScaleSize(bool scale_size) { this->m_do_size_scale = scale_size; }
 
+	/**
+	 * the size is read with the number of channels of its buffer
+	 */
+	bool isChannelAwareInput(unsigned int inputSocketIndex) const { return inputSocketIndex == 2; }
+
 	void executeOpenCL(OpenCLDevice *device, MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer, MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp, list<cl_kernel> *clKernelsToCleanUp);
 };
 
@@ -64,6 +64,11 @@ public:
 
 	void setVectorBlurSettings(NodeBlurData *settings) { this->m_settings = settings; }
 	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
+
+	/**
+	 * the Z input is converted to a value buffer
+	 */
+	bool isChannelAwareInput(unsigned int inputSocketIndex) const { return inputSocketIndex == 1; }
 protected:
 	
 	void generateVectorBlur(float *data, MemoryBuffer *inputImage, MemoryBuffer *inputSpeed, MemoryBuffer *inputZ);
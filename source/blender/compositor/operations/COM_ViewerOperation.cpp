@@ -86,6 +86,12 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 	int y;
 	bool breaked = false;
 
+	if (this->isRowExecution()) {
+		executeRegionRows(rect);
+		updateImage(rect);
+		return;
+	}
+
 	for (y = y1; y < y2 && (!breaked); y++) {
 		for (x = x1; x < x2; x++) {
 			this->m_imageInput->read(&(buffer[offset4]), x, y, COM_PS_NEAREST);
@@ -109,3 +115,42 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 	}
 	updateImage(rect);
 }
+
+void ViewerOperation::executeRegionRows(rcti *rect)
+{
+	float row[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+	float *buffer = this->m_outputBuffer;
+	float *depthbuffer = this->m_depthBuffer;
+	const int x1 = rect->xmin;
+	const int y1 = rect->ymin;
+	const int x2 = rect->xmax;
+	const int y2 = rect->ymax;
+	int x;
+	int y;
+	int i;
+
+	for (y = y1; y < y2; y++) {
+		for (x = x1; x < x2; x += COM_ROW_SIZE) {
+			const int width = min_ii(x2 - x, COM_ROW_SIZE);
+			const int offset = y * this->getWidth() + x;
+			float *output = buffer + offset * 4;
+
+			this->m_imageInput->readRow(output, x, y, width);
+			if (this->m_alphaInput != NULL) {
+				this->m_alphaInput->readRow(row, x, y, width);
+				for (i = 0; i < width; i++) {
+					output[i * 4 + 3] = row[i * 4];
+				}
+			}
+			if (this->m_depthInput != NULL) {
+				this->m_depthInput->readRow(row, x, y, width);
+				for (i = 0; i < width; i++) {
+					depthbuffer[offset + i] = row[i * 4];
+				}
+			}
+		}
+		if (isBreaked()) {
+			break;
+		}
+	}
+}
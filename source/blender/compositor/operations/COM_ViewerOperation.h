@@ -36,6 +36,7 @@ private:
 public:
 	ViewerOperation();
 	void executeRegion(rcti *rect, unsigned int tileNumber);
+	void executeRegionRows(rcti *rect);
 	void initExecution();
 	void deinitExecution();
 };
@@ -31,6 +31,9 @@ WriteBufferOperation::WriteBufferOperation() : NodeOperation()
 	this->m_memoryProxy = new MemoryProxy();
 	this->m_memoryProxy->setWriteBufferOperation(this);
 	this->m_memoryProxy->setExecutor(NULL);
+	this->m_cacheKey = 0;
+	this->m_hasCacheKey = false;
+	this->m_restored = false;
 }
 WriteBufferOperation::~WriteBufferOperation()
 {
@@ -61,6 +64,8 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 {
 	MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
 	float *buffer = memoryBuffer->getBuffer();
+	const unsigned int numberOfChannels = memoryBuffer->getNumberOfChannels();
+	float color[4];
 	if (this->m_input->isComplex()) {
 		void *data = this->m_input->initializeTileData(rect);
 		int x1 = rect->xmin;
@@ -71,10 +76,11 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 		int y;
 		bool breaked = false;
 		for (y = y1; y < y2 && (!breaked); y++) {
-			int offset4 = (y * memoryBuffer->getWidth() + x1) * COM_NUMBER_OF_CHANNELS;
+			int offset = (y * memoryBuffer->getWidth() + x1) * numberOfChannels;
 			for (x = x1; x < x2; x++) {
-				this->m_input->read(&(buffer[offset4]), x, y, data);
-				offset4 += COM_NUMBER_OF_CHANNELS;
+				this->m_input->read(color, x, y, data);
+				memcpy(&buffer[offset], color, sizeof(float) * numberOfChannels);
+				offset += numberOfChannels;
 
 			}
 			if (isBreaked()) {
@@ -87,6 +93,37 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 			data = NULL;
 		}
 	}
+	else if (this->isRowExecution()) {
+		int x1 = rect->xmin;
+		int y1 = rect->ymin;
+		int x2 = rect->xmax;
+		int y2 = rect->ymax;
+
+		int x;
+		int y;
+		bool breaked = false;
+		float row[COM_ROW_SIZE * COM_NUMBER_OF_CHANNELS];
+		for (y = y1; y < y2 && (!breaked); y++) {
+			int offset = (y * memoryBuffer->getWidth() + x1) * numberOfChannels;
+			for (x = x1; x < x2; x += COM_ROW_SIZE) {
+				const int width = min_ii(x2 - x, COM_ROW_SIZE);
+				if (numberOfChannels == COM_NUMBER_OF_CHANNELS) {
+					this->m_input->readRow(&(buffer[offset]), x, y, width);
+					offset += width * COM_NUMBER_OF_CHANNELS;
+				}
+				else {
+					this->m_input->readRow(row, x, y, width);
+					for (int i = 0; i < width; i++) {
+						memcpy(&buffer[offset], &row[i * COM_NUMBER_OF_CHANNELS], sizeof(float) * numberOfChannels);
+						offset += numberOfChannels;
+					}
+				}
+			}
+			if (isBreaked()) {
+				breaked = true;
+			}
+		}
+	}
 	else {
 		int x1 = rect->xmin;
 		int y1 = rect->ymin;
@@ -97,10 +134,11 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 		int y;
 		bool breaked = false;
 		for (y = y1; y < y2 && (!breaked); y++) {
-			int offset4 = (y * memoryBuffer->getWidth() + x1) * COM_NUMBER_OF_CHANNELS;
+			int offset = (y * memoryBuffer->getWidth() + x1) * numberOfChannels;
 			for (x = x1; x < x2; x++) {
-				this->m_input->read(&(buffer[offset4]), x, y, COM_PS_NEAREST);
-				offset4 += COM_NUMBER_OF_CHANNELS;
+				this->m_input->read(color, x, y, COM_PS_NEAREST);
+				memcpy(&buffer[offset], color, sizeof(float) * numberOfChannels);
+				offset += numberOfChannels;
 			}
 			if (isBreaked()) {
 				breaked = true;
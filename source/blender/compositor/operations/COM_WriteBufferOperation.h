@@ -26,6 +26,8 @@
 #include "COM_NodeOperation.h"
 #include "COM_MemoryProxy.h"
 #include "COM_SocketReader.h"
+#include "BLO_sys_types.h"
+
 /**
  * @brief Operation to write to a tile
  * @ingroup Operation
@@ -33,6 +35,17 @@
 class WriteBufferOperation : public NodeOperation {
 	MemoryProxy *m_memoryProxy;
 	NodeOperation *m_input;
+
+	/**
+	 * @brief key of the buffer in the ResultCache, when m_hasCacheKey is set
+	 */
+	uint64_t m_cacheKey;
+	bool m_hasCacheKey;
+
+	/**
+	 * @brief the buffer was restored from the ResultCache instead of calculated
+	 */
+	bool m_restored;
 public:
 	WriteBufferOperation();
 	~WriteBufferOperation();
@@ -50,5 +63,11 @@ public:
 		return m_input;
 	}
 
+	void setCacheKey(uint64_t key) { this->m_cacheKey = key; this->m_hasCacheKey = true; }
+	bool hasCacheKey() const { return this->m_hasCacheKey; }
+	uint64_t getCacheKey() const { return this->m_cacheKey; }
+	void setRestored() { this->m_restored = true; }
+	bool isRestored() const { return this->m_restored; }
+
 };
 #endif
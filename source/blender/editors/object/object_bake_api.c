@@ -0,0 +1,437 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2013 by Blender Foundation
+ * All rights reserved.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/editors/object/object_bake_api.c
+ *  \ingroup edobj
+ *
+ * Texture baking with the render engine, for engines that implement the
+ * bake callback. The object UV map decides which image pixel belongs to
+ * which point on the surface, the images are the ones assigned to the faces.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_context.h"
+#include "BKE_customdata.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_global.h"
+#include "BKE_image.h"
+#include "BKE_main.h"
+#include "BKE_report.h"
+
+#include "RE_bake.h"
+#include "RE_pipeline.h"
+#include "RE_shader_ext.h"
+
+#include "IMB_colormanagement.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "GPU_draw.h" /* GPU_free_image */
+
+#include "RNA_access.h"
+#include "RNA_define.h"
+#include "RNA_enum_types.h"
+
+#include "WM_api.h"
+#include "WM_types.h"
+
+#include "ED_object.h"
+#include "ED_screen.h"
+
+#include "object_intern.h"
+
+typedef struct BakeAPIRender {
+	Main *main;
+	Scene *scene;
+	Object *ob;
+	ReportList *reports;
+
+	int pass_type;
+	int margin;
+	int use_clear;
+
+	int result;
+
+	/* set when running as a job */
+	short *stop;
+} BakeAPIRender;
+
+static int bake_break(void *bkv)
+{
+	BakeAPIRender *bkr = bkv;
+	return (G.is_break || (bkr->stop && *bkr->stop));
+}
+
+static int bake_object_check(Object *ob, ReportList *reports)
+{
+	if (ob == NULL) {
+		BKE_report(reports, RPT_ERROR, "No active object");
+		return 0;
+	}
+
+	if (ob->type != OB_MESH) {
+		BKE_reportf(reports, RPT_ERROR, "Object \"%s\" is not a mesh", ob->id.name + 2);
+		return 0;
+	}
+
+	if (CustomData_get_active_layer_index(&((Mesh *)ob->data)->pdata, CD_MTEXPOLY) == -1) {
+		BKE_reportf(reports, RPT_ERROR, "No UV map found in the object \"%s\"", ob->id.name + 2);
+		return 0;
+	}
+
+	return 1;
+}
+
+/* collect the images assigned to the faces, each gets its range of pixels */
+static int bake_images_collect(MTFace *mtface, const int totface, BakeImage *images, int *r_num_pixels)
+{
+	int tot_images = 0;
+	int num_pixels = 0;
+	int i, j;
+
+	for (i = 0; i < totface; i++) {
+		Image *ima = mtface[i].tpage;
+		ImBuf *ibuf;
+
+		if (ima == NULL)
+			continue;
+
+		for (j = 0; j < tot_images; j++) {
+			if (images[j].image == ima)
+				break;
+		}
+
+		if (j != tot_images)
+			continue;
+
+		ibuf = BKE_image_acquire_ibuf(ima, NULL, NULL);
+
+		if (ibuf) {
+			images[tot_images].image = ima;
+			images[tot_images].width = ibuf->x;
+			images[tot_images].height = ibuf->y;
+			images[tot_images].offset = num_pixels;
+
+			num_pixels += ibuf->x * ibuf->y;
+			tot_images++;
+		}
+
+		BKE_image_release_ibuf(ima, ibuf, NULL);
+	}
+
+	*r_num_pixels = num_pixels;
+	return tot_images;
+}
+
+/* write the engine result into the image, pixels that no face covers keep
+ * their value unless the image is cleared, and are filled by the margin */
+static void bake_image_write(const BakeImage *bk_image, const BakePixel *pixel_array, const float *result,
+                             const int depth, const int margin, const int use_clear, const int is_noncolor)
+{
+	Image *ima = bk_image->image;
+	ImBuf *ibuf = BKE_image_acquire_ibuf(ima, NULL, NULL);
+	const int num_pixels = bk_image->width * bk_image->height;
+	char *mask;
+	int i;
+
+	/* image may have been reloaded with another size in the meantime */
+	if (ibuf == NULL || ibuf->x != bk_image->width || ibuf->y != bk_image->height ||
+	    (ibuf->rect_float && ibuf->channels != 4))
+	{
+		BKE_image_release_ibuf(ima, ibuf, NULL);
+		return;
+	}
+
+	if (use_clear) {
+		const float vec_alpha[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		const float vec_solid[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+
+		IMB_rectfill(ibuf, (ibuf->planes == R_IMF_PLANES_RGBA) ? vec_alpha : vec_solid);
+	}
+
+	mask = MEM_mallocN(sizeof(char) * num_pixels, "bake mask");
+	RE_bake_mask_fill(pixel_array + bk_image->offset, num_pixels, mask);
+
+	for (i = 0; i < num_pixels; i++) {
+		const float *col = result + (bk_image->offset + i) * depth;
+
+		if (mask[i] != FILTER_MASK_USED)
+			continue;
+
+		if (ibuf->rect_float) {
+			float *rrect = ibuf->rect_float + i * 4;
+
+			copy_v3_v3(rrect, col);
+			rrect[3] = 1.0f;
+		}
+		else {
+			unsigned char *rect = (unsigned char *)(ibuf->rect + i);
+			float rgb[3];
+
+			copy_v3_v3(rgb, col);
+
+			/* normals are data, not colors */
+			if (!is_noncolor)
+				IMB_colormanagement_scene_linear_to_colorspace_v3(rgb, ibuf->rect_colorspace);
+
+			rgb_float_to_uchar(rect, rgb);
+			rect[3] = 255;
+		}
+	}
+
+	RE_bake_ibuf_filter(ibuf, mask, margin);
+
+	/* force OpenGL reload and mipmap recalc */
+	ibuf->userflags |= IB_BITMAPDIRTY | IB_DISPLAY_BUFFER_INVALID;
+	if (ibuf->rect_float)
+		ibuf->userflags |= IB_RECT_INVALID;
+
+	GPU_free_image(ima);
+	imb_freemipmapImBuf(ibuf);
+
+	BKE_image_release_ibuf(ima, ibuf, NULL);
+
+	MEM_freeN(mask);
+}
+
+static int bake_object(BakeAPIRender *bkr)
+{
+	Scene *scene = bkr->scene;
+	Object *ob = bkr->ob;
+	Render *re;
+	DerivedMesh *dm;
+	MFace *mface;
+	MTFace *mtface;
+	BakeImage *images;
+	BakePixel *pixel_array;
+	float *result;
+	const int depth = 4;
+	const int is_noncolor = (bkr->pass_type == SCE_PASS_NORMAL);
+	int totface, tot_images, num_pixels, i;
+
+	/* same mesh as the render engine sees, with quads split in the same order */
+	dm = mesh_create_derived_render(scene, ob, CD_MASK_BAREMESH | CD_MASK_MTFACE);
+	DM_ensure_tessface(dm);
+
+	mface = dm->getTessFaceArray(dm);
+	totface = dm->getNumTessFaces(dm);
+	mtface = CustomData_get_layer(&dm->faceData, CD_MTFACE);
+
+	if (mtface == NULL || totface == 0) {
+		BKE_reportf(bkr->reports, RPT_ERROR, "No UV map found in the object \"%s\"", ob->id.name + 2);
+		dm->release(dm);
+		return OPERATOR_CANCELLED;
+	}
+
+	images = MEM_callocN(sizeof(BakeImage) * totface, "bake images");
+	tot_images = bake_images_collect(mtface, totface, images, &num_pixels);
+
+	if (tot_images == 0) {
+		BKE_report(bkr->reports, RPT_ERROR, "No valid images found to bake to");
+		MEM_freeN(images);
+		dm->release(dm);
+		return OPERATOR_CANCELLED;
+	}
+
+	pixel_array = MEM_mallocN(sizeof(BakePixel) * num_pixels, "bake pixels");
+	result = MEM_callocN(sizeof(float) * depth * num_pixels, "bake result");
+
+	RE_bake_pixels_populate(mface, mtface, totface, images, tot_images, pixel_array);
+
+	dm->release(dm);
+
+	/* the engine renders with the scene settings, only the image resolution
+	 * matters for the camera it may set up */
+	re = RE_NewRender("_Bake Engine_");
+	RE_InitState(re, NULL, &scene->r, NULL,
+	             (scene->r.size * scene->r.xsch) / 100, (scene->r.size * scene->r.ysch) / 100, NULL);
+	RE_SetReports(re, bkr->reports);
+	RE_test_break_cb(re, bkr, bake_break);
+
+	if (!RE_bake_has_engine(re)) {
+		BKE_report(bkr->reports, RPT_ERROR, "Current render engine does not support baking");
+	}
+	else {
+		RE_bake_engine(re, bkr->main, scene, ob, pixel_array, num_pixels, depth, bkr->pass_type, result);
+
+		/* a cancelled bake leaves the images untouched */
+		if (!bake_break(bkr)) {
+			for (i = 0; i < tot_images; i++)
+				bake_image_write(&images[i], pixel_array, result, depth, bkr->margin, bkr->use_clear, is_noncolor);
+
+			bkr->result = OPERATOR_FINISHED;
+		}
+	}
+
+	RE_SetReports(re, NULL);
+	RE_FreeRender(re);
+
+	MEM_freeN(result);
+	MEM_freeN(pixel_array);
+	MEM_freeN(images);
+
+	return bkr->result;
+}
+
+static void bake_init_api_data(wmOperator *op, bContext *C, BakeAPIRender *bkr)
+{
+	/* get editmode results */
+	ED_object_exit_editmode(C, 0);  /* 0 = does not exit editmode */
+
+	bkr->main = CTX_data_main(C);
+	bkr->scene = CTX_data_scene(C);
+	bkr->ob = CTX_data_active_object(C);
+	bkr->reports = op->reports;
+
+	bkr->pass_type = RNA_enum_get(op->ptr, "type");
+	bkr->margin = RNA_int_get(op->ptr, "margin");
+	bkr->use_clear = RNA_boolean_get(op->ptr, "use_clear");
+
+	bkr->result = OPERATOR_CANCELLED;
+}
+
+static int bake_exec(bContext *C, wmOperator *op)
+{
+	BakeAPIRender bkr = {NULL};
+
+	bake_init_api_data(op, C, &bkr);
+
+	if (!bake_object_check(bkr.ob, op->reports))
+		return OPERATOR_CANCELLED;
+
+	G.is_break = FALSE;
+	G.is_rendering = TRUE;
+
+	bake_object(&bkr);
+
+	G.is_rendering = FALSE;
+
+	WM_event_add_notifier(C, NC_IMAGE, NULL);
+
+	return bkr.result;
+}
+
+static void bake_startjob(void *bkv, short *stop, short *UNUSED(do_update), float *UNUSED(progress))
+{
+	BakeAPIRender *bkr = bkv;
+
+	bkr->stop = stop;
+	bake_object(bkr);
+}
+
+static void bake_freejob(void *bkv)
+{
+	BakeAPIRender *bkr = bkv;
+
+	MEM_freeN(bkr);
+	G.is_rendering = FALSE;
+}
+
+/* catch esc */
+static int bake_modal(bContext *C, wmOperator *UNUSED(op), wmEvent *event)
+{
+	/* no running bake, remove handler and pass through */
+	if (0 == WM_jobs_test(CTX_wm_manager(C), CTX_data_scene(C), WM_JOB_TYPE_OBJECT_BAKE_TEXTURE))
+		return OPERATOR_FINISHED | OPERATOR_PASS_THROUGH;
+
+	/* running bake */
+	switch (event->type) {
+		case ESCKEY:
+			return OPERATOR_RUNNING_MODAL;
+	}
+	return OPERATOR_PASS_THROUGH;
+}
+
+static int bake_invoke(bContext *C, wmOperator *op, wmEvent *UNUSED(event))
+{
+	Scene *scene = CTX_data_scene(C);
+	BakeAPIRender *bkr;
+	wmJob *wm_job;
+
+	/* only one bake job at a time */
+	if (WM_jobs_test(CTX_wm_manager(C), scene, WM_JOB_TYPE_OBJECT_BAKE_TEXTURE))
+		return OPERATOR_CANCELLED;
+
+	bkr = MEM_callocN(sizeof(BakeAPIRender), "render bake");
+	bake_init_api_data(op, C, bkr);
+
+	if (!bake_object_check(bkr->ob, op->reports)) {
+		MEM_freeN(bkr);
+		return OPERATOR_CANCELLED;
+	}
+
+	/* setup job */
+	wm_job = WM_jobs_get(CTX_wm_manager(C), CTX_wm_window(C), scene, "Texture Bake",
+	                     WM_JOB_EXCL_RENDER | WM_JOB_PRIORITY | WM_JOB_PROGRESS, WM_JOB_TYPE_OBJECT_BAKE_TEXTURE);
+	WM_jobs_customdata_set(wm_job, bkr, bake_freejob);
+	WM_jobs_timer(wm_job, 0.5, NC_IMAGE, 0);
+	WM_jobs_callbacks(wm_job, bake_startjob, NULL, NULL, NULL);
+
+	G.is_break = FALSE;
+	G.is_rendering = TRUE;
+
+	WM_jobs_start(CTX_wm_manager(C), wm_job);
+
+	WM_cursor_wait(0);
+
+	/* add modal handler for ESC */
+	WM_event_add_modal_handler(C, op);
+
+	WM_event_add_notifier(C, NC_SCENE | ND_RENDER_RESULT, scene);
+
+	return OPERATOR_RUNNING_MODAL;
+}
+
+void OBJECT_OT_bake(wmOperatorType *ot)
+{
+	/* identifiers */
+	ot->name = "Bake";
+	ot->description = "Bake image textures of the active object with the render engine";
+	ot->idname = "OBJECT_OT_bake";
+
+	/* api callbacks */
+	ot->exec = bake_exec;
+	ot->invoke = bake_invoke;
+	ot->modal = bake_modal;
+	ot->poll = ED_operator_object_active_editable_mesh;
+
+	RNA_def_enum(ot->srna, "type", render_bake_pass_type_items, SCE_PASS_COMBINED, "Type",
+	             "Type of pass to bake, some of them may not be supported by the current render engine");
+	RNA_def_int(ot->srna, "margin", 16, 0, INT_MAX, "Margin",
+	            "Extends the baked result as a post process filter", 0, 64);
+	RNA_def_boolean(ot->srna, "use_clear", FALSE, "Clear",
+	                "Clear images before baking");
+}
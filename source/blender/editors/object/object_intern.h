@@ -238,5 +238,8 @@ void OBJECT_OT_group_remove(struct wmOperatorType *ot);
 /* object_bake.c */
 void OBJECT_OT_bake_image(wmOperatorType *ot);
 
+/* object_bake_api.c */
+void OBJECT_OT_bake(wmOperatorType *ot);
+
 #endif /* __OBJECT_INTERN_H__ */
 
@@ -226,6 +226,7 @@ void ED_operatortypes_object(void)
 	WM_operatortype_append(OBJECT_OT_hook_recenter);
 
 	WM_operatortype_append(OBJECT_OT_bake_image);
+	WM_operatortype_append(OBJECT_OT_bake);
 	WM_operatortype_append(OBJECT_OT_drop_named_material);
 }
 
@@ -102,6 +102,16 @@ typedef struct ThumbnailJob {
 	ReportList reports;
 } ThumbnailJob;
 
+typedef struct FileReadJob {
+	ThreadMutex lock;
+	char dir[FILE_MAX];
+	struct FileList *filelist;
+	struct DirListing *listing;  /* until the job thread ends it, locked by lock */
+	unsigned int totready;       /* entries of the listing added to filelist */
+	struct direntry *files;      /* sorted listing, when the job finished */
+	unsigned int totfile;
+} FileReadJob;
+
 typedef struct FileList {
 	struct direntry *filelist;
 	int *fidx;
@@ -543,15 +553,10 @@ FileList *filelist_new(short type)
 }
 
 
-void filelist_free(struct FileList *filelist)
+static void filelist_free_files(struct FileList *filelist)
 {
 	int i;
 
-	if (!filelist) {
-		printf("Attempting to delete empty filelist.\n");
-		return;
-	}
-	
 	if (filelist->fidx) {
 		MEM_freeN(filelist->fidx);
 		filelist->fidx = NULL;
@@ -575,9 +580,19 @@ void filelist_free(struct FileList *filelist)
 	filelist->numfiles = 0;
 	free(filelist->filelist);
 	filelist->filelist = NULL;
+	filelist->numfiltered = 0;
+}
+
+void filelist_free(struct FileList *filelist)
+{
+	if (!filelist) {
+		printf("Attempting to delete empty filelist.\n");
+		return;
+	}
+
+	filelist_free_files(filelist);
 	filelist->filter = 0;
 	filelist->filter_glob[0] = '\0';
-	filelist->numfiltered = 0;
 	filelist->hide_dot = 0;
 }
 
@@ -1393,10 +1408,150 @@ void thumbnails_start(struct FileList *filelist, const struct bContext *C)
 
 void thumbnails_stop(struct FileList *filelist, const struct bContext *C)
 {
-	WM_jobs_kill(CTX_wm_manager(C), filelist, NULL);
+	WM_jobs_kill_type(CTX_wm_manager(C), filelist, WM_JOB_TYPE_FILESEL_THUMBNAIL);
 }
 
 int thumbnails_running(struct FileList *filelist, const struct bContext *C)
 {
 	return WM_jobs_test(CTX_wm_manager(C), filelist, WM_JOB_TYPE_FILESEL_THUMBNAIL);
 }
+
+/* Directories are read in a job, the entries stat'ed so far are shown while
+ * waiting for the rest, on slow (network) disks that can take seconds. The final
+ * listing replaces them when the job is done. Libraries are read directly. */
+
+static void filelist_readjob_startjob(void *rjv, short *stop, short *do_update, float *UNUSED(progress))
+{
+	FileReadJob *rj = rjv;
+	struct DirListing *dl = BLI_dir_listing_begin(rj->dir);
+	struct direntry *files;
+	unsigned int totfile;
+
+	BLI_mutex_lock(&rj->lock);
+	rj->listing = dl;
+	BLI_mutex_unlock(&rj->lock);
+
+	while ((*stop == 0) && (BLI_dir_listing_ready(dl, &files, &totfile) < totfile)) {
+		*do_update = TRUE;
+		PIL_sleep_ms(10);
+	}
+
+	/* the update callback can't use the listing anymore once it gets sorted */
+	BLI_mutex_lock(&rj->lock);
+	rj->listing = NULL;
+	BLI_mutex_unlock(&rj->lock);
+
+	if (*stop) {
+		BLI_dir_listing_cancel(dl);
+	}
+	else {
+		rj->totfile = BLI_dir_listing_end(dl, &rj->files);
+
+		/* keep filelist_empty() false for a missing directory, like BLI_dir_contents() */
+		if (rj->files == NULL) {
+			rj->files = malloc(sizeof(struct direntry));
+		}
+	}
+}
+
+static void filelist_readjob_update(void *rjv)
+{
+	FileReadJob *rj = rjv;
+	FileList *filelist = rj->filelist;
+	struct direntry *files = NULL, *file;
+	unsigned int totready = 0, i;
+
+	BLI_mutex_lock(&rj->lock);
+	if (rj->listing) {
+		totready = BLI_dir_listing_ready(rj->listing, &files, NULL);
+	}
+
+	if (totready > rj->totready) {
+		filelist->filelist = realloc(filelist->filelist, sizeof(struct direntry) * (filelist->numfiles + totready - rj->totready));
+
+		for (i = rj->totready; i < totready; i++) {
+			file = &filelist->filelist[filelist->numfiles++];
+			*file = files[i];
+			file->relname = BLI_strdup(files[i].relname);
+			file->path = BLI_strdup(files[i].path);
+			file->string = NULL;
+			file->image = NULL;
+			file->poin = NULL;
+		}
+		rj->totready = totready;
+	}
+	BLI_mutex_unlock(&rj->lock);
+
+	if (filelist->filelist) {
+		filelist_setfiletypes(filelist);
+		filelist_filter(filelist);
+	}
+}
+
+static void filelist_readjob_endjob(void *rjv)
+{
+	FileReadJob *rj = rjv;
+	FileList *filelist = rj->filelist;
+
+	/* also called when the job is killed, then the entries read so far stay */
+	if (rj->files) {
+		filelist_free_files(filelist);
+		filelist->filelist = rj->files;
+		filelist->numfiles = rj->totfile;
+		rj->files = NULL;
+
+		filelist_setfiletypes(filelist);
+		filelist_filter(filelist);
+	}
+}
+
+static void filelist_readjob_free(void *rjv)
+{
+	FileReadJob *rj = rjv;
+
+	if (rj->files) {
+		BLI_dir_contents_free(rj->files, rj->totfile);
+	}
+	BLI_mutex_end(&rj->lock);
+	MEM_freeN(rj);
+}
+
+void filelist_readjob_start(struct FileList *filelist, const struct bContext *C)
+{
+	wmJob *wm_job;
+	FileReadJob *rj;
+
+	if (filelist->readf != filelist_read_dir) {
+		filelist_readdir(filelist);
+		return;
+	}
+
+	filelist_free_files(filelist);
+	BLI_cleanup_dir(G.main->name, filelist->dir);
+
+	/* prepare job data */
+	rj = MEM_callocN(sizeof(FileReadJob), "FileReadJob");
+	BLI_mutex_init(&rj->lock);
+	BLI_strncpy(rj->dir, filelist->dir, sizeof(rj->dir));
+	rj->filelist = filelist;
+
+	/* setup job */
+	wm_job = WM_jobs_get(CTX_wm_manager(C), CTX_wm_window(C), filelist, "Listing Directory",
+	                     0, WM_JOB_TYPE_FILESEL_READDIR);
+	WM_jobs_customdata_set(wm_job, rj, filelist_readjob_free);
+	WM_jobs_timer(wm_job, 0.1, NC_SPACE | ND_SPACE_FILE_LIST, NC_SPACE | ND_SPACE_FILE_LIST);
+	WM_jobs_callbacks(wm_job, filelist_readjob_startjob, NULL, filelist_readjob_update, filelist_readjob_endjob);
+
+	/* start the job */
+	WM_jobs_start(CTX_wm_manager(C), wm_job);
+}
+
+void filelist_readjob_stop(struct FileList *filelist, const struct bContext *C)
+{
+	WM_jobs_kill_type(CTX_wm_manager(C), filelist, WM_JOB_TYPE_FILESEL_READDIR);
+}
+
+int filelist_readjob_running(struct FileList *filelist, const struct bContext *C)
+{
+	return WM_jobs_test(CTX_wm_manager(C), filelist, WM_JOB_TYPE_FILESEL_READDIR);
+}
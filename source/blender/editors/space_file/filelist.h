@@ -103,6 +103,10 @@ void                thumbnails_stop(struct FileList *filelist, const struct bCon
 void                thumbnails_start(struct FileList *filelist, const struct bContext *C);
 int                 thumbnails_running(struct FileList *filelist, const struct bContext *C);
 
+void                filelist_readjob_start(struct FileList *filelist, const struct bContext *C);
+void                filelist_readjob_stop(struct FileList *filelist, const struct bContext *C);
+int                 filelist_readjob_running(struct FileList *filelist, const struct bContext *C);
+
 #ifdef __cplusplus
 }
 #endif
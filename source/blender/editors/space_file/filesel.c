@@ -689,6 +689,7 @@ void ED_fileselect_clear(struct bContext *C, struct SpaceFile *sfile)
 {
 	/* only NULL in rare cases - [#29734] */
 	if (sfile->files) {
+		filelist_readjob_stop(sfile->files, C);
 		thumbnails_stop(sfile->files, C);
 		filelist_freelib(sfile->files);
 		filelist_free(sfile->files);
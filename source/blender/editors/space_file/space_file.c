@@ -115,7 +115,7 @@ static void file_free(SpaceLink *sl)
 	SpaceFile *sfile = (SpaceFile *) sl;
 	
 	if (sfile->files) {
-		// XXXXX would need to do thumbnails_stop here, but no context available
+		// XXXXX would need to do thumbnails_stop and filelist_readjob_stop here, but no context available
 		filelist_freelib(sfile->files);
 		filelist_free(sfile->files);
 		MEM_freeN(sfile->files);
@@ -201,14 +201,23 @@ static void file_refresh(const bContext *C, ScrArea *UNUSED(sa))
 	filelist_setfilter(sfile->files, params->flag & FILE_FILTER ? params->filter : 0);
 	filelist_setfilter_types(sfile->files, params->filter_glob);
 
-	if (filelist_empty(sfile->files)) {
+	if (filelist_readjob_running(sfile->files, C)) {
+		/* entries are added until the job is done, thumbnails start after it */
+		if (params->sort != FILE_SORT_NONE) {
+			filelist_sort(sfile->files, params->sort);
+		}
+		else {
+			filelist_filter(sfile->files);
+		}
+	}
+	else if (filelist_empty(sfile->files)) {
 		thumbnails_stop(sfile->files, C);
-		filelist_readdir(sfile->files);
+		filelist_readjob_start(sfile->files, C);
 		if (params->sort != FILE_SORT_NONE) {
 			filelist_sort(sfile->files, params->sort);
 		}
 		BLI_strncpy(params->dir, filelist_dir(sfile->files), FILE_MAX);
-		if (params->display == FILE_IMGDISPLAY) {
+		if (params->display == FILE_IMGDISPLAY && !filelist_readjob_running(sfile->files, C)) {
 			thumbnails_start(sfile->files, C);
 		}
 	}
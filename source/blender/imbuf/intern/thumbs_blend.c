@@ -27,8 +27,6 @@
 
 #include <string.h>
 
-#include "zlib.h"
-
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
@@ -36,6 +34,7 @@
 #include "BLI_fileops.h"
 
 #include "BLO_blend_defs.h"
+#include "BLO_readfile.h"
 
 #include "BKE_global.h"
 
@@ -46,7 +45,7 @@
 /* extracts the thumbnail from between the 'REND' and the 'GLOB'
  * chunks of the header, don't use typical blend loader because its too slow */
 
-static ImBuf *loadblend_thumb(gzFile gzfile)
+static ImBuf *loadblend_thumb(BlendFileReader *reader)
 {
 	char buf[12];
 	int bhead[24 / sizeof(int)]; /* max size on 64bit */
@@ -55,7 +54,7 @@ static ImBuf *loadblend_thumb(gzFile gzfile)
 	int sizeof_bhead;
 
 	/* read the blend file header */
-	if (gzread(gzfile, buf, 12) != 12)
+	if (BLO_file_reader_read(reader, buf, 12) != 12)
 		return NULL;
 	if (strncmp(buf, "BLENDER", 7))
 		return NULL;
@@ -78,12 +77,13 @@ static ImBuf *loadblend_thumb(gzFile gzfile)
 
 	endian_switch = ((ENDIAN_ORDER != endian)) ? 1 : 0;
 
-	while (gzread(gzfile, bhead, sizeof_bhead) == sizeof_bhead) {
+	while (BLO_file_reader_read(reader, bhead, sizeof_bhead) == sizeof_bhead) {
 		if (endian_switch)
 			BLI_endian_switch_int32(&bhead[1]);  /* length */
 
 		if (bhead[0] == REND) {
-			gzseek(gzfile, bhead[1], SEEK_CUR); /* skip to the next */
+			if (!BLO_file_reader_skip(reader, bhead[1])) /* skip to the next */
+				return NULL;
 		}
 		else {
 			break;
@@ -95,7 +95,7 @@ static ImBuf *loadblend_thumb(gzFile gzfile)
 		ImBuf *img = NULL;
 		int size[2];
 
-		if (gzread(gzfile, size, sizeof(size)) != sizeof(size))
+		if (BLO_file_reader_read(reader, size, sizeof(size)) != sizeof(size))
 			return NULL;
 
 		if (endian_switch) {
@@ -112,7 +112,7 @@ static ImBuf *loadblend_thumb(gzFile gzfile)
 		/* finally malloc and read the data */
 		img = IMB_allocImBuf(size[0], size[1], 32, IB_rect | IB_metadata);
 	
-		if (gzread(gzfile, img->rect, bhead[1]) != bhead[1]) {
+		if (BLO_file_reader_read(reader, img->rect, bhead[1]) != bhead[1]) {
 			IMB_freeImBuf(img);
 			img = NULL;
 		}
@@ -125,18 +125,18 @@ static ImBuf *loadblend_thumb(gzFile gzfile)
 
 ImBuf *IMB_loadblend_thumb(const char *path)
 {
-	gzFile gzfile;
-	/* not necessarily a gzip */
-	gzfile = BLI_gzopen(path, "rb");
+	BlendFileReader *reader;
+	/* not necessarily a gzip, also framed compressed files */
+	reader = BLO_file_reader_open(path);
 
-	if (NULL == gzfile) {
+	if (NULL == reader) {
 		return NULL;
 	}
 	else {
-		ImBuf *img = loadblend_thumb(gzfile);
+		ImBuf *img = loadblend_thumb(reader);
 
 		/* read ok! */
-		gzclose(gzfile);
+		BLO_file_reader_close(reader);
 
 		return img;
 	}
@@ -111,6 +111,10 @@ typedef struct Image {
 
 	/* color management */
 	ColorManagedColorspaceSettings colorspace_settings;
+
+	/* runtime, unique value set when the image is read or its buffers are
+	 * freed, so users of the buffers can notice a reload */
+	int generation, pad3;
 } Image;
 
 
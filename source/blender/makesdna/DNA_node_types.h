@@ -311,6 +311,8 @@ typedef struct bNodeTree {
 #define NTREE_DS_EXPAND		1	/* for animation editors */
 #define NTREE_COM_OPENCL	2	/* use opencl */
 #define NTREE_TWO_PASS		4	/* two pass */
+#define NTREE_COM_PROXY_50	8	/* first pass at half resolution during editing */
+#define NTREE_COM_PROXY_25	16	/* first pass at quarter resolution during editing */
 /* XXX not nice, but needed as a temporary flags
  * for group updates after library linking.
  */
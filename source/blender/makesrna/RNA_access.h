@@ -69,6 +69,7 @@ extern StructRNA RNA_ArmatureModifier;
 extern StructRNA RNA_ArmatureSensor;
 extern StructRNA RNA_ArrayModifier;
 extern StructRNA RNA_BackgroundImage;
+extern StructRNA RNA_BakePixel;
 extern StructRNA RNA_BevelModifier;
 extern StructRNA RNA_SplinePoint;
 extern StructRNA RNA_BezierSplinePoint;
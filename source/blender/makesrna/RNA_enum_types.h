@@ -81,6 +81,8 @@ extern EnumPropertyItem nla_mode_blend_items[];
 
 extern EnumPropertyItem motionpath_bake_location_items[];
 
+extern EnumPropertyItem render_bake_pass_type_items[];
+
 extern EnumPropertyItem event_value_items[];
 extern EnumPropertyItem event_type_items[];
 extern EnumPropertyItem operator_return_items[];
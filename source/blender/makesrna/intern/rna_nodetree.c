@@ -84,6 +84,13 @@ EnumPropertyItem node_chunksize_items[] = {
 	{0, NULL, 0, NULL, NULL}
 };
 
+static EnumPropertyItem node_edit_proxy_items[] = {
+	{0,                  "NONE",     0, "None", "Calculate at full resolution"},
+	{NTREE_COM_PROXY_50, "PROXY_50", 0, "50%",  "First calculate at half resolution"},
+	{NTREE_COM_PROXY_25, "PROXY_25", 0, "25%",  "First calculate at quarter resolution"},
+	{0, NULL, 0, NULL, NULL}
+};
+
 EnumPropertyItem node_socket_type_items[] = {
 	{SOCK_FLOAT,   "VALUE",     0,    "Value",     ""},
 	{SOCK_VECTOR,  "VECTOR",    0,    "Vector",    ""},
@@ -4833,6 +4840,12 @@ static void rna_def_composite_nodetree(BlenderRNA *brna)
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_TWO_PASS);
 	RNA_def_property_ui_text(prop, "Two Pass", "Use two pass execution during editing: first calculate fast nodes, "
 	                                           "second pass calculate all nodes");
+
+	prop = RNA_def_property(srna, "edit_proxy", PROP_ENUM, PROP_NONE);
+	RNA_def_property_enum_bitflag_sdna(prop, NULL, "flag");
+	RNA_def_property_enum_items(prop, node_edit_proxy_items);
+	RNA_def_property_ui_text(prop, "Edit Proxy", "Resolution of the first pass during editing, "
+	                                             "the result is refined at full resolution afterwards");
 }
 
 static void rna_def_shader_nodetree(BlenderRNA *brna)
@@ -204,9 +204,7 @@ static DerivedMesh *doMirrorOnAxis(MirrorModifierData *mmd,
 	totshape = CustomData_number_of_layers(&result->vertData, CD_SHAPEKEY);
 	for (a = 0; a < totshape; a++) {
 		float (*cos)[3] = CustomData_get_layer_n(&result->vertData, CD_SHAPEKEY, a);
-		for (i = maxVerts; i < result->numVertData; i++) {
-			mul_m4_v3(mtx, cos[i]);
-		}
+		mul_m4_v3_array(mtx, cos + maxVerts, result->numVertData - maxVerts);
 	}
 	
 	/* adjust mirrored edge vertex indices */
@@ -0,0 +1,71 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2013 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file RE_bake.h
+ *  \ingroup render
+ */
+
+#ifndef __RE_BAKE_H__
+#define __RE_BAKE_H__
+
+struct Image;
+struct Main;
+struct MFace;
+struct MTFace;
+struct Object;
+struct Render;
+struct Scene;
+
+/* Texture baking through external render engines. Every image pixel is a
+ * point on the mesh surface, given as a triangle and barycentric coordinates
+ * in the same convention the engine uses for its triangles: quads are split
+ * in (0, 1, 2) and (0, 2, 3), the point is u * v0 + v * v1 + (1 - u - v) * v2 */
+
+typedef struct BakeImage {
+	struct Image *image;
+	int width;
+	int height;
+	int offset;  /* first pixel of this image in the pixel array */
+} BakeImage;
+
+typedef struct BakePixel {
+	int primitive_id;  /* triangle index, -1 for pixels outside the UV map */
+	float uv[2];
+} BakePixel;
+
+/* external_engine.c */
+int RE_bake_has_engine(struct Render *re);
+
+int RE_bake_engine(struct Render *re, struct Main *bmain, struct Scene *scene, struct Object *object,
+                   const BakePixel pixel_array[], const int num_pixels, const int depth,
+                   const int pass_type, float result[]);
+
+/* bake_api.c */
+void RE_bake_pixels_populate(struct MFace *mface, struct MTFace *mtface, const int totface,
+                             const BakeImage images[], const int tot_images, BakePixel pixel_array[]);
+
+void RE_bake_mask_fill(const BakePixel pixel_array[], const int num_pixels, char *mask);
+
+#endif /* __RE_BAKE_H__ */
@@ -0,0 +1,158 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2013 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/render/intern/source/bake_api.c
+ *  \ingroup render
+ *
+ * \brief The API to bake textures with external render engines.
+ *
+ * The image pixels are mapped to points on the mesh surface here, by
+ * rasterizing the UV triangles of each face into the image assigned to it.
+ * The engine then evaluates the points in any order it likes, and the
+ * operator writes the results back into the images.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_meshdata_types.h"
+
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf.h"
+
+#include "RE_bake.h"
+
+static int bake_image_index(const BakeImage images[], const int tot_images, struct Image *image)
+{
+	int i;
+
+	for (i = 0; i < tot_images; i++) {
+		if (images[i].image == image)
+			return i;
+	}
+
+	return -1;
+}
+
+/* fill the pixels covered by one UV triangle, with u and v the barycentric
+ * weights of the first and second vertex */
+static void bake_rasterize_triangle(const BakeImage *bk_image, BakePixel *pixel_array, const int primitive_id,
+                                    const float uv1[2], const float uv2[2], const float uv3[2])
+{
+	const int width = bk_image->width;
+	const int height = bk_image->height;
+	float co[3][2];
+	float min[2], max[2];
+	int x, y, xmin, xmax, ymin, ymax;
+
+	/* triangle in pixel space */
+	co[0][0] = uv1[0] * width; co[0][1] = uv1[1] * height;
+	co[1][0] = uv2[0] * width; co[1][1] = uv2[1] * height;
+	co[2][0] = uv3[0] * width; co[2][1] = uv3[1] * height;
+
+	if (area_tri_v2(co[0], co[1], co[2]) == 0.0f)
+		return;
+
+	INIT_MINMAX2(min, max);
+	minmax_v2v2_v2(min, max, co[0]);
+	minmax_v2v2_v2(min, max, co[1]);
+	minmax_v2v2_v2(min, max, co[2]);
+
+	/* pixel centers inside the bounds */
+	xmin = max_ii((int)floorf(min[0] - 0.5f), 0);
+	ymin = max_ii((int)floorf(min[1] - 0.5f), 0);
+	xmax = min_ii((int)ceilf(max[0] - 0.5f), width - 1);
+	ymax = min_ii((int)ceilf(max[1] - 0.5f), height - 1);
+
+	for (y = ymin; y <= ymax; y++) {
+		for (x = xmin; x <= xmax; x++) {
+			BakePixel *bp = &pixel_array[bk_image->offset + y * width + x];
+			float pt[2], w[3];
+
+			/* first triangle to cover a pixel keeps it */
+			if (bp->primitive_id != -1)
+				continue;
+
+			pt[0] = (float)x + 0.5f;
+			pt[1] = (float)y + 0.5f;
+
+			barycentric_weights_v2(co[0], co[1], co[2], pt, w);
+
+			if (w[0] < 0.0f || w[1] < 0.0f || w[2] < 0.0f)
+				continue;
+
+			bp->primitive_id = primitive_id;
+			bp->uv[0] = w[0];
+			bp->uv[1] = w[1];
+		}
+	}
+}
+
+void RE_bake_pixels_populate(MFace *mface, MTFace *mtface, const int totface,
+                             const BakeImage images[], const int tot_images, BakePixel pixel_array[])
+{
+	int num_pixels = 0;
+	int primitive_id = 0;
+	int i;
+
+	for (i = 0; i < tot_images; i++)
+		num_pixels += images[i].width * images[i].height;
+
+	for (i = 0; i < num_pixels; i++) {
+		pixel_array[i].primitive_id = -1;
+		pixel_array[i].uv[0] = 0.0f;
+		pixel_array[i].uv[1] = 0.0f;
+	}
+
+	for (i = 0; i < totface; i++) {
+		MFace *mf = &mface[i];
+		MTFace *tf = &mtface[i];
+		const int image_index = bake_image_index(images, tot_images, tf->tpage);
+
+		/* triangle numbering has to match the engine even for skipped faces */
+		if (image_index != -1) {
+			const BakeImage *bk_image = &images[image_index];
+
+			bake_rasterize_triangle(bk_image, pixel_array, primitive_id, tf->uv[0], tf->uv[1], tf->uv[2]);
+
+			if (mf->v4)
+				bake_rasterize_triangle(bk_image, pixel_array, primitive_id + 1, tf->uv[0], tf->uv[2], tf->uv[3]);
+		}
+
+		primitive_id += (mf->v4) ? 2 : 1;
+	}
+}
+
+/* mask of the pixels that got a result, for filtering the margin */
+void RE_bake_mask_fill(const BakePixel pixel_array[], const int num_pixels, char *mask)
+{
+	int i;
+
+	for (i = 0; i < num_pixels; i++)
+		mask[i] = (pixel_array[i].primitive_id != -1) ? FILTER_MASK_USED : FILTER_MASK_NULL;
+}
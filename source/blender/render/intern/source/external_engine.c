@@ -52,6 +52,7 @@
 #include "BPY_extern.h"
 #endif
 
+#include "RE_bake.h"
 #include "RE_engine.h"
 #include "RE_pipeline.h"
 
@@ -64,7 +65,7 @@
 static RenderEngineType internal_render_type = {
 	NULL, NULL,
 	"BLENDER_RENDER", N_("Blender Render"), RE_INTERNAL,
-	NULL, NULL, NULL, NULL, NULL,
+	NULL, NULL, NULL, NULL, NULL, NULL,
 	{NULL, NULL, NULL}
 };
 
@@ -73,7 +74,7 @@ static RenderEngineType internal_render_type = {
 static RenderEngineType internal_game_type = {
 	NULL, NULL,
 	"BLENDER_GAME", N_("Blender Game"), RE_INTERNAL | RE_GAME,
-	NULL, NULL, NULL, NULL, NULL,
+	NULL, NULL, NULL, NULL, NULL, NULL,
 	{NULL, NULL, NULL}
 };
 
@@ -310,6 +311,58 @@ void RE_engine_report(RenderEngine *engine, int type, const char *msg)
 		BKE_report(engine->reports, type, msg);
 }
 
+/* Bake */
+
+int RE_bake_has_engine(Render *re)
+{
+	RenderEngineType *type = RE_engines_find(re->r.engine);
+	return (type->bake != NULL);
+}
+
+int RE_bake_engine(Render *re, struct Main *bmain, Scene *scene, Object *object,
+                   const BakePixel pixel_array[], const int num_pixels, const int depth,
+                   const int pass_type, float result[])
+{
+	RenderEngineType *type = RE_engines_find(re->r.engine);
+	RenderEngine *engine;
+
+	/* set up render */
+	re->main = bmain;
+	re->scene = scene;
+	re->lay = scene->lay;
+
+	/* the engine is only used for this bake, persistent data does not apply */
+	engine = RE_engine_create(type);
+	engine->re = re;
+	engine->flag |= RE_ENGINE_RENDERING;
+	engine->resolution_x = re->winx;
+	engine->resolution_y = re->winy;
+
+	RE_parts_init(re, FALSE);
+	engine->tile_x = re->partx;
+	engine->tile_y = re->party;
+
+	/* update is only called so the engine can sync the scene */
+	if (type->update)
+		type->update(engine, bmain, scene);
+
+	if (type->bake)
+		type->bake(engine, scene, object, pass_type, pixel_array, num_pixels, depth, result);
+
+	engine->tile_x = 0;
+	engine->tile_y = 0;
+	engine->flag &= ~RE_ENGINE_RENDERING;
+
+	RE_engine_free(engine);
+
+	RE_parts_free(re);
+
+	if (BKE_reports_contain(re->reports, RPT_ERROR))
+		G.is_break = TRUE;
+
+	return 1;
+}
+
 /* Render */
 
 int RE_engine_render(Render *re, int do_all)
@@ -333,6 +333,7 @@ enum {
 	WM_JOB_TYPE_OBJECT_SIM_FLUID,
 	WM_JOB_TYPE_OBJECT_BAKE_TEXTURE,
 	WM_JOB_TYPE_FILESEL_THUMBNAIL,
+	WM_JOB_TYPE_FILESEL_READDIR,
 	WM_JOB_TYPE_CLIP_BUILD_PROXY,
 	WM_JOB_TYPE_CLIP_TRACK_MARKERS,
 	WM_JOB_TYPE_CLIP_SOLVE_CAMERA,
@@ -360,6 +361,7 @@ void        WM_jobs_callbacks(struct wmJob *,
 void		WM_jobs_start(struct wmWindowManager *wm, struct wmJob *);
 void		WM_jobs_stop(struct wmWindowManager *wm, void *owner, void *startjob);
 void		WM_jobs_kill(struct wmWindowManager *wm, void *owner, void (*)(void *, short int *, short int *, float *));
+void		WM_jobs_kill_type(struct wmWindowManager *wm, void *owner, int job_type);
 void		WM_jobs_kill_all(struct wmWindowManager *wm);
 	void		WM_jobs_kill_all_except(struct wmWindowManager *wm, void *owner);
 	
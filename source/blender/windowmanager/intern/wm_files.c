@@ -111,6 +111,8 @@
 
 #include "GPU_draw.h"
 
+#include "COM_compositor.h"
+
 #ifdef WITH_PYTHON
 #include "BPY_extern.h"
 #endif
@@ -334,7 +336,8 @@ static int wm_read_exotic(Scene *UNUSED(scene), const char *name)
 		else {
 			len = gzread(gzfile, header, sizeof(header));
 			gzclose(gzfile);
-			if (len == sizeof(header) && strncmp(header, "BLENDER", 7) == 0) {
+			/* 'BLENDZ' starts LZO/LZMA framed files, gzip framed files are read by gzread */
+			if (len == sizeof(header) && (strncmp(header, "BLENDER", 7) == 0 || strncmp(header, "BLENDZ", 6) == 0)) {
 				retval = BKE_READ_EXOTIC_OK_BLEND;
 			}
 			else {
@@ -391,6 +394,11 @@ void WM_file_read(bContext *C, const char *filepath, ReportList *reports)
 		retval = BKE_read_file(C, filepath, reports);
 		G.save_over = 1;
 
+#ifdef WITH_COMPOSITOR
+		/* results of the old file's images and node trees */
+		COM_clearCaches();
+#endif
+
 		/* this flag is initialized by the operator but overwritten on read.
 		 * need to re-enable it here else drivers + registered scripts wont work. */
 		if (G.f != G_f) {
@@ -534,6 +542,10 @@ int WM_homefile_read(bContext *C, ReportList *UNUSED(reports), short from_memory
 	/* prevent buggy files that had G_FILE_RELATIVE_REMAP written out by mistake. Screws up autosaves otherwise
 	 * can remove this eventually, only in a 2.53 and older, now its not written */
 	G.fileflags &= ~G_FILE_RELATIVE_REMAP;
+
+#ifdef WITH_COMPOSITOR
+	COM_clearCaches();
+#endif
 	
 	/* check userdef before open window, keymaps etc */
 	wm_init_userdef(C);
@@ -825,8 +837,8 @@ int WM_file_write(bContext *C, const char *target, int fileflags, ReportList *re
 			G.save_over = 1; /* disable untitled.blend convention */
 		}
 
-		if (fileflags & G_FILE_COMPRESS) G.fileflags |= G_FILE_COMPRESS;
-		else G.fileflags &= ~G_FILE_COMPRESS;
+		G.fileflags &= ~(G_FILE_COMPRESS | G_FILE_COMPRESS_LZO | G_FILE_COMPRESS_LZMA);
+		G.fileflags |= fileflags & (G_FILE_COMPRESS | G_FILE_COMPRESS_LZO | G_FILE_COMPRESS_LZMA);
 		
 		if (fileflags & G_FILE_AUTOPLAY) G.fileflags |= G_FILE_AUTOPLAY;
 		else G.fileflags &= ~G_FILE_AUTOPLAY;
@@ -449,6 +449,21 @@ void WM_jobs_kill(wmWindowManager *wm, void *owner, void (*startjob)(void *, sho
 }
 
 
+/* kill the jobs of one type from this owner, unlike WM_jobs_kill() which kills all of them */
+void WM_jobs_kill_type(wmWindowManager *wm, void *owner, int job_type)
+{
+	wmJob *wm_job, *next_job;
+	
+	for (wm_job = wm->jobs.first; wm_job; wm_job = next_job) {
+		next_job = wm_job->next;
+
+		if (wm_job->owner == owner) {
+			if (job_type == WM_JOB_TYPE_ANY || wm_job->job_type == job_type)
+				wm_jobs_kill_job(wm, wm_job);
+		}
+	}
+}
+
 /* kill job entirely, also removes timer itself */
 void wm_jobs_timer_ended(wmWindowManager *wm, wmTimer *wt)
 {
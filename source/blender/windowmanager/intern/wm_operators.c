@@ -2091,6 +2091,13 @@ static void untitled(char *filepath)
 	}
 }
 
+static EnumPropertyItem save_compress_method_items[] = {
+	{0, "GZIP", 0, "Gzip", "Deflate compressed, can be read by older versions"},
+	{G_FILE_COMPRESS_LZO, "LZO", 0, "LZO", "Fastest compression, larger files"},
+	{G_FILE_COMPRESS_LZMA, "LZMA", 0, "LZMA", "Best compression, slowest to save"},
+	{0, NULL, 0, NULL, NULL}
+};
+
 static void save_set_compress(wmOperator *op)
 {
 	if (!RNA_struct_property_is_set(op->ptr, "compress")) {
@@ -2099,6 +2106,9 @@ static void save_set_compress(wmOperator *op)
 		else /* use userdef for new file */
 			RNA_boolean_set(op->ptr, "compress", U.flag & USER_FILECOMPRESS);
 	}
+	if (!RNA_struct_property_is_set(op->ptr, "compress_method")) {
+		RNA_enum_set(op->ptr, "compress_method", G.fileflags & (G_FILE_COMPRESS_LZO | G_FILE_COMPRESS_LZMA));
+	}
 }
 
 static int wm_save_as_mainfile_invoke(bContext *C, wmOperator *op, wmEvent *UNUSED(event))
@@ -2143,6 +2153,8 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
 	/* set compression flag */
 	BKE_BIT_TEST_SET(fileflags, RNA_boolean_get(op->ptr, "compress"),
 	                 G_FILE_COMPRESS);
+	fileflags &= ~(G_FILE_COMPRESS_LZO | G_FILE_COMPRESS_LZMA);
+	fileflags |= RNA_enum_get(op->ptr, "compress_method");
 	BKE_BIT_TEST_SET(fileflags, RNA_boolean_get(op->ptr, "relative_remap"),
 	                 G_FILE_RELATIVE_REMAP);
 	BKE_BIT_TEST_SET(fileflags,
@@ -2194,6 +2206,8 @@ static void WM_OT_save_as_mainfile(wmOperatorType *ot)
 	WM_operator_properties_filesel(ot, FOLDERFILE | BLENDERFILE, FILE_BLENDER, FILE_SAVE,
 	                               WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY);
 	RNA_def_boolean(ot->srna, "compress", 0, "Compress", "Write compressed .blend file");
+	RNA_def_enum(ot->srna, "compress_method", save_compress_method_items, 0, "Compression Method",
+	             "Compression used when saving a compressed .blend file");
 	RNA_def_boolean(ot->srna, "relative_remap", 1, "Remap Relative",
 	                "Remap relative paths when saving in a different directory");
 	RNA_def_boolean(ot->srna, "copy", 0, "Save Copy",
@@ -2261,6 +2275,8 @@ static void WM_OT_save_mainfile(wmOperatorType *ot)
 	WM_operator_properties_filesel(ot, FOLDERFILE | BLENDERFILE, FILE_BLENDER, FILE_SAVE,
 	                               WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY);
 	RNA_def_boolean(ot->srna, "compress", 0, "Compress", "Write compressed .blend file");
+	RNA_def_enum(ot->srna, "compress_method", save_compress_method_items, 0, "Compression Method",
+	             "Compression used when saving a compressed .blend file");
 	RNA_def_boolean(ot->srna, "relative_remap", 0, "Remap Relative", "Remap relative paths when saving in a different directory");
 }
 
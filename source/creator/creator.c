@@ -379,6 +379,12 @@ static int debug_mode_generic(int UNUSED(argc), const char **UNUSED(argv), void
 	return 0;
 }
 
+static int debug_mode_memory(int UNUSED(argc), const char **UNUSED(argv), void *UNUSED(data))
+{
+	/* handled by mem_allocator_init() already */
+	return 0;
+}
+
 #ifdef WITH_LIBMV
 static int debug_mode_libmv(int UNUSED(argc), const char **UNUSED(argv), void *UNUSED(data))
 {
@@ -1145,6 +1151,8 @@ static void setupArguments(bContext *C, bArgs *ba, SYS_SystemHandle *syshandle)
 
 	BLI_argsAdd(ba, 1, NULL, "--debug-value", "<value>\n\tSet debug value of <value> on startup\n", set_debug_value, NULL);
 	BLI_argsAdd(ba, 1, NULL, "--debug-jobs",  "\n\tEnable time profiling for background jobs.", debug_mode_generic, (void *)G_DEBUG_JOBS);
+	BLI_argsAdd(ba, 1, NULL, "--debug-memory", "\n\tUse the guarded memory allocator, slower with many threads but checks for corruption and lists leaks by name (always used by debug builds)", debug_mode_memory, NULL);
+	BLI_argsAdd(ba, 1, NULL, "--debug-memory-track", "\n\tKeep the lock-free memory allocator of release builds but track all blocks, to list leaks by name", debug_mode_memory, NULL);
 
 	BLI_argsAdd(ba, 1, NULL, "--verbose", "<verbose>\n\tSet logging verbosity level.", set_verbosity, NULL);
 
@@ -1204,13 +1212,39 @@ char **environ = NULL;
 #endif
 
 
+/* the allocator can only be chosen before anything is allocated,
+ * so this can't wait for the argument parsing */
+static void mem_allocator_init(int argc, const char **argv)
+{
+#ifdef NDEBUG
+	int track_blocks = FALSE;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--debug-memory") == 0) {
+			/* keep the guarded allocator, checks all blocks and lists leaks by name */
+			return;
+		}
+		else if (strcmp(argv[i], "--debug-memory-track") == 0) {
+			track_blocks = TRUE;
+		}
+	}
+
+	MEM_use_lockfree_allocator(track_blocks);
+#else
+	/* debug builds keep the guarded allocator for its corruption checks and named leak reports */
+	(void)argc;
+	(void)argv;
+#endif
+}
+
 #ifdef WIN32
 int main(int argc, const char **UNUSED(argv_c)) /* Do not mess with const */
 #else
 int main(int argc, const char **argv)
 #endif
 {
-	bContext *C = CTX_create();
+	bContext *C;
 	SYS_SystemHandle syshandle;
 
 #ifndef WITH_PYTHON_MODULE
@@ -1218,15 +1252,24 @@ int main(int argc, const char **argv)
 #endif
 
 #ifdef WIN32
-	wchar_t **argv_16 = CommandLineToArgvW(GetCommandLineW(), &argc);
+	wchar_t **argv_16;
 	int argci = 0;
-	char **argv = MEM_mallocN(argc * sizeof(char *), "argv array");
+	char **argv;
+
+	mem_allocator_init(__argc, (const char **)__argv);
+
+	argv_16 = CommandLineToArgvW(GetCommandLineW(), &argc);
+	argv = MEM_mallocN(argc * sizeof(char *), "argv array");
 	for (argci = 0; argci < argc; argci++) {
 		argv[argci] = alloc_utf_8_from_16(argv_16[argci], 0);
 	}
 	LocalFree(argv_16);
+#else
+	mem_allocator_init(argc, argv);
 #endif
 
+	C = CTX_create();
+
 #ifdef WITH_PYTHON_MODULE
 #ifdef __APPLE__
 	environ = *_NSGetEnviron();
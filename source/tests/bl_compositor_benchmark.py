@@ -0,0 +1,165 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Benchmark compositing a 2K color grading tree per pixel and in rows.
+
+Builds a tree of simple nodes (color balance, mixes, math, set alpha) on a
+generated float image, then composites it with every pixel calculated
+separately (bpy.app.debug_value 710) and with row execution, and checks that
+both give the same result.
+
+Example Usage:
+
+./blender.bin --background --factory-startup \
+    --python source/tests/bl_compositor_benchmark.py -- \
+    --size=2048x1080 \
+    --repeat=5
+"""
+
+import sys
+import time
+
+# COM_DEBUG_VALUE_PIXEL_EXECUTION in COM_defines.h
+DEBUG_VALUE_PIXEL_EXECUTION = 710
+
+
+def build_grading_tree(width, height):
+    import bpy
+
+    scene = bpy.context.scene
+    scene.render.resolution_x = width
+    scene.render.resolution_y = height
+    scene.render.resolution_percentage = 100
+    scene.render.use_compositing = True
+    scene.use_nodes = True
+
+    tree = scene.node_tree
+    for node in tree.nodes[:]:
+        tree.nodes.remove(node)
+
+    image = bpy.data.images.new("Benchmark", width, height, alpha=True, float_buffer=True)
+    image.generated_type = 'COLOR_GRID'
+
+    nodes = tree.nodes
+    links = tree.links
+
+    source = nodes.new('CompositorNodeImage')
+    source.image = image
+
+    balance = nodes.new('CompositorNodeColorBalance')
+    balance.correction_method = 'LIFT_GAMMA_GAIN'
+    balance.lift = (0.95, 1.0, 1.05)
+    balance.gamma = (1.1, 1.0, 0.9)
+    balance.gain = (1.05, 1.0, 0.95)
+    links.new(source.outputs["Image"], balance.inputs["Image"])
+
+    tint = nodes.new('CompositorNodeMixRGB')
+    tint.blend_type = 'MULTIPLY'
+    tint.inputs["Fac"].default_value = 0.5
+    tint.inputs[2].default_value = (1.0, 0.9, 0.8, 1.0)
+    links.new(balance.outputs["Image"], tint.inputs[1])
+
+    # luminance mask from the graded image
+    mask = nodes.new('CompositorNodeMath')
+    mask.operation = 'MULTIPLY'
+    mask.inputs[1].default_value = 0.75
+    links.new(tint.outputs["Image"], mask.inputs[0])
+
+    lift = nodes.new('CompositorNodeMixRGB')
+    lift.blend_type = 'ADD'
+    lift.inputs[2].default_value = (0.02, 0.03, 0.05, 1.0)
+    links.new(mask.outputs["Value"], lift.inputs["Fac"])
+    links.new(tint.outputs["Image"], lift.inputs[1])
+
+    blend = nodes.new('CompositorNodeMixRGB')
+    blend.blend_type = 'MIX'
+    blend.inputs["Fac"].default_value = 0.8
+    links.new(source.outputs["Image"], blend.inputs[1])
+    links.new(lift.outputs["Image"], blend.inputs[2])
+
+    alpha = nodes.new('CompositorNodeSetAlpha')
+    links.new(blend.outputs["Image"], alpha.inputs["Image"])
+    links.new(mask.outputs["Value"], alpha.inputs["Alpha"])
+
+    composite = nodes.new('CompositorNodeComposite')
+    links.new(alpha.outputs["Image"], composite.inputs["Image"])
+
+    viewer = nodes.new('CompositorNodeViewer')
+    links.new(alpha.outputs["Image"], viewer.inputs["Image"])
+
+
+def time_composite(debug_value, repeat):
+    import bpy
+
+    bpy.app.debug_value = debug_value
+
+    best = None
+    for i in range(repeat):
+        t = time.time()
+        bpy.ops.render.render()
+        t = time.time() - t
+        if best is None or t < best:
+            best = t
+
+    pixels = bpy.data.images["Viewer Node"].pixels[:]
+
+    bpy.app.debug_value = 0
+
+    return best, pixels
+
+
+def main():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--size", dest="size", default="2048x1080",
+            help="Image size as WIDTHxHEIGHT")
+    parser.add_argument("--repeat", dest="repeat", type=int, default=5,
+            help="Number of composites per mode, the fastest is reported")
+
+    args = parser.parse_args(argv)
+
+    width, height = (int(s) for s in args.size.split("x"))
+
+    build_grading_tree(width, height)
+
+    # warm up image and buffer allocation
+    time_composite(0, 1)
+
+    time_pixel, pixels_pixel = time_composite(DEBUG_VALUE_PIXEL_EXECUTION, args.repeat)
+    time_row, pixels_row = time_composite(0, args.repeat)
+
+    max_error = max(abs(a - b) for a, b in zip(pixels_pixel, pixels_row))
+
+    print("\n%12s %12s" % ("execution", "time (s)"))
+    print("%12s %12.4f" % ("pixel", time_pixel))
+    print("%12s %12.4f" % ("row", time_row))
+    print("\nspeedup %.2fx, max difference %g" % (time_pixel / time_row, max_error))
+
+    if max_error > 1e-5:
+        print("Error: row execution differs from pixel execution")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
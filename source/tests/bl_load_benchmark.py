@@ -0,0 +1,132 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Benchmark .blend loading time against the number of blocks in the file.
+
+Writes synthetic files with an increasing number of objects (each with its own
+mesh and randomly ordered parent/modifier links, so pointers are not resolved
+in file order), then times loading each of them.
+Load time per block should stay roughly constant as the file grows.
+
+Example Usage:
+
+./blender.bin --background --factory-startup \
+    --python source/tests/bl_load_benchmark.py -- \
+    --counts=1000,2000,4000,8000 \
+    --repeat=3 \
+    --save_path=/tmp
+"""
+
+import os
+import sys
+import time
+import random
+
+
+def clear_data():
+    import bpy
+
+    scene = bpy.context.scene
+    for obj in scene.objects[:]:
+        scene.objects.unlink(obj)
+        bpy.data.objects.remove(obj)
+
+    for bpy_data_iter in (bpy.data.meshes, bpy.data.materials):
+        for id_data in bpy_data_iter[:]:
+            if id_data.users == 0:
+                bpy_data_iter.remove(id_data)
+
+
+def write_synthetic(filepath, count):
+    import bpy
+
+    clear_data()
+
+    random.seed(count)
+    scene = bpy.context.scene
+    objects = []
+
+    for i in range(count):
+        me = bpy.data.meshes.new("Mesh.%d" % i)
+        me.from_pydata(((0.0, 0.0, 0.0), (1.0, 0.0, 0.0), (0.0, 1.0, 0.0)), (), ((0, 1, 2),))
+        me.materials.append(bpy.data.materials.new("Mat.%d" % i))
+
+        obj = bpy.data.objects.new("Object.%d" % i, me)
+        scene.objects.link(obj)
+        objects.append(obj)
+
+    # cross links so library lookups hit the map out of write order
+    for obj in objects:
+        other = random.choice(objects)
+        if other is not obj and other.parent is None:
+            obj.parent = other
+        mod = obj.modifiers.new("Curve", 'CURVE')
+        mod.object = random.choice(objects)
+
+    bpy.ops.wm.save_as_mainfile(filepath=filepath, check_existing=False)
+
+    return len(objects) * 3
+
+
+def time_load(filepath, repeat):
+    import bpy
+
+    best = None
+    for i in range(repeat):
+        t = time.time()
+        bpy.ops.wm.open_mainfile(filepath=filepath)
+        t = time.time() - t
+        if best is None or t < best:
+            best = t
+    return best
+
+
+def main():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--counts", dest="counts", default="1000,2000,4000,8000",
+            help="Comma separated number of objects for each file")
+    parser.add_argument("--repeat", dest="repeat", type=int, default=3,
+            help="Number of loads per file, the fastest is reported")
+    parser.add_argument("--save_path", dest="save_path", default="/tmp",
+            help="Directory to write the synthetic files to")
+
+    args = parser.parse_args(argv)
+
+    counts = [int(c) for c in args.counts.split(",")]
+
+    results = []
+    for count in counts:
+        filepath = os.path.join(args.save_path, "bl_load_benchmark_%d.blend" % count)
+        totid = write_synthetic(filepath, count)
+        results.append((count, totid, time_load(filepath, args.repeat)))
+        os.remove(filepath)
+
+    print("\n%10s %10s %12s %16s" % ("objects", "IDs", "load (s)", "usec per ID"))
+    for count, totid, t in results:
+        print("%10d %10d %12.4f %16.2f" % (count, totid, t, (t / totid) * 1e6))
+
+
+if __name__ == "__main__":
+    main()